@@ -0,0 +1,347 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) com F generica e DF obtida  */
+/*  por derivacao automatica (gsdae::autojac).            */
+/*                                                        */
+/*  As jacobianas de autojac com 8 direcoes, com 3        */
+/*  direcoes (ultimo grupo incompleto) e com o padrao de  */
+/*  SETPATTERN devem coincidir com a DF escrita a mao ate */
+/*  o arredondamento, e a integracao com autojac (com e   */
+/*  sem padrao) deve chegar ao ponto da integracao pela   */
+/*  interface C com a DF escrita a mao.                   */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.hpp"
+
+#include <cstdio>
+
+#define N      20
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATEC ( real *, mreal );
+void START ( mreal );
+void PATTERN ( int *, vint, vint );
+
+/* ****************************************************** */
+/* F generica : y1' = y2 - 0.01 y1^3 - 0.001 sin(x)       */
+/* exp(-y1^2), y2' = -y1 - 0.01 (y1 - y1 do oscilador     */
+/* anterior)                                              */
+/* ****************************************************** */
+
+struct chain {
+  template <class X, class Y, class D>
+  void
+  operator() (int o, int n, X x, Y y, D delta)
+  {
+    for (int i = 1; i <= n; i += 2) {
+      delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                   0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+      delta[i+1] = y[1][i+1]+y[0][i];
+      if (i > 1)
+        delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+    }
+  }
+};
+
+/* ****************************************************** */
+/* maior diferenca entre DF de autojac e a DF escrita a   */
+/* mao em x = 0.7 e num ponto y qualquer                  */
+/* ****************************************************** */
+
+template <int M>
+real
+JACDIFF (
+coloring *cpr
+)
+{
+  gsdae::autojac<M> ad;
+  chain             f;
+  mreal             y;
+  vreal             DFx, DFx0;
+  mmreal            DFy, DFy0;
+  real              err;
+
+  y    = ALLOCMREAL(1,N);
+  DFx  = ALLOCVREAL(N);
+  DFx0 = ALLOCVREAL(N);
+  DFy  = ALLOCMMREAL(1,N,N);
+  DFy0 = ALLOCMMREAL(1,N,N);
+  if ((y == NULL) || (DFx == NULL) || (DFx0 == NULL) || (DFy == NULL) ||
+      (DFy0 == NULL))
+    return (1.0);
+
+  for (int k = 0; k <= 1; k++)
+    for (int i = 1; i <= N; i++)
+      y[k][i] = 0.3*(k+1)+0.1*i-0.05*i*k;
+  /* elementos fora do padrao devem ser zerados por autojac */
+  for (int k = 0; k <= 1; k++)
+    for (int j = 1; j <= N; j++)
+      for (int i = 1; i <= N; i++)
+        DFy[k][j][i] = 1.0;
+
+  ad(f,cpr,1,N,0.7,y,DFx,DFy);
+  DFCHAIN(1,N,0.7,y,DFx0,DFy0,NULL);
+
+  err = 0.0;
+  for (int i = 1; i <= N; i++)
+    if (!(fabs(DFx[i]-DFx0[i]) <= err))
+      err = fabs(DFx[i]-DFx0[i]);
+  for (int k = 0; k <= 1; k++)
+    for (int j = 1; j <= N; j++)
+      for (int i = 1; i <= N; i++)
+        if (!(fabs(DFy[k][j][i]-DFy0[k][j][i]) <= err))
+          err = fabs(DFy[k][j][i]-DFy0[k][j][i]);
+
+  FREEMREAL(1,N,y);
+  FREEVREAL(N,DFx);
+  FREEVREAL(N,DFx0);
+  FREEMMREAL(1,N,N,DFy);
+  FREEMMREAL(1,N,N,DFy0);
+
+  return (err);
+}
+
+int main ( void )
+{
+  gsdae_ctx *ctx;
+  int        erro,pat,cont,nnz,k,i;
+  real       err[3],x0,dmax;
+  mreal      y0;
+  vint       ia,ja;
+
+  erro = 0;
+  y0   = ALLOCMREAL(1,N);
+  ia   = ALLOCVINT(N+1);
+  ja   = ALLOCVINT(3*N);
+  ctx  = ALLOCCTX(N,1,FCHAIN,NULL,NULL);
+  if ((y0 == NULL) || (ia == NULL) || (ja == NULL) || (ctx == NULL))
+    return (1);
+
+  /* jacobianas : densa com 8 e 3 direcoes e colorida com 4 */
+  PATTERN(&nnz,ia,ja);
+  if (SETPATTERN(ctx,nnz,ia,ja) != 0)
+    return (1);
+  err[0] = JACDIFF<8>(NULL);
+  err[1] = JACDIFF<3>(NULL);
+  err[2] = JACDIFF<4>(ctx->ls.cpr);
+  printf("autojac<8>           : |DF - DF exata| = %e\n",err[0]);
+  printf("autojac<3>           : |DF - DF exata| = %e\n",err[1]);
+  printf("autojac<4> (padrao)  : |DF - DF exata| = %e\n",err[2]);
+  for (k = 0; k <= 2; k++)
+    if (!(err[k] <= 1.0e-14))
+      erro = 1;
+
+  /* integracao pela interface C com a DF escrita a mao */
+  if (INTEGRATEC(&x0,y0) != 0)
+    erro = 1;
+  printf("DF (C)               : x = %.12lf y[0][1] = %.12lf\n",
+         x0,y0[0][1]);
+
+  /* integracao com autojac, sem e com o padrao */
+  for (pat = 0; pat <= 1; pat++) {
+    gsdae::solver<chain,gsdae::autojac<>> sv(N,1,chain());
+    if ((pat == 1) && (SETPATTERN(sv.ctx(),nnz,ia,ja) != 0))
+      return (1);
+    START(sv.y());
+    sv.tolerances(1.0e-9,1.0e-7,1.0e-6);
+    cont = 0;
+    while ((sv.advance(SEND) > 0) && (++cont < 100))
+      ;
+    if (sv.infooutput()[1] != 0)
+      erro = 1;
+    dmax = fabs(sv.x()-x0);
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (!(fabs(sv.y(k,i)-y0[k][i]) <= dmax))
+          dmax = fabs(sv.y(k,i)-y0[k][i]);
+    printf("autojac%s: x = %.12lf y[0][1] = %.12lf\n",
+           (pat == 1) ? " (padrao)   " : "            ",sv.x(),sv.y(0,1));
+    if (!(dmax <= 1.0e-8))
+      erro = 1;
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exautojac : ok" : "exautojac : FALHOU");
+
+  FREECTX(ctx);
+  FREEMREAL(1,N,y0);
+  FREEVINT(N+1,ia);
+  FREEVINT(3*N,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao pela interface C com a DF escrita a mao     */
+/* ****************************************************** */
+
+int
+INTEGRATEC (
+real *xf,
+mreal yf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,erro,cont;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  START(y);
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  cont = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++cont < 100));
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+void
+START (
+mreal y
+)
+{
+  int i;
+
+  for (i = 1; i <= N; i += 2) {
+    y[0][i]   =  1.0;
+    y[0][i+1] =  0.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+}
+
+
+
+/* ****************************************************** */
+/* padrao de DFy por equacoes : a equacao i usa y[.][i] e */
+/* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]          */
+/* ****************************************************** */
+
+void
+PATTERN (
+int  *nnz,
+vint  ia,
+vint  ja
+)
+{
+  int i;
+
+  *nnz = 0;
+  for (i = 1; i <= N; i += 2) {
+    ia[i]        = *nnz+1;
+    ja[++(*nnz)] = i;
+    ja[++(*nnz)] = i+1;
+    ia[i+1]      = *nnz+1;
+    if (i > 1)
+      ja[++(*nnz)] = i-2;
+    ja[++(*nnz)] = i;
+    ja[++(*nnz)] = i+1;
+  }
+  ia[N+1] = *nnz+1;
+}
+
+
+
+/* ****************************************************** */
+/* F e DF escritas a mao para a interface C               */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  chain f;
+
+  f(o,n,x,y,delta);
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
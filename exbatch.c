@@ -0,0 +1,247 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : m = 60 osciladores harmonicos y'' = -w^2 y  */
+/*  (n = 2, o = 1) com w, send e a jacobiana (DF ou       */
+/*  aproximada) diferentes em cada instancia, integrados  */
+/*  por GSDAEBATCH.                                       */
+/*                                                        */
+/*  Os resultados com 1 e com 4 threads devem ser iguais  */
+/*  bit a bit entre si e as instancias integradas uma a   */
+/*  uma por GSDAECTX, e y[0][1] deve ser cos(w x).        */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define M      60
+#define X0     1.0
+
+void FOSC ( int, int, real, mreal, vreal, void * );
+void DFOSC ( int, int, real, mreal, vreal, mmreal, void * );
+int  INITINST ( gsdae_inst *, vreal );
+void FREEINST ( gsdae_inst * );
+int  SAME ( gsdae_inst *, gsdae_inst * );
+
+int main ( void )
+{
+  gsdae_inst  inst[3][M];
+  gsdae_ctx  *ctx;
+  vreal       w;
+  vint        infoout;
+  int         n,o,i,l,erro,nerr;
+  real        len;
+
+  n    = 2;
+  o    = 1;
+  erro = 0;
+
+  w       = ALLOCVREAL(M);
+  infoout = ALLOCVINT(2*n+10);
+  ctx     = ALLOCCTX(n,o,FOSC,DFOSC,NULL);
+  if ((w == NULL) || (infoout == NULL) || (ctx == NULL))
+    return (1);
+  for (i = 1; i <= M; i++)
+    w[i] = 0.5+0.1*(real) (i % 17);
+  for (l = 0; l <= 2; l++)
+    if (INITINST(inst[l],w) != 0)
+      return (1);
+
+  /* GSDAEBATCH com 1 e com 4 threads */
+  nerr = GSDAEBATCH(n,o,M,inst[0],FOSC,DFOSC,1);
+  printf("1 thread   : %d instancias com erro\n",nerr);
+  if (nerr != 0)
+    erro = 1;
+  nerr = GSDAEBATCH(n,o,M,inst[1],FOSC,DFOSC,4);
+  printf("4 threads  : %d instancias com erro\n",nerr);
+  if (nerr != 0)
+    erro = 1;
+
+  /* as mesmas instancias uma a uma, num unico contexto */
+  for (i = 0; i < M; i++) {
+    ctx->data = inst[2][i].data;
+    inst[2][i].info[1] = 0;
+    do
+      inst[2][i].status = GSDAECTX(ctx,n,o,inst[2][i].h,inst[2][i].hmin,
+                                   inst[2][i].hmax,inst[2][i].cdmax,
+                                   &(inst[2][i].s),inst[2][i].send,
+                                   &(inst[2][i].x),inst[2][i].y,
+                                   inst[2][i].atolx,inst[2][i].atoly,
+                                   inst[2][i].rtolx,inst[2][i].rtoly,
+                                   inst[2][i].ftol,inst[2][i].info,infoout);
+    while (inst[2][i].status > 0);
+    STATISTICSCTX(ctx,&len,&(inst[2][i].nstep),
+                  &(inst[2][i].nreject),&(inst[2][i].nsuc),
+                  &(inst[2][i].nfunc),&(inst[2][i].njac),&(inst[2][i].nqr),
+                  &(inst[2][i].nstart),&(inst[2][i].nfnew));
+  }
+
+  for (i = 0; i < M; i++) {
+    if (!SAME(&inst[0][i],&inst[1][i]) || !SAME(&inst[0][i],&inst[2][i]))
+      erro = 1;
+    if (fabs(inst[0][i].y[0][1]-cos(w[i+1]*inst[0][i].x)) > 1.0e-5)
+      erro = 1;
+  }
+  printf("instancia 1  : x = %.12lf y[0][1] = %.12lf Number of Steps : %d\n",
+         inst[0][0].x,inst[0][0].y[0][1],inst[0][0].nstep);
+  printf("instancia %d : x = %.12lf y[0][1] = %.12lf Number of Steps : %d\n",
+         M,inst[0][M-1].x,inst[0][M-1].y[0][1],inst[0][M-1].nstep);
+
+  printf("\n%s\n",(erro == 0) ? "exbatch : ok" : "exbatch : FALHOU");
+
+  for (l = 0; l <= 2; l++)
+    FREEINST(inst[l]);
+  FREECTX(ctx);
+  FREEVREAL(M,w);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* instancias : y = cos(w x) em x = X0, send = 3..7 e DF  */
+/* aproximada em uma de cada tres instancias              */
+/* ****************************************************** */
+
+int
+INITINST (
+gsdae_inst *in,
+vreal       w
+)
+{
+  int i;
+
+  for (i = 0; i < M; i++) {
+    in[i].h       = 1.0e-6;
+    in[i].hmin    = 1.0e-16;
+    in[i].hmax    = 0.0;
+    in[i].cdmax   = 1.0e50;
+    in[i].send    = 3.0+(real) (i % 5);
+    in[i].atolx   = 1.0e-10;
+    in[i].rtolx   = 1.0e-8;
+    in[i].atoly   = ALLOCMREAL(1,2);
+    in[i].rtoly   = ALLOCMREAL(1,2);
+    in[i].y       = ALLOCMREAL(1,2);
+    in[i].ftol    = ALLOCVREAL(2);
+    in[i].info    = ALLOCVINT(2*2+10);
+    if ((in[i].atoly == NULL) || (in[i].rtoly == NULL) ||
+        (in[i].y == NULL) || (in[i].ftol == NULL) || (in[i].info == NULL))
+      return (1);
+    in[i].data    = &w[i+1];
+    in[i].s       = 0.0;
+    in[i].x       = X0;
+    in[i].y[0][1] = cos(w[i+1]*X0);
+    in[i].y[0][2] = -w[i+1]*sin(w[i+1]*X0);
+    in[i].y[1][1] = in[i].y[0][2];
+    in[i].y[1][2] = -w[i+1]*w[i+1]*in[i].y[0][1];
+    in[i].ftol[1] = 1.0e-6;
+    in[i].info[2] = ((i % 3) != 0);
+    in[i].info[3] = 1;
+  }
+
+  return (0);
+}
+
+
+
+void
+FREEINST (
+gsdae_inst *in
+)
+{
+  int i;
+
+  for (i = 0; i < M; i++) {
+    FREEMREAL(1,2,in[i].atoly);
+    FREEMREAL(1,2,in[i].rtoly);
+    FREEMREAL(1,2,in[i].y);
+    FREEVREAL(2,in[i].ftol);
+    FREEVINT(2*2+10,in[i].info);
+  }
+}
+
+
+
+/* ****************************************************** */
+/* compara o ponto final e os contadores de duas          */
+/* instancias                                             */
+/* ****************************************************** */
+
+int
+SAME (
+gsdae_inst *a,
+gsdae_inst *b
+)
+{
+  int k,j;
+
+  if ((a->status != b->status) || (a->x != b->x) ||
+      (a->nstep != b->nstep) || (a->nfunc != b->nfunc) ||
+      (a->njac != b->njac))
+    return (0);
+  for (k = 0; k <= 1; k++)
+    for (j = 1; j <= 2; j++)
+      if (a->y[k][j] != b->y[k][j])
+        return (0);
+
+  return (1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2, y2' = -w^2 y1                            */
+/* ****************************************************** */
+
+void
+FOSC (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  real w;
+
+  w = *((real *) data);
+
+  delta[1] = y[1][1]-y[0][2];
+  delta[2] = y[1][2]+w*w*y[0][1];
+}
+
+
+
+void
+DFOSC (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  real w;
+  int  i,j,k;
+
+  w = *((real *) data);
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  DFx[1] = 0.0;
+  DFx[2] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  DFy[1][1][1] = 1.0;
+  DFy[0][2][1] = -1.0;
+  DFy[1][2][2] = 1.0;
+  DFy[0][1][2] = w*w;
+}
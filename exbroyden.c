@@ -0,0 +1,194 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 80, o = 1) integrada com a jacobiana   */
+/*  DF, com DH reavaliada a cada mudanca dos coeficientes */
+/*  (infoinput[6] = 0) e com a fatoracao de DH mantida e  */
+/*  corrigida por atualizacoes de Broyden                 */
+/*  (infoinput[6] = 1).                                   */
+/*                                                        */
+/*  As duas integracoes devem chegar ao mesmo ponto       */
+/*  dentro da tolerancia, e com as atualizacoes de        */
+/*  Broyden DF deve ser avaliada menos vezes.             */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      80
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int, real *, real *, int * );
+
+int main ( void )
+{
+  int  erro,broyden,njac[2];
+  real x[2],y1[2];
+
+  erro = 0;
+  for (broyden = 0; broyden <= 1; broyden++)
+    if (INTEGRATE(broyden,&x[broyden],&y1[broyden],&njac[broyden]) != 0)
+      erro = 1;
+
+  /* mesmo ponto final */
+  if ((fabs(x[1]-x[0]) > 1.0e-5) || (fabs(y1[1]-y1[0]) > 1.0e-5))
+    erro = 1;
+
+  /* menos avaliacoes de DF */
+  if (njac[1] >= njac[0])
+    erro = 1;
+
+  printf("\n%s\n",(erro == 0) ? "exbroyden : ok" : "exbroyden : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com DF;               */
+/* broyden = infoinput[6]                                 */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   broyden,
+real *xf,
+real *y1f,
+int  *njacf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,l,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  info[6] = broyden;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (broyden == 1) ? "Broyden" : "DF     ",erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Calls of DF : %d\n",
+         npas,nreject,njac);
+
+  *xf    = x;
+  *y1f   = y[0][1];
+  *njacf = njac;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
@@ -0,0 +1,259 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1). DH tem dimensao            */
+/*  (o+1)n+1 = 41 > GSDAE_NB, de modo que QRH passa pela  */
+/*  atualizacao em blocos (forma WY) apos o primeiro      */
+/*  painel de colunas.                                    */
+/*                                                        */
+/*  A integracao e feita com DF e com a jacobiana         */
+/*  aproximada, e QRH e comparada com QR (Givens) numa    */
+/*  matriz com uma coluna cuja parte abaixo da diagonal   */
+/*  e um residuo de arredondamento (alpha = -1 e          */
+/*  |A[k+1..m][k]| = 5.2e-160).                           */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      20
+#define SEND   20.0
+#define MAXPAS 1000
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int );
+int  RESIDUE ( void );
+
+int main ( void )
+{
+  int erro;
+
+  erro  = INTEGRATE(1);
+  erro += INTEGRATE(0);
+  erro += RESIDUE();
+
+  printf("\n%s\n",(erro == 0) ? "exchain : ok" : "exchain : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND; jac = infoinput[2]   */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int jac
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,j,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = jac;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (s < SEND));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("DF %s : erro = %d s = %lf x = %lf y[0][1] = %lf\n",
+         jac ? "exata     " : "aproximada",erro,s,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Newton Fail : %d\n",
+         npas,nreject,nfnew);
+
+  for (i = 0; i <= o; i++)
+    for (j = 1; j <= n; j++)
+      if (!isfinite(y[i][j]))
+        erro = -1;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return (((erro == 0) && (npas <= MAXPAS)) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* resolve A u = b por QRH/NEWTONH e por QR/NEWTON numa   */
+/* matriz 41 x 41 e verifica os residuos                  */
+/* ****************************************************** */
+
+int
+RESIDUE ( void )
+{
+  gsdae_ctx *ctx;
+  int        dim,i,j,m,erro;
+  real       cond,res,aux;
+  mreal      A,B,T;
+  vreal      b,u;
+
+  dim  = 2*N+1;
+  erro = 0;
+
+  ctx = ALLOCCTX(N,1,FCHAIN,NULL,NULL);
+  A   = ALLOCMREAL(dim,dim);
+  B   = ALLOCMREAL(dim,dim);
+  T   = ALLOCMREAL(dim,dim);
+  b   = ALLOCVREAL(dim);
+  u   = ALLOCVREAL(dim);
+  if ((ctx == NULL) || (A == NULL) || (B == NULL) || (T == NULL) ||
+      (b == NULL) || (u == NULL))
+    return (1);
+
+  for (m = 0; m <= 1; m++) {
+
+    /* triangular superior com uma coluna quase ja reduzida */
+    for (i = 1; i <= dim; i++) {
+      for (j = 1; j <= dim; j++)
+        A[i][j] = (j >= i) ? 1.0/(real) (i+j) : 0.0;
+      A[i][i] = 2.0;
+      b[i]    = 1.0;
+    }
+    A[dim-1][dim-1] = -1.0;
+    A[dim][dim-1]   = 5.2e-160;
+    for (i = 1; i <= dim; i++)
+      for (j = 1; j <= dim; j++)
+        B[i][j] = A[i][j];
+
+    if (m == 0) {
+      QRH(dim,dim,A,T,&(ctx->ls),1,&cond);
+      NEWTONH(dim,T,A,&(ctx->ls),u,b,1.0);
+    } else {
+      QR(dim,dim,A,T,1,&cond);
+      NEWTON(dim,T,A,u,b,1.0);
+    }
+
+    /* residuo de B u = b (NaN falha) */
+    res = 0.0;
+    for (i = 1; i <= dim; i++) {
+      aux = -b[i];
+      for (j = 1; j <= dim; j++)
+        aux += B[i][j]*u[j];
+      if (!(fabs(aux) <= res))
+        res = fabs(aux);
+    }
+    printf("%s : residual = %e\n",(m == 0) ? "QRH" : "QR ",res);
+    if (!(res <= 1.0e-12))
+      erro = 1;
+
+  }
+
+  FREECTX(ctx);
+  FREEMREAL(dim,dim,A);
+  FREEMREAL(dim,dim,B);
+  FREEMREAL(dim,dim,T);
+  FREEVREAL(dim,b);
+  FREEVREAL(dim,u);
+
+  return (erro);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
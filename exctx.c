@@ -0,0 +1,280 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : osciladores harmonicos y'' = -w^2 y         */
+/*  (n = 2, o = 1) com w passado a F e DF pelo ponteiro   */
+/*  data do contexto.                                     */
+/*                                                        */
+/*  Dois contextos (w = 1 e w = 3) sao avancados          */
+/*  alternadamente, em intervalos de s, e devem dar os    */
+/*  mesmos valores, bit a bit, que cada contexto          */
+/*  integrado sozinho. A interface antiga (ALLOCPAR e     */
+/*  GSDAE sobre o contexto global par) deve dar os mesmos */
+/*  valores que ALLOCCTX/GSDAECTX com w = 1.              */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define SEND   10.0
+#define NINT   7
+
+void FOSC ( int, int, real, mreal, vreal, void * );
+void DFOSC ( int, int, real, mreal, vreal, mmreal, void * );
+void FOSC1 ( int, int, real, mreal, vreal );
+void DFOSC1 ( int, int, real, mreal, vreal, mmreal );
+void START ( real, mreal, vreal, vint );
+
+int main ( void )
+{
+  gsdae_ctx *ctx[2];
+  int        n,o,i,j,k,l,erro,st[2];
+  real       w[2],s[2],x[2],xs[2],y0s[2],s1,x1;
+  mreal      y[2],atoly,rtoly,y1,atoly1,rtoly1;
+  vreal      ftol,ftol1;
+  vint       info[2],infoout,info1,infoout1;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n    = 2;
+  o    = 1;
+  erro = 0;
+  w[0] = 1.0;
+  w[1] = 3.0;
+
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  infoout = ALLOCVINT(2*n+10);
+  if ((atoly == NULL) || (rtoly == NULL) || (ftol == NULL) ||
+      (infoout == NULL))
+    return (1);
+  for (l = 0; l <= 1; l++) {
+    ctx[l]  = ALLOCCTX(n,o,FOSC,DFOSC,&w[l]);
+    y[l]    = ALLOCMREAL(o,n);
+    info[l] = ALLOCVINT(2*n+10);
+    if ((ctx[l] == NULL) || (y[l] == NULL) || (info[l] == NULL))
+      return (1);
+  }
+
+  /* cada contexto integrado sozinho */
+  for (l = 0; l <= 1; l++) {
+    START(w[l],y[l],ftol,info[l]);
+    s[l] = 0.0;
+    x[l] = 0.0;
+    st[l] = GSDAECTX(ctx[l],n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s[l],SEND,&x[l],
+                     y[l],1.0e-10,atoly,1.0e-8,rtoly,ftol,info[l],infoout);
+    xs[l]  = x[l];
+    y0s[l] = y[l][0][1];
+    STATISTICSCTX(ctx[l],&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,
+                  &nstart,&nfnew);
+    printf("w = %lf : erro = %d x = %.12lf y[0][1] = %.12lf "
+           "cos(w x) = %.12lf\n",w[l],st[l],x[l],y[l][0][1],cos(w[l]*x[l]));
+    printf("  Number of Steps : %d\n",npas);
+    if ((st[l] != 0) || (fabs(y[l][0][1]-cos(w[l]*x[l])) > 1.0e-5))
+      erro = 1;
+  }
+
+  /* os dois contextos avancados alternadamente */
+  for (l = 0; l <= 1; l++) {
+    START(w[l],y[l],ftol,info[l]);
+    s[l] = 0.0;
+    x[l] = 0.0;
+  }
+  for (k = 1; k <= NINT; k++)
+    for (l = 0; l <= 1; l++)
+      st[l] = GSDAECTX(ctx[l],n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s[l],
+                       SEND*k/NINT,&x[l],y[l],1.0e-10,atoly,1.0e-8,rtoly,
+                       ftol,info[l],infoout);
+
+  /* mesma solucao em SEND que a integracao de uma vez */
+  for (l = 0; l <= 1; l++) {
+    printf("alternado w = %lf : erro = %d x = %.12lf y[0][1] = %.12lf\n",
+           w[l],st[l],x[l],y[l][0][1]);
+    if ((st[l] != 0) || (fabs(x[l]-xs[l]) > 1.0e-6) ||
+        (fabs(y[l][0][1]-y0s[l]) > 1.0e-6))
+      erro = 1;
+  }
+
+  /* intervalos iguais : mesmos valores bit a bit com a ordem das */
+  /* chamadas trocada                                             */
+  for (l = 0; l <= 1; l++) {
+    START(w[l],y[l],ftol,info[l]);
+    s[l] = 0.0;
+    x[l] = 0.0;
+  }
+  for (k = 1; k <= NINT; k++)
+    for (l = 1; l >= 0; l--)
+      st[l] = GSDAECTX(ctx[l],n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s[l],
+                       SEND*k/NINT,&x[l],y[l],1.0e-10,atoly,1.0e-8,rtoly,
+                       ftol,info[l],infoout);
+  xs[0]  = x[0];
+  xs[1]  = x[1];
+  y0s[0] = y[0][0][1];
+  y0s[1] = y[1][0][1];
+  for (l = 0; l <= 1; l++) {
+    START(w[l],y[l],ftol,info[l]);
+    s[l] = 0.0;
+    x[l] = 0.0;
+    for (k = 1; k <= NINT; k++)
+      st[l] = GSDAECTX(ctx[l],n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s[l],
+                       SEND*k/NINT,&x[l],y[l],1.0e-10,atoly,1.0e-8,rtoly,
+                       ftol,info[l],infoout);
+    if ((x[l] != xs[l]) || (y[l][0][1] != y0s[l]))
+      erro = 1;
+  }
+
+  /* interface antiga com w = 1 */
+  ALLOCPAR(n,o,&y1,&atoly1,&rtoly1,&ftol1,&info1,&infoout1,FOSC1,DFOSC1);
+  if (par == NULL)
+    return (1);
+  START(1.0,y1,ftol1,info1);
+  s1 = 0.0;
+  x1 = 0.0;
+  for (k = 1; k <= NINT; k++)
+    i = GSDAE(n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s1,SEND*k/NINT,&x1,y1,
+              1.0e-10,atoly1,1.0e-8,rtoly1,ftol1,info1,infoout1);
+  printf("GSDAE w = 1.000000 : erro = %d x = %.12lf y[0][1] = %.12lf\n",
+         i,x1,y1[0][1]);
+  for (i = 0; i <= o; i++)
+    for (j = 1; j <= n; j++)
+      if (y1[i][j] != y[0][i][j])
+        erro = 1;
+  if (x1 != x[0])
+    erro = 1;
+  FREEPAR(n,o,&y1,&atoly1,&rtoly1,&ftol1,&info1,&infoout1);
+
+  printf("\n%s\n",(erro == 0) ? "exctx : ok" : "exctx : FALHOU");
+
+  for (l = 0; l <= 1; l++) {
+    FREECTX(ctx[l]);
+    FREEMREAL(o,n,y[l]);
+    FREEVINT(2*n+10,info[l]);
+  }
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* ponto inicial y = 1, y' = 0 e primeira chamada         */
+/* ****************************************************** */
+
+void
+START (
+real   w,
+mreal  y,
+vreal  ftol,
+vint   info
+)
+{
+  y[0][1] = 1.0;
+  y[0][2] = 0.0;
+  y[1][1] = 0.0;
+  y[1][2] = -w*w;
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2, y2' = -w^2 y1                            */
+/* ****************************************************** */
+
+void
+FOSC (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  real w;
+
+  w = *((real *) data);
+
+  delta[1] = y[1][1]-y[0][2];
+  delta[2] = y[1][2]+w*w*y[0][1];
+}
+
+
+
+void
+DFOSC (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  real w;
+  int  i,j,k;
+
+  w = *((real *) data);
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  DFx[1] = 0.0;
+  DFx[2] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  DFy[1][1][1] = 1.0;
+  DFy[0][2][1] = -1.0;
+  DFy[1][2][2] = 1.0;
+  DFy[0][1][2] = w*w;
+}
+
+
+
+/* ****************************************************** */
+/* F e DF da interface antiga (w = 1)                     */
+/* ****************************************************** */
+
+void
+FOSC1 (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta
+)
+{
+  real w;
+
+  w = 1.0;
+  FOSC(o,n,x,y,delta,&w);
+}
+
+
+
+void
+DFOSC1 (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy
+)
+{
+  real w;
+
+  w = 1.0;
+  DFOSC(o,n,x,y,DFx,DFy,&w);
+}
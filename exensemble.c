@@ -0,0 +1,210 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : m = 40 osciladores harmonicos y'' = -w^2 y  */
+/*  (n = 2, o = 1) integrados por GSDAEENSEMBLE com       */
+/*  grupos de 1 instancia, de 8 instancias (fatoracao     */
+/*  densa do grupo) e com o grupo padrao (LU esparsa),    */
+/*  com a jacobiana DF e por diferencas finitas. As       */
+/*  ultimas instancias tem outro ponto final, o que       */
+/*  fecha um grupo antes de w instancias.                 */
+/*                                                        */
+/*  Em todos os casos y[0][1] deve ser cos(w x) com x o   */
+/*  ponto final xend de cada instancia, e s o comprimento */
+/*  de arco percorrido (positivo); send nao e usado.      */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define M      40
+#define MEND   36
+#define X0     1.0
+
+void FOSCW ( int, int, int, real, mreal, vreal, void ** );
+void DFOSCW ( int, int, int, real, mreal, vreal, mmreal, void ** );
+int  INITINST ( gsdae_inst *, vreal );
+void FREEINST ( gsdae_inst * );
+
+int main ( void )
+{
+  gsdae_inst  inst[M];
+  vreal       w;
+  int         i,j,l,erro,nerr,jac;
+  int         wl[3];
+  real        err;
+
+  erro  = 0;
+  wl[0] = 1;
+  wl[1] = 8;
+  wl[2] = 0;
+
+  w = ALLOCVREAL(M);
+  if (w == NULL)
+    return (1);
+  for (i = 1; i <= M; i++)
+    w[i] = 0.5+0.05*(real) i;
+
+  for (jac = 1; jac >= 0; jac--)
+    for (j = 0; j <= 2; j++) {
+
+      if (INITINST(inst,w) != 0)
+        return (1);
+      for (i = 0; i < M; i++)
+        inst[i].info[2] = jac;
+
+      nerr = GSDAEENSEMBLE(2,1,M,inst,FOSCW,(jac == 1) ? DFOSCW : NULL,
+                           wl[j]);
+
+      /* erro maximo em relacao a cos(w x) */
+      err = 0.0;
+      for (l = 0; l < M; l++) {
+        if ((inst[l].status != 0) ||
+            (fabs(inst[l].x-inst[l].xend) > 1.0e-8) || !(inst[l].s > 0.0))
+          erro = 1;
+        if (!(fabs(inst[l].y[0][1]-cos(w[l+1]*inst[l].x)) <= err))
+          err = fabs(inst[l].y[0][1]-cos(w[l+1]*inst[l].x));
+      }
+      if ((nerr != 0) || !(err <= 1.0e-5))
+        erro = 1;
+
+      printf("%s w = %d : %d instancias com erro, erro maximo = %e, "
+             "Number of Steps : %d\n",(jac == 1) ? "DF        " :
+             "DF aprox. ",wl[j],nerr,err,inst[0].nstep);
+
+      FREEINST(inst);
+    }
+
+  printf("\n%s\n",(erro == 0) ? "exensemble : ok" : "exensemble : FALHOU");
+
+  FREEVREAL(M,w);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* instancias : y = cos(w x) em x = X0, xend = X0+4 (ou   */
+/* X0+5 a partir de MEND)                                 */
+/* ****************************************************** */
+
+int
+INITINST (
+gsdae_inst *in,
+vreal       w
+)
+{
+  int i;
+
+  for (i = 0; i < M; i++) {
+    in[i].h       = 1.0e-6;
+    in[i].hmin    = 1.0e-16;
+    in[i].hmax    = 0.0;
+    in[i].cdmax   = 1.0e50;
+    in[i].send    = 0.0;
+    in[i].xend    = X0+((i < MEND) ? 4.0 : 5.0);
+    in[i].atolx   = 1.0e-10;
+    in[i].rtolx   = 1.0e-8;
+    in[i].atoly   = ALLOCMREAL(1,2);
+    in[i].rtoly   = ALLOCMREAL(1,2);
+    in[i].y       = ALLOCMREAL(1,2);
+    in[i].ftol    = ALLOCVREAL(2);
+    in[i].info    = ALLOCVINT(2*2+10);
+    if ((in[i].atoly == NULL) || (in[i].rtoly == NULL) ||
+        (in[i].y == NULL) || (in[i].ftol == NULL) || (in[i].info == NULL))
+      return (1);
+    in[i].data    = &w[i+1];
+    in[i].s       = 0.0;
+    in[i].x       = X0;
+    in[i].y[0][1] = cos(w[i+1]*X0);
+    in[i].y[0][2] = -w[i+1]*sin(w[i+1]*X0);
+    in[i].y[1][1] = in[i].y[0][2];
+    in[i].y[1][2] = -w[i+1]*w[i+1]*in[i].y[0][1];
+    in[i].ftol[1] = 1.0e-6;
+    in[i].info[3] = 1;
+  }
+
+  return (0);
+}
+
+
+
+void
+FREEINST (
+gsdae_inst *in
+)
+{
+  int i;
+
+  for (i = 0; i < M; i++) {
+    FREEMREAL(1,2,in[i].atoly);
+    FREEMREAL(1,2,in[i].rtoly);
+    FREEMREAL(1,2,in[i].y);
+    FREEVREAL(2,in[i].ftol);
+    FREEVINT(2*2+10,in[i].info);
+  }
+}
+
+
+
+/* ****************************************************** */
+/* F do grupo : y1' = y2, y2' = -w^2 y1 em cada instancia */
+/* l, com y[k][(i-1)*nw+l]                                */
+/* ****************************************************** */
+
+void
+FOSCW (
+int    o,
+int    n,
+int    nw,
+real   x,
+mreal  y,
+vreal  delta,
+void **data
+)
+{
+  int  l;
+  real w;
+
+  for (l = 1; l <= nw; l++) {
+    w = *((real *) data[l]);
+    delta[l]    = y[1][l]-y[0][nw+l];
+    delta[nw+l] = y[1][nw+l]+w*w*y[0][l];
+  }
+}
+
+
+
+void
+DFOSCW (
+int    o,
+int    n,
+int    nw,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void **data
+)
+{
+  int  i,j,k,l;
+  real w;
+
+  for (k = 0; k <= o; k++)
+    for (j = 1; j <= n; j++)
+      for (i = 1; i <= n*nw; i++)
+        DFy[k][j][i] = 0.0;
+  for (i = 1; i <= n*nw; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao intercalada] */
+  for (l = 1; l <= nw; l++) {
+    w = *((real *) data[l]);
+    DFy[1][1][l]    = 1.0;
+    DFy[0][2][l]    = -1.0;
+    DFy[1][2][nw+l] = 1.0;
+    DFy[0][1][nw+l] = w*w;
+  }
+}
@@ -1,14 +1,13 @@
 #include "gsdae.h"
 
-void main ( void );
+int  main ( void );
 void FESF ( int, int, real, mreal, vreal );
 void DFESF ( int, int, real, mreal, vreal, mmreal );
 
-void main ( )
+int main ( void )
 {
   int        n;
-  int        q;
-  int        r;
+  int        o;
   real       h;
   real       hmin;
   real       hmax;
@@ -22,18 +21,20 @@ void main ( )
   vreal      FTOL;
   mreal      y;
   vint       info;
+  vint       infoout;
   char       msg[250];
   real       s,sout,soutp,ds;
 
-  int        erro,i,j,k,t;
+  int        erro,i,j,t;
   real       len;
-  int        npas,nreject,nsuc,nfnew,nfunc,njac,nqr;
+  int        npas,nreject,nsuc,nfnew,nfunc,njac,nqr,nstart;
 
   n = 1;
-  r = 1;
-  q = 0;
+  o = 0;
 
-  ALLOCPAR(n,q,r,&y,&ATOLY,&RTOLY,&FTOL,&info,FESF,DFESF);
+  ALLOCPAR(n,o,&y,&ATOLY,&RTOLY,&FTOL,&info,&infoout,FESF,DFESF);
+  if (par == NULL)
+    return (1);
 
   hmin   = 1.0e-16;
   hmax   = 0.0;
@@ -41,14 +42,15 @@ void main ( )
   ATOLX = 1.0e-15;
   RTOLX = 1.0e-8;
   for (i = 1; i <= n; i++) {
-    for (j = 0; j <= q; j++) {
-      ATOLY[j][i] = 1.0e-15; 
+    for (j = 0; j <= o; j++) {
+      ATOLY[j][i] = 1.0e-15;
       RTOLY[j][i] = 1.0e-8;
     }
     FTOL[i] = 1.0e-6;
   }
   info[1] = 0;
   info[2] = 1;
+  info[3] = 1;
   h         = 1.0e-15;
   s         = 0.0;
   sout      = 6.5;
@@ -62,14 +64,12 @@ void main ( )
   erro = 0;
   soutp  = s;
 
-  printf("s = %14.16lf \n",s); 
-  printf("x = %14.16lf \n",x); 
-  for (i = 0; i <= q-1; i++)
+  printf("s = %14.16lf \n",s);
+  printf("x = %14.16lf \n",x);
+  for (i = 0; i <= o; i++)
     for (j = 1; j <= n; j++)
-      printf("y[%d][%d] = %14.16lf \n",i,j,y[i][j]); 
-  for (j = 1; j <= r; j++)
-    printf("y[%d][%d] = %14.16lf \n",q,j,y[q][j]); 
-  printf("\n\n"); 
+      printf("y[%d][%d] = %14.16lf \n",i,j,y[i][j]);
+  printf("\n\n");
 
   for (t = 1; (t <= m) && (erro >= 0); t++) {
 
@@ -77,24 +77,22 @@ void main ( )
 
     do {
 
-      erro = GSDAE (n,q,r,h,hmin,hmax,cdmax,&s,soutp,&x,y,
-                    ATOLX,ATOLY,RTOLX,RTOLY,FTOL,info);
+      erro = GSDAE(n,o,h,hmin,hmax,cdmax,&s,soutp,&x,y,
+                   ATOLX,ATOLY,RTOLX,RTOLY,FTOL,info,infoout);
 
-      printf("s = %14.16lf \n",s); 
-      printf("x = %14.16lf \n",x); 
-      for (i = 0; i <= q-1; i++)
+      printf("s = %14.16lf \n",s);
+      printf("x = %14.16lf \n",x);
+      for (i = 0; i <= o; i++)
         for (j = 1; j <= n; j++)
-          printf("y[%d][%d] = %14.16lf \n",i,j,y[i][j]); 
-      for (j = 1; j <= r; j++)
-        printf("y[%d][%d] = %14.16lf \n",q,j,y[q][j]); 
-      printf("\n\n"); 
+          printf("y[%d][%d] = %14.16lf \n",i,j,y[i][j]);
+      printf("\n\n");
 
     } while (erro == 1);
 
   }
 
-  ERROR(erro,msg);
-  STATISTIC(&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nfnew);
+  STATUS(erro,msg);
+  STATISTICS(&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,&nfnew);
 
   printf("\n\nError menssage\n\n");
   printf("%s\n",msg);
@@ -108,30 +106,38 @@ void main ( )
   printf("Number of Evaluation of the Jacobian : %d\n",njac);
   printf("Number of QR Decomposition : %d\n",nqr);
 
-  FREEPAR(n,q,r,&y,&ATOLY,&RTOLY,&FTOL,&info);
+  /* o ponto final deve estar sobre a circunferencia */
+  if (fabs(x*x+y[0][1]*y[0][1]-1.0) > 1.0e-6)
+    erro = -1;
 
-  return;
+  FREEPAR(n,o,&y,&ATOLY,&RTOLY,&FTOL,&info,&infoout);
+
+  return ((erro >= 0) ? 0 : 1);
 }
 
 
-void FESF( q, n, x, y, delta )
-int    q;
-int    n;
-real   x;
-mreal  y;
-vreal delta ;
+void
+FESF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta
+)
 {
   delta[1] = x*x + y[0][1]*y[0][1] - 1.0;
 }
 
 
-void DFESF( q, n, x, y, DFx, DFy )
-int    q;
-int    n;
-real   x;
-mreal  y;
-vreal  DFx;
-mmreal DFy;
+void
+DFESF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy
+)
 {
   DFx[1]       = 2.0*x;
   DFy[0][1][1] = 2.0*y[0][1];
@@ -0,0 +1,257 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) integrada com a jacobiana   */
+/*  aproximada, com F avaliada ponto a ponto e por lotes  */
+/*  (SETFBATCH, com lotes de GSDAE_FBMAX e de 5 pontos),  */
+/*  com e sem o padrao de DFy (SETPATTERN).               */
+/*                                                        */
+/*  Como Fb calcula os mesmos valores que F, os           */
+/*  resultados com e sem Fb devem ser iguais bit a bit, e */
+/*  com Fb as colunas das jacobianas nao devem mais       */
+/*  chamar F : as chamadas de F que restam (corretor e    */
+/*  ponto central) nao dependem de mmax.                  */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      20
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void FBCHAIN ( int, int, int, vreal, mmreal, mreal, void * );
+void RCHAIN ( int, real, mreal, vreal );
+int  INTEGRATE ( int, int, int, real *, mreal, int * );
+
+int main ( void )
+{
+  int   erro,pat,mode,i,k;
+  int   ncall[3][2];
+  real  x[3];
+  mreal y[3];
+
+  erro = 0;
+  for (mode = 0; mode <= 2; mode++) {
+    y[mode] = ALLOCMREAL(1,N);
+    if (y[mode] == NULL)
+      return (1);
+  }
+
+  for (pat = 0; pat <= 1; pat++) {
+
+    /* mode = 0 : F, 1 : Fb com GSDAE_FBMAX, 2 : Fb com 5 pontos */
+    for (mode = 0; mode <= 2; mode++)
+      if (INTEGRATE(pat,mode,(mode == 2) ? 5 : 0,&x[mode],y[mode],
+                    ncall[mode]) != 0)
+        erro = 1;
+
+    /* mesmos valores bit a bit */
+    for (mode = 1; mode <= 2; mode++) {
+      if (x[mode] != x[0])
+        erro = 1;
+      for (k = 0; k <= 1; k++)
+        for (i = 1; i <= N; i++)
+          if (y[mode][k][i] != y[0][k][i])
+            erro = 1;
+    }
+
+    /* as colunas passam para Fb : as chamadas de F que restam */
+    /* nao dependem de mmax e lotes menores pedem mais Fb      */
+    if ((ncall[1][1] == 0) || (ncall[1][0] >= ncall[0][0]) ||
+        (ncall[2][0] != ncall[1][0]) || (ncall[2][1] < ncall[1][1]))
+      erro = 1;
+
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exfbatch : ok" : "exfbatch : FALHOU");
+
+  for (mode = 0; mode <= 2; mode++)
+    FREEMREAL(1,N,y[mode]);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com a jacobiana       */
+/* aproximada; pat = 1 informa o padrao de DFy, mode > 0  */
+/* informa Fb com lotes de mmax pontos. ncall[0] e        */
+/* ncall[1] sao os numeros de chamadas de F e de Fb       */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   pat,
+int   mode,
+int   mmax,
+real *xf,
+mreal yf,
+int  *ncall
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,nnz,erro,cont;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout,ia,ja;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ncall[0] = 0;
+  ncall[1] = 0;
+  ctx      = ALLOCCTX(n,o,FCHAIN,NULL,ncall);
+  y        = ALLOCMREAL(o,n);
+  atoly    = ALLOCMREAL(o,n);
+  rtoly    = ALLOCMREAL(o,n);
+  ftol     = ALLOCVREAL(n);
+  info     = ALLOCVINT(2*n+10);
+  infoout  = ALLOCVINT(2*n+10);
+  ia       = ALLOCVINT(n+1);
+  ja       = ALLOCVINT(3*n);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (ia == NULL) || (ja == NULL))
+    return (1);
+
+  /* padrao de DFy por equacoes */
+  if (pat == 1) {
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+    if (SETPATTERN(ctx,nnz,ia,ja) != 0)
+      return (1);
+  }
+
+  if ((mode > 0) && (SETFBATCH(ctx,FBCHAIN,mmax) != 0))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 0;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  cont = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++cont < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s %s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (pat == 1) ? "SETPATTERN" : "          ",
+         (mode == 0) ? "F            " :
+         (mode == 1) ? "Fb           " : "Fb (mmax = 5)",erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Calls of F : %d  Calls of Fb : %d\n",
+         npas,ncall[0],ncall[1]);
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F e Fb : data aponta para os contadores de chamadas    */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  ((int *) data)[0]++;
+
+  RCHAIN(n,x,y,delta);
+}
+
+
+
+void
+FBCHAIN (
+int    o,
+int    n,
+int    m,
+vreal  xs,
+mmreal ys,
+mreal  fs,
+void  *data
+)
+{
+  int l;
+
+  ((int *) data)[1]++;
+
+  for (l = 1; l <= m; l++)
+    RCHAIN(n,xs[l],ys[l],fs[l]);
+}
+
+
+
+/* ****************************************************** */
+/* residuo : y1' = y2 - 0.01 y1^3 - 0.001 sin(x)          */
+/* exp(-y1^2), y2' = -y1 - 0.01 (y1 - y1 do oscilador     */
+/* anterior)                                              */
+/* ****************************************************** */
+
+void
+RCHAIN (
+int    n,
+real   x,
+mreal  y,
+vreal  delta
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
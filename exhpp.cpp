@@ -0,0 +1,327 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) integrada pela interface    */
+/*  C++ (gsdae.hpp) com F e DF em funcoes lambda, com e   */
+/*  sem DF, e pela interface C (ALLOCCTX e GSDAECTX) com  */
+/*  as mesmas opcoes. Sem DF as colunas sao avaliadas em  */
+/*  lotes (SETFBATCH) ou divididas entre 4 threads        */
+/*  (threads e SETTHREADS).                               */
+/*                                                        */
+/*  Os resultados das duas interfaces devem ser iguais    */
+/*  bit a bit, inclusive quando o integrador e movido     */
+/*  para outro objeto no meio da integracao, e com as     */
+/*  threads devem ser iguais aos obtidos com os lotes.    */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.hpp"
+
+#include <cstdio>
+
+#define N      20
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATEC ( int, real *, mreal );
+void START ( mreal );
+
+/* ****************************************************** */
+/* integracao pela interface C++ : sv avanca ate SEND/2,  */
+/* e movido para outro integrador e segue ate SEND        */
+/* ****************************************************** */
+
+template <class Solver>
+int
+INTEGRATECPP (
+Solver &sv,
+real   *xf,
+mreal   yf
+)
+{
+  int erro, cont;
+
+  START(sv.y());
+  sv.tolerances(1.0e-9,1.0e-7,1.0e-6);
+
+  cont = 0;
+  do
+    erro = sv.advance(SEND/2.0);
+  while ((erro > 0) && (++cont < 100));
+
+  Solver sv2(std::move(sv));
+
+  cont = 0;
+  do
+    erro = sv2.advance(SEND);
+  while ((erro > 0) && (++cont < 100));
+
+  *xf = sv2.x();
+  for (int k = 0; k <= 1; k++)
+    for (int i = 1; i <= N; i++)
+      yf[k][i] = sv2.y(k,i);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+int main ( void )
+{
+  int   erro,mode,k,i;
+  real  x[3];
+  mreal y[3];
+
+  auto F  = [] (int o, int n, real x, mreal y, vreal delta)
+            { FCHAIN(o,n,x,y,delta,NULL); };
+  auto DF = [] (int o, int n, real x, mreal y, vreal DFx, mmreal DFy)
+            { DFCHAIN(o,n,x,y,DFx,DFy,NULL); };
+
+  erro = 0;
+  y[0] = ALLOCMREAL(1,N);
+  y[1] = ALLOCMREAL(1,N);
+  y[2] = ALLOCMREAL(1,N);
+  if ((y[0] == NULL) || (y[1] == NULL) || (y[2] == NULL))
+    return (1);
+
+  /* mode = 0 : DF aproximada em lotes, 1 : DF, */
+  /* 2 : DF aproximada com 4 threads            */
+  for (mode = 0; mode <= 2; mode++) {
+
+    /* interface C */
+    if (INTEGRATEC(mode,&x[0],y[0]) != 0)
+      erro = 1;
+
+    /* interface C++ */
+    if (mode == 1) {
+      gsdae::solver<decltype(F),decltype(DF)> sv(N,1,F,DF);
+      if (INTEGRATECPP(sv,&x[1],y[1]) != 0)
+        erro = 1;
+    } else {
+      gsdae::solver<decltype(F)> sv(N,1,F);
+      /* com as threads a versao em lotes deve ser retirada */
+      if ((mode == 2) &&
+          ((sv.threads(4) != 0) || (sv.ctx()->ls.fb != NULL) ||
+           (sv.ctx()->ls.fd == NULL)))
+        erro = 1;
+      if (INTEGRATECPP(sv,&x[1],y[1]) != 0)
+        erro = 1;
+    }
+
+    printf("%s : C   x = %.12lf y[0][1] = %.12lf\n",
+           (mode == 1) ? "DF               " :
+           (mode == 0) ? "DF aprox. lotes  " : "DF aprox. threads",
+           x[0],y[0][0][1]);
+    printf("%s : C++ x = %.12lf y[0][1] = %.12lf\n",
+           (mode == 1) ? "DF               " :
+           (mode == 0) ? "DF aprox. lotes  " : "DF aprox. threads",
+           x[1],y[1][0][1]);
+
+    /* mesmos valores bit a bit */
+    if (x[1] != x[0])
+      erro = 1;
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (y[1][k][i] != y[0][k][i])
+          erro = 1;
+
+    /* threads e lotes dao os mesmos valores bit a bit */
+    if (mode == 0) {
+      x[2] = x[0];
+      for (k = 0; k <= 1; k++)
+        for (i = 1; i <= N; i++)
+          y[2][k][i] = y[0][k][i];
+    } else if (mode == 2) {
+      if (x[2] != x[0])
+        erro = 1;
+      for (k = 0; k <= 1; k++)
+        for (i = 1; i <= N; i++)
+          if (y[2][k][i] != y[0][k][i])
+            erro = 1;
+    }
+
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exhpp : ok" : "exhpp : FALHOU");
+
+  FREEMREAL(1,N,y[0]);
+  FREEMREAL(1,N,y[1]);
+  FREEMREAL(1,N,y[2]);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao pela interface C com as opcoes da classe    */
+/* (F em lotes com GSDAE_FBMAX pontos ou, com mode = 2,   */
+/* colunas divididas entre 4 threads)                     */
+/* ****************************************************** */
+
+void
+FBCHAIN (
+int    o,
+int    n,
+int    m,
+vreal  xs,
+mmreal ys,
+mreal  fs,
+void  *data
+)
+{
+  int l;
+
+  for (l = 1; l <= m; l++)
+    FCHAIN(o,n,xs[l],ys[l],fs[l],data);
+}
+
+int
+INTEGRATEC (
+int   mode,
+real *xf,
+mreal yf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,erro,cont;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,(mode == 1) ? DFCHAIN : NULL,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      ((mode != 2) && (SETFBATCH(ctx,FBCHAIN,0) != 0)) ||
+      ((mode == 2) && (SETTHREADS(ctx,4) != 0)))
+    return (1);
+
+  START(y);
+  info[1] = 0;
+  info[2] = (mode == 1);
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  cont = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND/2.0,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++cont < 100));
+  cont = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++cont < 100));
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+void
+START (
+mreal y
+)
+{
+  int i;
+
+  for (i = 1; i <= N; i += 2) {
+    y[0][i]   =  1.0;
+    y[0][i+1] =  0.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
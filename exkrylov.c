@@ -0,0 +1,367 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores de Van der Pol    */
+/*  acoplados (n = 40, o = 1, mu = 5) integrada com DH    */
+/*  completa (ALLOCCTX) e com o corretor de Newton-Krylov */
+/*  (ALLOCCTXKRYLOV), com produtos DF v por diferencas    */
+/*  finitas de F e pela rotina JV, e com o GMRES          */
+/*  precondicionado pelo bloco-Jacobi e pela ILU(0)       */
+/*  internos (SETPRECONDKIND) e pelas rotinas setup e     */
+/*  solve deste exemplo (SETPRECOND), que invertem os     */
+/*  blocos 2 x 2 de G de cada oscilador.                  */
+/*                                                        */
+/*  O corretor de Krylov deve chegar ao mesmo ponto com   */
+/*  um numero de passos proximo ao da DH completa : um    */
+/*  termo forcante frouxo demais para o teste de          */
+/*  convergencia de masterstep faz metade dos passos      */
+/*  falhar no corretor. Com os precondicionadores o setup */
+/*  deve ser chamado e o ponto final deve ser o mesmo.    */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      40
+#define MU     5.0
+#define SEND   30.0
+#define NMODE  5
+
+/* precondicionador do usuario : blocos 2 x 2 de G, com  */
+/* G[i][j] em g[i][j-i0+1], i0 a primeira linha do bloco */
+typedef struct {
+  mreal g;
+  int   nsetup;
+} pcvdp;
+
+void FVDP ( int, int, real, mreal, vreal, void * );
+void DFVDP ( int, int, real, mreal, vreal, mmreal, void * );
+void JVVDP ( int, int, real, mreal, real, mreal, vreal, void * );
+int  PCSETUPVDP ( real, real, pcstate *, void * );
+void PCSOLVEVDP ( int, vreal, void * );
+int  INTEGRATE ( int, real *, real *, int * );
+
+int main ( void )
+{
+  int  erro,mode,npas[NMODE+1];
+  real x[NMODE+1],y1[NMODE+1];
+
+  erro = 0;
+  for (mode = 0; mode <= NMODE; mode++)
+    if (INTEGRATE(mode,&x[mode],&y1[mode],&npas[mode]) != 0)
+      erro = 1;
+
+  /* mesmo ponto final e passos proximos aos da DH completa */
+  for (mode = 1; (mode <= NMODE) && (erro == 0); mode++) {
+    if (fabs(x[mode]-x[0]) > 1.0e-6)
+      erro = 1;
+    if (fabs(y1[mode]-y1[0]) > 1.0e-6)
+      erro = 1;
+    if (npas[mode] > 3*npas[0]/2)
+      erro = 1;
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exkrylov : ok" : "exkrylov : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND                       */
+/* mode = 0 : DH completa, 1 : Krylov com DF v por        */
+/* diferencas finitas, 2 : Krylov com JV, 3 : Krylov com  */
+/* JV e bloco-Jacobi, 4 : Krylov com JV e ILU(0), 5 :     */
+/* Krylov com JV e o precondicionador do usuario          */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   mode,
+real *xf,
+real *y1f,
+int  *npasf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,nnz,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol,delta;
+  vint       info,infoout,ia,ja;
+  pcvdp      pc;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  if (mode == 0)
+    ctx = ALLOCCTX(n,o,FVDP,DFVDP,NULL);
+  else
+    ctx = ALLOCCTXKRYLOV(n,o,FVDP,(mode >= 2) ? JVVDP : NULL,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  delta   = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  ia      = ALLOCVINT(n+1);
+  ja      = ALLOCVINT(3*n);
+  pc.g    = ALLOCMREAL(n,2);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (delta == NULL) || (info == NULL) ||
+      (infoout == NULL) || (ia == NULL) || (ja == NULL) || (pc.g == NULL))
+    return (1);
+
+  /* precondicionadores : o bloco-Jacobi com blocos 2 x 2 */
+  /* (um oscilador), a ILU(0) no padrao de DFy e o do     */
+  /* usuario                                              */
+  pc.nsetup = 0;
+  if ((mode == 3) && (SETPRECONDKIND(ctx,GSDAE_PCBJ,2) != 0))
+    return (1);
+  if (mode == 4) {
+    /* padrao por equacoes : a equacao i usa y[.][i] e    */
+    /* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]      */
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+    if ((SETPATTERN(ctx,nnz,ia,ja) != 0) ||
+        (SETPRECONDKIND(ctx,GSDAE_PCILU,0) != 0))
+      return (1);
+  }
+  if ((mode == 5) && (SETPRECOND(ctx,PCSETUPVDP,PCSOLVEVDP,&pc) != 0))
+    return (1);
+
+  /* ponto inicial consistente : y[1] = y[1] - F(x,y) com y[1] = 0 */
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   = 2.0;
+    y[0][i+1] = 0.0;
+  }
+  FVDP(o,n,0.0,y,delta,NULL);
+  for (i = 1; i <= n; i++)
+    y[1][i] = -delta[i];
+
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-12,atoly,1.0e-10,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (s < SEND));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (mode == 0) ? "DH completa        " :
+         (mode == 1) ? "Krylov (F)         " :
+         (mode == 2) ? "Krylov (JV)        " :
+         (mode == 3) ? "Krylov (JV, PCBJ)  " :
+         (mode == 4) ? "Krylov (JV, PCILU) " : "Krylov (JV, setup) ",
+         erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Newton Fail : %d\n",
+         npas,nreject,nfnew);
+  if (mode >= 3)
+    printf("  GMRES iterations : %d  Preconditioner setups : %d\n",
+           ctx->ls.kr->nli,ctx->ls.kr->npc);
+
+  /* o precondicionador deve ter sido montado */
+  if ((mode >= 3) && (ctx->ls.kr->npc == 0))
+    erro = 1;
+  if ((mode == 5) && (pc.nsetup == 0))
+    erro = 1;
+
+  *xf    = x;
+  *y1f   = y[0][1];
+  *npasf = npas;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVREAL(n,delta);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+  FREEMREAL(n,2,pc.g);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2, y2' = mu (1 - y1^2) y2 - y1 - 0.1 (y1 -  */
+/*     y1 do oscilador anterior)                          */
+/* ****************************************************** */
+
+void
+FVDP (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1];
+    delta[i+1] = y[1][i+1]-MU*(1.0-y[0][i]*y[0][i])*y[0][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.1*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFVDP (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int i,j,k;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i+1][i+1]   = -MU*(1.0-y[0][i]*y[0][i]);
+    DFy[0][i][i+1]     = 2.0*MU*y[0][i]*y[0][i+1]+1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.1;
+      DFy[0][i-2][i+1] -= 0.1;
+    }
+  }
+}
+
+
+
+/* ****************************************************** */
+/* jv = DFx vx + DFy[0] vy[0] + DFy[1] vy[1]              */
+/* ****************************************************** */
+
+void
+JVVDP (
+int    o,
+int    n,
+real   x,
+mreal  y,
+real   vx,
+mreal  vy,
+vreal  jv,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    jv[i]   = vy[1][i]-vy[0][i+1];
+    jv[i+1] = vy[1][i+1]-MU*(1.0-y[0][i]*y[0][i])*vy[0][i+1]+
+              (2.0*MU*y[0][i]*y[0][i+1]+1.0)*vy[0][i];
+    if (i > 1)
+      jv[i+1] += 0.1*(vy[0][i]-vy[0][i-2]);
+  }
+}
+
+
+
+/* ****************************************************** */
+/* setup : blocos 2 x 2 de G = DFy[1] + rho DFy[0] de     */
+/* cada oscilador no ponto (st->x,st->y), sem o           */
+/* acoplamento com o oscilador anterior                   */
+/* ****************************************************** */
+
+int
+PCSETUPVDP (
+real     cj,
+real     h,
+pcstate *st,
+void    *pdata
+)
+{
+  pcvdp *pc;
+  mreal  y;
+  real   rho;
+  int    i;
+
+  pc  = (pcvdp *) pdata;
+  y   = st->y;
+  rho = st->rho;
+
+  for (i = 1; i <= st->n; i += 2) {
+    pc->g[i][1]   = 1.0;
+    pc->g[i][2]   = -rho;
+    pc->g[i+1][1] = rho*(2.0*MU*y[0][i]*y[0][i+1]+1.0);
+    pc->g[i+1][2] = 1.0-rho*MU*(1.0-y[0][i]*y[0][i]);
+    if (i > 1)
+      pc->g[i+1][1] += 0.1*rho;
+    if (pc->g[i][1]*pc->g[i+1][2]-pc->g[i][2]*pc->g[i+1][1] == 0.0)
+      return (1);
+  }
+  (pc->nsetup)++;
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* solve : rhs <- P^(-1) rhs com os blocos de setup       */
+/* ****************************************************** */
+
+void
+PCSOLVEVDP (
+int    n,
+vreal  rhs,
+void  *pdata
+)
+{
+  pcvdp *pc;
+  real   det,r1,r2;
+  int    i;
+
+  pc = (pcvdp *) pdata;
+
+  for (i = 1; i <= n; i += 2) {
+    det      = pc->g[i][1]*pc->g[i+1][2]-pc->g[i][2]*pc->g[i+1][1];
+    r1       = rhs[i];
+    r2       = rhs[i+1];
+    rhs[i]   = ( pc->g[i+1][2]*r1-pc->g[i][2]*r2)/det;
+    rhs[i+1] = (-pc->g[i+1][1]*r1+pc->g[i][1]*r2)/det;
+  }
+}
@@ -0,0 +1,232 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) integrada com a jacobiana   */
+/*  DF, com DH decomposta sempre por QR                   */
+/*  (infoinput[7] = 0) e por LU longe de cdmax            */
+/*  (infoinput[7] = 1, STATISTICSLUCTX).                  */
+/*                                                        */
+/*  Com cdmax = 1.0e50 todas as decomposicoes apos a      */
+/*  primeira sao LU. Com cdmax = CDSW o limite da LU,     */
+/*  GSDAE_LUFRAC*cdmax, fica entre as condicoes           */
+/*  estimadas ao longo da integracao (0.44 e 0.48), e a   */
+/*  LU volta a QR pelo menos uma vez. Em todos os casos   */
+/*  os passos devem ser os mesmos da QR e o ponto final   */
+/*  deve coincidir ate o arredondamento.                  */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      20
+#define SEND   20.0
+#define CDSW   460.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int, real, real *, mreal, int *, int *, int * );
+
+int main ( void )
+{
+  int   erro,lu,c,k,i;
+  int   npas[2],nlu[2],nsw[2];
+  real  x[2],cdmax[2],dmax;
+  mreal y[2];
+
+  erro     = 0;
+  cdmax[0] = 1.0e50;
+  cdmax[1] = CDSW;
+  y[0]     = ALLOCMREAL(1,N);
+  y[1]     = ALLOCMREAL(1,N);
+  if ((y[0] == NULL) || (y[1] == NULL))
+    return (1);
+
+  for (c = 0; c <= 1; c++) {
+
+    /* lu = 0 : QR, 1 : LU */
+    for (lu = 0; lu <= 1; lu++)
+      if (INTEGRATE(lu,cdmax[c],&x[lu],y[lu],&npas[lu],&nlu[lu],
+                    &nsw[lu]) != 0)
+        erro = 1;
+
+    /* mesmos passos e mesmo ponto final ate o arredondamento */
+    dmax = fabs(x[1]-x[0]);
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (!(fabs(y[1][k][i]-y[0][k][i]) <= dmax))
+          dmax = fabs(y[1][k][i]-y[0][k][i]);
+    printf("cdmax = %.1e : |LU - QR| = %e\n\n",cdmax[c],dmax);
+    if ((npas[1] != npas[0]) || !(dmax <= 1.0e-9))
+      erro = 1;
+
+    /* LU utilizada e, com cdmax = CDSW, troca de LU para QR */
+    if (nlu[1] == 0)
+      erro = 1;
+    if ((c == 1) && (nsw[1] < 2))
+      erro = 1;
+
+  }
+
+  printf("%s\n",(erro == 0) ? "exlu : ok" : "exlu : FALHOU");
+
+  FREEMREAL(1,N,y[0]);
+  FREEMREAL(1,N,y[1]);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com DF; lu =          */
+/* infoinput[7]. npasf e o numero de passos, nluf e nswf  */
+/* os contadores de STATISTICSLUCTX                       */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   lu,
+real  cdmax,
+real *xf,
+mreal yf,
+int  *npasf,
+int  *nluf,
+int  *nswf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,l,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  info[7] = lu;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,cdmax,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  STATISTICSLUCTX(ctx,nluf,nswf);
+  printf("%s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (lu == 1) ? "LU" : "QR",erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Decompositions : %d  LU : %d  "
+         "LU <-> QR : %d\n",npas,nqr,*nluf,*nswf);
+
+  *xf    = x;
+  *npasf = npas;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
@@ -0,0 +1,231 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 80, o = 1) integrada com a jacobiana   */
+/*  DF em contextos alocados por ALLOCCTXMODE nos tres    */
+/*  modos de alocacao : GSDAE_MALLOC (um malloc por       */
+/*  linha), GSDAE_ARENA (um bloco alinhado) e GSDAE_HUGE  */
+/*  (um bloco em paginas grandes, quando disponiveis).    */
+/*                                                        */
+/*  O modo muda apenas o lugar das linhas das matrizes,   */
+/*  por isso as tres integracoes devem ser identicas bit  */
+/*  a bit : mesmo x, mesmo y, mesmos numeros de passos,   */
+/*  rejeicoes e avaliacoes de F e DF.                     */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      80
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int, real *, mreal, vint );
+
+int main ( void )
+{
+  int   erro,mode,i,k;
+  real  x[3];
+  mreal y[3];
+  vint  stat[3];
+
+  erro = 0;
+  for (mode = 0; mode <= 2; mode++) {
+    y[mode]    = ALLOCMREAL(1,N);
+    stat[mode] = ALLOCVINT(4);
+    if ((y[mode] == NULL) || (stat[mode] == NULL))
+      return (1);
+  }
+  if ((INTEGRATE(GSDAE_MALLOC,&x[0],y[0],stat[0]) != 0) ||
+      (INTEGRATE(GSDAE_ARENA,&x[1],y[1],stat[1]) != 0) ||
+      (INTEGRATE(GSDAE_HUGE,&x[2],y[2],stat[2]) != 0))
+    erro = 1;
+
+  /* integracoes identicas bit a bit */
+  for (mode = 1; (mode <= 2) && (erro == 0); mode++) {
+    if (x[mode] != x[0])
+      erro = 1;
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (y[mode][k][i] != y[0][k][i])
+          erro = 1;
+    for (i = 1; i <= 4; i++)
+      if (stat[mode][i] != stat[0][i])
+        erro = 1;
+  }
+
+  for (mode = 0; mode <= 2; mode++) {
+    FREEMREAL(1,N,y[mode]);
+    FREEVINT(4,stat[mode]);
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exmodes : ok" : "exmodes : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com DF em um contexto */
+/* alocado no modo mode; yf recebe y e stat os numeros de */
+/* passos, rejeicoes e avaliacoes de F e DF               */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   mode,
+real *xf,
+mreal yf,
+vint  stat
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,l,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTXMODE(n,o,FCHAIN,DFCHAIN,NULL,mode);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (mode == GSDAE_MALLOC) ? "GSDAE_MALLOC" :
+         (mode == GSDAE_ARENA)  ? "GSDAE_ARENA " : "GSDAE_HUGE  ",
+         erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Calls of F : %d"
+         "  Calls of DF : %d\n",npas,nreject,nfunc,njac);
+  printf("  Bytes used : %lu  Block : %lu  mmap : %d\n",
+         (unsigned long) ctx->mem.used,(unsigned long) ctx->mem.size,
+         ctx->mem.mapped);
+
+  /* o bloco existe so nos modos de arena, e em GSDAE_HUGE */
+  /* ocupa um numero inteiro de paginas grandes            */
+  if ((mode == GSDAE_MALLOC) != (ctx->mem.base == NULL))
+    erro = 1;
+  if ((mode == GSDAE_HUGE) && (ctx->mem.size % (2*1024*1024) != 0))
+    erro = 1;
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+  stat[1] = npas;
+  stat[2] = nreject;
+  stat[3] = nfunc;
+  stat[4] = njac;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
@@ -0,0 +1,361 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 40, o = 1) integrada com a             */
+/*  jacobiana DF, com a jacobiana aproximada por          */
+/*  diferencas finitas coluna a coluna e com a jacobiana  */
+/*  aproximada por grupos de colunas (SETPATTERN), com o  */
+/*  padrao escrito a mao ou detectado por DETECTPATTERN.  */
+/*                                                        */
+/*  Com o padrao cada aproximacao de DF custa             */
+/*  (o+1)*ncolor+1 avaliacoes de F em vez de (o+1)*n+1 :  */
+/*  a integracao com o padrao deve chegar ao mesmo ponto  */
+/*  que a integracao com DF e usar menos da metade das    */
+/*  chamadas de F da aproximacao coluna a coluna          */
+/*  (contadas por F no ponteiro data). Neste exemplo a    */
+/*  aproximacao coluna a coluna orienta a tangente        */
+/*  inicial para x decrescente, como na versao original,  */
+/*  e so o numero de chamadas de F e comparado.           */
+/*                                                        */
+/*  O padrao detectado deve conter o escrito a mao e o    */
+/*  padrao de DH montado por PATTERNDH deve conter os     */
+/*  elementos nao nulos da DH densa de SETDH. A segunda   */
+/*  chamada de DETECTPATTERN le o arquivo gravado pela    */
+/*  primeira (PATTERNWRITE e PATTERNREAD), nao chama F    */
+/*  para a deteccao e deve repetir a integracao bit a     */
+/*  bit.                                                  */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N       40
+#define SEND    20.0
+#define PATFILE "expattern.pat"
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  CHECKPATTERN ( pattern *, vint, vint );
+int  INTEGRATE ( int, real *, real *, int *, int * );
+
+int main ( void )
+{
+  int  erro,mode,ncall[5],npas[5];
+  real x[5],y1[5];
+
+  /* a primeira chamada de DETECTPATTERN deve detectar */
+  remove(PATFILE);
+
+  erro = 0;
+  for (mode = 0; mode <= 4; mode++)
+    if (INTEGRATE(mode,&x[mode],&y1[mode],&ncall[mode],&npas[mode]) != 0)
+      erro = 1;
+  remove(PATFILE);
+
+  /* mesmo ponto final com DF e com o padrao */
+  for (mode = 2; mode <= 3; mode++)
+    if ((fabs(x[mode]-x[0]) > 1.0e-5) || (fabs(y1[mode]-y1[0]) > 1.0e-5))
+      erro = 1;
+
+  /* a coloracao deve reduzir as chamadas de F */
+  if (2*ncall[2] > ncall[1])
+    erro = 1;
+
+  /* o padrao lido do arquivo repete a integracao sem a */
+  /* deteccao                                            */
+  if ((x[4] != x[3]) || (y1[4] != y1[3]) || (npas[4] != npas[3]) ||
+      (ncall[4] >= ncall[3]))
+    erro = 1;
+
+  printf("\n%s\n",(erro == 0) ? "expattern : ok" : "expattern : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND                       */
+/* mode = 0 : DF, 1 : DF aproximada coluna a coluna,      */
+/* 2 : DF aproximada com o padrao de DFy (SETPATTERN),    */
+/* 3 : padrao detectado e gravado em PATFILE, 4 :         */
+/* padrao lido de PATFILE (DETECTPATTERN)                 */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   mode,
+real *xf,
+real *y1f,
+int  *ncallf,
+int  *npasf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,l,nnz,erro,ncall;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout,ia,ja;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ncall   = 0;
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,&ncall);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  ia      = ALLOCVINT(n+1);
+  ja      = ALLOCVINT(3*n);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (ia == NULL) || (ja == NULL))
+    return (1);
+
+  /* padrao de DFy por equacoes : a equacao i usa y[.][i] e */
+  /* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]          */
+  if (mode >= 2) {
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+  }
+  if ((mode == 2) && (SETPATTERN(ctx,nnz,ia,ja) != 0))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+
+  /* padrao detectado no ponto inicial ou lido de PATFILE */
+  if (mode >= 3) {
+    if (DETECTPATTERN(ctx,0.0,y,PATFILE) != 0)
+      return (1);
+    if (CHECKPATTERN(ctx->pat,ia,ja) != 0) {
+      printf("DETECTPATTERN : padrao incompleto\n");
+      return (1);
+    }
+  }
+  info[1] = 0;
+  info[2] = (mode == 0);
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (mode == 0) ? "DF                   " :
+         (mode == 1) ? "DF aproximada        " :
+         (mode == 2) ? "SETPATTERN           " :
+         (mode == 3) ? "DETECTPATTERN        " : "DETECTPATTERN (FILE) ",
+         erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Calls of F : %d\n",npas,ncall);
+
+  *xf     = x;
+  *y1f    = y[0][1];
+  *ncallf = ncall;
+  *npasf  = npas;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* verifica que o padrao pt contem o padrao (ia,ja) e que */
+/* o padrao de DH montado por PATTERNDH (r = n, p e q     */
+/* identidades) contem os elementos nao nulos da DH densa */
+/* de SETDH em um ponto qualquer. Retorna 0 se sim.       */
+/* ****************************************************** */
+
+int
+CHECKPATTERN (
+pattern *pt,
+vint     ia,
+vint     ja
+)
+{
+  int    n,o,i,j,l,m,nz,dim,erro,found;
+  vint   p,q,dia,dja;
+  vreal  DFx;
+  mreal  py,dpy,DH;
+  mmreal DFy;
+
+  n   = pt->n;
+  o   = pt->o;
+  dim = o*n+n+1;
+
+  /* padrao escrito a mao contido no detectado */
+  erro = 0;
+  for (i = 1; (i <= n) && (erro == 0); i++)
+    for (l = ia[i]; l < ia[i+1]; l++) {
+      found = 0;
+      for (m = pt->ia[i]; m < pt->ia[i+1]; m++)
+        if (pt->ja[m] == ja[l])
+          found = 1;
+      if (found == 0)
+        erro = 1;
+    }
+  if (erro != 0)
+    return (1);
+
+  p   = ALLOCVINT(n);
+  q   = ALLOCVINT(n);
+  for (i = 1; i <= n; i++)
+    p[i] = q[i] = i;
+  nz  = PATTERNDH(pt,n,p,q,NULL,NULL);
+  if (nz < 0)
+    return (1);
+  dia = ALLOCVINT(dim+1);
+  dja = ALLOCVINT(nz);
+  DFx = ALLOCVREAL(n);
+  py  = ALLOCMREAL(o,n);
+  dpy = ALLOCMREAL(o,n);
+  DH  = ALLOCMREAL(dim,dim);
+  DFy = ALLOCMMREAL(o,n,n);
+  if ((dia == NULL) || (dja == NULL) || (DFx == NULL) || (py == NULL) ||
+      (dpy == NULL) || (DH == NULL) || (DFy == NULL))
+    return (1);
+  if ((PATTERNDH(pt,n,p,q,dia,dja) != nz) || (dia[dim+1] != nz+1))
+    erro = 1;
+
+  /* DH densa em um ponto sem elementos nulos por acaso */
+  for (i = 1; i <= n; i++) {
+    py[0][i]  = 1.0+0.01*i;
+    py[1][i]  = -0.5+0.02*i;
+    dpy[0][i] = 0.1+0.001*i;
+    dpy[1][i] = 0.2-0.003*i;
+  }
+  SETDH(n,o,n,1.0,0.1,0.3,py,0.5,dpy,p,q,DFx,DFy,DFCHAIN,NULL,DH);
+
+  for (i = 1; (i <= dim) && (erro == 0); i++)
+    for (j = 1; j <= dim; j++) {
+      if (DH[i][j] == 0.0)
+        continue;
+      found = 0;
+      for (l = dia[i]; l < dia[i+1]; l++)
+        if (dja[l] == j)
+          found = 1;
+      if (found == 0)
+        erro = 1;
+    }
+  printf("  Pattern : nnz = %d  DH nnz = %d (dense %d)\n",pt->nnz,nz,
+         dim*dim);
+
+  FREEVINT(n,p);
+  FREEVINT(n,q);
+  FREEVINT(dim+1,dia);
+  FREEVINT(nz,dja);
+  FREEVREAL(n,DFx);
+  FREEMREAL(o,n,py);
+  FREEMREAL(o,n,dpy);
+  FREEMREAL(dim,dim,DH);
+  FREEMMREAL(o,n,n,DFy);
+
+  return (erro);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  (*((int *) data))++;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
@@ -0,0 +1,315 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : fatoracoes densas divididas entre 4 threads */
+/*  (SETQRTHREADS com nmin = 32, abaixo de GSDAE_QRMIN)   */
+/*  comparadas com as fatoracoes sequenciais :            */
+/*                                                        */
+/*    QRH, LUH e QR2TH numa matriz 161 x 161 (e na sua    */
+/*    parte 80 x 80 para QR2TH), com ladrilhos de         */
+/*    GSDAE_QRTILE colunas;                               */
+/*                                                        */
+/*    integracao da cadeia de n/2 osciladores nao         */
+/*    lineares acoplados (n = 80, o = 1, DH 161 x 161 e B */
+/*    80 x 80 em settau) com DH decomposta por QR e por   */
+/*    LU (infoinput[7]).                                  */
+/*                                                        */
+/*  As operacoes de cada coluna nao mudam, de modo que os */
+/*  fatores, os pivos, a condicao e os pontos finais      */
+/*  devem ser iguais bit a bit.                           */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      80
+#define SEND   20.0
+#define NTH    4
+#define NMIN   32
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  FACTOR ( void );
+int  INTEGRATE ( int, int, real *, mreal );
+
+int main ( void )
+{
+  int   erro,lu,t,k,i;
+  real  x[2];
+  mreal y[2];
+
+  erro = FACTOR();
+
+  y[0] = ALLOCMREAL(1,N);
+  y[1] = ALLOCMREAL(1,N);
+  if ((y[0] == NULL) || (y[1] == NULL))
+    return (1);
+
+  for (lu = 0; lu <= 1; lu++) {
+
+    /* t = 0 : sequencial, 1 : NTH threads */
+    for (t = 0; t <= 1; t++)
+      if (INTEGRATE(lu,(t == 0) ? 1 : NTH,&x[t],y[t]) != 0)
+        erro = 1;
+
+    /* mesmos valores bit a bit */
+    if (x[1] != x[0])
+      erro = 1;
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (y[1][k][i] != y[0][k][i])
+          erro = 1;
+
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exqrthreads : ok" : "exqrthreads : FALHOU");
+
+  FREEMREAL(1,N,y[0]);
+  FREEMREAL(1,N,y[1]);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* QRH, LUH e QR2TH com o solver de um contexto           */
+/* sequencial e de um contexto com NTH threads            */
+/* ****************************************************** */
+
+int
+FACTOR ( void )
+{
+  gsdae_ctx *ctx[2];
+  int        dim,m,t,i,j,r[2],erro;
+  real       cond[2];
+  mreal      A0,A[2],T[2];
+  vint       p[2],q[2];
+  unsigned   seed;
+
+  dim  = 2*N+1;
+  erro = 0;
+
+  A0 = ALLOCMREAL(dim,dim);
+  if (A0 == NULL)
+    return (1);
+  for (t = 0; t <= 1; t++) {
+    ctx[t] = ALLOCCTX(N,1,FCHAIN,NULL,NULL);
+    A[t]   = ALLOCMREAL(dim,dim);
+    T[t]   = ALLOCMREAL(dim,dim);
+    p[t]   = ALLOCVINT(dim);
+    q[t]   = ALLOCVINT(dim);
+    if ((ctx[t] == NULL) || (A[t] == NULL) || (T[t] == NULL) ||
+        (p[t] == NULL) || (q[t] == NULL))
+      return (1);
+  }
+  if (SETQRTHREADS(ctx[1],NTH,NMIN) != 0)
+    return (1);
+
+  /* matriz pseudo-aleatoria com diagonal dominante fraca */
+  seed = 12345;
+  for (i = 1; i <= dim; i++)
+    for (j = 1; j <= dim; j++) {
+      seed     = seed*1103515245u+12345u;
+      A0[i][j] = (real) ((seed >> 8)%2001)/1000.0-1.0;
+      if (i == j)
+        A0[i][j] += 2.0;
+    }
+
+  /* m = 0 : QRH, 1 : LUH, 2 : QR2TH */
+  for (m = 0; m <= 2; m++) {
+
+    for (t = 0; t <= 1; t++) {
+      for (i = 1; i <= dim; i++)
+        for (j = 1; j <= dim; j++)
+          A[t][i][j] = A0[i][j];
+      r[t] = 0;
+      if (m == 0)
+        QRH(dim,dim,A[t],T[t],&(ctx[t]->ls),1,&cond[t]);
+      else if (m == 1)
+        r[t] = LUH(dim,A[t],&(ctx[t]->ls),&cond[t]);
+      else
+        r[t] = QR2TH(N,A[t],T[t],p[t],q[t],&(ctx[t]->ls));
+    }
+
+    /* fatores, pivos, condicao e posto iguais bit a bit */
+    if (r[1] != r[0])
+      erro = 1;
+    if ((m < 2) && (cond[1] != cond[0]))
+      erro = 1;
+    for (i = 1; i <= ((m < 2) ? dim : N); i++) {
+      if ((m < 2) && (ctx[1]->ls.piv[i] != ctx[0]->ls.piv[i]))
+        erro = 1;
+      if ((m == 2) && ((p[1][i] != p[0][i]) || (q[1][i] != q[0][i])))
+        erro = 1;
+      for (j = 1; j <= ((m < 2) ? dim : N); j++) {
+        if (A[1][i][j] != A[0][i][j])
+          erro = 1;
+        if ((m != 1) && (T[1][i][j] != T[0][i][j]))
+          erro = 1;
+      }
+    }
+    printf("%s : %s\n",(m == 0) ? "QRH  " : (m == 1) ? "LUH  " : "QR2TH",
+           (erro == 0) ? "iguais" : "diferentes");
+
+  }
+
+  for (t = 0; t <= 1; t++) {
+    FREECTX(ctx[t]);
+    FREEMREAL(dim,dim,A[t]);
+    FREEMREAL(dim,dim,T[t]);
+    FREEVINT(dim,p[t]);
+    FREEVINT(dim,q[t]);
+  }
+  FREEMREAL(dim,dim,A0);
+
+  return (erro);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com DF; lu =          */
+/* infoinput[7], fatoracoes com nthreads threads          */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   lu,
+int   nthreads,
+real *xf,
+mreal yf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,l,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (SETQRTHREADS(ctx,nthreads,NMIN) != 0))
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  info[7] = lu;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s %d thread(s) : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (lu == 1) ? "LU" : "QR",nthreads,erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Decompositions : %d\n",npas,nqr);
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
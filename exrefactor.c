@@ -0,0 +1,231 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) integrada com DF e DH       */
+/*  completa, com DF e o complemento de Schur             */
+/*  (infoinput[5] = 1) e com a jacobiana aproximada pelo  */
+/*  padrao de DFy (SETPATTERN), cada uma com DF sempre    */
+/*  reavaliada quando DH muda (infoinput[8] = 0) e com DH */
+/*  remontada para o novo cj com a jacobiana guardada     */
+/*  (infoinput[8] = 1, REFACTORDH).                       */
+/*                                                        */
+/*  Em cada caso as duas integracoes devem chegar ao      */
+/*  mesmo ponto dentro da tolerancia, e com               */
+/*  infoinput[8] = 1 a jacobiana deve ser avaliada menos  */
+/*  vezes.                                                */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      20
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int, int, real *, real *, int * );
+
+int main ( void )
+{
+  int  erro,mode,cj,njac[2];
+  real x[2],y1[2];
+
+  erro = 0;
+
+  /* mode = 0 : DF e DH completa, 1 : DF e complemento de */
+  /* Schur, 2 : DF aproximada com o padrao de DFy         */
+  for (mode = 0; mode <= 2; mode++) {
+
+    for (cj = 0; cj <= 1; cj++)
+      if (INTEGRATE(mode,cj,&x[cj],&y1[cj],&njac[cj]) != 0)
+        erro = 1;
+
+    /* mesmo ponto final */
+    if ((fabs(x[1]-x[0]) > 1.0e-5) || (fabs(y1[1]-y1[0]) > 1.0e-5))
+      erro = 1;
+
+    /* menos avaliacoes da jacobiana */
+    if (njac[1] >= njac[0])
+      erro = 1;
+
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exrefactor : ok" : "exrefactor : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND; cj = infoinput[8]    */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   mode,
+int   cj,
+real *xf,
+real *y1f,
+int  *njacf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,l,nnz,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout,ia,ja;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  ia      = ALLOCVINT(n+1);
+  ja      = ALLOCVINT(3*n);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (ia == NULL) || (ja == NULL))
+    return (1);
+
+  /* padrao de DFy por equacoes : a equacao i usa y[.][i] e */
+  /* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]          */
+  if (mode == 2) {
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+    if (SETPATTERN(ctx,nnz,ia,ja) != 0)
+      return (1);
+  }
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = (mode != 2);
+  info[3] = 1;
+  info[5] = (mode == 1);
+  info[8] = cj;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s %s : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (mode == 0) ? "DF          " :
+         (mode == 1) ? "DF (Schur)  " : "SETPATTERN  ",
+         (cj == 1) ? "REFACTORDH" : "          ",erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Jacobians : %d  Decompositions : %d\n",
+         npas,njac,nqr);
+
+  *xf    = x;
+  *y1f   = y[0][1];
+  *njacf = njac;
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
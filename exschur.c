@@ -0,0 +1,327 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : sistema de Newton com DH completa           */
+/*  (infoinput[5] = 0) e com as linhas da cadeia de       */
+/*  derivadas eliminadas (infoinput[5] = 1, SETDHSCHUR e  */
+/*  SCHURSOLVE) em tres casos :                           */
+/*                                                        */
+/*    cadeia de n/2 osciladores nao lineares acoplados    */
+/*    (n = 80, o = 1) com DF e com a jacobiana            */
+/*    aproximada pelo padrao de DFy (SETPATTERN);         */
+/*                                                        */
+/*    cadeia de n osciladores amortecidos de segunda      */
+/*    ordem (n = 20, o = 2) com DF.                       */
+/*                                                        */
+/*  O sistema reduzido e decomposto em outra ordem, de    */
+/*  modo que os resultados nao sao iguais bit a bit : as  */
+/*  duas integracoes devem ter os mesmos passos e         */
+/*  avaliacoes da jacobiana e o mesmo ponto final ate o   */
+/*  arredondamento.                                       */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N1     80
+#define N2     20
+#define SEND   20.0
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+void FCHAIN2 ( int, int, real, mreal, vreal, void * );
+void DFCHAIN2 ( int, int, real, mreal, vreal, mmreal, void * );
+int  INTEGRATE ( int, int, int, int, real *, mreal, int * );
+
+int main ( void )
+{
+  int   erro,c,n,o,schur,k,i;
+  int   cnt[2][3];
+  real  x[2],dmax;
+  mreal y[2];
+
+  erro = 0;
+
+  /* c = 0 : o = 1 com DF, 1 : o = 1 com SETPATTERN, */
+  /* 2 : o = 2 com DF                                */
+  for (c = 0; c <= 2; c++) {
+
+    n = (c < 2) ? N1 : N2;
+    o = (c < 2) ? 1 : 2;
+    y[0] = ALLOCMREAL(o,n);
+    y[1] = ALLOCMREAL(o,n);
+    if ((y[0] == NULL) || (y[1] == NULL))
+      return (1);
+
+    for (schur = 0; schur <= 1; schur++)
+      if (INTEGRATE(n,o,c == 1,schur,&x[schur],y[schur],cnt[schur]) != 0)
+        erro = 1;
+
+    /* mesmos passos e mesmo ponto final ate o arredondamento */
+    dmax = fabs(x[1]-x[0]);
+    for (k = 0; k <= o; k++)
+      for (i = 1; i <= n; i++)
+        if (!(fabs(y[1][k][i]-y[0][k][i]) <= dmax))
+          dmax = fabs(y[1][k][i]-y[0][k][i]);
+    printf("|Schur - DH completa| = %e\n\n",dmax);
+    for (k = 0; k <= 2; k++)
+      if (cnt[1][k] != cnt[0][k])
+        erro = 1;
+    if (!(dmax <= 1.0e-9))
+      erro = 1;
+
+    FREEMREAL(o,n,y[0]);
+    FREEMREAL(o,n,y[1]);
+
+  }
+
+  printf("%s\n",(erro == 0) ? "exschur : ok" : "exschur : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND; pat = 1 informa o    */
+/* padrao de DFy (sem DF), schur = infoinput[5]. cnt      */
+/* recebe os passos, as rejeicoes e as jacobianas         */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   n,
+int   o,
+int   pat,
+int   schur,
+real *xf,
+mreal yf,
+int  *cnt
+)
+{
+  gsdae_ctx *ctx;
+  int        i,k,l,nnz,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout,ia,ja;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  ctx     = (o == 1) ? ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL) :
+                       ALLOCCTX(n,o,FCHAIN2,DFCHAIN2,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  ia      = ALLOCVINT(n+1);
+  ja      = ALLOCVINT(3*n);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (ia == NULL) || (ja == NULL))
+    return (1);
+
+  /* padrao de DFy por equacoes : a equacao i usa y[.][i] e */
+  /* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]          */
+  if (pat == 1) {
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+    if (SETPATTERN(ctx,nnz,ia,ja) != 0)
+      return (1);
+  }
+
+  /* ponto inicial consistente */
+  if (o == 1) {
+    for (i = 1; i <= n; i += 2) {
+      y[0][i]   =  1.0;
+      y[1][i]   = -0.01;
+      y[1][i+1] = -1.0;
+    }
+  } else {
+    for (i = 1; i <= n; i++) {
+      y[0][i] =  1.0;
+      y[2][i] = -1.1;
+    }
+  }
+  info[1] = 0;
+  info[2] = (pat == 0);
+  info[3] = 1;
+  info[5] = schur;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("o = %d %s %s : erro = %d x = %.10lf y[0][1] = %.10lf\n",o,
+         (pat == 1) ? "SETPATTERN" : "DF        ",
+         (schur == 1) ? "Schur      " : "DH completa",erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Jacobians : %d\n",
+         npas,nreject,njac);
+
+  *xf    = x;
+  cnt[0] = npas;
+  cnt[1] = nreject;
+  cnt[2] = njac;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
+
+
+
+
+/* ****************************************************** */
+/* F : y1'' = -0.1 y1' - y1 - 0.1 y1^3                    */
+/*            - 0.05 (y1 - y1 do oscilador anterior)      */
+/* ****************************************************** */
+
+void
+FCHAIN2 (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i++) {
+    delta[i] = y[2][i]+0.1*y[1][i]+y[0][i]+0.1*y[0][i]*y[0][i]*y[0][i];
+    if (i > 1)
+      delta[i] += 0.05*(y[0][i]-y[0][i-1]);
+  }
+}
+
+
+
+void
+DFCHAIN2 (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int i,j,k;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i++) {
+    DFx[i]       = 0.0;
+    DFy[2][i][i] = 1.0;
+    DFy[1][i][i] = 0.1;
+    DFy[0][i][i] = 1.0+0.3*y[0][i]*y[0][i];
+    if (i > 1) {
+      DFy[0][i][i]   += 0.05;
+      DFy[0][i-1][i] -= 0.05;
+    }
+  }
+}
@@ -0,0 +1,333 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : nucleos vetoriais (SETSIMD). Para cada      */
+/*  nivel de GSDAE_SIMDNONE ate o maior suportado pela    */
+/*  CPU os nucleos de kern sao comparados com os          */
+/*  escalares em vetores de varios tamanhos, com e sem a  */
+/*  permutacao q : rot, acc, pred e wmax devem dar o      */
+/*  mesmo resultado bit a bit, dot e wssq (que somam em   */
+/*  outra ordem) o mesmo a menos de arredondamento.       */
+/*                                                        */
+/*  Em seguida a cadeia de n/2 osciladores nao lineares   */
+/*  acoplados (n = 40, o = 1) e integrada com a jacobiana */
+/*  DF em um contexto novo para cada nivel, e todas as    */
+/*  integracoes devem chegar ao ponto final da escalar    */
+/*  dentro da tolerancia.                                 */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include <float.h>
+#include "gsdae.h"
+
+#define N      40
+#define SEND   20.0
+#define NK     131
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+void DFCHAIN ( int, int, real, mreal, vreal, mmreal, void * );
+int  KERNCHECK ( int );
+int  INTEGRATE ( int, real *, real * );
+
+int main ( void )
+{
+  int  erro,best,level;
+  real x[GSDAE_SIMD512+1],y1[GSDAE_SIMD512+1];
+
+  best = SETSIMD(-1);
+  printf("maior nivel suportado : %d\n",best);
+
+  erro = 0;
+  for (level = GSDAE_SIMDNONE; level <= best; level++) {
+    if ((SETSIMD(level) != level) || (kern.level != level))
+      erro = 1;
+    if (KERNCHECK(level) != 0)
+      erro = 1;
+    if (INTEGRATE(level,&x[level],&y1[level]) != 0)
+      erro = 1;
+  }
+
+  /* mesmo ponto final em todos os niveis */
+  for (level = GSDAE_SIMDNONE+1; (level <= best) && (erro == 0); level++)
+    if ((fabs(x[level]-x[0]) > 1.0e-6) || (fabs(y1[level]-y1[0]) > 1.0e-6))
+      erro = 1;
+
+  printf("\n%s\n",(erro == 0) ? "exsimd : ok" : "exsimd : FALHOU");
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* compara os nucleos de kern com os escalares em vetores */
+/* de tamanho 1..NK, com q = NULL e com q uma permutacao. */
+/* Retorna 0 se rot, acc, pred e wmax sao identicos e dot */
+/* e wssq concordam a menos de arredondamento.            */
+/* ****************************************************** */
+
+int
+KERNCHECK (
+int level
+)
+{
+  int   n,j,l,m,erro,iq;
+  vint  q,p;
+  vreal x,y,z,x0,y0,z0,w,a,b,h,h0,yp,zp,yp0,zp0;
+  real  c,s,r,r0,e,e0;
+
+  m   = 5;
+  q   = (vint)  malloc(NK*sizeof(int));
+  x   = (vreal) malloc(NK*sizeof(real));
+  y   = (vreal) malloc(NK*sizeof(real));
+  z   = (vreal) malloc(NK*sizeof(real));
+  x0  = (vreal) malloc(NK*sizeof(real));
+  y0  = (vreal) malloc(NK*sizeof(real));
+  z0  = (vreal) malloc(NK*sizeof(real));
+  w   = (vreal) malloc(NK*sizeof(real));
+  h   = (vreal) malloc(m*NK*sizeof(real));
+  h0  = (vreal) malloc(m*NK*sizeof(real));
+  yp  = (vreal) malloc(NK*sizeof(real));
+  zp  = (vreal) malloc(NK*sizeof(real));
+  yp0 = (vreal) malloc(NK*sizeof(real));
+  zp0 = (vreal) malloc(NK*sizeof(real));
+  a   = (vreal) malloc(m*sizeof(real));
+  b   = (vreal) malloc(m*sizeof(real));
+  if ((q == NULL) || (x == NULL) || (y == NULL) || (z == NULL) ||
+      (x0 == NULL) || (y0 == NULL) || (z0 == NULL) || (w == NULL) ||
+      (h == NULL) || (h0 == NULL) || (yp == NULL) || (zp == NULL) ||
+      (yp0 == NULL) || (zp0 == NULL) || (a == NULL) || (b == NULL))
+    return (1);
+
+  c = 0.6;
+  s = 0.8;
+  for (l = 0; l < m; l++) {
+    a[l] = 1.0/(l+1.5);
+    b[l] = 1.0-0.1*l;
+  }
+
+  erro = 0;
+  for (n = 1; (n <= NK) && (erro == 0); n++)
+    for (iq = 0; iq <= 1; iq++) {
+
+      /* dados com mantissas cheias e permutacao reversa */
+      for (j = 0; j < NK; j++) {
+        x[j] = x0[j] = sin(1.0+j)*(1.0+j/3.0);
+        y[j] = y0[j] = cos(2.0+j)/(1.0+j/7.0);
+        z[j] = z0[j] = exp(-0.01*j)/3.0;
+        w[j] = 1.0e-3+fabs(sin(0.5*j))/7.0;
+        q[j] = NK-1-j;
+      }
+      for (j = 0; j < m*NK; j++)
+        h[j] = h0[j] = sin(0.3*j)/3.0;
+      p = (iq == 0) ? NULL : q;
+
+      /* rot e acc : mesmo resultado bit a bit */
+      kern.rot(n,x,y,p,c,s);
+      KROT(n,x0,y0,p,c,s);
+      kern.acc(n,0.7,x,y,z,p);
+      KACC(n,0.7,x0,y0,z0,p);
+      for (j = 0; j < NK; j++)
+        if ((x[j] != x0[j]) || (y[j] != y0[j]) || (z[j] != z0[j]))
+          erro = 1;
+
+      /* wmax : mesmo resultado bit a bit */
+      if (kern.wmax(n,x,w,p,0.0) != KWMAX(n,x,w,p,0.0))
+        erro = 1;
+
+      /* pred (sem permutacao) : mesmo resultado bit a bit */
+      if (iq == 0) {
+        kern.pred(n,m,2,b,a,h,NK,yp,zp);
+        KPRED(n,m,2,b,a,h0,NK,yp0,zp0);
+        for (j = 0; j < n; j++)
+          if ((yp[j] != yp0[j]) || (zp[j] != zp0[j]))
+            erro = 1;
+        for (j = 0; j < m*NK; j++)
+          if (h[j] != h0[j])
+            erro = 1;
+      }
+
+      /* dot e wssq : a menos de arredondamento */
+      if (iq == 0) {
+        r  = kern.dot(n,x,y);
+        r0 = KDOT(n,x,y);
+        e0 = KDOT(n,x,x)+KDOT(n,y,y);
+        if (fabs(r-r0) > 8.0*n*DBL_EPSILON*e0)
+          erro = 1;
+      }
+      e  = kern.wssq(n,x,w,p,3.0);
+      e0 = KWSSQ(n,x,w,p,3.0);
+      if (fabs(e-e0) > 8.0*n*DBL_EPSILON*e0)
+        erro = 1;
+      if (erro != 0)
+        printf("SETSIMD(%d) : n = %d q = %s difere da versao escalar\n",
+               level,n,(iq == 0) ? "NULL" : "reversa");
+    }
+
+  free(q);
+  free(x);
+  free(y);
+  free(z);
+  free(x0);
+  free(y0);
+  free(z0);
+  free(w);
+  free(h);
+  free(h0);
+  free(yp);
+  free(zp);
+  free(yp0);
+  free(zp0);
+  free(a);
+  free(b);
+
+  return (erro);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com DF em um contexto */
+/* novo, com os nucleos do nivel level                    */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   level,
+real *xf,
+real *y1f
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,l,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,DFCHAIN,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL))
+    return (1);
+
+  /* a alocacao do contexto mantem o nivel escolhido */
+  if (kern.level != level)
+    return (1);
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 1;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("SETSIMD(%d) : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         level,erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Rejected : %d  Calls of DF : %d\n",
+         npas,nreject,njac);
+
+  *xf  = x;
+  *y1f = y[0][1];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
+
+
+
+void
+DFCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int  i,j,k;
+  real g;
+
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      for (j = 1; j <= n; j++)
+        DFy[k][i][j] = 0.0;
+  for (i = 1; i <= n; i++)
+    DFx[i] = 0.0;
+
+  /* DFy[k][variavel][equacao] */
+  for (i = 1; i <= n; i += 2) {
+    g = exp(-y[0][i]*y[0][i]);
+    DFx[i]             = 0.001*cos(x)*g;
+    DFy[1][i][i]       = 1.0;
+    DFy[0][i+1][i]     = -1.0;
+    DFy[0][i][i]       = 0.03*y[0][i]*y[0][i]-0.002*sin(x)*y[0][i]*g;
+    DFy[1][i+1][i+1]   = 1.0;
+    DFy[0][i][i+1]     = 1.0;
+    if (i > 1) {
+      DFy[0][i][i+1]   += 0.01;
+      DFy[0][i-2][i+1] -= 0.01;
+    }
+  }
+}
@@ -0,0 +1,194 @@
+/* ****************************************************** */
+/*                                                        */
+/*  Exemplo : cadeia de n/2 osciladores nao lineares      */
+/*  acoplados (n = 20, o = 1) integrada com a jacobiana   */
+/*  aproximada coluna a coluna (SETDHAPPROX e DFAPPROX)   */
+/*  e por grupos de colunas (SETPATTERN e DFCOLOR), com   */
+/*  as colunas avaliadas em uma thread e divididas entre  */
+/*  4 threads (SETTHREADS).                               */
+/*                                                        */
+/*  Cada coluna e calculada como no laco sequencial, de   */
+/*  modo que os resultados com 1 e com 4 threads devem    */
+/*  ser iguais bit a bit.                                 */
+/*                                                        */
+/*  Retorna 0 se todos os testes passam.                  */
+/*                                                        */
+/* ****************************************************** */
+
+#include "gsdae.h"
+
+#define N      20
+#define SEND   20.0
+#define NTH    4
+
+void FCHAIN ( int, int, real, mreal, vreal, void * );
+int  INTEGRATE ( int, int, real *, mreal );
+
+int main ( void )
+{
+  int   erro,pat,t,k,i;
+  real  x[2];
+  mreal y[2];
+
+  erro = 0;
+  y[0] = ALLOCMREAL(1,N);
+  y[1] = ALLOCMREAL(1,N);
+  if ((y[0] == NULL) || (y[1] == NULL))
+    return (1);
+
+  for (pat = 0; pat <= 1; pat++) {
+
+    /* t = 0 : 1 thread, 1 : NTH threads */
+    for (t = 0; t <= 1; t++)
+      if (INTEGRATE(pat,(t == 0) ? 1 : NTH,&x[t],y[t]) != 0)
+        erro = 1;
+
+    /* mesmos valores bit a bit */
+    if (x[1] != x[0])
+      erro = 1;
+    for (k = 0; k <= 1; k++)
+      for (i = 1; i <= N; i++)
+        if (y[1][k][i] != y[0][k][i])
+          erro = 1;
+
+  }
+
+  printf("\n%s\n",(erro == 0) ? "exthreads : ok" : "exthreads : FALHOU");
+
+  FREEMREAL(1,N,y[0]);
+  FREEMREAL(1,N,y[1]);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* integracao de s = 0 ate s = SEND com a jacobiana       */
+/* aproximada e nthreads threads; pat = 1 informa o       */
+/* padrao de DFy                                          */
+/* ****************************************************** */
+
+int
+INTEGRATE (
+int   pat,
+int   nthreads,
+real *xf,
+mreal yf
+)
+{
+  gsdae_ctx *ctx;
+  int        n,o,i,k,l,nnz,erro;
+  real       s,x;
+  mreal      y,atoly,rtoly;
+  vreal      ftol;
+  vint       info,infoout,ia,ja;
+  real       len;
+  int        npas,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew;
+
+  n = N;
+  o = 1;
+
+  ctx     = ALLOCCTX(n,o,FCHAIN,NULL,NULL);
+  y       = ALLOCMREAL(o,n);
+  atoly   = ALLOCMREAL(o,n);
+  rtoly   = ALLOCMREAL(o,n);
+  ftol    = ALLOCVREAL(n);
+  info    = ALLOCVINT(2*n+10);
+  infoout = ALLOCVINT(2*n+10);
+  ia      = ALLOCVINT(n+1);
+  ja      = ALLOCVINT(3*n);
+  if ((ctx == NULL) || (y == NULL) || (atoly == NULL) || (rtoly == NULL) ||
+      (ftol == NULL) || (info == NULL) || (infoout == NULL) ||
+      (ia == NULL) || (ja == NULL) || (SETTHREADS(ctx,nthreads) != 0))
+    return (1);
+
+  /* padrao de DFy por equacoes : a equacao i usa y[.][i] e */
+  /* y[.][i+1], a equacao i+1 usa tambem y[.][i-2]          */
+  if (pat == 1) {
+    nnz = 0;
+    for (i = 1; i <= n; i += 2) {
+      ia[i]     = nnz+1;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+      ia[i+1]   = nnz+1;
+      if (i > 1)
+        ja[++nnz] = i-2;
+      ja[++nnz] = i;
+      ja[++nnz] = i+1;
+    }
+    ia[n+1] = nnz+1;
+    if (SETPATTERN(ctx,nnz,ia,ja) != 0)
+      return (1);
+  }
+
+  for (i = 1; i <= n; i += 2) {
+    y[0][i]   =  1.0;
+    y[1][i]   = -0.01;
+    y[1][i+1] = -1.0;
+  }
+  info[1] = 0;
+  info[2] = 0;
+  info[3] = 1;
+  ftol[1] = 1.0e-6;
+  s       = 0.0;
+  x       = 0.0;
+
+  l = 0;
+  do
+    erro = GSDAECTX(ctx,n,o,1.0e-6,1.0e-16,0.0,1.0e50,&s,SEND,&x,y,
+                    1.0e-9,atoly,1.0e-7,rtoly,ftol,info,infoout);
+  while ((erro > 0) && (++l < 100));
+
+  STATISTICSCTX(ctx,&len,&npas,&nreject,&nsuc,&nfunc,&njac,&nqr,&nstart,
+                &nfnew);
+  printf("%s %d thread(s) : erro = %d x = %.10lf y[0][1] = %.10lf\n",
+         (pat == 1) ? "DFCOLOR    " : "SETDHAPPROX",nthreads,erro,x,y[0][1]);
+  printf("  Number of Steps : %d  Jacobians : %d  Calls of F : %d\n",
+         npas,njac,nfunc);
+
+  *xf = x;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      yf[k][i] = y[k][i];
+
+  FREECTX(ctx);
+  FREEMREAL(o,n,y);
+  FREEMREAL(o,n,atoly);
+  FREEMREAL(o,n,rtoly);
+  FREEVREAL(n,ftol);
+  FREEVINT(2*n+10,info);
+  FREEVINT(2*n+10,infoout);
+  FREEVINT(n+1,ia);
+  FREEVINT(3*n,ja);
+
+  return ((erro == 0) ? 0 : 1);
+}
+
+
+
+/* ****************************************************** */
+/* F : y1' = y2 - 0.01 y1^3 - 0.001 sin(x) exp(-y1^2),    */
+/*     y2' = -y1 - 0.01 (y1 - y1 do oscilador anterior)   */
+/* ****************************************************** */
+
+void
+FCHAIN (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i += 2) {
+    delta[i]   = y[1][i]-y[0][i+1]+0.01*y[0][i]*y[0][i]*y[0][i]+
+                 0.001*sin(x)*exp(-y[0][i]*y[0][i]);
+    delta[i+1] = y[1][i+1]+y[0][i];
+    if (i > 1)
+      delta[i+1] += 0.01*(y[0][i]-y[0][i-2]);
+  }
+}
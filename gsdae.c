@@ -31,6 +31,39 @@
 
 
 
+/* ****************************************************** */
+/*   definindo a variavel global que armazena todos os    */
+/*   dados para a execucao da rotina GSDAE como nao       */
+/*   alocada                                              */
+/* ****************************************************** */
+parameter *par = NULL;
+
+
+/* ****************************************************** */
+/*   nucleos vetoriais : escalares ate a primeira         */
+/*   alocacao de contexto, que chama SETSIMD(-1) uma      */
+/*   unica vez no processo (KERNINIT)                     */
+/* ****************************************************** */
+kernels kern = {-1,KROT,KDOT,KACC,KPRED,KWMAX,KWSSQ};
+pthread_once_t kernonce = PTHREAD_ONCE_INIT;
+
+/* chamadas dos nucleos : os de kern, ou os escalares para */
+/* vetores com menos de GSDAE_KSHORT elementos             */
+#define KERNROT(n,x,y,q,c,s) ( ((n) < GSDAE_KSHORT) ? \
+  KROT(n,x,y,q,c,s) : kern.rot(n,x,y,q,c,s) )
+#define KERNDOT(n,x,y) ( ((n) < GSDAE_KSHORT) ? \
+  KDOT(n,x,y) : kern.dot(n,x,y) )
+#define KERNACC(n,a,x,y,z,q) ( ((n) < GSDAE_KSHORT) ? \
+  KACC(n,a,x,y,z,q) : kern.acc(n,a,x,y,z,q) )
+#define KERNPRED(n,m,ns,b,a,x,ld,y,z) ( ((n) < GSDAE_KSHORT) ? \
+  KPRED(n,m,ns,b,a,x,ld,y,z) : kern.pred(n,m,ns,b,a,x,ld,y,z) )
+#define KERNWMAX(n,c,w,q,v) ( ((n) < GSDAE_KSHORT) ? \
+  KWMAX(n,c,w,q,v) : kern.wmax(n,c,w,q,v) )
+#define KERNWSSQ(n,c,w,q,v) ( ((n) < GSDAE_KSHORT) ? \
+  KWSSQ(n,c,w,q,v) : kern.wssq(n,c,w,q,v) )
+
+
+
 /* ****************************************************** */
 /*                                                        */
 /*               Rotinas GSDAE e CSDAE                    */
@@ -117,6 +150,127 @@
 /*         esta variavel e alocada na rotina ALLOCPAR e   */
 /*         liberada na rotina FREEPAR                     */
 /*                                                        */
+/*  Contexto do integrador                                */
+/*                                                        */
+/*  As rotinas GSDAECTX e CSDAECTX sao identicas a GSDAE  */
+/*  e CSDAE, mas recebem como primeiro parametro um       */
+/*  contexto (gsdae_ctx) no lugar da variavel global par. */
+/*  O contexto e alocado na rotina ALLOCCTX e liberado na */
+/*  rotina FREECTX, e armazena todos os dados de uma      */
+/*  integracao, inclusive os contadores de erro. Assim,   */
+/*  varias EADs podem ser integradas ao mesmo tempo, uma  */
+/*  por contexto, inclusive em threads distintas.         */
+/*                                                        */
+/*  Por padrao todos os vetores e matrizes do contexto    */
+/*  ficam em um unico bloco alinhado; a rotina            */
+/*  ALLOCCTXMODE permite escolher a alocacao por linha    */
+/*  (GSDAE_MALLOC) ou o uso de paginas grandes            */
+/*  (GSDAE_HUGE).                                         */
+/*                                                        */
+/*  Os contextos utilizam as rotinas F e DF com um        */
+/*  parametro adicional data, definido pelo usuario em    */
+/*  ALLOCCTX e repassado sem alteracao a cada chamada :   */
+/*                                                        */
+/*    F(o,n,x,y,delta,data)                               */
+/*    DF(o,n,x,y,DFx,DFy,data)                            */
+/*                                                        */
+/*  As rotinas GSDAE, CSDAE, STATISTICS, ALLOCPAR e       */
+/*  FREEPAR utilizam o contexto global par.               */
+/*                                                        */
+/*  A rotina GSDAEBATCH integra varias instancias de uma  */
+/*  mesma EAD (gsdae_inst) em paralelo, com um contexto   */
+/*  por thread (veja a descricao da rotina).              */
+/*                                                        */
+/*  A rotina GSDAEENSEMBLE integra grupos de w instancias */
+/*  pequenas em passo travado, como uma unica EAD com as  */
+/*  variaveis das instancias intercaladas e F avaliada    */
+/*  para o grupo inteiro em uma chamada (veja a descricao */
+/*  da rotina).                                           */
+/*                                                        */
+/*  Jacobiana esparsa                                     */
+/*                                                        */
+/*  A rotina ALLOCCTXSPARSE aloca um contexto para EADs   */
+/*  grandes com jacobiana esparsa. O usuario informa o    */
+/*  padrao de DFy (uniao sobre as ordens 0..o) no formato */
+/*  CSR com indices a partir de 1 (ia[1..n+1], ja[1..nnz],*/
+/*  linhas = equacoes, colunas = variaveis) e a rotina    */
+/*                                                        */
+/*    DFS(o,n,x,y,DFx,val,data)                           */
+/*                                                        */
+/*  que preenche DFx e val[k][l], valor de DFy[k] na      */
+/*  posicao l do padrao. O sistema de Newton reduzido     */
+/*  (complemento de Schur) e fatorado por LU esparsa com  */
+/*  ordenacao de grau minimo calculada na alocacao; a     */
+/*  analise simbolica e os pivos sao reaproveitados nas   */
+/*  refatoracoes pedidas por aDH. Nesse modo as opcoes    */
+/*  infoinput[2] e infoinput[5] ficam implicitas. Para    */
+/*  n < sp->nmin (GSDAE_SPMIN) e usado o caminho denso.   */
+/*  O vetor tangente em settau tambem usa a LU esparsa    */
+/*  quando DFy[o] e regular; caso contrario a fatoracao   */
+/*  QR densa e mantida, por isso DFy continua alocada.    */
+/*                                                        */
+/*  Com a jacobiana aproximada (infoinput[2] = 0), a      */
+/*  rotina SETPATTERN informa o padrao de DFy no mesmo    */
+/*  formato. As colunas estruturalmente ortogonais sao    */
+/*  agrupadas por cores (Curtis, Powell e Reid) e cada    */
+/*  aproximacao de DF custa (o+1)*ncolor+1 avaliacoes de  */
+/*  F em vez de (o+1)*n+1. O padrao pode ser detectado    */
+/*  automaticamente por DETECTPATTERN, que perturba F em  */
+/*  torno do ponto inicial e guarda o resultado no        */
+/*  contexto e, opcionalmente, em um arquivo reutilizado  */
+/*  nas execucoes seguintes. PATTERNDETECT e PATTERNDH    */
+/*  fornecem o padrao sem contexto (por exemplo para      */
+/*  ALLOCCTXSPARSE) e o padrao da matriz DH.              */
+/*                                                        */
+/*  Se F pode ser chamada ao mesmo tempo por varias       */
+/*  threads, a rotina SETTHREADS divide as colunas das    */
+/*  jacobianas aproximadas entre threads.                 */
+/*                                                        */
+/*  Se F pode ser avaliada em varios pontos de uma vez, a */
+/*  rotina SETFBATCH informa a versao em lotes Fb, usada  */
+/*  nas colunas das jacobianas aproximadas.               */
+/*                                                        */
+/*  A rotina SETQRTHREADS divide entre threads as         */
+/*  fatoracoes densas (DH em masterstep e B em settau)    */
+/*  de dimensao acima de um limite, sem alterar os        */
+/*  pivos nem a estimativa da condicao.                   */
+/*                                                        */
+/*  Os lacos internos (rotacoes de Givens, passo de       */
+/*  Newton, norma ponderada, preditor e diferencas        */
+/*  divididas) usam nucleos SSE2, AVX2 ou AVX-512         */
+/*  escolhidos pela CPUID na primeira alocacao de um      */
+/*  contexto; SETSIMD limita o nivel (GSDAE_SIMDNONE      */
+/*  restaura os lacos escalares) e, como a tabela de      */
+/*  nucleos e global ao processo, deve ser chamada antes  */
+/*  de alocar os contextos que usarao o nivel e nunca     */
+/*  durante uma integracao.                               */
+/*                                                        */
+/*  Com infoinput[6] = 1 a fatoracao de DH e reutilizada  */
+/*  entre os passos e corrigida por atualizacoes de       */
+/*  Broyden de posto um, calculadas com os residuos ja    */
+/*  avaliados no corretor. DH so e reavaliada quando o    */
+/*  metodo de Newton deixa de convergir, apos             */
+/*  GSDAE_NBROY atualizacoes ou na mudanca de fase.       */
+/*                                                        */
+/*  Para EADs muito grandes, em que DH e Q nao cabem na   */
+/*  memoria, a rotina ALLOCCTXKRYLOV aloca um contexto    */
+/*  com o corretor de Newton-Krylov : o passo de Newton   */
+/*  e resolvido pelo GMRES com reinicio e produtos DH v   */
+/*  obtidos da rotina JV do usuario ou de diferencas      */
+/*  finitas de F, e a tolerancia do GMRES acompanha a     */
+/*  taxa de convergencia e o teste de aceitacao do        */
+/*  corretor. A memoria e O(n), mas DFy[o] deve ser       */
+/*  regular (nao ha queda de posto).                      */
+/*  Os contadores kr->nli e kr->nfe do contexto guardam   */
+/*  as iteracoes do GMRES e as avaliacoes extras de F.    */
+/*                                                        */
+/*  O GMRES pode ser precondicionado a direita : as       */
+/*  rotinas setup e solve do usuario (SETPRECOND) ou os   */
+/*  precondicionadores internos bloco-Jacobi e ILU(0)     */
+/*  (SETPRECONDKIND) aproximam o bloco de DFy[o] reduzido */
+/*  pela eliminacao da cadeia de derivadas. O setup so e  */
+/*  refeito quando a jacobiana seria reavaliada.          */
+/*                                                        */
 /*                                                        */
 /*  As rotinas GSDAE e CSDAE sao funces que retornam um   */
 /*  valor inteiro. O valor retornado esta entre -16 e 4   */
@@ -336,6 +490,49 @@
 /*               permutacoes das variaveis y[0],..,y[o]   */
 /*               estao em infoinput[10+n+i] (i = 1..n)    */
 /*                                                        */
+/* infoinput[5]: infoinput[5] = 0 indica a rotina que o   */
+/*               sistema linear do metodo de Newton e     */
+/*               resolvido com a matriz DH completa       */
+/*                                                        */
+/*               infoinput[5] = 1 indica a rotina que as  */
+/*               linhas de DH que definem as derivadas    */
+/*               (cadeia y[k]' = y[k+1]) sao eliminadas e */
+/*               apenas um sistema de dimensao n+1 e      */
+/*               decomposto (complemento de Schur). So e  */
+/*               utilizado quando o > 0 e infoinput[2] =  */
+/*               1; caso contrario e equivalente a 0      */
+/*                                                        */
+/* infoinput[6]: infoinput[6] = 0 indica a rotina que DH  */
+/*               e reavaliada e decomposta sempre que os  */
+/*               coeficientes do corretor mudam           */
+/*                                                        */
+/*               infoinput[6] = 1 indica a rotina que a   */
+/*               decomposicao de DH e mantida e corrigida */
+/*               por atualizacoes de Broyden; DH so e     */
+/*               reavaliada quando o metodo de Newton nao */
+/*               converge                                 */
+/*                                                        */
+/* infoinput[7]: infoinput[7] = 0 indica a rotina que DH  */
+/*               e sempre decomposta pelo metodo QR       */
+/*                                                        */
+/*               infoinput[7] = 1 indica a rotina que DH  */
+/*               e decomposta por LU com pivoteamento     */
+/*               parcial enquanto a condicao da fatoracao */
+/*               anterior esta longe de cdmax, voltando a */
+/*               QR perto de cdmax e apos mudancas de     */
+/*               posto ou de ordem                        */
+/*                                                        */
+/* infoinput[8]: infoinput[8] = 1 indica a rotina que,    */
+/*               quando apenas cj muda alem do alcance do */
+/*               fator de aceleracao ac, DH e remontada   */
+/*               com o novo cj e a jacobiana DF ja        */
+/*               avaliada, sem chamar DF; DF so e         */
+/*               reavaliada se o metodo de Newton nao     */
+/*               converge ou apos GSDAE_NCJ refatoracoes. */
+/*               Nao se aplica a jacobiana aproximada sem */
+/*               padrao (SETPATTERN) nem ao corretor de   */
+/*               Newton-Krylov                            */
+/*                                                        */
 /* infoinput[i]: i = 11..10+n armazena as permutacoes de  */
 /*               coordenadas da funcao que define a EAD   */
 /*               quando infoinput[0] > 0                  */
@@ -344,7 +541,7 @@
 /*               das variaveis y[0],..,y[o]               */
 /*               quando infoinput[0] > 0                  */
 /*                                                        */
-/* infoinput[i]: i = 0,5..10 nao sao utilizadas nesta     */
+/* infoinput[i]: i = 0,9..10 nao sao utilizadas nesta     */
 /*               versao                                   */
 /*                                                        */
 /*                                                        */
@@ -396,9 +593,44 @@ vint   infoinput,   /* informacoes para entrada de dados */
 vint   infooutput   /* informacoes para saida de dados   */
 )
 {
-  /* declarando variaveis locais estaticas para controle de erro */
-  static int error, nerror;
+  /* verificando se foi alocado espaco para os dados */
+  if (par == NULL) {
+
+    /* dados nao alocadaos */
+    return (-1);
+
+  }
+
+  /* integrando com o contexto global */
+  return (GSDAECTX(par,n,o,h,hmin,hmax,cdmax,s,send,x,y,
+                   atolx,atoly,rtolx,rtoly,ftol,infoinput,infooutput));
+}  
+/* fim GSDAE */
+
 
+
+int 
+GSDAECTX (
+gsdae_ctx *par,     /* contexto do integrador            */
+int    n,           /* dimensao da EAD                   */
+int    o,           /* ordem da EAD                      */
+real   h,           /* passo de integracao               */
+real   hmin,        /* passo minimo de integracao        */
+real   hmax,        /* passo maximo de integracao        */
+real   cdmax,       /* condicao maxima para a derivada   */
+real  *s,           /* c(s) = (x(s),y(s))                */
+real   send,        /* ponto final de integracao         */
+real  *x,           /* c(s) = (x(s),y(s))                */
+mreal  y,           /* c(s) = (x(s),y(s))                */
+real   atolx,       /* erro absoluto para x              */
+mreal  atoly,       /* erro absoluto para y              */
+real   rtolx,       /* erro realtivo para x              */
+mreal  rtoly,       /* erro realtivo para y              */
+vreal  ftol,        /* erro absoluto para a funcao       */
+vint   infoinput,   /* informacoes para entrada de dados */
+vint   infooutput   /* informacoes para saida de dados   */
+)
+{
   /* declarando variaveis locais de controle */
   int  converg, success, success0, success1, fail;
 
@@ -406,7 +638,7 @@ vint   infooutput   /* informacoes para saida de dados   */
   int  nstep;
 
   /* declarando controladores de lacos */
-  int  i, j, k;
+  int  i, j;
 
 
   /* verificando se foi alocado espaco para os dados */
@@ -427,7 +659,8 @@ vint   infooutput   /* informacoes para saida de dados   */
     infoinput[1] = 1;
 
     /* verificar a dimensao e a ordem da EAD */
-    if ((o < 0) || (n <= 0)) {
+    if ((o < 0) || (n <= 0) || (n > par->nalloc) || (o > par->oalloc) ||
+        ((par->ls.sp != NULL) && (n != par->nalloc))) {
 
       /* erro na entrada de dados */
       return (-2);
@@ -521,6 +754,37 @@ vint   infooutput   /* informacoes para saida de dados   */
 
     }
 
+    /* definindo o resolvedor do sistema linear do metodo */
+    /* de Newton                                          */
+    par->ls.schur = (infoinput[5] == 1);
+
+    /* atualizacoes de Broyden da fatoracao de DH */
+    par->ls.broyden = (infoinput[6] == 1);
+    par->ls.bdim    = 0;
+    par->ls.nbroy   = 0;
+
+    /* politica LU/QR : a primeira fatoracao e sempre QR */
+    par->ls.adapt = (infoinput[7] == 1);
+    par->ls.lu    = 0;
+    par->ls.lcond = 0.0;
+
+    /* refatoracao para um novo cj com a jacobiana guardada */
+    par->ls.cjup = (infoinput[8] == 1);
+    par->ls.jok  = 0;
+    par->ls.ncj  = 0;
+
+    /* o vetor tangente do corretor de Newton-Krylov ainda */
+    /* nao tem uma derivada de referencia                  */
+    if (par->ls.kr != NULL) 
+      par->ls.kr->ref = 0;
+
+    /* com a jacobiana esparsa (ALLOCCTXSPARSE) a rotina DF e */
+    /* sempre utilizada e o sistema e sempre reduzido         */
+    if (par->ls.sp != NULL) {
+      par->nDH      = 1;
+      par->ls.schur = 1;
+    }
+
     /* definindo as tolerancias */
     if (infoinput[3] == 0) {
 
@@ -713,6 +977,14 @@ vint   infooutput   /* informacoes para saida de dados   */
 
     }
 
+    /* o corretor de Newton-Krylov supoe DFy[o] regular */
+    if ((par->ls.kr != NULL) && (par->rank != n)) {
+
+      /* erro na entrada de dados */
+      return (-2);
+
+    }
+
     /* inicializando os contadores de passos,     */
     /* passos falhos, falhas no metodo de Newton, */
     /* numero de avaliacao da funcao, numero de   */
@@ -726,6 +998,14 @@ vint   infooutput   /* informacoes para saida de dados   */
     par->naDH   = 0;
     par->ndQR   = 0;
     par->nstart = 0;
+    par->ls.nlu = 0;
+    par->ls.nsw = 0;
+
+    /* inicializando o contador de falhas consecutivas e a */
+    /* avaliacao da jacobiana, de modo que um contexto     */
+    /* reutilizado se comporte como um contexto novo       */
+    par->cfalhas = 0;
+    par->aDH     = 0;
 
     /* definindo a direcao de integracao de acordo */
     /* com o ponto final                           */
@@ -751,9 +1031,17 @@ vint   infooutput   /* informacoes para saida de dados   */
                       par->cdmax,par->dir,par->Q,par->DH,par->p,par->q,
                       par->paux,par->qaux,par->ftol,par->atolx,par->rtolx,
                       &(par->x),par->y,par->nDH,&(par->naF),
-                      &(par->naDH),&(par->ndQR),par->F,par->DF);
+                      &(par->naDH),&(par->ndQR),par->F,par->DF,par->data,
+                      &(par->ls));
     (par->nstart)++;
 
+    /* singularidade ou mudanca de posto ou de ordem : a */
+    /* proxima fatoracao de DH e QR e avalia DF          */
+    if (success0 != 0) {
+      par->ls.lcond = 0.0;
+      par->ls.jok   = 0;
+    }
+
     /* escrevendo no vetor de saida de comunicacao */
     /* com o usuario                               */
 
@@ -783,7 +1071,7 @@ vint   infooutput   /* informacoes para saida de dados   */
               &(par->ns),par->psi,&(par->ifase),&(par->dx)); 
 
     /* definindo o contador de erros para o laco principal */
-    nerror = 0;
+    par->nerror = 0;
 
     /* abortando no caso de erro na definicao do vetor tangente */
     if (success0 != 0) {
@@ -895,7 +1183,7 @@ vint   infooutput   /* informacoes para saida de dados   */
   nstep   = 0;
 
   /* definindo que nao ha erro */
-  error   = 0;
+  par->error   = 0;
 
   /* verificando a convergencia:                      */
   /* se o ponto final nao e posterior ao ponto atual  */
@@ -925,9 +1213,9 @@ vint   infooutput   /* informacoes para saida de dados   */
               par->atolx, par->rtolx, par->atoly,par->rtoly,par->ftol,
               &(par->nff),&(par->wtx),par->wty,&(par->Ex),par->Ey, 
 	      &(par->ifase),&(par->ns),&(par->hold),&(par->kold),
-              par->F,par->DF,&(par->sold),&(par->taux),par->tauy,
+              par->F,par->DF,par->data,&(par->sold),&(par->taux),par->tauy,
               &(par->naF),&(par->naDH),&(par->ndQR), 
-              par->deltah,par->deltahx);
+              par->deltah,par->deltahx,&(par->ls));
 
     /* verificar se houve sucesso no passo masterstep */
     if (success == 1) {
@@ -956,7 +1244,7 @@ vint   infooutput   /* informacoes para saida de dados   */
 
         /* definindo a nao ocorrencia de erro nas rotinas masterstep */
         /* e controlstep                                             */
-        error = 0;
+        par->error = 0;
 
       } else {
 
@@ -1031,12 +1319,7 @@ vint   infooutput   /* informacoes para saida de dados   */
       /* reinicializa o metodo com h inicial             */
 
       /* restaura phi */
-      for (k = par->ns+1; k <= par->k+1; k++) {  
-        par->phix[k] /= par->beta[k];
-        for (i = 0; i <= o; i++)
-          for (j = 1; j <= n; j++)
-            par->phiy[k][i][j] /= par->beta[k];
-      }
+      phirestore(n,o,par->ns+1,par->k+1,par->beta,par->phix,par->phiy);
 
       /* restaura psi */  
       for (i = 2; i <= par->k+1; i++)  
@@ -1049,7 +1332,7 @@ vint   infooutput   /* informacoes para saida de dados   */
           par->cy[i][j] = par->cyx[i][j];
    
       /* verificar se e a primeira falha */
-      if (!error) {
+      if (!par->error) {
 
         /* definindo o passo como sendo o passo inicial */
         par->h = par->h0;
@@ -1062,9 +1345,17 @@ vint   infooutput   /* informacoes para saida de dados   */
                           par->DH,par->p,par->q,par->paux,par->qaux,
                           par->ftol,par->atolx,par->rtolx,
                           &(par->x),par->y,par->nDH,&(par->naF),
-                          &(par->naDH),&(par->ndQR),par->F,par->DF);
+                          &(par->naDH),&(par->ndQR),par->F,par->DF,par->data,
+                          &(par->ls));
         (par->nstart)++;
 
+        /* singularidade ou mudanca de posto ou de ordem : a */
+        /* proxima fatoracao de DH e QR e avalia DF          */
+        if (success0 != 0) {
+          par->ls.lcond = 0.0;
+          par->ls.jok   = 0;
+        }
+
         /* escrevendo os novos dados */
         infooutput[1] = success0;
         infooutput[2] = par->rank;
@@ -1081,7 +1372,7 @@ vint   infooutput   /* informacoes para saida de dados   */
       /* no passo masterstep, ou se ocorreram mais que */
       /* quatro falhas, ou se nao houve sucesso na     */
       /* definicao da tangente, o programa e abortado  */
-      if (error || (nerror > 4) || (success0 < 0)) {
+      if (par->error || (par->nerror > 4) || (success0 < 0)) {
 
         /* copiando o ultimo ponto */
         *x         = par->cx;
@@ -1127,10 +1418,10 @@ vint   infooutput   /* informacoes para saida de dados   */
               &(par->ns),par->psi,&(par->ifase),&(par->dx)); 
 
       /* definindo a ocorrencia de erro */
-      error  = 1;
+      par->error  = 1;
 
       /* incrementando o contador de erros */
-      nerror++;
+      par->nerror++;
 
       /* informando ao usuario a mudanca de situacao */ 
       if (success0 > 0) {
@@ -1177,7 +1468,7 @@ vint   infooutput   /* informacoes para saida de dados   */
   /* retornando sucesso no passo de integracao (s = send) */
   return (0);                   
 }  
-/* fim GSDAE */
+/* fim GSDAECTX */
 
 
 
@@ -1203,9 +1494,44 @@ vint   infoinput,   /* informacoes para entrada de dados */
 vint   infooutput   /* informacoes para saida de dados   */
 )
 {
-  /* declarando variaveis locais estaticas para controle de erro */
-  static int error, nerror;
+  /* verificando se foi alocado espaco para os dados */
+  if (par == NULL) {
+
+    /* dados nao alocadaos */
+    return (-1);
+
+  }
+
+  /* integrando com o contexto global */
+  return (CSDAECTX(par,n,o,h,hmin,hmax,cdmax,s,x,xend,y,
+                   atolx,atoly,rtolx,rtoly,ftol,infoinput,infooutput));
+}  
+/* fim CSDAE */
+
 
+
+int 
+CSDAECTX (
+gsdae_ctx *par,     /* contexto do integrador            */
+int    n,           /* dimensao da EAD                   */
+int    o,           /* ordem da EAD                      */
+real   h,           /* passo de integracao               */
+real   hmin,        /* passo minimo de integracao        */
+real   hmax,        /* passo maximo de integracao        */
+real   cdmax,       /* condicao maxima para a derivada   */
+real  *s,           /* c(s) = (x(s),y(s))                */
+real  *x,           /* c(s) = (x(s),y(s))                */
+real   xend,        /* ponto final de integracao         */
+mreal  y,           /* c(s) = (x(s),y(s))                */
+real   atolx,       /* erro absoluto para x              */
+mreal  atoly,       /* erro absoluto para y              */
+real   rtolx,       /* erro realtivo para x              */
+mreal  rtoly,       /* erro realtivo para y              */
+vreal  ftol,        /* erro absoluto para a funcao       */
+vint   infoinput,   /* informacoes para entrada de dados */
+vint   infooutput   /* informacoes para saida de dados   */
+)
+{
   /* declarando variaveis locais de controle */
   int  converg, success, success0, success1, fail;
 
@@ -1213,7 +1539,7 @@ vint   infooutput   /* informacoes para saida de dados   */
   int  nstep;
 
   /* declarando controladores de lacos */
-  int  i, j, k;
+  int  i, j;
 
 
   /* verificando se foi alocado espaco para os dados */
@@ -1234,7 +1560,8 @@ vint   infooutput   /* informacoes para saida de dados   */
     infoinput[1] = 1;
 
     /* verificar a dimensao e a ordem da EAD */
-    if ((o < 0) || (n <= 0)) {
+    if ((o < 0) || (n <= 0) || (n > par->nalloc) || (o > par->oalloc) ||
+        ((par->ls.sp != NULL) && (n != par->nalloc))) {
 
       /* erro na entrada de dados */
       return (-2);
@@ -1328,6 +1655,37 @@ vint   infooutput   /* informacoes para saida de dados   */
 
     }
 
+    /* definindo o resolvedor do sistema linear do metodo */
+    /* de Newton                                          */
+    par->ls.schur = (infoinput[5] == 1);
+
+    /* atualizacoes de Broyden da fatoracao de DH */
+    par->ls.broyden = (infoinput[6] == 1);
+    par->ls.bdim    = 0;
+    par->ls.nbroy   = 0;
+
+    /* politica LU/QR : a primeira fatoracao e sempre QR */
+    par->ls.adapt = (infoinput[7] == 1);
+    par->ls.lu    = 0;
+    par->ls.lcond = 0.0;
+
+    /* refatoracao para um novo cj com a jacobiana guardada */
+    par->ls.cjup = (infoinput[8] == 1);
+    par->ls.jok  = 0;
+    par->ls.ncj  = 0;
+
+    /* o vetor tangente do corretor de Newton-Krylov ainda */
+    /* nao tem uma derivada de referencia                  */
+    if (par->ls.kr != NULL) 
+      par->ls.kr->ref = 0;
+
+    /* com a jacobiana esparsa (ALLOCCTXSPARSE) a rotina DF e */
+    /* sempre utilizada e o sistema e sempre reduzido         */
+    if (par->ls.sp != NULL) {
+      par->nDH      = 1;
+      par->ls.schur = 1;
+    }
+
     /* definindo as tolerancias */
     if (infoinput[3] == 0) {
 
@@ -1517,6 +1875,14 @@ vint   infooutput   /* informacoes para saida de dados   */
 
     }
 
+    /* o corretor de Newton-Krylov supoe DFy[o] regular */
+    if ((par->ls.kr != NULL) && (par->rank != n)) {
+
+      /* erro na entrada de dados */
+      return (-2);
+
+    }
+
     /* inicializando os contadores de passos,     */
     /* passos falhos, falhas no metodo de Newton, */
     /* numero de avaliacao da funcao, numero de   */
@@ -1530,6 +1896,14 @@ vint   infooutput   /* informacoes para saida de dados   */
     par->naDH   = 0;
     par->ndQR   = 0;
     par->nstart = 0;
+    par->ls.nlu = 0;
+    par->ls.nsw = 0;
+
+    /* inicializando o contador de falhas consecutivas e a */
+    /* avaliacao da jacobiana, de modo que um contexto     */
+    /* reutilizado se comporte como um contexto novo       */
+    par->cfalhas = 0;
+    par->aDH     = 0;
 
     /* definindo o vetor tangente ao ponto inicial e     */
     /* caso haja queda de posto definindo o novo posto e */
@@ -1539,9 +1913,17 @@ vint   infooutput   /* informacoes para saida de dados   */
                       par->cdmax,par->dir,par->Q,par->DH,par->p,par->q,
                       par->paux,par->qaux,par->ftol,par->atolx,par->rtolx,
                       &(par->x),par->y,par->nDH,&(par->naF),
-                      &(par->naDH),&(par->ndQR),par->F,par->DF);
+                      &(par->naDH),&(par->ndQR),par->F,par->DF,par->data,
+                      &(par->ls));
     (par->nstart)++;
 
+    /* singularidade ou mudanca de posto ou de ordem : a */
+    /* proxima fatoracao de DH e QR e avalia DF          */
+    if (success0 != 0) {
+      par->ls.lcond = 0.0;
+      par->ls.jok   = 0;
+    }
+
     /* escrevendo no vetor de saida de comunicacao */
     /* com o usuario                               */
 
@@ -1587,7 +1969,7 @@ vint   infooutput   /* informacoes para saida de dados   */
               &(par->ns),par->psi,&(par->ifase),&(par->dx)); 
 
     /* definindo o contador de erros para o laco principal */
-    nerror = 0;
+    par->nerror = 0;
 
     /* abortando no caso de erro na definicao do vetor tangente */
     if (success0 != 0) {
@@ -1716,12 +2098,12 @@ vint   infooutput   /* informacoes para saida de dados   */
   nstep   = 0;
 
   /* definindo que nao ha erro */
-  error   = 0;
+  par->error   = 0;
 
   /* verificando a convergencia:                      */
   /* se o ponto final nao e posterior ao ponto atual  */
   /* basta interpolar a solucao                       */
-  if ((xend-par->cx)*par->dir >= 0.0) {
+  if ((par->cx-xend)*par->dir >= 0.0) {
 
     /* definindo a convergencia */
     converg = 1;
@@ -1746,9 +2128,9 @@ vint   infooutput   /* informacoes para saida de dados   */
               par->atolx, par->rtolx, par->atoly,par->rtoly,par->ftol,
               &(par->nff),&(par->wtx),par->wty,&(par->Ex),par->Ey, 
 	      &(par->ifase),&(par->ns),&(par->hold),&(par->kold),
-              par->F,par->DF,&(par->sold),&(par->taux),par->tauy,
+              par->F,par->DF,par->data,&(par->sold),&(par->taux),par->tauy,
               &(par->naF),&(par->naDH),&(par->ndQR), 
-              par->deltah,par->deltahx);
+              par->deltah,par->deltahx,&(par->ls));
 
     /* verificar se houve sucesso no passo masterstep */
     if (success == 1) {
@@ -1777,7 +2159,7 @@ vint   infooutput   /* informacoes para saida de dados   */
 
         /* definindo a nao ocorrencia de erro nas rotinas masterstep */
         /* e controlstep                                             */
-        error = 0;
+        par->error = 0;
 
       } else {
 
@@ -1852,12 +2234,7 @@ vint   infooutput   /* informacoes para saida de dados   */
       /* reinicializa o metodo com h inicial             */
 
       /* restaura phi */
-      for (k = par->ns+1; k <= par->k+1; k++) {  
-        par->phix[k] /= par->beta[k];
-        for (i = 0; i <= o; i++)
-          for (j = 1; j <= n; j++)
-            par->phiy[k][i][j] /= par->beta[k];
-      }
+      phirestore(n,o,par->ns+1,par->k+1,par->beta,par->phix,par->phiy);
 
       /* restaura psi */  
       for (i = 2; i <= par->k+1; i++)  
@@ -1870,7 +2247,7 @@ vint   infooutput   /* informacoes para saida de dados   */
           par->cy[i][j] = par->cyx[i][j];
 
       /* verificar se e a primeira falha */
-      if (!error) {
+      if (!par->error) {
 
         /* definindo o passo como sendo o passo inicial */
         par->h = par->h0;
@@ -1883,9 +2260,17 @@ vint   infooutput   /* informacoes para saida de dados   */
                           par->DH,par->p,par->q,par->paux,par->qaux,
                           par->ftol,par->atolx,par->rtolx,
                           &(par->x),par->y,par->nDH,&(par->naF),
-                          &(par->naDH),&(par->ndQR),par->F,par->DF);
+                          &(par->naDH),&(par->ndQR),par->F,par->DF,par->data,
+                          &(par->ls));
         (par->nstart)++;
 
+        /* singularidade ou mudanca de posto ou de ordem : a */
+        /* proxima fatoracao de DH e QR e avalia DF          */
+        if (success0 != 0) {
+          par->ls.lcond = 0.0;
+          par->ls.jok   = 0;
+        }
+
         /* escrevendo os novos dados */
         infooutput[1] = success0;
         infooutput[2] = par->rank;
@@ -1902,7 +2287,7 @@ vint   infooutput   /* informacoes para saida de dados   */
       /* no passo masterstep, ou se ocorreram mais que */
       /* quatro falhas, ou se nao houve sucesso na     */
       /* definicao da tangente, o programa e abortado  */
-      if (error || (nerror > 4) || (success0 < 0)) {
+      if (par->error || (par->nerror > 4) || (success0 < 0)) {
 
         /* copiando o ultimo ponto */
         *x         = par->cx;
@@ -1948,10 +2333,10 @@ vint   infooutput   /* informacoes para saida de dados   */
                 &(par->ns),par->psi,&(par->ifase),&(par->dx)); 
 
       /* definindo a ocorrencia de erro */
-      error  = 1;
+      par->error  = 1;
 
       /* incrementando o contador de erros */
-      nerror++;
+      par->nerror++;
 
       /* informando ao usuario a mudanca de situacao */ 
       if (success0 > 0) {
@@ -1970,7 +2355,7 @@ vint   infooutput   /* informacoes para saida de dados   */
     }
              
      /* verificando a convergencia */
-    if ((xend-par->cx)*par->dir >= 0.0) {
+    if ((par->cx-xend)*par->dir >= 0.0) {
 
       /* definindo a convergencia */
       converg = 1;
@@ -1998,7 +2383,7 @@ vint   infooutput   /* informacoes para saida de dados   */
   /* retornando sucesso no passo de integracao (s = send) */
   return (0);                   
 }  
-/* fim CSDAE */
+/* fim CSDAECTX */
 
 
 
@@ -2018,6 +2403,31 @@ int  *nqr,
 int  *nstart,
 int  *nfnew
 )
+{
+  STATISTICSCTX(par,s,nstep,nreject,nsuc,nfunc,njac,nqr,nstart,nfnew);
+
+  return;
+}
+
+
+
+/*******************************************************/
+/* rotina que retorna os contadores de um contexto     */
+/*******************************************************/
+
+void 
+STATISTICSCTX (
+gsdae_ctx *par,
+real      *s,
+int       *nstep,
+int       *nreject,
+int       *nsuc,
+int       *nfunc,
+int       *njac,
+int       *nqr,
+int       *nstart,
+int       *nfnew
+)
 {
   *s       = par->s;
   *nstep   = par->nstep;
@@ -2031,12 +2441,50 @@ int  *nfnew
 
   return;
 }
-                                         
-  
 
 
 
 
+/*******************************************************/
+/* rotina que retorna os contadores da politica LU/QR  */
+/* (infoinput[7] = 1) : nlu decomposicoes de DH por LU */
+/* (as demais das nqr de STATISTICS sao QR) e nsw      */
+/* trocas entre LU e QR                                */
+/*******************************************************/
+
+void 
+STATISTICSLU (
+int *nlu,
+int *nsw
+)
+{
+  STATISTICSLUCTX(par,nlu,nsw);
+
+  return;
+}
+
+
+
+/*******************************************************/
+/* rotina que retorna os contadores da politica LU/QR  */
+/* de um contexto                                      */
+/*******************************************************/
+
+void 
+STATISTICSLUCTX (
+gsdae_ctx *par,
+int       *nlu,
+int       *nsw
+)
+{
+  *nlu = par->ls.nlu;
+  *nsw = par->ls.nsw;
+
+  return;
+}
+
+
+
 /**********************************************************/
 /* Esta rotina retorna uma menssagem de erro de acordo    */
 /* com o valor da variavel status que e um parametro de   */
@@ -2229,9 +2677,10 @@ mreal  wty
 
   *wtx = rtolx*fabs(cx)+atolx;
 
+  /* linhas 0..o-1 completas : acesso sequencial */
   for (i = 0; i <= o-1; i++)   
     for (j = 1; j <= n; j++)   
-       wty[i][q[j]] = rtoly[i][q[j]]*fabs(cy[i][q[j]])+atoly[i][q[j]];
+       wty[i][j] = rtoly[i][j]*fabs(cy[i][j])+atoly[i][j];
 
   for (j = 1; j <= r; j++)   
     wty[o][q[j]] = rtoly[o][q[j]]*fabs(cy[o][q[j]])+atoly[o][q[j]];
@@ -2258,23 +2707,49 @@ real   wtx,
 mreal  wty
 )
 {
-  int  i,j;
+  int  i;
+  real vmax;
+
+  /* as linhas 0..o-1 sao completas e percorridas em ordem; */
+  /* a linha o usa as r primeiras colunas de q              */
+  vmax = fabs(cx/wtx); 
+  for (i = 0; i <= o-1; i++) 
+    vmax = KERNWMAX(n,cy[i]+1,wty[i]+1,NULL,vmax);
+  vmax = KERNWMAX(r,cy[o],wty[o],q+1,vmax);
+
+  return (weightnormvmax(n,o,r,cx,cy,q,wtx,wty,vmax));
+} 
+/* fim weightnorm */  
+
+
+
+/* ********************************************* */
+/* segunda passagem de weightnorm : norma peso   */
+/* de c = (cx,cy) dado vmax = max |c/wtc|, ja    */
+/* obtido por quem percorreu c (PREDICTSTEP e o  */
+/* corretor de masterstep)                       */
+/* ********************************************* */
+
+real 
+weightnormvmax (
+int    n, 
+int    o,
+int    r, 
+real   cx, 
+mreal  cy,
+vint   q,
+real   wtx, 
+mreal  wty,
+real   vmax
+)
+{
+  int  i;
   int  neq;
-  real vmax,aux;
   real norm;
 
   neq  = o*n+r+1;
   norm = 0.0;  
 
-  vmax = fabs(cx/wtx); 
-  for (i = 0; i <= o-1; i++) 
-    for (j = 1; j <= n; j++)    
-      if ((aux = fabs(cy[i][q[j]]/wty[i][q[j]])) >= vmax) 
-        vmax = aux;
-  for (j = 1; j <= r; j++)    
-    if ((aux = fabs(cy[o][q[j]]/wty[o][q[j]])) >= vmax) 
-      vmax = aux;
-
   if (vmax == 0.0) {
 
     return (0.0);
@@ -2284,21 +2759,15 @@ mreal  wty
     norm  = (cx/wtx)/vmax;  
     norm *= norm; 
     for (i = 0; i <= o-1; i++)
-      for (j = 1; j <= n; j++) {
-        aux    = (cy[i][q[j]]/wty[i][q[j]])/vmax;
-        norm  += aux*aux;
-      }
-    for (j = 1; j <= r; j++) {
-      aux    = (cy[o][q[j]]/wty[o][q[j]])/vmax;
-      norm  += aux*aux;
-    }
+      norm += KERNWSSQ(n,cy[i]+1,wty[i]+1,NULL,vmax);
+    norm += KERNWSSQ(r,cy[o],wty[o],q+1,vmax);
     norm = vmax*sqrt(norm/neq);
 
   }
 
   return (norm);   
 } 
-/* fim weightnorm */  
+/* fim weightnormvmax */  
 
 
 
@@ -2320,7 +2789,39 @@ vint  p,
 vint  q,
 vreal delta, 
 vreal deltah,
-void  (*F)(int,int,real,mreal,vreal)
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  *data
+)
+{ 
+  /* deltah[i] = F(c(s))[i] (i = 1..n) */
+
+  F(o,n,x,y,delta,data);  
+  SETHW(n,o,r,h,dpx,dpy,y,p,q,delta,deltah);
+
+  return;
+} 
+/* fim SETH */
+
+
+
+/* *********************************************************** */
+/*  Rotina para a construcao de H(c) a partir de delta = F(c)  */
+/*  ja avaliada                                                */
+/* *********************************************************** */
+
+void 
+SETHW (
+int   n,          
+int   o,
+int   r,
+real  h,
+real  dpx,
+mreal dpy,
+mreal y,       
+vint  p,
+vint  q,
+vreal delta, 
+vreal deltah
 )
 { 
   int  i,j;
@@ -2328,7 +2829,6 @@ void  (*F)(int,int,real,mreal,vreal)
       
   /* deltah[i] = F(c(s))[i] (i = 1..n) */
 
-  F(o,n,x,y,delta);  
   for (i = 1; i <= n; i++)
     deltah[i] = delta[p[i]];
 
@@ -2363,7 +2863,7 @@ void  (*F)(int,int,real,mreal,vreal)
   
   return;
 } 
-/* fim SETH */
+/* fim SETHW */
 
 
 
@@ -2387,116 +2887,95 @@ vint    p,
 vint    q,
 vreal   DFx,
 mmreal  DFy,
-void    (*DF)(int,int,real,mreal,vreal,mmreal),
+void    (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
 mreal   DH 
 )
 {
-  int  i,j,k,l;
-  real cjaux;
+  int   i,j,k,l;
+  int   dim;    /* dimensao de DH                */
+  int   c0;     /* primeira coluna do bloco      */
+  real  cjaux;
+  real  hdpx;   /* h*dpx                         */
+  vreal DHi;    /* linha de DH                   */
   
   cjaux = cj*h;
+  hdpx  = h*dpx;
+  dim   = o*n+r+1;
       
-  /* avaliacao de DF */
-  DF(o,n,px,py,DFx,DFy); 
+  /* avaliacao de DF (DF = NULL : DFx e DFy ja avaliadas) */
+  if (DF != NULL) 
+    DF(o,n,px,py,DFx,DFy,data); 
 
   /*  construcao de DH[i][j] (i = 1..n, j = 1..(o+1)n)  */
   for (i = 1; i <= r; i++)
     for (j = 1; j <= r; j++)
-      DH[i][j] = DFy[o][q[i]][p[j]];
+      DH[i][j] = DFy[o][q[j]][p[i]];
   for (i = r+1; i <= n; i++)
     for (j = 1; j <= r; j++)
       DH[i][j] = 0.0;
-  for (k = o-1; k >= 0; k--)
-    for (i = 1; i <= n; i++)
+  for (k = o-1; k >= 0; k--) {
+    c0 = (o-k-1)*n+r;
+    for (i = 1; i <= n; i++) {
+      DHi = DH[i];
       for (j = 1; j <= n; j++)
-        DH[i][(o-k-1)*n+r+j] = DFy[k][q[j]][p[i]];
+        DHi[c0+j] = DFy[k][q[j]][p[i]];
+    }
+  }
 
   /*  DH[i][on+r+1] = DFx[i] (i = 1..n) */
   for (i = 1; i <= n; i++)
-    DH[i][o*n+r+1] = DFx[p[i]];
+    DH[i][dim] = DFx[p[i]];
 
-  /*  DH[n+i][on+r+1] = cj y0[o][i] (i = 1..r) */
-  for (i = 1; i <= r; i++)
-    DH[n+i][o*n+r+1] = cjaux*py[o][q[i]];
-  
-  /*  DH[(o-k)n+r+i][on+r+1] = cj y0[k][i] (i = 1..r, k = o-1..1) */
-  for (k = o-1; k >= 1; k--)
-    for (i = 1; i <= n; i++)
-      DH[(o-k)*n+r+i][o*n+r+1] = cjaux*py[k][q[i]];
+  /*  linhas da cadeia de derivadas (i = n+1..on+r) : apenas  */
+  /*  h*dpx, -cj e cj y0 sao nao nulos, por isso a linha e    */
+  /*  anulada e os tres elementos sao escritos                */
+  if (o > 0) {
 
-  /*  construcao de DH[i][j] (i = n+r..on, j = r..(o+1)n) */
-  for (l = o-1; l >= 1; l --)    
-    for (k = o-1; k >= 0; k--)   
-      for (i = 1; i <= n; i++)
-        for (j = 1; j <= n; j++) 
-          if (l == k) {
-            if (i == j) 
-              DH[(o-l)*n+r+i][(o-1-k)*n+r+j] = h*dpx;
-            else  
-              DH[(o-l)*n+r+i][(o-1-k)*n+r+j] = 0.0;
-          } else if (l == k+1) {
-            if (i == j) 
-              DH[(o-l)*n+r+i][(o-1-k)*n+r+j] = -cjaux;
-            else  
-              DH[(o-l)*n+r+i][(o-1-k)*n+r+j] = 0.0;
-          } else {
-            DH[(o-l)*n+r+i][(o-1-k)*n+r+j] = 0.0;
-          }
-             
-  /*  construcao de DH[i][j] (i = n+1..n+r, j = 1..o*n+r) */
-  for (i = 1; i <= r; i++) { 
-    for (j = 1; j <= r; j++)  
-      if (i == j) {
-        DH[n+i][j]   = h*dpx;
-        DH[n+i][r+j] = -cjaux;
-      } else {  
-        DH[n+i][j]   = 0.0;
-        DH[n+i][r+j] = 0.0;
+    /*  DH[n+i][i] = h dpx, DH[n+i][r+i] = -cj,              */
+    /*  DH[n+i][on+r+1] = cj y0[o][i] (i = 1..r)              */
+    for (i = 1; i <= r; i++) { 
+      DHi = DH[n+i];
+      for (j = 1; j < dim; j++)  
+        DHi[j] = 0.0; 
+      DHi[i]   = hdpx;
+      DHi[r+i] = -cjaux;
+      DHi[dim] = cjaux*py[o][q[i]];
+    }    
+
+    /*  DH[(o-l)n+r+i][(o-l-1)n+r+i] = h dpx,                */
+    /*  DH[(o-l)n+r+i][(o-l)n+r+i]   = -cj,                  */
+    /*  DH[(o-l)n+r+i][on+r+1]       = cj y0[l][i]            */
+    /*  (i = 1..n, l = o-1..1)                                */
+    for (l = o-1; l >= 1; l--) {
+      c0 = (o-l)*n+r;
+      for (i = 1; i <= n; i++) {
+        DHi = DH[c0+i];
+        for (j = 1; j < dim; j++)  
+          DHi[j] = 0.0; 
+        DHi[c0-n+i] = hdpx;
+        DHi[c0+i]   = -cjaux;
+        DHi[dim]    = cjaux*py[l][q[i]];
       }
-    for (j = n+r+1; j <= o*n+r; j++)  
-      DH[i][j] = 0.0; 
-  }    
-    
-  /*  construcao de DH[i][j] (i = n+1+r..(o-1)n, j = 1..r) */
-  for (i = n+r+1; i <= o*n+r; i++)
-    for (j = 1; j <= r; j ++)
-      DH[i][j] = 0.0;
+    }
+
+  }
 
   /*  construcao de DH[(o+1)*n+1][i] (i = 1..on) */
+  DHi = DH[dim];
   for (i = 1; i <= r; i++)
-    DH[o*n+r+1][i] = 2.0*cjaux*dpy[o][i]; 
+    DHi[i] = 2.0*cjaux*dpy[o][q[i]]; 
 
   for (k = o-1; k >= 0; k--)
     for (i = 1; i <= n; i++)
-      DH[o*n+r+1][(o-k-1)*n+r+i] = 2.0*cjaux*dpy[k][q[i]]; 
+      DHi[(o-k-1)*n+r+i] = 2.0*cjaux*dpy[k][q[i]]; 
     
   /*  construcao de DH[(o+1)*n+1][(o+1)*n+1] */
-  DH[o*n+r+1][o*n+r+1] = 2.0*cjaux*dpx;
+  DHi[dim] = 2.0*cjaux*dpx;
 
-/*
-  printf("\n\n\n\n");
-  printf("cjaux = %lf\n",cjaux);
-  printf("px = %lf, dpx = %lf\n",px,dpx);
-  for (k = 0; k < o; k++)
-    for (i = 1; i <= n; i++) 
-      printf("py[%d][%d] = %lf, dpy[%d][%d] = %lf\n",k,i,py[k][i],k,i,dpy[k][i]);
-  for (i = 1; i <= r; i++) 
-    printf("py[%d][%d] = %lf, dpy[%d][%d] = %lf\n",o,i,py[k][i],o,i,dpy[k][i]);
-  printf("\n\n");
-
-  for (i = 1; i <= o*n+r+1; i++) {
-    for (j = 1; j <= o*n+r+1; j++) {
-      printf("%lf ",DH[i][j]);
-    }
-    printf("\n");
-  }
-  exit(0);
-*/
-      
-
-  return;
-} 
-/* fim SETDH */
+  return;
+} 
+/* fim SETDH */
 
 
 
@@ -2527,17 +3006,42 @@ vreal   deltaaux,
 vreal   deltah,
 vreal   deltahaux,
 mreal   DH,
-void   (*F)(int,int,real,mreal,vreal) 
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
 )
 {
-  int  i, j, k;  /* variaveis auxiliares   */
-  real del;      /* armazenar o incremento */
-  real save;     /* armazena o ponto       */
-  real dsave;    /* armazena a derivada    */
+  int    i, j, k;  /* variaveis auxiliares   */
+  real   del;      /* armazenar o incremento */
+  real   save;     /* armazena o ponto       */
+  real   dsave;    /* armazena a derivada    */
+  fdjac *fd;       /* threads da jacobiana   */
 
   /* calculando a menor constante */ 
   uround   = sqrt(uround);
 
+  /* com Fb (SETFBATCH) as colunas sao avaliadas em lotes; */
+  /* com F segura sao divididas entre as threads            */
+  if ((ls->fb != NULL) || (ls->fd != NULL)) {
+    fd = (ls->fb != NULL) ? &(ls->fb->task) : ls->fd;
+    FDSETUP(fd,GSDAE_FDDH,(o+1)*n+1,n,o,r,dim,x,y,deltah,F,data);
+    fd->uround = uround;
+    fd->h      = h;
+    fd->cj     = cj;
+    fd->dx     = dx;
+    fd->wtx    = wtx;
+    fd->dys    = dy;
+    fd->wty    = wty;
+    fd->p      = p;
+    fd->q      = q;
+    fd->DH     = DH;
+    if (ls->fb != NULL) 
+      FBRUN(ls->fb);
+    else
+      POOLRUN(fd->pl,FDTASK,(void *) fd);
+    return;
+  }
+
   /* calculando a derivada aproximada com relacao a x */
 
   /* calculando o incremento */
@@ -2555,7 +3059,7 @@ void   (*F)(int,int,real,mreal,vreal)
   del   = 1.0/del;
 
   /* avaliando H */
-  SETH(n,o,r,h,dx,dy,x,y,p,q,deltaaux,deltahaux,F);
+  SETH(n,o,r,h,dx,dy,x,y,p,q,deltaaux,deltahaux,F,data);
 
   /* calculando a derivada aproximada */
   for (i = 1; i <= dim; i++)
@@ -2584,7 +3088,7 @@ void   (*F)(int,int,real,mreal,vreal)
       del       = 1.0/del;
 
       /* avaliando H */
-      SETH(n,o,r,h,dx,dy,x,y,p,q,deltaaux,deltahaux,F);
+      SETH(n,o,r,h,dx,dy,x,y,p,q,deltaaux,deltahaux,F,data);
 
       /* calculando a derivada aproximada */
       for (j = 1; j <= dim; j++)
@@ -2602,9 +3106,64 @@ void   (*F)(int,int,real,mreal,vreal)
 
 
 
+/* ******************************************************** */
+/* predicao de x e da linha o : phix* e pcx, pdcx; phiy*    */
+/* em todas as colunas da linha o e pcy, pdcy nas colunas   */
+/* q[1..r]                                                  */
+/* ******************************************************** */
+
+void 
+predictlast (
+int     n, 
+int     o, 
+int     r, 
+int     k, 
+int     ns,
+vreal   beta, 
+vreal   gama, 
+vreal   phix,
+mmreal  phiy,
+real   *pcx,
+mreal   pcy,
+real   *pdcx,
+mreal   pdcy,
+vint    q
+)
+{   
+  int   j,l;
+  real  b;     /* beta[l]                      */
+
+  /* calculo de phix estrela, pcx e pdcx */
+  *pcx = *pdcx = 0.0;
+  for (l = 1; l <= k+1; l++) {
+    if (l > ns) 
+      phix[l] *= beta[l]; 
+    (*pcx)  += phix[l];
+    (*pdcx) += gama[l]*phix[l];
+  }
+
+  /* linha o */
+  for (l = ns+1; l <= k+1; l++)    
+    for (j = 1, b = beta[l]; j <= n; j++) 
+      phiy[l][o][j] *= b;
+  for (j = 1; j <= r; j++)   
+    pcy[o][q[j]] = pdcy[o][q[j]] = 0.0;
+  for (l = 1; l <= k+1; l++)   
+    KERNACC(r,gama[l],phiy[l][o],pcy[o],pdcy[o],q+1);
+
+  return;
+}  
+/* fim predictlast */
+
+
+
 /* ******************************************************** */
 /* rotina para realizar a predicao do ponto pc = (pcx,pcy), */
-/* e de pdc = (pdcx,pdcy)  atraves do polinomio preditor    */    
+/* e de pdc = (pdcx,pdcy)  atraves do polinomio preditor.   */
+/* Antes troca phi por phi* (phi[l] *= beta[l], l > ns).    */
+/* Nas linhas 0..o-1 as tres operacoes sao feitas por       */
+/* kern.pred, que percorre as k+1 linhas do historico (a    */
+/* distancia ld no bloco de ALLOCPHI) de uma so vez.        */
 /* ******************************************************** */
 
 void 
@@ -2613,6 +3172,8 @@ int     n,
 int     o, 
 int     r, 
 int     k, 
+int     ns,
+vreal   beta, 
 vreal   gama, 
 vreal   phix,
 mmreal  phiy,
@@ -2624,37 +3185,20 @@ vint    q,
 vreal   u
 )
 {   
-  int i,j,l;
+  int   i,j;
+  int   ld;    /* distancia entre phiy[l] e phiy[l+1] */
 
-  /* calculo de pcx e de pdcx */
-  *pcx = *pdcx = 0.0;
-  for (i = 1; i <= k+1; i++) {
-    (*pcx)  += phix[i];
-    (*pdcx) += gama[i]*phix[i];
-  }
-
-  /* calculo de pcy e de pdcy */
-  for (i = 0; i < o; i++) {   
-    for (j = 1; j <= n; j++) {  
-      pcy[i][q[j]] = pdcy[i][q[j]] = 0.0;
-      for (l = 1; l <= k+1; l++) {  
-         pcy[i][q[j]]  += phiy[l][i][q[j]];
-         pdcy[i][q[j]] += gama[l]*phiy[l][i][q[j]];
-      }
-    }
-  }  
+  /* x e linha o */
+  predictlast(n,o,r,k,ns,beta,gama,phix,phiy,pcx,pcy,pdcx,pdcy,q);
 
-  for (j = 1; j <= r; j++) {  
-    pcy[o][q[j]] = pdcy[o][q[j]] = 0.0;
-    for (l = 1; l <= k+1; l++) {  
-       pcy[o][q[j]]  += phiy[l][o][q[j]];
-       pdcy[o][q[j]] += gama[l]*phiy[l][o][q[j]];
-    }
-  }  
+  /* linhas 0..o-1 completas */
+  ld = phiy[2][0]-phiy[1][0];
+  for (i = 0; i < o; i++)    
+    KERNPRED(n,k+1,ns,beta+1,gama+1,phiy[1][i]+1,ld,pcy[i]+1,pdcy[i]+1);
 
   /* calculo do vetor u utilizado no proc. NEWTON p/ correcao do ponto */
   for (j = 1; j <= r; j++) 
-    u[j] = pcy[i][q[j]];
+    u[j] = pcy[o][q[j]];
   for (i = o-1; i >= 0; i--) 
     for (j = 1; j <= n; j++) 
       u[(o-i)*n+j] = pcy[i][q[j]];
@@ -2663,6 +3207,102 @@ vreal   u
   return;
 }  
 /* fim predictor */
+
+
+
+/* ************************************************************ */
+/* Inicio do passo em masterstep : vetor peso em c (weightvec-  */
+/* tor), ponto predito (predictor), c guardado em cx e trocado  */
+/* pelo ponto predito, vetor erro zerado e norma peso do ponto  */
+/* predito, que e o valor retornado. Cada bloco de colunas e    */
+/* lido uma vez para tudo isso, de modo que c, pc, wtc, E e o   */
+/* historico sao percorridos juntos; so a soma de weightnorm    */
+/* exige uma segunda passagem, depois de conhecido vmax.        */
+/* ************************************************************ */
+
+real 
+PREDICTSTEP (
+int     n, 
+int     o, 
+int     r, 
+int     k, 
+int     ns,
+vreal   beta, 
+vreal   gama, 
+vreal   phix,
+mmreal  phiy,
+real   *cx,
+mreal   cy,
+real   *cxx,
+mreal   cyx,
+real   *pcx,
+mreal   pcy,
+real   *pdcx,
+mreal   pdcy,
+real   *Ex,
+mreal   Ey,
+vint    q,
+vreal   u,
+real    atolx,
+real    rtolx,
+mreal   atoly,
+mreal   rtoly,
+real   *wtx,
+mreal   wty
+)
+{   
+  int   i,j;
+  int   j0,nb; /* bloco de colunas j0..j0+nb-1        */
+  int   ld;    /* distancia entre phiy[l] e phiy[l+1] */
+  real  vmax;  /* max |pc/wtc|                        */
+  size_t bytes;
+
+  /* vetor peso e predicao em x e na linha o */
+  *wtx = rtolx*fabs(*cx)+atolx;
+  for (j = 1; j <= r; j++)   
+    wty[o][q[j]] = rtoly[o][q[j]]*fabs(cy[o][q[j]])+atoly[o][q[j]];
+  predictlast(n,o,r,k,ns,beta,gama,phix,phiy,pcx,pcy,pdcx,pdcy,q);
+  vmax = fabs((*pcx)/(*wtx)); 
+  ld   = phiy[2][0]-phiy[1][0];
+
+  /* linhas 0..o-1 por blocos : o vetor peso usa c antes */
+  /* de c ser trocado pelo ponto predito                 */
+  for (i = 0; i < o; i++)    
+    for (j0 = 1; j0 <= n; j0 += GSDAE_PHIBLK) {
+      nb    = MIN2(GSDAE_PHIBLK,n-j0+1);
+      bytes = nb*sizeof(real);
+      for (j = j0; j < j0+nb; j++)   
+        wty[i][j] = rtoly[i][j]*fabs(cy[i][j])+atoly[i][j];
+      KERNPRED(nb,k+1,ns,beta+1,gama+1,phiy[1][i]+j0,ld,pcy[i]+j0,
+                pdcy[i]+j0);
+      memcpy(cyx[i]+j0,cy[i]+j0,bytes);
+      memcpy(cy[i]+j0,pcy[i]+j0,bytes);
+      memset(Ey[i]+j0,0,bytes);
+      vmax = KERNWMAX(nb,pcy[i]+j0,wty[i]+j0,NULL,vmax);
+    }
+
+  /* linha o e x */
+  bytes = n*sizeof(real);
+  memcpy(cyx[o]+1,cy[o]+1,bytes);
+  memcpy(cy[o]+1,pcy[o]+1,bytes);
+  memset(Ey[o]+1,0,bytes);
+  vmax = KERNWMAX(r,pcy[o],wty[o],q+1,vmax);
+  *cxx = *cx;
+  *cx  = *pcx; 
+  *Ex  = 0.0;
+
+  /* calculo do vetor u utilizado no proc. NEWTON p/ correcao do ponto */
+  for (j = 1; j <= r; j++) 
+    u[j] = pcy[o][q[j]];
+  for (i = o-1; i >= 0; i--) 
+    for (j = 1; j <= n; j++) 
+      u[(o-i)*n+j] = pcy[i][q[j]];
+  u[o*n+r+1] = *pcx;
+
+  /* norma peso do ponto predito */
+  return (weightnormvmax(n,o,r,*pcx,pcy,q,*wtx,wty,vmax));
+}  
+/* fim PREDICTSTEP */
    
 
 
@@ -2692,14 +3332,12 @@ real   *cjold,
 real   *factor,
 int    *aDH,
 real   *ck,
-vreal   phix,
-mmreal  phiy,
 int    *ns,
 real   *hold,
 int    *kold 
 )
 {  
-  int  i,j,l ;      /* controladores de loop     */
+  int  i ;          /* controlador de loop       */
   int  kp1,kp2,km1; /*  valores de k+1, k+2, k-1 */ 
   real hx1,hx2;     /* variaveis auxiliares */
   real cjlast ;     /* var. p/ guardar o ultimo valor de cj  */ 
@@ -2739,24 +3377,30 @@ int    *kold
   } 
   /* fim if */
 
-  /* calculo de alfas e alfa0 */
-  (*alfas) = (alfa0) = 0.0;
-  for (i = 1; i < kp1; i++) { 
-    *alfas -= 1.0/(real)i ; 
-    alfa0  -= alfa[i];
-  }  
+  cjlast = *cj;     
+  if (kp1 >= (*ns)) {
 
-  /* calculo dos coeficientes principais */
+    /* calculo de alfas e alfa0 */
+    (*alfas) = (alfa0) = 0.0;
+    for (i = 1; i < kp1; i++) { 
+      *alfas -= 1.0/(real)i ; 
+      alfa0  -= alfa[i];
+    }  
 
-  /* cj eh inicializado qdo k = 1  */
-  cjlast = *cj;     
-  *cj    = -(*alfas)/h; 
+    /* calculo dos coeficientes principais */
+
+    /* cj eh inicializado qdo k = 1  */
+    *cj    = -(*alfas)/h; 
 
-  /* calculo dos coeficientes p/ o erro com passo variavel */ 
+    /* calculo dos coeficientes p/ o erro com passo variavel */ 
 
-  /* valor utilizado no teste de aceitacao do passo */
-  *ck = alfa[kp1]+(*alfas)-alfa0;
-  *ck = MAX2(fabs(*ck),alfa[kp1]); 
+    /* valor utilizado no teste de aceitacao do passo */
+    *ck = alfa[kp1]+(*alfas)-alfa0;
+    *ck = MAX2(fabs(*ck),alfa[kp1]); 
+
+  } 
+  /* com ns > k+1 os k+1 passos anteriores usaram os mesmos h e k : */
+  /* alfa nao mudou e alfas, cj e ck da chamada anterior valem      */
 
   /* teste p/ verificar se nova jacobiana eh necessaria  */
 
@@ -2780,19 +3424,9 @@ int    *kold
     /* inicializando factor */
     *factor = 100.0;
   }
- 
-  /* troca de phi por phi*,  phi = (phix,phiy) */
-  if (kp1 >= (*ns)+1) {  
-    /* troca de phix por phix estrela */
-    for (i = (*ns)+1; i <= kp1; i++)
-      phix[i] *= beta[i]; 
-   
-    /* troca de phiy por phiy estrela */
-    for (l = (*ns)+1; l <= kp1; l++)  
-      for (i = 0; i <= o; i++)
-        for (j = 1; j <= n; j++) 
-          phiy[l][i][j] *= beta[l];
-  } 
+
+  /* a troca de phi por phi* (phi*beta, l > ns) e feita em */
+  /* predictor, na mesma passagem que calcula pc e pdc     */
 
   return;
 }  
@@ -2800,6 +3434,44 @@ int    *kold
 
 
 
+/* ************************************************************ */
+/* Esta rotina desfaz a troca de phi por phi* feita em predictor */
+/* (phi[l] /= beta[l], l = l0..l1) apos uma falha do passo. As  */
+/* linhas y[0..o] de phiy[l] sao contiguas (veja ALLOCPHI) e    */
+/* sao percorridas de uma so vez.                               */
+/* ************************************************************ */
+
+void 
+phirestore (
+int    n,
+int    o,
+int    l0,
+int    l1,
+vreal  beta,
+vreal  phix,
+mmreal phiy
+)
+{   
+  int   j,l;
+  int   m;     /* (o+1)*n                      */
+  real  b;     /* beta[l]                      */
+  vreal v;     /* linha l de phi               */
+
+  m = (o+1)*n;
+  for (l = l0; l <= l1; l++) {  
+    b        = beta[l];
+    phix[l] /= b;
+    v        = phiy[l][0];
+    for (j = 1; j <= m; j++)
+      v[j] /= b;
+  }
+
+  return;
+}
+/* fim phirestore */
+
+
+
 /* ********************************** */
 /* UPDATE de phi, phi = (phix, phiy ) */
 /* ********************************** */
@@ -2818,34 +3490,30 @@ vreal  phix,
 mmreal phiy
 )
 {   
-  int  i,j,l ;    /* controladores de loop  */
+  int  i,l ;    /* controladores de loop        */
+  int  j0,nb;   /* bloco de colunas j0..j0+nb-1 */
   
   /* calculando as novas diferencas divididas */
 
-  /* se a ordem e menor que 5 */
-  if (kold < 5) { 
-   
-    /* calculando as diferencas divididas de ordem k+2 */
+  /* diferencas divididas de ordem k+2 (se a ordem e menor */
+  /* que 5), k+1 e 1..k de phix                            */
+  if (kold < 5)  
     phix[kp2] = Ex;
-    for (i = 0; i <= o; i ++)
-      for (j = 1; j <= n; j ++)  
-        phiy[kp2][i][q[j]] = Ey[i][q[j]];
-
-  } 
-
-  /* calculando as diferencas divididas de ordem k+1 */
   phix[kp1] += Ex ;
-  for (i = 0; i <= o; i ++)
-    for (j = 1; j <= n; j ++) 
-      phiy[kp1][i][q[j]] += Ey[i][q[j]];
-   
-  /* calculando as diferencas divididas de ordem 1..k */
   for (l = 2; l <= kp1; l++)   
     phix[kp1-l+1] += phix[kp1-l+2];
-  for (l = 2; l <= kp1; l++)   
-    for (i = 0; i <= o; i++)
-      for (j = 1; j <= n ; j++)
-        phiy[kp1-l+1][i][q[j]] += phiy[kp1-l+2][i][q[j]];
+
+  /* o mesmo para phiy em uma passagem por blocos de colunas */
+  /* (as linhas sao completas e sao percorridas em ordem)    */
+  for (i = 0; i <= o; i ++)
+    for (j0 = 1; j0 <= n; j0 += GSDAE_PHIBLK) {
+      nb = MIN2(GSDAE_PHIBLK,n-j0+1);
+      if (kold < 5)  
+        memcpy(phiy[kp2][i]+j0,Ey[i]+j0,nb*sizeof(real));
+      KERNACC(nb,0.0,Ey[i]+j0,phiy[kp1][i]+j0,NULL,NULL);
+      for (l = 2; l <= kp1; l++)   
+        KERNACC(nb,0.0,phiy[kp1-l+2][i]+j0,phiy[kp1-l+1][i]+j0,NULL,NULL);
+    }
 
   return;
 } 
@@ -2936,8 +3604,9 @@ int    *ifase,
 int    *ns,
 real   *hold,
 int    *kold,
-void   (*F)(int,int,real,mreal,vreal),
-void   (*DF)(int,int,real,mreal,vreal,mmreal),
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
 real   *sold,
 real   *taux,
 mreal   tauy,
@@ -2945,7 +3614,8 @@ int    *naF,
 int    *naDH,
 int    *ndQR,
 vreal  deltah,
-vreal  deltahx
+vreal  deltahx,
+solver *ls
 )
 {   
   real d;       /* armazena o valor de || cm+1 - cm ||                  */  
@@ -2958,66 +3628,72 @@ vreal  deltahx
   int ncor;     /* numero de iteracoes para a resolucao do sistema de */
                 /* equacoes atraves do metodo de NEWTON */
                 /* o numero maximo de iteracoes eh 4.    */
-  int  i,j,l;
+  int  i,j;
   real tolerancia;
   real ro;
   real pnrm;      /* norma do ponto predito */
   real cond;
   real ac;      /* fator de aceleracao p/ o met de Newton */
+  real vmax;    /* max |v/wtc| na correcao v              */
   int  dim;
 
   /* definindo a tolerancia, a dimensao e o contador de correcoes */
   tolerancia = 2.3e-16;
   dim        = o*n+r+1;
   nint       = 0; 
+  cond       = 0.0;
+  d          = 0.0;
+  ls->cdmax  = cdmax;
    
-  /* atualizando o vetor peso */
-  weightvector(n,o,r,*cx,cy,q,atolx,rtolx,atoly,rtoly,wtx,wty);
-  
   /* calculo dos coeficientes para o polinomio preditor e corretor */
   coefficient(n,o,r,k,*h,alfa,beta,gama,sigma,psi,alfas, 
-              cj,cjold,factor,aDH,ck,phix,phiy,ns,hold,kold);
-
-  /* calculo de pc = (pcx,pcy) e de pdc = (pdcx,pdcy) atraves do  */
-  /* polinomio preditor                                           */
-  predictor(n,o,r,*k,gama,phix,phiy,pcx,pcy,pdcx,pdcy,q,u);
+              cj,cjold,factor,aDH,ck,ns,hold,kold);
 
-  /* armazena os valores anteriores de c = (cx, cy) -- c(n)  */
-  *cxx = *cx;
-  *cx  = *pcx; 
-  for (i = 0; i <= o; i++) 
-    for (j = 1; j <= n; j++) {
-      cyx[i][j] = cy[i][j];
-      cy[i][j]  = pcy[i][j]; 
-    }
+  /* vetor peso em c, calculo de pc = (pcx,pcy) e de pdc = (pdcx,pdcy) */
+  /* atraves do polinomio preditor, c(n) guardado em (cxx,cyx) e      */
+  /* trocado por pc, vetor erro zerado e norma do ponto predito       */
+  pnrm = PREDICTSTEP(n,o,r,*k,*ns,beta,gama,phix,phiy,cx,cy,cxx,cyx,
+                     pcx,pcy,pdcx,pdcy,Ex,Ey,q,u,atolx,rtolx,atoly,rtoly,
+                     wtx,wty);
 
   /* avalia a funcao no ponto predito */ 
-  SETH(n,o,r,*h,*pdcx,pdcy,*pcx,pcy,p,q,deltax,deltahx,F); 
+  SETH(n,o,r,*h,*pdcx,pdcy,*pcx,pcy,p,q,deltax,deltahx,F,data); 
   (*naF) ++; 
 
-  /* calcula a norma do ponto predito */
-  pnrm = weightnorm(n,o,r,*pcx,pcy,q,*wtx,wty);
-  
   /* copiando o valor de F no ponto predito */
-  for (i = 1; i <= dim; i++) 
-    deltah[i] = deltahx[i];
+  memcpy(deltah+1,deltahx+1,dim*sizeof(real));
 
-  /* avaliando a jacobiana se necessario */
+  /* com as atualizacoes de Broyden a fatoracao anterior e mantida e */
+  /* marcada como desatualizada (aDH = 1) : DH so e avaliada no ponto */
+  /* predito se o metodo de Newton nao convergir                      */
   ncor = 0;
-  if ((*aDH == 1) || ((*ifase == 0) && (*k == 1))) {  
+  if ((ls->broyden) && (ls->bdim == dim) && (ls->nbroy < GSDAE_NBROY) &&
+      !((*ifase == 0) && (*k == 1))) {  
 
-    if (nDH == 0) {
-      SETDHAPPROX(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,
-                  pcy,pdcy,wty,p,q,delta,deltax,deltah,deltahx,DH,F); 
-    } else {
-      SETDH(n,o,r,*cj,*h,*pcx,pcy,*pdcx,pdcy,p,q,DFx,DFy,DF,DH); 
-    }
-    (*naDH) ++;
+    *aDH = 1;
+
+  } else if ((ls->cjup) && (*aDH == 1) && !((*ifase == 0) && (*k == 1)) &&
+             (REFACTORDH(n,o,r,dim,*h,*cj,*pcx,*pdcx,pcy,pdcy,p,q,
+                         DFx,DFy,data,DH,Q,ls,&cond) == 0)) {
+
+    /* apenas cj mudou : DH foi refatorada com a jacobiana */
+    /* guardada e continua marcada como desatualizada, de  */
+    /* modo que DF e reavaliada se Newton nao convergir    */
     *cjold  = *cj;
     *factor = 100.0;
+    (*ndQR) ++;
+    if (cond > cdmax) 
+      ncor = 4;
 
-    /* decomposicao QR de DH */
-    QR(dim,dim,DH,Q,1,&cond);
+  } else if ((*aDH == 1) || ((*ifase == 0) && (*k == 1))) {  
+
+    /* avaliacao e decomposicao QR de DH */
+    FACTORDH(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,pcy,pdcy,wty,
+             p,q,delta,deltax,deltah,deltahx,DFx,DFy,nDH,F,DF,data,
+             DH,Q,ls,&cond);
+    (*naDH) ++;
+    *cjold  = *cj;
+    *factor = 100.0;
     (*ndQR) ++;
 
     /* teste da condicao da jacobiana */
@@ -3029,12 +3705,6 @@ vreal  deltahx
     *aDH = 0;
   } 
   
-  /* inicializando o vetor erro */
-  *Ex = 0.0;
-  for (i = 0; i <= o; i++)
-    for (j = 1; j <= n; j ++)
-      Ey[i][j] = 0.0;
-                 
   /* laco para o calculo do ponto corrigido */
   do { 
 
@@ -3046,9 +3716,29 @@ vreal  deltahx
             
       /* fator de aceleracao do metodo de Newton modificado */
       ac = 2.0/(1.0+(*cj)/(*cjold));
+
+      /* atualizacao de Broyden com o passo e o residuo anteriores */
+      if (ls->broyden) {
+        if (ncor > 1)
+          BROYDENUPDATE(n,o,r,dim,p,q,DFy,Q,DH,ls,u,deltah,ac);
+        for (i = 1; i <= dim; i++) 
+          ls->bh[i] = deltah[i];
+      }
   
+      /* taxa e norma peso esperadas da correcao (termo forcante */
+      /* do corretor de Newton-Krylov); a primeira correcao e da */
+      /* ordem da estimativa do erro, mantida abaixo de 1. Nas   */
+      /* demais kr->ro guarda a ultima taxa estimada abaixo      */
+      if (ls->kr != NULL) {
+        if (ncor <= 2)
+          ls->kr->ro = (*factor)/(1.0+(*factor));
+        ls->kr->dn = (ncor == 1) ? 1.0 : ls->kr->ro*d;
+      }
+
       /* calculo de QRu = deltah, QR = DH, DH <- R */
-      NEWTON(dim,Q,DH,u,deltah,ac) ; 
+      SOLVEDH(n,o,r,dim,p,q,DFy,Q,DH,ls,u,deltah,ac) ; 
+      if (ls->nbroy > 0)
+        BROYDENAPPLY(ls,dim,u);
 
       /* calculo de v = cn(i+1) - cn(i) */ 
       for (i = o-1; i >= 0; i--)
@@ -3059,24 +3749,29 @@ vreal  deltahx
       *x = u[o*n+r+1];
 
       /* atualizacao de c = (cx, cy0, cy1, ..., cyo), */
-      /* sua derivada e o vetor de erro               */               
+      /* sua derivada e o vetor de erro; o maximo de  */
+      /* |v/wtc| e tomado com cada linha na cache     */               
       *cx   -= (*x);
       *pdcx -= (*cj)*(*x);
       *Ex   -= (*x); 
-      for (i = 0; i < o; i++) 
+      vmax   = fabs((*x)/(*wtx));
+      for (i = 0; i < o; i++) {
         for (j = 1; j <= n; j++) {
-          cy[i][q[j]]   -= y[i][q[j]];
-          pdcy[i][q[j]] -= (*cj)*y[i][q[j]];
-          Ey[i][q[j]]   -= y[i][q[j]];
+          cy[i][j]   -= y[i][j];
+          pdcy[i][j] -= (*cj)*y[i][j];
+          Ey[i][j]   -= y[i][j];
         }
+        vmax = KERNWMAX(n,y[i]+1,wty[i]+1,NULL,vmax);
+      }
       for (j = 1; j <= r; j++) {
         cy[o][q[j]]   -= y[o][q[j]];
         pdcy[o][q[j]] -= (*cj)*y[o][q[j]];
         Ey[o][q[j]]   -= y[o][q[j]];
       }
+      vmax = KERNWMAX(r,y[o],wty[o],q+1,vmax);
 
       /* calculo da norma peso no ponto corrigido */
-      d = weightnorm(n,o,r,*x,y,q,*wtx,wty);
+      d = weightnormvmax(n,o,r,*x,y,q,*wtx,wty,vmax);
         
       /* verificando se o ponto corrigido deve ser aceito */ 
       if (d <= (tolerancia*100.0*pnrm)) { 
@@ -3085,7 +3780,7 @@ vreal  deltahx
         if (ftol[1] != 0.0) {
 
           /* Avaliando a funcao F no ponto aceito */
-          SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F);
+          SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F,data);
           (*naF) ++;
 
           /* calcula a norma peso de F */
@@ -3109,7 +3804,7 @@ vreal  deltahx
           if (ftol[1] != 0.0) {
   
             /* Avaliando a funcao F no ponto aceito */
-            SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F);
+            SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F,data);
             (*naF) ++;
   
             /* calcula a norma peso de F */
@@ -3126,7 +3821,7 @@ vreal  deltahx
         } else { 
 
           /* ponto corrigido nao aceito */
-          SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F);
+          SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F,data);
           (*naF) ++;
 
         }
@@ -3137,6 +3832,8 @@ vreal  deltahx
         ro      = d/d0 ;    
         ro      = ROOT(ro,ncor-1); 
         *factor = ro/(1.0-ro);  
+        if (ls->kr != NULL)
+          ls->kr->ro = ro;
 
         if (ro > 0.9) {  
 
@@ -3151,7 +3848,7 @@ vreal  deltahx
           if (ftol[1] != 0.0) {
   
             /* Avaliando a funcao F no ponto aceito */
-            SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F);
+            SETH(n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F,data);
             (*naF) ++;
   
             /* calcula a norma peso de F */
@@ -3168,7 +3865,7 @@ vreal  deltahx
         } else {
 
           /* ponto corrigido nao aceito */
-          SETH (n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F);
+          SETH (n,o,r,*h,*pdcx,pdcy,*cx,cy,p,q,delta,deltah,F,data);
           (*naF) ++;  
 
         }
@@ -3184,6 +3881,15 @@ vreal  deltahx
       /* A matriz jacobiana nao foi avaliada no ponto predito    */
       /* Avalia a jacobiana e tenta-se novamente                 */
 
+      /* retorna ao ponto predito */
+      *pdcx += (*cj)*((*pcx)-(*cx));
+      *cx    = *pcx;
+      for (i = 0; i <= o; i++)
+        for (j = 1; j <= n; j++) {
+          pdcy[i][j] += (*cj)*(pcy[i][j]-cy[i][j]);
+          cy[i][j]    = pcy[i][j];
+        }
+
       /* calcula a norma do ponto predito */
       pnrm = weightnorm(n,o,r,*pcx,pcy,q,*wtx,wty);
 
@@ -3192,19 +3898,15 @@ vreal  deltahx
         deltah[i] = deltahx[i];
                    
       /* calcula a jacobina no ponto predito */
-      if (nDH == 0) {
-        SETDHAPPROX(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,
-                    pcy,pdcy,wty,p,q,delta,deltax,deltah,deltahx,DH,F);
-      } else {
-        SETDH(n,o,r,*cj,*h,*pcx,pcy,*pdcx,pdcy,p,q,DFx,DFy,DF,DH); 
-      }
+      FACTORDH(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,pcy,pdcy,wty,
+               p,q,delta,deltax,deltah,deltahx,DFx,DFy,nDH,F,DF,data,
+               DH,Q,ls,&cond);
       (*naDH) ++; 
       *cjold  = *cj;
       *factor = 100.0;
 
       ncor = 0;
       /* decomposicao QR de DH */
-      QR(dim,dim,DH,Q,1,&cond);
       (*ndQR) ++;
       if (cond > cdmax) { 
         /* matriz mal condicionada */
@@ -3231,12 +3933,7 @@ vreal  deltahx
       *ifase = 1;
 
       /* restaura psi e phi */
-      for (l = (*ns)+1; l <= (*k)+1; l++) {  
-        phix[l] = phix[l]/beta[l];
-        for (i = 0; i <= o; i++)
-          for (j = 1; j <= n; j++)
-            phiy[l][i][q[j]] = phiy[l][i][q[j]]/beta[l];
-      }
+      phirestore(n,o,(*ns)+1,(*k)+1,beta,phix,phiy);
       for (i = 1; i <= *k; i++)  
 	psi[i] = psi[i+1]-(*h);
 
@@ -3248,20 +3945,20 @@ vreal  deltahx
         *cx = *cxx;
         for (i = 0; i <= o; i++)
           for (j = 1; j <= n; j++)
-            cy[i][q[j]] = cyx[i][q[j]];
+            cy[i][j] = cyx[i][j];
 
         return (-12); 
       }
          
       /* calculo dos coeficientes para o nova tentativa */
       coefficient(n,o,r,k,*h,alfa,beta,gama,sigma,psi,alfas, 
-                  cj,cjold,factor,aDH,ck,phix,phiy,ns,hold,kold);
+                  cj,cjold,factor,aDH,ck,ns,hold,kold);
 
       /* calculo do ponto predito */
-      predictor(n,o,r,*k,gama,phix,phiy,pcx,pcy,pdcx,pdcy,q,u);
+      predictor(n,o,r,*k,*ns,beta,gama,phix,phiy,pcx,pcy,pdcx,pdcy,q,u);
 
       /* avalia a funcao no ponto predito  */
-      SETH(n,o,r,*h,*pdcx,pdcy,*pcx,pcy,p,q,deltax,deltahx,F);          
+      SETH(n,o,r,*h,*pdcx,pdcy,*pcx,pcy,p,q,deltax,deltahx,F,data);          
       (*naF) ++; 
 
       /* calcula a norma do ponto predito */
@@ -3272,12 +3969,9 @@ vreal  deltahx
         deltah[i] = deltahx[i];
 
       /* avaliacao da jacobiana DH */
-      if (nDH == 0) {
-        SETDHAPPROX(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,
-                    pcy,pdcy,wty,p,q,delta,deltax,deltah,deltahx,DH,F);
-      } else {
-        SETDH(n,o,r,*cj,*h,*pcx,pcy,*pdcx,pdcy,p,q,DFx,DFy,DF,DH);
-      }
+      FACTORDH(n,o,r,dim,*h,*cj,tolerancia,*pcx,*pdcx,*wtx,pcy,pdcy,wty,
+               p,q,delta,deltax,deltah,deltahx,DFx,DFy,nDH,F,DF,data,
+               DH,Q,ls,&cond);
       (*naDH)++;
       *aDH    = 0;
       *cjold  = *cj;
@@ -3285,7 +3979,6 @@ vreal  deltahx
 
       ncor = 0;
       /* decomposicao QR de DH */
-      QR(dim,dim,DH,Q,1,&cond);
       (*ndQR) ++;
       if (cond > cdmax) {
         /* matriz mal condicionada */
@@ -3298,8 +3991,8 @@ vreal  deltahx
       *Ex = 0.0;
       for (i = 0; i<= o; i++) {
         for (j = 1; j <= n; j++) {
-          cy[i][q[j]] = pcy[i][q[j]]; 
-          Ey[i][q[j]] = 0.0;
+          cy[i][j] = pcy[i][j]; 
+          Ey[i][j] = 0.0;
         }
       } 
  
@@ -3315,7 +4008,7 @@ vreal  deltahx
   *cx = *cxx;
   for (i = 0; i <= o; i++)
     for (j = 1; j <= n; j++)
-      cy[i][q[j]] = cyx[i][q[j]];
+      cy[i][j] = cyx[i][j];
 
   /* nao convergiu : excedeu numero maximo de iteracoes */
   if (cond > cdmax)
@@ -3374,7 +4067,7 @@ real    hmax,
 int     ns
 )
 {  
-  int  i,j,l;                  
+  int  i,j;                  
   int  knew,kdiff,kp1,kp2,km1;
   real terk,terkm1,terkm2,terkp1;
   real erk,erkm1,erkm2,erkp1;
@@ -3447,12 +4140,7 @@ int     ns
     (*nflhs)++;
 
     /* restaura phi */
-    for (l = ns+1; l <= kp1; l++) {  
-      phix[l] /= beta[l];
-      for (i = 0; i <= o; i++)
-        for (j = 1; j <= n; j++)
-          phiy[l][i][j] /= beta[l];
-    }
+    phirestore(n,o,ns+1,kp1,beta,phix,phiy);
 
     /* restaura psi */  
     for (i = 2; i <= kp1; i++)  
@@ -3878,32 +4566,47 @@ mmreal  DFy,
 mreal   B
 )
 {
-  int  i,j,k;  /* variaveis auxiliares */
+  int   i,j,k;  /* variaveis auxiliares   */
+  real  a;      /* componente de y        */
+  vreal row;    /* linha q[j] de DFy[k]   */
 
-  /* B[1] = DFx + DFy[0] y[1] + .. + DFy[o-1] y[o] */
-  for (i = 1; i <= n; i++) {
+  /* B[1] = DFx + DFy[0] y[1] + .. + DFy[o-1] y[o]; os lacos em */
+  /* i sao internos (linhas de DFy e de B percorridas em ordem) */
+  /* e cada B[1][i] soma os termos na mesma ordem (k,j)         */
+  for (i = 1; i <= n; i++) 
     B[1][i] = DFx[p[i]];
-    for (k = 0; k <= o-2; k++) 
-      for (j = 1; j <= n; j++) 
-        B[1][i] += DFy[k][q[j]][p[i]]*y[k+1][q[j]];
-    if (o > 0)  
-      for (j = 1; j <= r; j++) 
-        B[1][i] += DFy[o-1][q[j]][p[i]]*y[o][q[j]];
-  }
+  for (k = 0; k <= o-2; k++) 
+    for (j = 1; j <= n; j++) {
+      row = DFy[k][q[j]];
+      a   = y[k+1][q[j]];
+      for (i = 1; i <= n; i++) 
+        B[1][i] += row[p[i]]*a;
+    }
+  if (o > 0)  
+    for (j = 1; j <= r; j++) {
+      row = DFy[o-1][q[j]];
+      a   = y[o][q[j]];
+      for (i = 1; i <= n; i++) 
+        B[1][i] += row[p[i]]*a;
+    }
 
   /* B[i+1][j] = DFy[o][i][j] (i = 1..n, j = 1..r) */
-  for (i = 1; i <= r; i++) 
-    for (j = 1; j <= r; j++)
-      B[j+1][i] = DFy[o][q[j]][p[i]];
-  for (i = r+1; i <= n; i++)
-    for (j = r+1; j <= n; j++)
+  for (j = 1; j <= r; j++) {
+    row = DFy[o][q[j]];
+    for (i = 1; i <= n; i++) 
+      B[j+1][i] = row[p[i]];
+  }
+  for (j = r+1; j <= n; j++)
+    for (i = r+1; i <= n; i++)
       B[j+1][i] = 0.0;
 
   /* B[i+1][j] = DFy[o-1][i][j] (i = 1..n, j = r+1..n) */
   if (o > 0)  
-    for (i = 1; i <= n; i++) 
-      for (j = r+1; j <= n; j++)
-        B[j+1][i] = DFy[o-1][q[j]][p[i]];
+    for (j = r+1; j <= n; j++) {
+      row = DFy[o-1][q[j]];
+      for (i = 1; i <= n; i++) 
+        B[j+1][i] = row[p[i]];
+    }
 
   return;
 } 
@@ -3967,8 +4670,10 @@ int     nDH,
 int    *naF,
 int    *naDH,
 int    *nQR,
-void    (*F)(int,int,real,mreal,vreal),
-void    (*DF)(int,int,real,mreal,vreal,mmreal)
+void    (*F)(int,int,real,mreal,vreal,void *),
+void    (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+solver *ls
 )
 {  
   real  cond;  /* condicao da matriz B              */
@@ -3977,6 +4682,10 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
   int   raux2; /* posto de DFy[o] em uma vizinhanca */
   int   oaux;  /* ordem da EAD                      */
   int   i,j;   /* variaveis auxiliares              */
+  int   spr;   /* usar a LU esparsa                 */
+  vreal z;     /* nucleo de B^t                     */
+
+  spr = (ls->sp != NULL) && (n >= ls->sp->nmin);
 
   /* tau = (taux,tauy) define a tangente no ponto inicial */
   /* tau pertence ao nucleo de  B^t = (DF(c),w(c)c')^t    */
@@ -3984,7 +4693,7 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
 
 
   /* avalida a funcao que define a EAD */
-  F(*o,n,cx,cy,delta);
+  F(*o,n,cx,cy,delta,data);
   (*naF)++;
 
   /* se foi definida tolerancias para a avaliacao da EAD */
@@ -4013,7 +4722,19 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
 
   /* verificando se o posto, a ordem e as permutacoes foram */
   /* predefinidos pelo usuario                              */
-  if (!irank) {
+  if (ls->kr != NULL) {
+
+    /* corretor de Newton-Krylov : DFy[o] regular (r = n) e a */
+    /* jacobiana nao e avaliada                               */
+    if (!irank) 
+      for (i = 1; i <= n; i++) {
+        p[i] = i;
+        q[i] = i;
+      }
+    oaux  = *o;
+    raux1 = *r;
+
+  } else if (!irank) {
 
     /* o posto nao foi definido pelo usuario               */
     /* definindo o posto, a ordem e as permutacoes para    */
@@ -4023,26 +4744,40 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
     if (nDH == 1) {
 
       /* jacobiana exata */
-      DF(*o,n,cx,cy,DFx,DFy);
+      DF(*o,n,cx,cy,DFx,DFy,data);
 
     } else {
     
       /* jacobiana aproximada */
-      DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+      DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
     }
     (*naDH)++;
  
-    /* verificando o posto de DFy[o] */
-    /* B = DFy[o]                    */
-    for (i = 1; i <= n; i++)
-      for (j = 1; j <= n; j++)
-        B[i][j] = DFy[*o][j][i];
+    if (spr && SPARSEREGULAR(n,*o,ls->sp)) {
+
+      /* DFy[o] e regular (LU esparsa) : posto maximo e */
+      /* permutacoes iguais a identidade                */
+      raux1 = n;
+      for (i = 1; i <= n; i++) {
+        p[i] = i;
+        q[i] = i;
+      }
+
+    } else {
+
+      /* verificando o posto de DFy[o] */
+      /* B = DFy[o]                    */
+      for (i = 1; i <= n; i++)
+        for (j = 1; j <= n; j++)
+          B[i][j] = DFy[*o][j][i];
 
-    /* decomposicao QR de DFy[o]                            */
-    /* r define o posto de DFy[o]                           */
-    /* p a permutacao de linhas e q a permutacao de colunas */
-    raux1 = QR2(n,B,Q,p,q);
+      /* decomposicao QR de DFy[o]                            */
+      /* r define o posto de DFy[o]                           */
+      /* p a permutacao de linhas e q a permutacao de colunas */
+      raux1 = QR2TH(n,B,Q,p,q,ls);
+
+    }
     (nQR)++;
 
     /* copiando a ordem */
@@ -4061,18 +4796,18 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
 
       /* verifincando se o posto e constante em uma vizinhanca */
       raux2 =  rankneighbourhood(n,*o,raux1,dir,*o,cx,cy,delta,deltaaux, 
-                                 DFx,DFy,Q,B,p,q,nDH,naDH,nQR,F,DF);
+                                 DFx,DFy,Q,B,p,q,nDH,naDH,nQR,F,DF,data,ls);
 
       /* reavaliando a jacobiana */
       if (nDH == 1) {
 
         /* jacobiana exata */
-        DF(*o,n,cx,cy,DFx,DFy);
+        DF(*o,n,cx,cy,DFx,DFy,data);
 
       } else {
     
         /* jacobiana aproximada */
-        DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+        DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
       }
       (*naDH)++;
@@ -4109,7 +4844,7 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
               B[i][j] = DFy[oaux][j][i];
 
           /* decomposicao QR de DFy[oaux] */
-          raux1 = QR2(n,B,Q,p,q);
+          raux1 = QR2TH(n,B,Q,p,q,ls);
           (nQR)++;
 
           /* verificando o posto de DFy[oaux] */
@@ -4118,18 +4853,18 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
             /* verifincando se o posto e constante em uma vizinhanca */
             raux2 =  rankneighbourhood(n,*o,raux1,dir,*o,cx,cy,delta,
 				       deltaaux,DFx,DFy,Q,B,p,q,nDH,
-				       naDH,nQR,F,DF);
+				       naDH,nQR,F,DF,data,ls);
 
             /* reavaliando a jacobiana */
             if (nDH == 1) {
 
               /* jacobiana exata */
-              DF(*o,n,cx,cy,DFx,DFy);
+              DF(*o,n,cx,cy,DFx,DFy,data);
 
             } else {
     
               /* jacobiana aproximada */
-              DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+              DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
             }
             (*naDH)++;
@@ -4179,12 +4914,12 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
     if (nDH == 1) {
 
       /* jacobiana exata */
-      DF(*o,n,cx,cy,DFx,DFy);
+      DF(*o,n,cx,cy,DFx,DFy,data);
 
     } else {
     
       /* jacobiana aproximada */
-      DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+      DFAPPROX(n,*o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
     }
     (*naDH)++;
@@ -4195,11 +4930,28 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
 
   }
 
-  /* calcula a matriz que define a tangente no ponto inicial */
-  SETB(n,oaux,raux1,cy,p,q,DFx,DFy,B);
+  if (ls->kr != NULL) {
+
+    /* nucleo de B^t pelo GMRES */
+    KRYLOVTAU(n,oaux,cx,cy,q,delta,F,data,ls->kr,&cond);
+    z = ls->kr->z;
+
+  } else if (spr && ((oaux > 0) || (raux1 == n))) {
+
+    /* nucleo de B^t pela LU esparsa, em Q[n+1] */
+    SPARSETAU(n,oaux,raux1,cy,p,q,DFx,ls->sp,Q[n+1],&cond);
+    z = Q[n+1];
+
+  } else {
+
+    /* calcula a matriz que define a tangente no ponto inicial */
+    SETB(n,oaux,raux1,cy,p,q,DFx,DFy,B);
 
-  /* decomposicao QR de B */
-  QR(n+1,n,B,Q,0,&cond);
+    /* decomposicao QR de B */
+    QR(n+1,n,B,Q,0,&cond);
+    z = Q[n+1];
+
+  }
   (nQR)++;
 
   /* testando se o posto de B e maximo */ 
@@ -4240,17 +4992,17 @@ void    (*DF)(int,int,real,mreal,vreal,mmreal)
   /* calculando o nucleo de B */
 
   /* calcula taux e tauy[o][i] (i = 1..r) */
-  *taux = Q[n+1][1];
+  *taux = z[1];
   norm = (*taux)*(*taux);
   for (i = 1; i <= raux1; i++) { 
-    tauy[oaux][q[i]]  = Q[n+1][i+1];
+    tauy[oaux][q[i]]  = z[i+1];
     norm           += tauy[oaux][q[i]]*tauy[oaux][q[i]];
   }
 
   /* tauy[o-1][i] (i = r+1..n), tauy[o-1][i] (i = 1..r) */
   if (oaux > 0) {
     for (i = raux1+1; i <= n; i++) { 
-      tauy[oaux-1][q[i]]  = Q[n+1][i+1];
+      tauy[oaux-1][q[i]]  = z[i+1];
       norm             += tauy[oaux-1][q[i]]*tauy[oaux-1][q[i]];
     }
     for (i = 1; i <= raux1; i++) {
@@ -4366,8 +5118,10 @@ vint    q,
 int     nDH,
 int    *naDH,
 int    *nQR,
-void   (*F)(int,int,real,mreal,vreal),
-void   (*DF)(int,int,real,mreal,vreal,mmreal)
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+solver *ls
 )
 {
   int  i,j,k,l; /* variaveis auxiliares */
@@ -4382,12 +5136,12 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
   if (nDH == 1) {
 
     /* jacobiana exata */
-    par->DF(o,n,cx,cy,DFx,DFy);
+    DF(o,n,cx,cy,DFx,DFy,data);
 
   } else {
     
     /* jacobiana aproximada */
-    DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+    DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
   }
   (*naDH)++;
@@ -4399,7 +5153,7 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
       B[i][j] = DFy[ord][j][i];
 
   /* decomposicao QR de DFy[ord] */
-  raux = QR2(n,B,Q,p,q);
+  raux = QR2TH(n,B,Q,p,q,ls);
   (nQR)++;
 
   /* voltando a variavel x ao valor original */
@@ -4425,12 +5179,12 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
       if (nDH == 1) {
 
         /* jacobiana exata */
-        par->DF(o,n,cx,cy,DFx,DFy);
+        DF(o,n,cx,cy,DFx,DFy,data);
 
       } else {
     
         /* jacobiana aproximada */
-        DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+        DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
       }
       (*naDH)++;
@@ -4442,7 +5196,7 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
           B[i][j] = DFy[ord][j][i];
 
       /* decomposicao QR de DFy[ord] */
-      raux = QR2(n,B,Q,p,q);
+      raux = QR2TH(n,B,Q,p,q,ls);
       (nQR)++;
     
       /* voltando a variavel y[k][l] ao valor original */
@@ -4467,12 +5221,12 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
   if (nDH == 1) {
 
     /* jacobiana exata */
-    par->DF(o,n,cx,cy,DFx,DFy);
+    DF(o,n,cx,cy,DFx,DFy,data);
 
   } else {
     
     /* jacobiana aproximada */
-    DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+    DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
   }
   (*naDH)++;
@@ -4484,7 +5238,7 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
       B[i][j] = DFy[ord][j][i];
 
   /* decomposicao QR de DFy[ord] */
-  raux = QR2(n,B,Q,p,q);
+  raux = QR2TH(n,B,Q,p,q,ls);
   (nQR)++;
 
   /* voltando a variavel x ao valor original */
@@ -4510,12 +5264,12 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
       if (nDH == 1) {
 
         /* jacobiana exata */
-        par->DF(o,n,cx,cy,DFx,DFy);
+        DF(o,n,cx,cy,DFx,DFy,data);
 
       } else {
     
         /* jacobiana aproximada */
-        DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F); 
+        DFAPPROX(n,o,dir,cx,cy,delta,deltaaux,DFx,DFy,F,data,ls); 
 
       }
       (*naDH)++;
@@ -4527,7 +5281,7 @@ void   (*DF)(int,int,real,mreal,vreal,mmreal)
           B[i][j] = DFy[ord][j][i];
 
       /* decomposicao QR de DFy[ord] */
-      raux = QR2(n,B,Q,p,q);
+      raux = QR2TH(n,B,Q,p,q,ls);
       (nQR)++;
     
       /* voltando a variavel y[k][l] ao valor original */
@@ -4565,18 +5319,49 @@ vreal   delta,
 vreal   deltaaux,
 vreal   DFx,
 mmreal  DFy,
-void    (*F)(int,int,real,mreal,vreal) 
+void    (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
 )
 {
-  int  i, j, k;   /* variaveis auxiliares        */
-  real del;       /* incremento                  */
-  real save;      /* salva o valor anterior      */
-  real uround;    /* menor constante considerada */
+  int    i, j, k; /* variaveis auxiliares        */
+  real   del;     /* incremento                  */
+  real   save;    /* salva o valor anterior      */
+  real   uround;  /* menor constante considerada */
+  fdjac *fd;      /* lotes ou threads            */
 
   
   /* calculando a menor constante */
   uround = dir*sqrt(1.0e-15);
 
+  /* com o padrao de DFy as colunas sao avaliadas por cores */
+  if (ls->cpr != NULL) {
+    del = uround*fabs(x);
+    del = (x+del)-x;
+    for (k = 0; k <= o; k++)
+      for (i = 1; i <= n; i++) {
+        ls->cpr->del[k][i] = uround*fabs(y[k][i]);
+        ls->cpr->del[k][i] = (y[k][i]+ls->cpr->del[k][i])-y[k][i];
+      }
+    DFCOLOR(n,o,x,del,y,delta,deltaaux,DFx,DFy,F,data,ls);
+    return;
+  }
+
+  /* com Fb (SETFBATCH) as colunas sao avaliadas em lotes; */
+  /* com F segura sao divididas entre as threads            */
+  if ((ls->fb != NULL) || (ls->fd != NULL)) {
+    fd = (ls->fb != NULL) ? &(ls->fb->task) : ls->fd;
+    FDSETUP(fd,GSDAE_FDDF,(o+1)*n+1,n,o,0,n,x,y,delta,F,data);
+    fd->uround = uround;
+    fd->DFx    = DFx;
+    fd->DFy    = DFy;
+    if (ls->fb != NULL) 
+      FBRUN(ls->fb);
+    else
+      POOLRUN(fd->pl,FDTASK,(void *) fd);
+    return;
+  }
+
   /* calculo da derivada aproximada com relacao a x */
 
   /* calculando o incremento */
@@ -4591,7 +5376,7 @@ void    (*F)(int,int,real,mreal,vreal)
   del   = 1.0/del;
 
   /* avaliando a funcao */
-  F(o,n,x,y,deltaaux);
+  F(o,n,x,y,deltaaux,data);
 
   /* calculando uma aproximacao para a variavel */
   for (i = 1; i <= n; i++)
@@ -4616,7 +5401,7 @@ void    (*F)(int,int,real,mreal,vreal)
       del       = 1.0/del;
 
       /* avaliando a funcao */
-      F(o,n,x,y,deltaaux);
+      F(o,n,x,y,deltaaux,data);
 
       /* calculando uma aproximacao para a variavel */
       for (j = 1; j <= n; j++)
@@ -4632,254 +5417,2694 @@ void    (*F)(int,int,real,mreal,vreal)
 /* fim DFAPPROX */
 
 
-
-/* ************************************************************* */
-/* Esta rotina inicializa todos os dados para a aplicacao do     */
-/* metodo BDF.                                                   */
-/* ************************************************************* */
+/***********************************************************/
+/* rotina que calcula uma aproximacao para DF em um ponto  */
+/* pelo metodo de Curtis, Powell e Reid : as variaveis de  */
+/* uma mesma cor nao aparecem juntas em nenhuma equacao e  */
+/* sao incrementadas ao mesmo tempo, com uma avaliacao de  */
+/* F por cor e por ordem. delx e cpr->del contem os        */
+/* incrementos de x e de y, e delta = F(x,y).              */
+/***********************************************************/
 
 void 
-firststep (
+DFCOLOR (
 int     n,
 int     o,
-int     r,
-real    cx,
-mreal   cy,
-vreal   phix,
-mmreal  phiy,
-vint    p,
-vint    q,
-real    taux,
-mreal   tauy,
-real   *cj,
-real   *cjold,
-real   *factor,
-real   *hold,
-real    h,
-int    *k,
-int    *kold,
-int    *ns,
-vreal   psi,
-int    *ifase,
-real   *pdcx
+real    x,
+real    delx,
+mreal   y,
+vreal   delta,
+vreal   deltaaux,
+vreal   DFx,
+mmreal  DFy,
+void    (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
 )
-{  
-  int   i,j; /* variaveis auxiliares                */
+{
+  int       i, j, k;   /* variaveis auxiliares        */
+  int       c, l, m;   /* cor e posicoes no padrao    */
+  real      del;       /* inverso do incremento       */
+  coloring *cpr;       /* coloracao das colunas       */
+  fdjac    *fd;        /* lotes ou threads            */
+
+  cpr = ls->cpr;
+
+  /* elementos fora do padrao */
+  for (k = 0; k <= o; k++)
+    for (j = 1; j <= n; j++)
+      for (i = 1; i <= n; i++)
+        DFy[k][j][i] = 0.0;
+
+  /* com Fb (SETFBATCH) as cores sao avaliadas em lotes; */
+  /* com F segura sao divididas entre as threads          */
+  if ((ls->fb != NULL) || (ls->fd != NULL)) {
+    fd = (ls->fb != NULL) ? &(ls->fb->task) : ls->fd;
+    FDSETUP(fd,GSDAE_FDCOLOR,(o+1)*cpr->ncolor+1,n,o,0,n,x,y,delta,
+            F,data);
+    fd->delx = delx;
+    fd->DFx  = DFx;
+    fd->DFy  = DFy;
+    fd->cpr  = cpr;
+    if (ls->fb != NULL) 
+      FBRUN(ls->fb);
+    else
+      POOLRUN(fd->pl,FDTASK,(void *) fd);
+    return;
+  }
+
+  /* calculo da derivada aproximada com relacao a x */
+  del = 1.0/delx;
+  F(o,n,x+delx,y,deltaaux,data);
+  for (i = 1; i <= n; i++)
+    DFx[i] = (deltaaux[i]-delta[i])*del;
+
+  /* calculo da derivada aproximada com relacao a y */
+  for (k = o; k >= 0; k--) {
+
+    for (c = 1; c <= cpr->ncolor; c++) {
+
+      /* incrementando as variaveis da cor c */
+      for (l = cpr->gp[c]; l < cpr->gp[c+1]; l++) {
+        j             = cpr->gv[l];
+        cpr->save[j]  = y[k][j];
+        y[k][j]      += cpr->del[k][j];
+      }
+
+      /* avaliando a funcao */
+      F(o,n,x,y,deltaaux,data);
+
+      /* cada equacao depende de no maximo uma variavel da cor */
+      for (l = cpr->gp[c]; l < cpr->gp[c+1]; l++) {
+        j       = cpr->gv[l];
+        y[k][j] = cpr->save[j];
+        del     = 1.0/cpr->del[k][j];
+        for (m = cpr->cp[j]; m < cpr->cp[j+1]; m++) {
+          i            = cpr->ri[m];
+          DFy[k][j][i] = (deltaaux[i]-delta[i])*del;
+        }
+      }
 
-  /* inicializando phi */
-  phix[1] = cx;
-  phix[2] = h*taux;
-  for (i = 0; i <= o; i++) {
-    for (j = 1; j <= n; j++) { 
-      phiy[1][i][q[j]] = cy[i][q[j]] ;
-      phiy[2][i][q[j]] = h*tauy[i][q[j]];
     }
-  }  
-        
-  /* inicializando psi */
-  psi[1] = h;
 
-  /* inicializacao para realizar o primeiro passo */
-  *cj     = 1.0/h ;
-  *cjold  = *cj;
-  *hold   = 0.0;
-  *kold   = 0;
-  *k      = 1;
-  *ns     = 0; 
-  *ifase  = 0;
-  *pdcx   = taux;
-  *factor = 100.0;
+  }
 
-  return; 
+  return;
 } 
-/* fim firststep */
+/* fim DFCOLOR */
 
 
 
-int 
-functionnorm (
-int   n,
-vreal x,
-vreal tol
+/***********************************************************/
+/* rotina que aproxima DF no ponto predito por DFCOLOR com */
+/* os incrementos de SETDHAPPROX. deltah contem H no ponto */
+/* (deltah[i] = F[p[i]], i = 1..n) e delta e deltaaux sao  */
+/* areas de trabalho.                                      */
+/***********************************************************/
+
+void 
+SETDFCOLOR (
+int     n,
+int     o,
+real    h,
+real    uround,
+real    x,
+real    dx,
+real    wtx,
+mreal   y,
+mreal   dy,
+mreal   wty,
+vint    p,
+vreal   deltah,
+vreal   delta,
+vreal   deltaaux,
+vreal   DFx,
+mmreal  DFy,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
 )
 {
-  int i;
+  int   i, k;  /* variaveis auxiliares   */
+  real  del;   /* incremento de x        */
+  mreal dely;  /* incrementos de y       */
+
+  /* calculando a menor constante */ 
+  uround = sqrt(uround);
 
+  /* incremento de x */
+  del  = uround*MAX3(fabs(h*dx),fabs(x),fabs(wtx));
+  del *= FSIGN(h*dx);
+  del  = (x+del)-x;
+
+  /* incrementos de y */
+  dely = ls->cpr->del;
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++) {
+      dely[k][i]  = uround*MAX3(fabs(h*dy[k][i]),fabs(y[k][i]),fabs(wty[k][i]));
+      dely[k][i] *= FSIGN(h*dy[k][i]);
+      dely[k][i]  = (y[k][i]+dely[k][i])-y[k][i];
+    }
+
+  /* F no ponto */
   for (i = 1; i <= n; i++)
-    if (fabs(x[i]) > tol[i]) return (0);
+    delta[p[i]] = deltah[i];
 
-  return (1);
-}
+  DFCOLOR(n,o,x,del,y,delta,deltaaux,DFx,DFy,F,data,ls);
 
+  return;
+} 
+/* fim SETDFCOLOR */
 
 
-/****************************************************/
-/* rotina que retorna x^y                           */
-/****************************************************/
 
-real 
-POWER (
-real x,
-int  y
+/***********************************************************/
+/* rotina que aloca a estrutura coloring a partir do       */
+/* padrao de DFy (uniao sobre as ordens 0..o) por linhas : */
+/* as variaveis que aparecem na equacao i sao ja[l],       */
+/* l = ia[i]..ia[i+1]-1. As colunas sao coloridas de forma */
+/* gulosa, na ordem natural, com a menor cor nao usada     */
+/* pelas colunas que compartilham alguma equacao. Retorna  */
+/* NULL se o padrao e invalido ou se nao ha memoria.       */
+/***********************************************************/
+
+coloring *
+COLORALLOC (
+int   n,
+int   o,
+int   nnz,
+vint  ia,
+vint  ja
 )
 {
-  real z;
+  coloring *cpr;   /* estrutura alocada                           */
+  int       i,j,l; /* variaveis auxiliares para controle de lacos */
+  int       m,c;   /* posicao no padrao e cor                     */
+  vint      w;     /* vetor de trabalho                           */
+
+  /* verificando o padrao */
+  if ((n <= 0) || (o < 0) || (ia == NULL) || (ja == NULL) || (nnz < 0) || 
+      (ia[1] != 1) || (ia[n+1] != nnz+1)) 
+    return (NULL);
+  for (i = 1; i <= n; i++) 
+    if (ia[i+1] < ia[i]) 
+      return (NULL);
+  for (l = 1; l <= nnz; l++) 
+    if ((ja[l] < 1) || (ja[l] > n)) 
+      return (NULL);
 
-  if (x == 0.0) {
-    if (y == 0) 
-      return (1.0); 
-    else 
-      return (0.0);
-  } else {
-    if ((abs(y) % 2) == 0) 
-      z = exp(abs(y)*log(fabs(x)));
-    else {
-      if (x > 0.0) 
-        z = exp(abs(y)*log(x)); 
-      else 
-        z = -exp(abs(y)*log(-x));
+  cpr = (coloring *) calloc(1,sizeof(coloring));
+  if (cpr == NULL) {
+    printf("COLORALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  cpr->n     = n;
+  cpr->o     = o;
+  cpr->cp    = (vint)  ALLOCVINT(n+1);
+  cpr->color = (vint)  ALLOCVINT(n);
+  cpr->gp    = (vint)  ALLOCVINT(n+1);
+  cpr->gv    = (vint)  ALLOCVINT(n);
+  cpr->del   = (mreal) ALLOCMREAL(o,n);
+  cpr->save  = (vreal) ALLOCVREAL(n);
+  w          = (vint)  ALLOCVINT(n+1);
+
+  if ((cpr->cp == NULL) || (cpr->color == NULL) || (cpr->gp   == NULL) ||
+      (cpr->gv == NULL) || (cpr->del   == NULL) || (cpr->save == NULL) ||
+      (w       == NULL)) {
+    printf("COLORALLOC : nao alocado\n");
+    FREEVINT(n+1,w);
+    COLORFREE(cpr);
+    return (NULL);
+  }
+
+  /* contando os elementos distintos de cada coluna */
+  for (i = 1; i <= n; i++) 
+    for (l = ia[i]; l < ia[i+1]; l++) 
+      if (w[ja[l]] != i) {
+        w[ja[l]] = i;
+        cpr->cp[ja[l]]++;
+      }
+  m = 1;
+  for (j = 1; j <= n; j++) {
+    c           = cpr->cp[j];
+    cpr->cp[j]  = m;
+    m          += c;
+  }
+  cpr->cp[n+1] = m;
+  cpr->nnz     = m-1;
+
+  cpr->ri = (vint) ALLOCVINT(cpr->nnz);
+  if (cpr->ri == NULL) {
+    printf("COLORALLOC : nao alocado\n");
+    FREEVINT(n+1,w);
+    COLORFREE(cpr);
+    return (NULL);
+  }
+
+  /* preenchendo as equacoes de cada coluna */
+  for (j = 1; j <= n; j++) {
+    cpr->gv[j] = cpr->cp[j];
+    w[j]       = 0;
+  }
+  for (i = 1; i <= n; i++) 
+    for (l = ia[i]; l < ia[i+1]; l++) 
+      if (w[ja[l]] != i) {
+        w[ja[l]]                 = i;
+        cpr->ri[cpr->gv[ja[l]]]  = i;
+        cpr->gv[ja[l]]++;
+      }
+
+  /* coloracao gulosa : w[c] = j se a cor c e usada por uma */
+  /* coluna vizinha da coluna j                            */
+  for (j = 1; j <= n; j++) 
+    w[j] = 0;
+  cpr->ncolor = 0;
+  for (j = 1; j <= n; j++) {
+    for (m = cpr->cp[j]; m < cpr->cp[j+1]; m++) {
+      i = cpr->ri[m];
+      for (l = ia[i]; l < ia[i+1]; l++) 
+        if (cpr->color[ja[l]] > 0) 
+          w[cpr->color[ja[l]]] = j;
     }
-    if (y > 0) return (z); else return (1.0/z);
+    c = 1;
+    while (w[c] == j) 
+      c++;
+    cpr->color[j] = c;
+    if (c > cpr->ncolor) 
+      cpr->ncolor = c;
   }
+
+  /* agrupando as variaveis por cor */
+  for (c = 1; c <= cpr->ncolor+1; c++) 
+    cpr->gp[c] = 0;
+  for (j = 1; j <= n; j++) 
+    cpr->gp[cpr->color[j]]++;
+  m = 1;
+  for (c = 1; c <= cpr->ncolor; c++) {
+    i           = cpr->gp[c];
+    cpr->gp[c]  = m;
+    w[c]        = m;
+    m          += i;
+  }
+  cpr->gp[cpr->ncolor+1] = m;
+  for (j = 1; j <= n; j++) {
+    cpr->gv[w[cpr->color[j]]] = j;
+    w[cpr->color[j]]++;
+  }
+
+  FREEVINT(n+1,w);
+
+  return (cpr);
 }
 
 
 
-/****************************************************/
-/* rotina que retorna x^(-y)                        */
-/****************************************************/
+/***********************************************************/
+/* rotina que libera a estrutura coloring                  */
+/***********************************************************/
 
-real 
-ROOT ( 
-real x,
-int  y
+void 
+COLORFREE (
+coloring *cpr
 )
 {
-  real z;
+  if (cpr == NULL) 
+    return;
 
-  if ((abs(y) % 2) == 0) 
-    z = exp(log(fabs(x))/abs(y));
-  else {
-    if (x > 0.0) 
-      z = exp(log(x)/abs(y)); 
-    else 
-      z = -exp(log(-x)/abs(y));
-  }
-  if (y > 0) 
-    return (z); 
-  else 
-    return (1.0/z);
-}
+  FREEVINT(cpr->n+1,cpr->cp);
+  FREEVINT(cpr->nnz,cpr->ri);
+  FREEVINT(cpr->n,cpr->color);
+  FREEVINT(cpr->n+1,cpr->gp);
+  FREEVINT(cpr->n,cpr->gv);
+  FREEMREAL(cpr->o,cpr->n,cpr->del);
+  FREEVREAL(cpr->n,cpr->save);
 
+  free(cpr);
 
-void    
-PIVOT (
-int   n,
-int   k,
-mreal A,
-mreal Q
-) 
-{
-  int   i,imax;
-  real  max;
-  vreal aux;
+  return;
+}
 
-  max  = fabs(A[k][k]);
-  imax = k;
 
-  for (i = k+1; i <= n; i++) 
-    if (fabs(A[i][k]) > max) {
-      imax = i;
-      max  = fabs(A[i][k]);
-    }
 
-  if (imax != k) {
-    aux     = A[k];
-    A[k]    = A[imax];
-    A[imax] = aux;
-    aux     = Q[k];
-    Q[k]    = Q[imax];
-    Q[imax] = aux;
-  }
+/***********************************************************/
+/* gerador de numeros pseudo-aleatorios em [0,1) usado na  */
+/* deteccao do padrao (congruencial, reprodutivel)         */
+/***********************************************************/
 
-  return;
+real 
+PATTERNRAND (
+unsigned long *seed
+)
+{
+  *seed = (1103515245UL*(*seed)+12345UL) & 0x7fffffffUL;
+
+  return ((real) (*seed)/2147483648.0);
 }
 
 
 
-/****************************************************************************/
-/* Esta rotina aplica a matriz de rotacao de Givens nas matrizes A e Q para */
-/* a decomposicao A = QR.                                                   */
-/****************************************************************************/
+/***********************************************************/
+/* rotina que aloca a estrutura pattern com nnz elementos  */
+/***********************************************************/
 
-void 
-GIVENS ( 
-int   m,
+pattern *
+PATTERNALLOC (
 int   n,
-int   i,
-int   k,
-mreal A,
-mreal Q,
-real  s1,
-real  s2
+int   o,
+int   nnz
 )
 {
-  int   j;   /* variavel auxiliar para controle de lacos  */
-  real  s,t; /* variaveis auxiliares para armazenar dados */
+  pattern *pt; /* estrutura alocada */
 
-  if (fabs(s2)+fabs(s1) > 0.0) {
-    if (fabs(s2) >= fabs(s1))
-      s  = sqrt(1.0+(s1/s2)*(s1/s2))*fabs(s2);
-    else
-      s  = sqrt(1.0+(s2/s1)*(s2/s1))*fabs(s1);
-    s1 = s1/s; s2 = s2/s; 
-    /* aplicando a matriz de rotacao em A */
-    for (j = 1; j <= n; j++) {
-      s       =  s1*A[i][j]+s2*A[k][j];
-      t       = -s2*A[i][j]+s1*A[k][j];
-      A[i][j] =  s; 
-      A[k][j] =  t;
-    }
-    /* aplicando a matriz de rotacao em Q */
-    for (j = 1; j <= m; j++) {
-      s       =  s1*Q[i][j]+s2*Q[k][j];
-      t       = -s2*Q[i][j]+s1*Q[k][j];
-      Q[i][j] =  s;
-      Q[k][j] =  t;
-    }
+  pt = (pattern *) calloc(1,sizeof(pattern));
+  if (pt == NULL) {
+    printf("PATTERNALLOC : nao alocado\n");
+    return (NULL);
   }
 
-  return;
+  pt->n   = n;
+  pt->o   = o;
+  pt->nnz = nnz;
+  pt->ia  = (vint) ALLOCVINT(n+1);
+  pt->ja  = (vint) ALLOCVINT(nnz);
+  pt->ord = (vint) ALLOCVINT(nnz);
+  pt->dx  = (vint) ALLOCVINT(n);
+
+  if ((pt->ia == NULL) || (pt->ja == NULL) || (pt->ord == NULL) || 
+      (pt->dx == NULL)) {
+    printf("PATTERNALLOC : nao alocado\n");
+    PATTERNFREE(pt);
+    return (NULL);
+  }
+
+  return (pt);
 }
 
 
 
-/**************************************************************************/
-/* Esta rotina retorna a decomposicao QR de uma matriz A (n+1)x(n) usando */
-/* o metodo de Givens. A matriz R volta em A e em Q volta a matriz Q^t da */
-/* decomposicao A = QR. Esta rotina tambem calcula uma estimativa para a  */
-/* condicao da matriz A.                                                  */
-/**************************************************************************/
+/***********************************************************/
+/* rotina que libera a estrutura pattern                   */
+/***********************************************************/
 
 void 
-QR (
-int    m,
-int    n,
-mreal  A,
-mreal  Q,
-int    pivot,
-real  *cond
+PATTERNFREE (
+pattern *pt
 )
 {
-  int   i,j; /* variaveis auxiliares para controle de lacos       */
+  if (pt == NULL) 
+    return;
 
-  /* inicializando Q com a identidade */
-  for (i = 1; i <= m; i++) {
-    for (j = 1; j <= m; j++) Q[i][j] = 0.0;
-    Q[i][i] = 1.0;
-  } 
+  FREEVINT(pt->n+1,pt->ia);
+  FREEVINT(pt->nnz,pt->ja);
+  FREEVINT(pt->nnz,pt->ord);
+  FREEVINT(pt->n,pt->dx);
 
-  /* decomposicao QR por Givens */
+  free(pt);
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* rotina que detecta o padrao de DFy e DFx em (x,y) : F e */
+/* avaliada em GSDAE_NPROBE pontos base aleatorios proximos*/
+/* de (x,y) e, em cada um, x e cada y[k][j] sao            */
+/* incrementados separadamente por um valor aleatorio. A   */
+/* equacao i entra no padrao da variavel se F[i] se altera */
+/* em algum ponto base, de modo que derivadas que se       */
+/* anulam apenas em (x,y) nao sao perdidas. O padrao e a   */
+/* uniao sobre as ordens (ord guarda as ordens de cada     */
+/* elemento). Custa GSDAE_NPROBE*((o+1)*n+2) avaliacoes de */
+/* F. Retorna NULL se o > GSDAE_PMAXO ou se nao ha memoria.*/
+/***********************************************************/
+
+pattern *
+PATTERNDETECT (
+int     n,
+int     o,
+real    x,
+mreal   y,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+)
+{
+  pattern      *pt;                   /* padrao detectado             */
+  int           i,j,k,l,t;            /* variaveis auxiliares         */
+  int           nz, nmax;             /* elementos das colunas        */
+  int           nl;                   /* equacoes da coluna atual     */
+  vint          cp, ri, rm;           /* padrao por colunas e ordens  */
+  vint          mask, list;           /* ordens das equacoes marcadas */
+  vint          dx;                   /* equacoes que dependem de x   */
+  vreal         f;                    /* F no ponto incrementado      */
+  real          del, save;            /* incremento e valor original  */
+  real          xb[GSDAE_NPROBE+1];   /* pontos base                  */
+  mreal         yb[GSDAE_NPROBE+1];
+  vreal         fb[GSDAE_NPROBE+1];   /* F nos pontos base            */
+  unsigned long seed;                 /* semente                      */
+  int           fail;                 /* falha na alocacao            */
+
+  if ((n <= 0) || (o < 0) || (o > GSDAE_PMAXO) || (y == NULL)) 
+    return (NULL);
+
+  nmax = 4*n;
+  cp   = (vint)  ALLOCVINT(n+1);
+  ri   = (vint)  ALLOCVINT(nmax);
+  rm   = (vint)  ALLOCVINT(nmax);
+  mask = (vint)  ALLOCVINT(n);
+  list = (vint)  ALLOCVINT(n);
+  dx   = (vint)  ALLOCVINT(n);
+  f    = (vreal) ALLOCVREAL(n);
+  fail = (cp   == NULL) || (ri == NULL) || (rm == NULL) || (mask == NULL) ||
+         (list == NULL) || (dx == NULL) || (f  == NULL);
+  for (t = 1; t <= GSDAE_NPROBE; t++) {
+    yb[t] = (mreal) ALLOCMREAL(o,n);
+    fb[t] = (vreal) ALLOCVREAL(n);
+    fail  = fail || (yb[t] == NULL) || (fb[t] == NULL);
+  }
+
+  if (!fail) {
+
+    /* pontos base */
+    seed = 20111UL;
+    for (t = 1; t <= GSDAE_NPROBE; t++) {
+      xb[t] = x+1.0e-3*(1.0+fabs(x))*(2.0*PATTERNRAND(&seed)-1.0);
+      for (k = 0; k <= o; k++)
+        for (i = 1; i <= n; i++)
+          yb[t][k][i] = y[k][i]+1.0e-3*(1.0+fabs(y[k][i]))*
+                                (2.0*PATTERNRAND(&seed)-1.0);
+      F(o,n,xb[t],yb[t],fb[t],data);
+    }
+
+    /* dependencia em x */
+    for (t = 1; t <= GSDAE_NPROBE; t++) {
+      del = 1.0e-2*(1.0+fabs(xb[t]))*(0.5+PATTERNRAND(&seed));
+      F(o,n,xb[t]+del,yb[t],f,data);
+      for (i = 1; i <= n; i++)
+        if (f[i] != fb[t][i]) 
+          dx[i] = 1;
+    }
+
+    /* padrao por colunas : equacoes que dependem de y[k][j] */
+    nz = 0;
+    for (j = 1; (j <= n) && (!fail); j++) {
+      cp[j] = nz+1;
+      nl    = 0;
+      for (t = 1; t <= GSDAE_NPROBE; t++) 
+        for (k = 0; k <= o; k++) {
+          save         = yb[t][k][j];
+          del          = 1.0e-2*(1.0+fabs(save))*(0.5+PATTERNRAND(&seed));
+          yb[t][k][j] += del;
+          F(o,n,xb[t],yb[t],f,data);
+          yb[t][k][j]  = save;
+          for (i = 1; i <= n; i++)
+            if (f[i] != fb[t][i]) {
+              if (mask[i] == 0) 
+                list[++nl] = i;
+              mask[i] |= (1 << k);
+            }
+        }
+
+      /* aumentando a area das colunas */
+      if (nz+nl > nmax) {
+        l    = nmax;
+        nmax = 2*nmax+nl;
+        ri   = (vint) REALLOCVINT(l,nmax,ri);
+        rm   = (vint) REALLOCVINT(l,nmax,rm);
+        fail = (ri == NULL) || (rm == NULL);
+      }
+
+      for (l = 1; (l <= nl) && (!fail); l++) {
+        i       = list[l];
+        nz++;
+        ri[nz]  = i;
+        rm[nz]  = mask[i];
+        mask[i] = 0;
+      }
+    }
+    cp[n+1] = nz+1;
+
+  }
+
+  /* padrao por linhas */
+  pt = NULL;
+  if (!fail) 
+    pt = PATTERNALLOC(n,o,nz);
+  if (pt != NULL) {
+    for (l = 1; l <= nz; l++) 
+      pt->ia[ri[l]]++;
+    k = 1;
+    for (i = 1; i <= n; i++) {
+      l         = pt->ia[i];
+      pt->ia[i] = k;
+      mask[i]   = k;
+      k        += l;
+    }
+    pt->ia[n+1] = k;
+    for (j = 1; j <= n; j++) 
+      for (l = cp[j]; l < cp[j+1]; l++) {
+        i                = ri[l];
+        pt->ja[mask[i]]  = j;
+        pt->ord[mask[i]] = rm[l];
+        mask[i]++;
+      }
+    for (i = 1; i <= n; i++) 
+      pt->dx[i] = dx[i];
+  } else if (fail) {
+    printf("PATTERNDETECT : nao alocado\n");
+  }
+
+  FREEVINT(n+1,cp);
+  FREEVINT(nmax,ri);
+  FREEVINT(nmax,rm);
+  FREEVINT(n,mask);
+  FREEVINT(n,list);
+  FREEVINT(n,dx);
+  FREEVREAL(n,f);
+  for (t = 1; t <= GSDAE_NPROBE; t++) {
+    FREEMREAL(o,n,yb[t]);
+    FREEVREAL(n,fb[t]);
+  }
+
+  return (pt);
+}
+
+
+
+/***********************************************************/
+/* rotina que grava o padrao no arquivo file, para que     */
+/* execucoes seguintes do mesmo modelo nao repitam a       */
+/* deteccao. Formato texto : "GSDAE n o nnz", uma linha    */
+/* "i j ord" por elemento e uma linha dx[i] por equacao.   */
+/* Retorna 0, ou -1 se o arquivo nao pode ser gravado.     */
+/***********************************************************/
+
+int 
+PATTERNWRITE (
+char    *file,
+pattern *pt
+)
+{
+  FILE *fp;   /* arquivo do padrao   */
+  int   i,l;  /* variaveis auxiliares */
+
+  fp = fopen(file,"w");
+  if (fp == NULL) {
+    printf("PATTERNWRITE : arquivo %s nao gravado\n",file);
+    return (-1);
+  }
+
+  fprintf(fp,"GSDAE %d %d %d\n",pt->n,pt->o,pt->nnz);
+  for (i = 1; i <= pt->n; i++) 
+    for (l = pt->ia[i]; l < pt->ia[i+1]; l++) 
+      fprintf(fp,"%d %d %d\n",i,pt->ja[l],pt->ord[l]);
+  for (i = 1; i <= pt->n; i++) 
+    fprintf(fp,"%d\n",pt->dx[i]);
+
+  if (fclose(fp) != 0) {
+    printf("PATTERNWRITE : arquivo %s nao gravado\n",file);
+    return (-1);
+  }
+
+  return (0);
+}
+
+
+
+/***********************************************************/
+/* rotina que le um padrao gravado por PATTERNWRITE.       */
+/* Retorna NULL se o arquivo nao existe, e invalido ou foi */
+/* gravado para outra dimensao ou ordem.                   */
+/***********************************************************/
+
+pattern *
+PATTERNREAD (
+char *file,
+int   n,
+int   o
+)
+{
+  FILE    *fp;        /* arquivo do padrao    */
+  pattern *pt;        /* padrao lido          */
+  int      i,j,l,m;   /* variaveis auxiliares */
+  int      nf,of,nnz; /* cabecalho            */
+  int      ok;        /* arquivo valido       */
+
+  fp = fopen(file,"r");
+  if (fp == NULL) 
+    return (NULL);
+
+  pt = NULL;
+  if ((fscanf(fp,"GSDAE %d %d %d",&nf,&of,&nnz) == 3) && 
+      (nf == n) && (of == o) && (nnz >= 0)) 
+    pt = PATTERNALLOC(n,o,nnz);
+
+  ok = (pt != NULL);
+  if (ok) {
+    /* os elementos estao ordenados por linhas */
+    i = 1;
+    pt->ia[1] = 1;
+    for (l = 1; (l <= nnz) && ok; l++) {
+      ok = (fscanf(fp,"%d %d %d",&m,&j,&(pt->ord[l])) == 3) && 
+           (m >= i) && (m <= n) && (j >= 1) && (j <= n);
+      if (ok) {
+        for (; i < m; i++) 
+          pt->ia[i+1] = l;
+        pt->ja[l] = j;
+      }
+    }
+    for (; i <= n; i++) 
+      pt->ia[i+1] = nnz+1;
+    for (i = 1; (i <= n) && ok; i++) 
+      ok = (fscanf(fp,"%d",&(pt->dx[i])) == 1);
+  }
+  fclose(fp);
+
+  if (!ok) {
+    PATTERNFREE(pt);
+    return (NULL);
+  }
+
+  return (pt);
+}
+
+
+
+/***********************************************************/
+/* rotina que monta o padrao de DH (SETDH) por linhas, com */
+/* dimensao o*n+r+1, a partir do padrao pt e das           */
+/* permutacoes p e q. As linhas da cadeia de derivadas e a */
+/* linha de normalizacao (densa) tem estrutura fixa. Se ia */
+/* e ja sao NULL apenas o numero de elementos e calculado. */
+/* Retorna o numero de elementos, ou -1 se o = 0 ou se nao */
+/* ha memoria disponivel.                                  */
+/***********************************************************/
+
+int 
+PATTERNDH (
+pattern *pt,
+int      r,
+vint     p,
+vint     q,
+vint     ia,
+vint     ja
+)
+{
+  int  n, o, dim;  /* dimensoes                   */
+  int  i,j,k,l,e;  /* variaveis auxiliares        */
+  int  nz;         /* elementos do padrao de DH   */
+  vint qinv;       /* inversa da permutacao q     */
+
+  n   = pt->n;
+  o   = pt->o;
+  dim = o*n+r+1;
+  if (o == 0) 
+    return (-1);
+
+  qinv = (vint) ALLOCVINT(n);
+  if (qinv == NULL) {
+    printf("PATTERNDH : nao alocado\n");
+    return (-1);
+  }
+  for (j = 1; j <= n; j++) 
+    qinv[q[j]] = j;
+
+  /* linhas de F : DH[i][j] = DFy[k][q[j]][p[i]] e DFx[p[i]] */
+  nz = 0;
+  for (i = 1; i <= n; i++) {
+    if (ia != NULL) 
+      ia[i] = nz+1;
+    e = p[i];
+    for (l = pt->ia[e]; l < pt->ia[e+1]; l++) {
+      j = qinv[pt->ja[l]];
+      for (k = o; k >= 0; k--) 
+        if (pt->ord[l] & (1 << k)) {
+          if (k == o) {
+            if ((i > r) || (j > r)) 
+              continue;
+            nz++;
+            if (ja != NULL) 
+              ja[nz] = j;
+          } else {
+            nz++;
+            if (ja != NULL) 
+              ja[nz] = (o-k-1)*n+r+j;
+          }
+        }
+    }
+    if (pt->dx[e]) {
+      nz++;
+      if (ja != NULL) 
+        ja[nz] = dim;
+    }
+  }
+
+  /* linhas da cadeia : y[o][q[i]] x' - y'[o-1][q[i]] (i = 1..r) */
+  for (i = 1; i <= r; i++) {
+    if (ia != NULL) {
+      ia[n+i]  = nz+1;
+      ja[nz+1] = i;
+      ja[nz+2] = r+i;
+      ja[nz+3] = dim;
+    }
+    nz += 3;
+  }
+
+  /* y[k][q[i]] x' - y'[k-1][q[i]] (k = o-1..1, i = 1..n) */
+  for (k = o-1; k >= 1; k--) 
+    for (i = 1; i <= n; i++) {
+      if (ia != NULL) {
+        ia[(o-k)*n+r+i] = nz+1;
+        ja[nz+1]        = (o-1-k)*n+r+i;
+        ja[nz+2]        = (o-k)*n+r+i;
+        ja[nz+3]        = dim;
+      }
+      nz += 3;
+    }
+
+  /* linha de normalizacao */
+  if (ia != NULL) {
+    ia[dim] = nz+1;
+    for (j = 1; j <= dim; j++) 
+      ja[nz+j] = j;
+    ia[dim+1] = nz+dim+1;
+  }
+  nz += dim;
+
+  FREEVINT(n,qinv);
+
+  return (nz);
+}
+
+
+
+/***********************************************************/
+/* rotina que aloca a estrutura fdjac com nthreads threads */
+/* e as copias privadas do ponto e dos residuos de cada    */
+/* thread                                                  */
+/***********************************************************/
+
+fdjac *
+FDALLOC (
+int   n,
+int   o,
+int   nthreads
+)
+{
+  fdjac *fd;   /* estrutura alocada    */
+  int    t;    /* variavel auxiliar    */
+  int    fail; /* falha na alocacao    */
+
+  fd = (fdjac *) calloc(1,sizeof(fdjac));
+  if (fd == NULL) {
+    printf("FDALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  fd->pl = POOLALLOC(nthreads);
+  if (fd->pl == NULL) {
+    free(fd);
+    return (NULL);
+  }
+  fd->nthreads = fd->pl->nthreads;
+  fd->nalloc   = n;
+  fd->oalloc   = o;
+
+  fd->y  = (mreal *) calloc(fd->nthreads,sizeof(mreal));
+  fd->dy = (mreal *) calloc(fd->nthreads,sizeof(mreal));
+  fd->f  = (vreal *) calloc(fd->nthreads,sizeof(vreal));
+  fd->fh = (vreal *) calloc(fd->nthreads,sizeof(vreal));
+  fail   = (fd->y == NULL) || (fd->dy == NULL) || (fd->f == NULL) || 
+           (fd->fh == NULL);
+  for (t = 0; (t < fd->nthreads) && (!fail); t++) {
+    fd->y[t]  = (mreal) ALLOCMREAL(o,n);
+    fd->dy[t] = (mreal) ALLOCMREAL(o,n);
+    fd->f[t]  = (vreal) ALLOCVREAL(n+1);
+    fd->fh[t] = (vreal) ALLOCVREAL((o+1)*n+1);
+    fail      = (fd->y[t] == NULL) || (fd->dy[t] == NULL) || 
+                (fd->f[t] == NULL) || (fd->fh[t] == NULL);
+  }
+
+  if (fail) {
+    printf("FDALLOC : nao alocado\n");
+    FDFREE(fd);
+    return (NULL);
+  }
+
+  return (fd);
+}
+
+
+
+/***********************************************************/
+/* rotina que libera a estrutura fdjac                     */
+/***********************************************************/
+
+void 
+FDFREE (
+fdjac *fd
+)
+{
+  int t, n, o; /* variaveis auxiliares */
+
+  if (fd == NULL) 
+    return;
+
+  POOLFREE(fd->pl);
+
+  n = fd->nalloc;
+  o = fd->oalloc;
+  for (t = 0; t < fd->nthreads; t++) {
+    if (fd->y  != NULL) FREEMREAL(o,n,fd->y[t]);
+    if (fd->dy != NULL) FREEMREAL(o,n,fd->dy[t]);
+    if (fd->f  != NULL) FREEVREAL(n+1,fd->f[t]);
+    if (fd->fh != NULL) FREEVREAL((o+1)*n+1,fd->fh[t]);
+  }
+  free(fd->y);
+  free(fd->dy);
+  free(fd->f);
+  free(fd->fh);
+  free(fd);
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* rotina que aloca a estrutura qrthr com nthreads threads */
+/* e as areas de trabalho de cada thread para matrizes de  */
+/* dimensao ate dim                                        */
+/***********************************************************/
+
+qrthr *
+QRTHALLOC (
+int   dim,
+int   nb,
+int   nthreads,
+int   nmin
+)
+{
+  qrthr *qt;   /* estrutura alocada    */
+  int    t;    /* variavel auxiliar    */
+  int    fail; /* falha na alocacao    */
+
+  qt = (qrthr *) calloc(1,sizeof(qrthr));
+  if (qt == NULL) {
+    printf("QRTHALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  qt->pl = POOLALLOC(nthreads);
+  if (qt->pl == NULL) {
+    free(qt);
+    return (NULL);
+  }
+  qt->nthreads = qt->pl->nthreads;
+  qt->nmin     = (nmin > 0) ? nmin : GSDAE_QRMIN;
+  qt->nb       = nb;
+  qt->dim      = dim;
+  pthread_mutex_init(&(qt->lock),NULL);
+
+  qt->W  = (mreal *) calloc(qt->nthreads,sizeof(mreal));
+  qt->rc = (vreal) ALLOCVREAL(dim);
+  qt->rs = (vreal) ALLOCVREAL(dim);
+  qt->rk = (vint)  ALLOCVINT(dim);
+  fail   = (qt->W == NULL) || (qt->rc == NULL) || (qt->rs == NULL) ||
+           (qt->rk == NULL);
+  for (t = 0; (t < qt->nthreads) && (!fail); t++) {
+    qt->W[t] = (mreal) ALLOCMREAL(nb,dim);
+    fail     = (qt->W[t] == NULL);
+  }
+
+  if (fail) {
+    printf("QRTHALLOC : nao alocado\n");
+    QRTHFREE(qt);
+    return (NULL);
+  }
+
+  return (qt);
+}
+
+
+
+/***********************************************************/
+/* rotina que libera a estrutura qrthr                     */
+/***********************************************************/
+
+void 
+QRTHFREE (
+qrthr *qt
+)
+{
+  int t; /* variavel auxiliar */
+
+  if (qt == NULL) 
+    return;
+
+  POOLFREE(qt->pl);
+
+  for (t = 0; (qt->W != NULL) && (t < qt->nthreads); t++) 
+    FREEMREAL(qt->nb,qt->dim,qt->W[t]);
+  free(qt->W);
+  FREEVREAL(qt->dim,qt->rc);
+  FREEVREAL(qt->dim,qt->rs);
+  FREEVINT(qt->dim,qt->rk);
+  pthread_mutex_destroy(&(qt->lock));
+  free(qt);
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* tarefa das threads de qrthr : cada thread retira        */
+/* ladrilhos de GSDAE_QRTILE colunas de j0..j1 ate que nao */
+/* restem ladrilhos, e aplica neles a atualizacao kind.    */
+/* As colunas sao independentes, de modo que o resultado   */
+/* e identico ao da rotina sequencial.                     */
+/***********************************************************/
+
+void 
+QRTHTASK (
+int   id,
+void *arg
+)
+{
+  qrthr *qt;    /* estrutura das threads */
+  int    t;     /* ladrilho              */
+  int    ja,jb; /* colunas do ladrilho   */
+
+  qt = (qrthr *) arg;
+
+  while (1) {
+
+    pthread_mutex_lock(&(qt->lock));
+    t = (qt->next)++;
+    pthread_mutex_unlock(&(qt->lock));
+    if (t >= qt->ntile) 
+      break;
+
+    ja = qt->j0+t*GSDAE_QRTILE;
+    jb = MIN2(ja+GSDAE_QRTILE-1,qt->j1);
+
+    if (qt->kind == GSDAE_THQRH) 
+      QRHUPDATE(qt->m,qt->A,qt->T,qt->W[id],qt->k0,qt->k1,ja,jb);
+    else if (qt->kind == GSDAE_THLUH) 
+      LUHUPDATE(qt->n,qt->A,qt->k0,qt->k1,ja,jb);
+    else 
+      QR2UPDATE(qt->n,qt->k0,qt->A,qt->T,qt->p,qt->q,qt->rc,qt->rs,
+                qt->rk,ja,jb);
+
+  }
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* rotina que executa a atualizacao kind nas colunas j0..j1 */
+/* com as threads de qt                                    */
+/***********************************************************/
+
+void 
+QRTHRUN (
+qrthr *qt,
+int    kind,
+int    m,
+int    n,
+int    k0,
+int    k1,
+int    j0,
+int    j1,
+mreal  A,
+mreal  T,
+vint   p,
+vint   q
+)
+{
+  qt->kind  = kind;
+  qt->m     = m;
+  qt->n     = n;
+  qt->k0    = k0;
+  qt->k1    = k1;
+  qt->j0    = j0;
+  qt->j1    = j1;
+  qt->A     = A;
+  qt->T     = T;
+  qt->p     = p;
+  qt->q     = q;
+  qt->next  = 0;
+  qt->ntile = (j1-j0+GSDAE_QRTILE)/GSDAE_QRTILE;
+
+  POOLRUN(qt->pl,QRTHTASK,(void *) qt);
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* rotina que define os dados comuns da proxima tarefa de  */
+/* FDTASK : ncol colunas (ou cores) no ponto (x,y), onde   */
+/* base contem F (GSDAE_FDDF e GSDAE_FDCOLOR) ou H         */
+/* (GSDAE_FDDH)                                            */
+/***********************************************************/
+
+void 
+FDSETUP (
+fdjac  *fd,
+int     kind,
+int     ncol,
+int     n,
+int     o,
+int     r,
+int     dim,
+real    x,
+mreal   y,
+vreal   base,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+)
+{
+  fd->kind = kind;
+  fd->ncol = ncol;
+  fd->n    = n;
+  fd->o    = o;
+  fd->r    = r;
+  fd->dim  = dim;
+  fd->x    = x;
+  fd->ys   = y;
+  fd->base = base;
+  fd->F    = F;
+  fd->data = data;
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* Tarefa executada por cada thread nas jacobianas         */
+/* aproximadas : a thread id calcula uma faixa contigua    */
+/* das colunas (a coluna 0 e a de x) com as suas copias    */
+/* privadas do ponto, que e restaurado a partir de fd->ys. */
+/* Cada coluna e calculada exatamente como na versao       */
+/* sequencial.                                             */
+/***********************************************************/
+
+void 
+FDTASK (
+int   id,
+void *arg
+)
+{
+  fdjac    *fd;       /* dados compartilhados        */
+  int       lo, hi;   /* faixa de colunas            */
+  int       n, o;     /* dimensao e ordem            */
+  int       c,i,j,k;  /* variaveis auxiliares        */
+  int       g,l,m;    /* cor e posicoes no padrao    */
+  real      del;      /* incremento                  */
+  mreal     y, dy;    /* copias privadas do ponto    */
+  vreal     f, fh;    /* residuos privados           */
+  coloring *cpr;      /* coloracao das colunas       */
+
+  fd  = (fdjac *) arg;
+  lo  = (int) (((long) id*fd->ncol)/fd->nthreads);
+  hi  = (int) (((long) (id+1)*fd->ncol)/fd->nthreads);
+  if (lo >= hi) 
+    return;
+
+  n   = fd->n;
+  o   = fd->o;
+  y   = fd->y[id];
+  dy  = fd->dy[id];
+  f   = fd->f[id];
+  fh  = fd->fh[id];
+  cpr = fd->cpr;
+
+  /* copia privada do ponto */
+  for (k = 0; k <= o; k++)
+    for (i = 1; i <= n; i++)
+      y[k][i] = fd->ys[k][i];
+  if (fd->kind == GSDAE_FDDH) 
+    for (k = 0; k <= o; k++)
+      for (i = 1; i <= n; i++)
+        dy[k][i] = fd->dys[k][i];
+
+  for (c = lo; c < hi; c++) {
+
+    if (fd->kind == GSDAE_FDDH) {
+
+      /* colunas de DH como em SETDHAPPROX */
+      if (c == 0) {
+        del  = fd->uround*MAX3(fabs(fd->h*fd->dx),fabs(fd->x),fabs(fd->wtx));
+        del *= FSIGN(fd->h*fd->dx);
+        del  = (fd->x+del)-fd->x;
+        SETH(n,o,fd->r,fd->h,fd->dx+del*fd->cj,dy,fd->x+del,y,fd->p,fd->q,
+             f,fh,fd->F,fd->data);
+        del  = 1.0/del;
+        for (j = 1; j <= fd->dim; j++)
+          fd->DH[j][fd->dim] = (fh[j]-fd->base[j])*del;
+      } else {
+        k         = o-(c-1)/n;
+        i         = (c-1)%n+1;
+        del       = fd->uround*MAX3(fabs(fd->h*dy[k][i]),fabs(y[k][i]),
+                                    fabs(fd->wty[k][i]));
+        del      *= FSIGN(fd->h*dy[k][i]);
+        del       = (y[k][i]+del)-y[k][i];
+        y[k][i]  += del;
+        dy[k][i] += del*fd->cj;
+        del       = 1.0/del;
+        SETH(n,o,fd->r,fd->h,fd->dx,dy,fd->x,y,fd->p,fd->q,
+             f,fh,fd->F,fd->data);
+        for (j = 1; j <= fd->dim; j++)
+          fd->DH[j][c] = (fh[j]-fd->base[j])*del;
+        y[k][i]   = fd->ys[k][i];
+        dy[k][i]  = fd->dys[k][i];
+      }
+
+    } else if (fd->kind == GSDAE_FDDF) {
+
+      /* colunas de DF como em DFAPPROX */
+      if (c == 0) {
+        del = fd->uround*fabs(fd->x);
+        del = (fd->x+del)-fd->x;
+        fd->F(o,n,fd->x+del,y,f,fd->data);
+        del = 1.0/del;
+        for (j = 1; j <= n; j++)
+          fd->DFx[j] = (f[j]-fd->base[j])*del;
+      } else {
+        k        = o-(c-1)/n;
+        i        = (c-1)%n+1;
+        del      = fd->uround*fabs(y[k][i]);
+        del      = (y[k][i]+del)-y[k][i];
+        y[k][i] += del;
+        del      = 1.0/del;
+        fd->F(o,n,fd->x,y,f,fd->data);
+        for (j = 1; j <= n; j++)
+          fd->DFy[k][i][j] = (f[j]-fd->base[j])*del;
+        y[k][i]  = fd->ys[k][i];
+      }
+
+    } else {
+
+      /* cores de DF como em DFCOLOR */
+      if (c == 0) {
+        del = 1.0/fd->delx;
+        fd->F(o,n,fd->x+fd->delx,y,f,fd->data);
+        for (j = 1; j <= n; j++)
+          fd->DFx[j] = (f[j]-fd->base[j])*del;
+      } else {
+        k = o-(c-1)/cpr->ncolor;
+        g = (c-1)%cpr->ncolor+1;
+        for (l = cpr->gp[g]; l < cpr->gp[g+1]; l++) 
+          y[k][cpr->gv[l]] += cpr->del[k][cpr->gv[l]];
+        fd->F(o,n,fd->x,y,f,fd->data);
+        for (l = cpr->gp[g]; l < cpr->gp[g+1]; l++) {
+          j       = cpr->gv[l];
+          y[k][j] = fd->ys[k][j];
+          del     = 1.0/cpr->del[k][j];
+          for (m = cpr->cp[j]; m < cpr->cp[j+1]; m++) {
+            i                = cpr->ri[m];
+            fd->DFy[k][j][i] = (f[i]-fd->base[i])*del;
+          }
+        }
+      }
+
+    }
+
+  }
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* rotina que aloca a estrutura fbatch para lotes de ate   */
+/* mmax pontos de dimensao n e ordem o                     */
+/***********************************************************/
+
+fbatch *
+FBALLOC (
+int   n,
+int   o,
+int   mmax,
+void (*Fb)(int,int,int,vreal,mmreal,mreal,void *)
+)
+{
+  fbatch *fb;   /* estrutura alocada    */
+  int     l;    /* variavel auxiliar    */
+  int     fail; /* falha na alocacao    */
+
+  fb = (fbatch *) calloc(1,sizeof(fbatch));
+  if (fb == NULL) {
+    printf("FBALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  fb->mmax   = mmax;
+  fb->Fb     = Fb;
+  fb->nalloc = n;
+  fb->oalloc = o;
+
+  fb->xs  = (vreal) ALLOCVREAL(mmax);
+  fb->ys  = (mmreal) calloc(mmax+1,sizeof(mreal));
+  fb->fs  = (mreal) ALLOCMREAL(mmax,n);
+  fb->del = (vreal) ALLOCVREAL(mmax);
+  fb->dy  = (mreal) ALLOCMREAL(o,n);
+  fb->fh  = (vreal) ALLOCVREAL((o+1)*n+1);
+  fail    = (fb->xs == NULL) || (fb->ys == NULL) || (fb->fs == NULL) || 
+            (fb->del == NULL) || (fb->dy == NULL) || (fb->fh == NULL);
+  for (l = 1; (l <= mmax) && (!fail); l++) {
+    fb->ys[l] = (mreal) ALLOCMREAL(o,n);
+    fail      = (fb->ys[l] == NULL);
+  }
+
+  if (fail) {
+    printf("FBALLOC : nao alocado\n");
+    FBFREE(fb);
+    return (NULL);
+  }
+
+  return (fb);
+}
+
+
+
+/***********************************************************/
+/* rotina que libera a estrutura fbatch                    */
+/***********************************************************/
+
+void 
+FBFREE (
+fbatch *fb
+)
+{
+  int l, n, o; /* variaveis auxiliares */
+
+  if (fb == NULL) 
+    return;
+
+  n = fb->nalloc;
+  o = fb->oalloc;
+  for (l = 1; (fb->ys != NULL) && (l <= fb->mmax); l++) 
+    if (fb->ys[l] != NULL) 
+      FREEMREAL(o,n,fb->ys[l]);
+  free(fb->ys);
+  if (fb->xs  != NULL) FREEVREAL(fb->mmax,fb->xs);
+  if (fb->fs  != NULL) FREEMREAL(fb->mmax,n,fb->fs);
+  if (fb->del != NULL) FREEVREAL(fb->mmax,fb->del);
+  if (fb->dy  != NULL) FREEMREAL(o,n,fb->dy);
+  if (fb->fh  != NULL) FREEVREAL((o+1)*n+1,fb->fh);
+  free(fb);
+
+  return;
+}
+
+
+
+/***********************************************************/
+/* Jacobianas aproximadas com a rotina Fb do usuario : as  */
+/* colunas da tarefa fb->task (as mesmas de FDTASK, com a  */
+/* coluna 0 de x) sao avaliadas em lotes de ate fb->mmax   */
+/* pontos por chamada de Fb. Cada ponto do lote e uma      */
+/* copia do ponto com a perturbacao da sua coluna, que e   */
+/* desfeita apos o lote. Com Fb equivalente a F cada       */
+/* coluna e igual a da versao sequencial.                  */
+/***********************************************************/
+
+void 
+FBRUN (
+fbatch *fb
+)
+{
+  fdjac    *fd;       /* tarefa atual                */
+  int       n, o;     /* dimensao e ordem            */
+  int       c0, mc;   /* primeira coluna e tamanho   */
+  int       c,i,j,k;  /* variaveis auxiliares        */
+  int       g,l,m,v;  /* cor e posicoes no padrao    */
+  real      del;      /* incremento                  */
+  mreal     y;        /* ponto perturbado            */
+  vreal     f;        /* F no ponto perturbado       */
+  coloring *cpr;      /* coloracao das colunas       */
+
+  fd  = &(fb->task);
+  n   = fd->n;
+  o   = fd->o;
+  cpr = fd->cpr;
+
+  /* copias do ponto usadas pelos lotes */
+  mc = MIN2(fb->mmax,fd->ncol);
+  for (l = 1; l <= mc; l++)
+    for (k = 0; k <= o; k++)
+      for (i = 1; i <= n; i++)
+        fb->ys[l][k][i] = fd->ys[k][i];
+  if (fd->kind == GSDAE_FDDH) 
+    for (k = 0; k <= o; k++)
+      for (i = 1; i <= n; i++)
+        fb->dy[k][i] = fd->dys[k][i];
+
+  for (c0 = 0; c0 < fd->ncol; c0 += fb->mmax) {
+
+    mc = MIN2(fb->mmax,fd->ncol-c0);
+
+    /* perturbando os pontos do lote */
+    for (l = 1; l <= mc; l++) {
+
+      c          = c0+l-1;
+      y          = fb->ys[l];
+      fb->xs[l]  = fd->x;
+
+      if (fd->kind == GSDAE_FDDH) {
+
+        /* incrementos de SETDHAPPROX */
+        if (c == 0) {
+          del  = fd->uround*MAX3(fabs(fd->h*fd->dx),fabs(fd->x),fabs(fd->wtx));
+          del *= FSIGN(fd->h*fd->dx);
+          del  = (fd->x+del)-fd->x;
+          fb->xs[l] = fd->x+del;
+        } else {
+          k        = o-(c-1)/n;
+          i        = (c-1)%n+1;
+          del      = fd->uround*MAX3(fabs(fd->h*fd->dys[k][i]),fabs(y[k][i]),
+                                     fabs(fd->wty[k][i]));
+          del     *= FSIGN(fd->h*fd->dys[k][i]);
+          del      = (y[k][i]+del)-y[k][i];
+          y[k][i] += del;
+        }
+
+      } else if (fd->kind == GSDAE_FDDF) {
+
+        /* incrementos de DFAPPROX */
+        if (c == 0) {
+          del = fd->uround*fabs(fd->x);
+          del = (fd->x+del)-fd->x;
+          fb->xs[l] = fd->x+del;
+        } else {
+          k        = o-(c-1)/n;
+          i        = (c-1)%n+1;
+          del      = fd->uround*fabs(y[k][i]);
+          del      = (y[k][i]+del)-y[k][i];
+          y[k][i] += del;
+        }
+
+      } else {
+
+        /* incrementos de DFCOLOR */
+        del = fd->delx;
+        if (c == 0) {
+          fb->xs[l] = fd->x+fd->delx;
+        } else {
+          k = o-(c-1)/cpr->ncolor;
+          g = (c-1)%cpr->ncolor+1;
+          for (m = cpr->gp[g]; m < cpr->gp[g+1]; m++) 
+            y[k][cpr->gv[m]] += cpr->del[k][cpr->gv[m]];
+        }
+
+      }
+
+      fb->del[l] = del;
+
+    }
+
+    /* avaliando F nos pontos do lote */
+    fb->Fb(o,n,mc,fb->xs,fb->ys,fb->fs,fd->data);
+
+    /* colunas do lote e restauracao dos pontos */
+    for (l = 1; l <= mc; l++) {
+
+      c   = c0+l-1;
+      y   = fb->ys[l];
+      f   = fb->fs[l];
+      del = fb->del[l];
+
+      if (fd->kind == GSDAE_FDDH) {
+
+        if (c == 0) {
+          SETHW(n,o,fd->r,fd->h,fd->dx+del*fd->cj,fb->dy,y,fd->p,fd->q,
+                f,fb->fh);
+          del = 1.0/del;
+          for (j = 1; j <= fd->dim; j++)
+            fd->DH[j][fd->dim] = (fb->fh[j]-fd->base[j])*del;
+        } else {
+          k             = o-(c-1)/n;
+          i             = (c-1)%n+1;
+          fb->dy[k][i] += del*fd->cj;
+          del           = 1.0/del;
+          SETHW(n,o,fd->r,fd->h,fd->dx,fb->dy,y,fd->p,fd->q,f,fb->fh);
+          for (j = 1; j <= fd->dim; j++)
+            fd->DH[j][c] = (fb->fh[j]-fd->base[j])*del;
+          y[k][i]       = fd->ys[k][i];
+          fb->dy[k][i]  = fd->dys[k][i];
+        }
+
+      } else if (fd->kind == GSDAE_FDDF) {
+
+        del = 1.0/del;
+        if (c == 0) {
+          for (j = 1; j <= n; j++)
+            fd->DFx[j] = (f[j]-fd->base[j])*del;
+        } else {
+          k       = o-(c-1)/n;
+          i       = (c-1)%n+1;
+          for (j = 1; j <= n; j++)
+            fd->DFy[k][i][j] = (f[j]-fd->base[j])*del;
+          y[k][i] = fd->ys[k][i];
+        }
+
+      } else {
+
+        if (c == 0) {
+          del = 1.0/del;
+          for (j = 1; j <= n; j++)
+            fd->DFx[j] = (f[j]-fd->base[j])*del;
+        } else {
+          k = o-(c-1)/cpr->ncolor;
+          g = (c-1)%cpr->ncolor+1;
+          for (m = cpr->gp[g]; m < cpr->gp[g+1]; m++) {
+            j       = cpr->gv[m];
+            y[k][j] = fd->ys[k][j];
+            del     = 1.0/cpr->del[k][j];
+            for (v = cpr->cp[j]; v < cpr->cp[j+1]; v++) {
+              i                = cpr->ri[v];
+              fd->DFy[k][j][i] = (f[i]-fd->base[i])*del;
+            }
+          }
+        }
+
+      }
+
+    }
+
+  }
+
+  return;
+}
+
+
+
+/* ************************************************************* */
+/* Esta rotina inicializa todos os dados para a aplicacao do     */
+/* metodo BDF.                                                   */
+/* ************************************************************* */
+
+void 
+firststep (
+int     n,
+int     o,
+int     r,
+real    cx,
+mreal   cy,
+vreal   phix,
+mmreal  phiy,
+vint    p,
+vint    q,
+real    taux,
+mreal   tauy,
+real   *cj,
+real   *cjold,
+real   *factor,
+real   *hold,
+real    h,
+int    *k,
+int    *kold,
+int    *ns,
+vreal   psi,
+int    *ifase,
+real   *pdcx
+)
+{  
+  int   i,j; /* variaveis auxiliares                */
+
+  /* inicializando phi */
+  phix[1] = cx;
+  phix[2] = h*taux;
+  for (i = 0; i <= o; i++) {
+    for (j = 1; j <= n; j++) { 
+      phiy[1][i][j] = cy[i][j] ;
+      phiy[2][i][j] = h*tauy[i][j];
+    }
+  }  
+        
+  /* inicializando psi */
+  psi[1] = h;
+
+  /* inicializacao para realizar o primeiro passo */
+  *cj     = 1.0/h ;
+  *cjold  = *cj;
+  *hold   = 0.0;
+  *kold   = 0;
+  *k      = 1;
+  *ns     = 0; 
+  *ifase  = 0;
+  *pdcx   = taux;
+  *factor = 100.0;
+
+  return; 
+} 
+/* fim firststep */
+
+
+
+int 
+functionnorm (
+int   n,
+vreal x,
+vreal tol
+)
+{
+  int i;
+
+  for (i = 1; i <= n; i++)
+    if (fabs(x[i]) > tol[i]) return (0);
+
+  return (1);
+}
+
+
+
+/****************************************************/
+/* rotina que retorna x^y                           */
+/****************************************************/
+
+real 
+POWER (
+real x,
+int  y
+)
+{
+  real z;
+
+  if (x == 0.0) {
+    if (y == 0) 
+      return (1.0); 
+    else 
+      return (0.0);
+  } else {
+    if ((abs(y) % 2) == 0) 
+      z = exp(abs(y)*log(fabs(x)));
+    else {
+      if (x > 0.0) 
+        z = exp(abs(y)*log(x)); 
+      else 
+        z = -exp(abs(y)*log(-x));
+    }
+    if (y > 0) return (z); else return (1.0/z);
+  }
+}
+
+
+
+/****************************************************/
+/* rotina que retorna x^(-y)                        */
+/****************************************************/
+
+real 
+ROOT ( 
+real x,
+int  y
+)
+{
+  real z;
+
+  if ((abs(y) % 2) == 0) 
+    z = exp(log(fabs(x))/abs(y));
+  else {
+    if (x > 0.0) 
+      z = exp(log(x)/abs(y)); 
+    else 
+      z = -exp(log(-x)/abs(y));
+  }
+  if (y > 0) 
+    return (z); 
+  else 
+    return (1.0/z);
+}
+
+
+void    
+PIVOT (
+int   n,
+int   k,
+mreal A,
+mreal Q
+) 
+{
+  int   i,imax;
+  real  max;
+  vreal aux;
+
+  max  = fabs(A[k][k]);
+  imax = k;
+
+  for (i = k+1; i <= n; i++) 
+    if (fabs(A[i][k]) > max) {
+      imax = i;
+      max  = fabs(A[i][k]);
+    }
+
+  if (imax != k) {
+    aux     = A[k];
+    A[k]    = A[imax];
+    A[imax] = aux;
+    aux     = Q[k];
+    Q[k]    = Q[imax];
+    Q[imax] = aux;
+  }
+
+  return;
+}
+
+
+
+/****************************************************************************/
+/*                     NUCLEOS VETORIAIS (SSE2/AVX2/AVX-512)                */
+/*                                                                          */
+/* Os lacos internos de GIVENS, GIVENS2, QR2UPDATE, NEWTON, weightnorm,     */
+/* predictor e update usam os nucleos de kern, escolhidos em tempo de       */
+/* execucao pela CPUID (SETSIMD). Os vetores sao indexados a partir de 0;   */
+/* se q != NULL os elementos sao x[q[0..n-1]] (coleta pela permutacao).     */
+/* As versoes vetoriais de rot, acc, pred e wmax dao o mesmo resultado da   */
+/* versao escalar; dot e wssq somam em outra ordem (diferenca de            */
+/* arredondamento). Vetores com menos de GSDAE_KSHORT elementos usam sempre */
+/* a versao escalar (KERNROT, ..., KERNWSSQ no inicio deste arquivo).       */
+/****************************************************************************/
+
+/* aplica a rotacao (c,s) : x <- c x + s y, y <- -s x + c y */
+void
+KROT (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+)
+{
+  int   j,l; /* variaveis auxiliares */
+  real  a,b; /* variaveis auxiliares */
+
+  if (q == NULL)
+    for (j = 0; j < n; j++) {
+      a    =  c*x[j]+s*y[j];
+      b    = -s*x[j]+c*y[j];
+      x[j] =  a;
+      y[j] =  b;
+    }
+  else
+    for (j = 0; j < n; j++) {
+      l    =  q[j];
+      a    =  c*x[l]+s*y[l];
+      b    = -s*x[l]+c*y[l];
+      x[l] =  a;
+      y[l] =  b;
+    }
+
+  return;
+}
+
+
+/* produto interno x^t y */
+real
+KDOT (
+int    n,
+vreal  x,
+vreal  y
+)
+{
+  int   j; /* variavel auxiliar */
+  real  s; /* soma              */
+
+  for (j = 0, s = 0.0; j < n; j++)
+    s += x[j]*y[j];
+
+  return (s);
+}
+
+
+/* y <- y + x e, se z != NULL, z <- z + a x */
+void
+KACC (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+)
+{
+  int   j,l; /* variaveis auxiliares */
+
+  if (q == NULL) {
+    for (j = 0; j < n; j++)
+      y[j] += x[j];
+    if (z != NULL)
+      for (j = 0; j < n; j++)
+        z[j] += a*x[j];
+  } else {
+    for (j = 0; j < n; j++) {
+      l     = q[j];
+      y[l] += x[l];
+    }
+    if (z != NULL)
+      for (j = 0; j < n; j++) {
+        l     = q[j];
+        z[l] += a*x[l];
+      }
+  }
+
+  return;
+}
+
+
+/* predicao : y = soma de x_l e z = soma de a[l] x_l, l = 0..m-1, */
+/* onde x_l = x+l*ld; antes x_l <- b[l] x_l para l >= ns. As     */
+/* somas de cada elemento sao feitas em registro, na ordem de l  */
+void
+KPRED (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+)
+{
+  int   j,l;   /* variaveis auxiliares */
+  real  s,t,v; /* somas e x_l[j]       */
+
+  for (j = 0; j < n; j++) {
+    s = t = 0.0;
+    for (l = 0; l < m; l++) {
+      v = x[l*ld+j];
+      if (l >= ns)
+        x[l*ld+j] = v = b[l]*v;
+      s += v;
+      t += a[l]*v;
+    }
+    y[j] = s;
+    z[j] = t;
+  }
+
+  return;
+}
+
+
+/* maior valor entre vmax e |c/w| */
+real
+KWMAX (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+)
+{
+  int   j,l; /* variaveis auxiliares */
+  real  aux; /* variavel auxiliar    */
+
+  for (j = 0; j < n; j++) {
+    l = (q == NULL) ? j : q[j];
+    if ((aux = fabs(c[l]/w[l])) >= vmax)
+      vmax = aux;
+  }
+
+  return (vmax);
+}
+
+
+/* soma dos quadrados de (c/w)/v */
+real
+KWSSQ (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+)
+{
+  int   j,l;   /* variaveis auxiliares */
+  real  s,aux; /* soma e auxiliar      */
+
+  for (j = 0, s = 0.0; j < n; j++) {
+    l    = (q == NULL) ? j : q[j];
+    aux  = (c[l]/w[l])/v;
+    s   += aux*aux;
+  }
+
+  return (s);
+}
+
+
+#ifdef GSDAE_X86
+
+/* ---------------------------- SSE2 -------------------------------- */
+
+GSDAE_TSSE2 void
+KROTSSE2 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+)
+{
+  int      j;        /* variavel auxiliar      */
+  __m128d  vc,vs,vn; /* c, s e -s              */
+  __m128d  a,b,r;    /* elementos de x e de y  */
+
+  vc = _mm_set1_pd(c);
+  vs = _mm_set1_pd(s);
+  vn = _mm_set1_pd(-s);
+  if (q == NULL)
+    for (j = 0; j+2 <= n; j += 2) {
+      a = _mm_loadu_pd(x+j);
+      b = _mm_loadu_pd(y+j);
+      _mm_storeu_pd(x+j,_mm_add_pd(_mm_mul_pd(vc,a),_mm_mul_pd(vs,b)));
+      _mm_storeu_pd(y+j,_mm_add_pd(_mm_mul_pd(vn,a),_mm_mul_pd(vc,b)));
+    }
+  else
+    for (j = 0; j+2 <= n; j += 2) {
+      a = _mm_set_pd(x[q[j+1]],x[q[j]]);
+      b = _mm_set_pd(y[q[j+1]],y[q[j]]);
+      r = _mm_add_pd(_mm_mul_pd(vc,a),_mm_mul_pd(vs,b));
+      b = _mm_add_pd(_mm_mul_pd(vn,a),_mm_mul_pd(vc,b));
+      _mm_storel_pd(x+q[j],  r);
+      _mm_storeh_pd(x+q[j+1],r);
+      _mm_storel_pd(y+q[j],  b);
+      _mm_storeh_pd(y+q[j+1],b);
+    }
+  KROT(n-j,x+((q == NULL) ? j : 0),y+((q == NULL) ? j : 0),
+       (q == NULL) ? NULL : q+j,c,s);
+
+  return;
+}
+
+
+GSDAE_TSSE2 real
+KDOTSSE2 (
+int    n,
+vreal  x,
+vreal  y
+)
+{
+  int      j;     /* variavel auxiliar */
+  __m128d  s0,s1; /* somas parciais    */
+  real     t[2];  /* reducao           */
+
+  s0 = s1 = _mm_setzero_pd();
+  for (j = 0; j+4 <= n; j += 4) {
+    s0 = _mm_add_pd(s0,_mm_mul_pd(_mm_loadu_pd(x+j),  _mm_loadu_pd(y+j)));
+    s1 = _mm_add_pd(s1,_mm_mul_pd(_mm_loadu_pd(x+j+2),_mm_loadu_pd(y+j+2)));
+  }
+  _mm_storeu_pd(t,_mm_add_pd(s0,s1));
+
+  return (t[0]+t[1]+KDOT(n-j,x+j,y+j));
+}
+
+
+GSDAE_TSSE2 void
+KACCSSE2 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+)
+{
+  int      j;  /* variavel auxiliar */
+  __m128d  va; /* a                 */
+  __m128d  v;  /* elementos de x    */
+
+  if (q != NULL) {
+    KACC(n,a,x,y,z,q);
+    return;
+  }
+  va = _mm_set1_pd(a);
+  for (j = 0; j+2 <= n; j += 2) {
+    v = _mm_loadu_pd(x+j);
+    _mm_storeu_pd(y+j,_mm_add_pd(_mm_loadu_pd(y+j),v));
+    if (z != NULL)
+      _mm_storeu_pd(z+j,_mm_add_pd(_mm_loadu_pd(z+j),_mm_mul_pd(va,v)));
+  }
+  KACC(n-j,a,x+j,y+j,(z == NULL) ? NULL : z+j,NULL);
+
+  return;
+}
+
+
+GSDAE_TSSE2 void
+KPREDSSE2 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+)
+{
+  int      j,l; /* variaveis auxiliares */
+  __m128d  s,t; /* somas                */
+  __m128d  v;   /* elementos de x_l     */
+
+  for (j = 0; j+2 <= n; j += 2) {
+    s = t = _mm_setzero_pd();
+    for (l = 0; l < m; l++) {
+      v = _mm_loadu_pd(x+l*ld+j);
+      if (l >= ns) {
+        v = _mm_mul_pd(_mm_set1_pd(b[l]),v);
+        _mm_storeu_pd(x+l*ld+j,v);
+      }
+      s = _mm_add_pd(s,v);
+      t = _mm_add_pd(t,_mm_mul_pd(_mm_set1_pd(a[l]),v));
+    }
+    _mm_storeu_pd(y+j,s);
+    _mm_storeu_pd(z+j,t);
+  }
+  KPRED(n-j,m,ns,b,a,x+j,ld,y+j,z+j);
+
+  return;
+}
+
+
+GSDAE_TSSE2 real
+KWMAXSSE2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+)
+{
+  int      j;     /* variavel auxiliar    */
+  __m128d  m,a;   /* maximo e |c/w|       */
+  __m128d  mask;  /* mascara do sinal     */
+  real     t[2];  /* reducao              */
+
+  mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+  m    = _mm_set1_pd(vmax);
+  for (j = 0; j+2 <= n; j += 2) {
+    if (q == NULL)
+      a = _mm_div_pd(_mm_loadu_pd(c+j),_mm_loadu_pd(w+j));
+    else
+      a = _mm_div_pd(_mm_set_pd(c[q[j+1]],c[q[j]]),
+                     _mm_set_pd(w[q[j+1]],w[q[j]]));
+    m = _mm_max_pd(_mm_and_pd(a,mask),m);
+  }
+  _mm_storeu_pd(t,m);
+  vmax = MAX2(t[0],t[1]);
+
+  return (KWMAX(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                (q == NULL) ? NULL : q+j,vmax));
+}
+
+
+GSDAE_TSSE2 real
+KWSSQSSE2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+)
+{
+  int      j;     /* variavel auxiliar */
+  __m128d  s,a,vv; /* soma, termo e v  */
+  real     t[2];  /* reducao           */
+
+  s  = _mm_setzero_pd();
+  vv = _mm_set1_pd(v);
+  for (j = 0; j+2 <= n; j += 2) {
+    if (q == NULL)
+      a = _mm_div_pd(_mm_loadu_pd(c+j),_mm_loadu_pd(w+j));
+    else
+      a = _mm_div_pd(_mm_set_pd(c[q[j+1]],c[q[j]]),
+                     _mm_set_pd(w[q[j+1]],w[q[j]]));
+    a = _mm_div_pd(a,vv);
+    s = _mm_add_pd(s,_mm_mul_pd(a,a));
+  }
+  _mm_storeu_pd(t,s);
+
+  return (t[0]+t[1]+KWSSQ(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                          (q == NULL) ? NULL : q+j,v));
+}
+
+
+/* ---------------------------- AVX2 -------------------------------- */
+
+/* coleta e espalhamento de x[q[0..3]] : cargas escalares, mais rapidas */
+/* que vgatherdpd nas CPUs com a mitigacao de microcodigo do gather     */
+GSDAE_TAVX2 __m256d
+KGET4 (
+vreal  x,
+vint   q
+)
+{
+  return (_mm256_set_pd(x[q[3]],x[q[2]],x[q[1]],x[q[0]]));
+}
+
+
+GSDAE_TAVX2 void
+KPUT4 (
+vreal    x,
+vint     q,
+__m256d  v
+)
+{
+  __m128d  h; /* metade de v */
+
+  h = _mm256_castpd256_pd128(v);
+  _mm_storel_pd(x+q[0],h);
+  _mm_storeh_pd(x+q[1],h);
+  h = _mm256_extractf128_pd(v,1);
+  _mm_storel_pd(x+q[2],h);
+  _mm_storeh_pd(x+q[3],h);
+
+  return;
+}
+
+
+GSDAE_TAVX2 void
+KROTAVX2 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+)
+{
+  int      j;        /* variavel auxiliar      */
+  __m256d  vc,vs,vn; /* c, s e -s              */
+  __m256d  a,b,r;    /* elementos de x e de y  */
+
+  vc = _mm256_set1_pd(c);
+  vs = _mm256_set1_pd(s);
+  vn = _mm256_set1_pd(-s);
+  if (q == NULL)
+    for (j = 0; j+4 <= n; j += 4) {
+      a = _mm256_loadu_pd(x+j);
+      b = _mm256_loadu_pd(y+j);
+      _mm256_storeu_pd(x+j,_mm256_add_pd(_mm256_mul_pd(vc,a),
+                                         _mm256_mul_pd(vs,b)));
+      _mm256_storeu_pd(y+j,_mm256_add_pd(_mm256_mul_pd(vn,a),
+                                         _mm256_mul_pd(vc,b)));
+    }
+  else
+    for (j = 0; j+4 <= n; j += 4) {
+      a  = KGET4(x,q+j);
+      b  = KGET4(y,q+j);
+      r  = _mm256_add_pd(_mm256_mul_pd(vc,a),_mm256_mul_pd(vs,b));
+      b  = _mm256_add_pd(_mm256_mul_pd(vn,a),_mm256_mul_pd(vc,b));
+      KPUT4(x,q+j,r);
+      KPUT4(y,q+j,b);
+    }
+  _mm256_zeroupper();
+  KROT(n-j,x+((q == NULL) ? j : 0),y+((q == NULL) ? j : 0),
+       (q == NULL) ? NULL : q+j,c,s);
+
+  return;
+}
+
+
+GSDAE_TAVX2 real
+KDOTAVX2 (
+int    n,
+vreal  x,
+vreal  y
+)
+{
+  int      j;     /* variavel auxiliar */
+  __m256d  s0,s1; /* somas parciais    */
+  real     t[4];  /* reducao           */
+
+  s0 = s1 = _mm256_setzero_pd();
+  for (j = 0; j+8 <= n; j += 8) {
+    s0 = _mm256_add_pd(s0,_mm256_mul_pd(_mm256_loadu_pd(x+j),
+                                        _mm256_loadu_pd(y+j)));
+    s1 = _mm256_add_pd(s1,_mm256_mul_pd(_mm256_loadu_pd(x+j+4),
+                                        _mm256_loadu_pd(y+j+4)));
+  }
+  _mm256_storeu_pd(t,_mm256_add_pd(s0,s1));
+  _mm256_zeroupper();
+
+  return ((t[0]+t[1])+(t[2]+t[3])+KDOT(n-j,x+j,y+j));
+}
+
+
+GSDAE_TAVX2 void
+KACCAVX2 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+)
+{
+  int      j;   /* variavel auxiliar */
+  __m256d  va;  /* a                 */
+  __m256d  v;   /* elementos de x    */
+
+  va = _mm256_set1_pd(a);
+  if (q == NULL) {
+    for (j = 0; j+4 <= n; j += 4) {
+      v = _mm256_loadu_pd(x+j);
+      _mm256_storeu_pd(y+j,_mm256_add_pd(_mm256_loadu_pd(y+j),v));
+      if (z != NULL)
+        _mm256_storeu_pd(z+j,_mm256_add_pd(_mm256_loadu_pd(z+j),
+                                           _mm256_mul_pd(va,v)));
+    }
+    _mm256_zeroupper();
+    KACC(n-j,a,x+j,y+j,(z == NULL) ? NULL : z+j,NULL);
+  } else {
+    for (j = 0; j+4 <= n; j += 4) {
+      v = KGET4(x,q+j);
+      KPUT4(y,q+j,_mm256_add_pd(KGET4(y,q+j),v));
+      if (z != NULL)
+        KPUT4(z,q+j,_mm256_add_pd(KGET4(z,q+j),_mm256_mul_pd(va,v)));
+    }
+    _mm256_zeroupper();
+    KACC(n-j,a,x,y,z,q+j);
+  }
+
+  return;
+}
+
+
+GSDAE_TAVX2 void
+KPREDAVX2 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+)
+{
+  int      j,l; /* variaveis auxiliares */
+  __m256d  s,t; /* somas                */
+  __m256d  v;   /* elementos de x_l     */
+
+  for (j = 0; j+4 <= n; j += 4) {
+    s = t = _mm256_setzero_pd();
+    for (l = 0; l < m; l++) {
+      v = _mm256_loadu_pd(x+l*ld+j);
+      if (l >= ns) {
+        v = _mm256_mul_pd(_mm256_set1_pd(b[l]),v);
+        _mm256_storeu_pd(x+l*ld+j,v);
+      }
+      s = _mm256_add_pd(s,v);
+      t = _mm256_add_pd(t,_mm256_mul_pd(_mm256_set1_pd(a[l]),v));
+    }
+    _mm256_storeu_pd(y+j,s);
+    _mm256_storeu_pd(z+j,t);
+  }
+  _mm256_zeroupper();
+  KPRED(n-j,m,ns,b,a,x+j,ld,y+j,z+j);
+
+  return;
+}
+
+
+GSDAE_TAVX2 real
+KWMAXAVX2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+)
+{
+  int      j;     /* variavel auxiliar    */
+  __m256d  m,a;   /* maximo e |c/w|       */
+  __m256d  mask;  /* mascara do sinal     */
+  real     t[4];  /* reducao              */
+
+  mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+  m    = _mm256_set1_pd(vmax);
+  for (j = 0; j+4 <= n; j += 4) {
+    if (q == NULL)
+      a = _mm256_div_pd(_mm256_loadu_pd(c+j),_mm256_loadu_pd(w+j));
+    else {
+      a = _mm256_div_pd(KGET4(c,q+j),KGET4(w,q+j));
+    }
+    m = _mm256_max_pd(_mm256_and_pd(a,mask),m);
+  }
+  _mm256_storeu_pd(t,m);
+  _mm256_zeroupper();
+  vmax = MAX2(MAX2(t[0],t[1]),MAX2(t[2],t[3]));
+
+  return (KWMAX(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                (q == NULL) ? NULL : q+j,vmax));
+}
+
+
+GSDAE_TAVX2 real
+KWSSQAVX2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+)
+{
+  int      j;      /* variavel auxiliar  */
+  __m256d  s,a,vv; /* soma, termo e v    */
+  real     t[4];   /* reducao            */
+
+  s  = _mm256_setzero_pd();
+  vv = _mm256_set1_pd(v);
+  for (j = 0; j+4 <= n; j += 4) {
+    if (q == NULL)
+      a = _mm256_div_pd(_mm256_loadu_pd(c+j),_mm256_loadu_pd(w+j));
+    else {
+      a = _mm256_div_pd(KGET4(c,q+j),KGET4(w,q+j));
+    }
+    a = _mm256_div_pd(a,vv);
+    s = _mm256_add_pd(s,_mm256_mul_pd(a,a));
+  }
+  _mm256_storeu_pd(t,s);
+  _mm256_zeroupper();
+
+  return ((t[0]+t[1])+(t[2]+t[3])+
+          KWSSQ(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                (q == NULL) ? NULL : q+j,v));
+}
+
+
+/* --------------------------- AVX-512 ------------------------------- */
+
+/* coleta e espalhamento de x[q[0..7]] (veja KGET4) */
+GSDAE_T512 __m512d
+KGET8 (
+vreal  x,
+vint   q
+)
+{
+  return (_mm512_set_pd(x[q[7]],x[q[6]],x[q[5]],x[q[4]],
+                        x[q[3]],x[q[2]],x[q[1]],x[q[0]]));
+}
+
+
+GSDAE_T512 void
+KPUT8 (
+vreal    x,
+vint     q,
+__m512d  v
+)
+{
+  KPUT4(x,q,  _mm512_castpd512_pd256(v));
+  KPUT4(x,q+4,_mm512_extractf64x4_pd(v,1));
+
+  return;
+}
+
+
+GSDAE_T512 void
+KROT512 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+)
+{
+  int      j;        /* variavel auxiliar      */
+  __m512d  vc,vs,vn; /* c, s e -s              */
+  __m512d  a,b;      /* elementos de x e de y  */
+
+  vc = _mm512_set1_pd(c);
+  vs = _mm512_set1_pd(s);
+  vn = _mm512_set1_pd(-s);
+  if (q == NULL)
+    for (j = 0; j+8 <= n; j += 8) {
+      a = _mm512_loadu_pd(x+j);
+      b = _mm512_loadu_pd(y+j);
+      _mm512_storeu_pd(x+j,_mm512_add_pd(_mm512_mul_pd(vc,a),
+                                         _mm512_mul_pd(vs,b)));
+      _mm512_storeu_pd(y+j,_mm512_add_pd(_mm512_mul_pd(vn,a),
+                                         _mm512_mul_pd(vc,b)));
+    }
+  else
+    for (j = 0; j+8 <= n; j += 8) {
+      a = KGET8(x,q+j);
+      b = KGET8(y,q+j);
+      KPUT8(x,q+j,_mm512_add_pd(_mm512_mul_pd(vc,a),_mm512_mul_pd(vs,b)));
+      KPUT8(y,q+j,_mm512_add_pd(_mm512_mul_pd(vn,a),_mm512_mul_pd(vc,b)));
+    }
+  _mm256_zeroupper();
+  KROT(n-j,x+((q == NULL) ? j : 0),y+((q == NULL) ? j : 0),
+       (q == NULL) ? NULL : q+j,c,s);
+
+  return;
+}
+
+
+GSDAE_T512 real
+KDOT512 (
+int    n,
+vreal  x,
+vreal  y
+)
+{
+  int      j;     /* variavel auxiliar */
+  __m512d  s0,s1; /* somas parciais    */
+  real     t;     /* reducao           */
+
+  s0 = s1 = _mm512_setzero_pd();
+  for (j = 0; j+16 <= n; j += 16) {
+    s0 = _mm512_add_pd(s0,_mm512_mul_pd(_mm512_loadu_pd(x+j),
+                                        _mm512_loadu_pd(y+j)));
+    s1 = _mm512_add_pd(s1,_mm512_mul_pd(_mm512_loadu_pd(x+j+8),
+                                        _mm512_loadu_pd(y+j+8)));
+  }
+
+  t = _mm512_reduce_add_pd(_mm512_add_pd(s0,s1));
+  _mm256_zeroupper();
+
+  return (t+KDOT(n-j,x+j,y+j));
+}
+
+
+GSDAE_T512 void
+KACC512 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+)
+{
+  int      j;  /* variavel auxiliar  */
+  __m512d  va; /* a                  */
+  __m512d  v;  /* elementos de x     */
+
+  va = _mm512_set1_pd(a);
+  if (q == NULL) {
+    for (j = 0; j+8 <= n; j += 8) {
+      v = _mm512_loadu_pd(x+j);
+      _mm512_storeu_pd(y+j,_mm512_add_pd(_mm512_loadu_pd(y+j),v));
+      if (z != NULL)
+        _mm512_storeu_pd(z+j,_mm512_add_pd(_mm512_loadu_pd(z+j),
+                                           _mm512_mul_pd(va,v)));
+    }
+    _mm256_zeroupper();
+    KACC(n-j,a,x+j,y+j,(z == NULL) ? NULL : z+j,NULL);
+  } else {
+    for (j = 0; j+8 <= n; j += 8) {
+      v = KGET8(x,q+j);
+      KPUT8(y,q+j,_mm512_add_pd(KGET8(y,q+j),v));
+      if (z != NULL)
+        KPUT8(z,q+j,_mm512_add_pd(KGET8(z,q+j),_mm512_mul_pd(va,v)));
+    }
+    _mm256_zeroupper();
+    KACC(n-j,a,x,y,z,q+j);
+  }
+
+  return;
+}
+
+
+GSDAE_T512 void
+KPRED512 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+)
+{
+  int      j,l; /* variaveis auxiliares */
+  __m512d  s,t; /* somas                */
+  __m512d  v;   /* elementos de x_l     */
+
+  for (j = 0; j+8 <= n; j += 8) {
+    s = t = _mm512_setzero_pd();
+    for (l = 0; l < m; l++) {
+      v = _mm512_loadu_pd(x+l*ld+j);
+      if (l >= ns) {
+        v = _mm512_mul_pd(_mm512_set1_pd(b[l]),v);
+        _mm512_storeu_pd(x+l*ld+j,v);
+      }
+      s = _mm512_add_pd(s,v);
+      t = _mm512_add_pd(t,_mm512_mul_pd(_mm512_set1_pd(a[l]),v));
+    }
+    _mm512_storeu_pd(y+j,s);
+    _mm512_storeu_pd(z+j,t);
+  }
+  _mm256_zeroupper();
+  KPRED(n-j,m,ns,b,a,x+j,ld,y+j,z+j);
+
+  return;
+}
+
+
+GSDAE_T512 real
+KWMAX512 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+)
+{
+  int      j;   /* variavel auxiliar  */
+  __m512d  m,a; /* maximo e |c/w|     */
+
+  m = _mm512_set1_pd(vmax);
+  for (j = 0; j+8 <= n; j += 8) {
+    if (q == NULL)
+      a = _mm512_div_pd(_mm512_loadu_pd(c+j),_mm512_loadu_pd(w+j));
+    else {
+      a = _mm512_div_pd(KGET8(c,q+j),KGET8(w,q+j));
+    }
+    m = _mm512_max_pd(_mm512_abs_pd(a),m);
+  }
+  vmax = _mm512_reduce_max_pd(m);
+  _mm256_zeroupper();
+
+  return (KWMAX(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                (q == NULL) ? NULL : q+j,vmax));
+}
+
+
+GSDAE_T512 real
+KWSSQ512 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+)
+{
+  int      j;      /* variavel auxiliar  */
+  __m512d  s,a,vv; /* soma, termo e v    */
+  real     t;      /* reducao            */
+
+  s  = _mm512_setzero_pd();
+  vv = _mm512_set1_pd(v);
+  for (j = 0; j+8 <= n; j += 8) {
+    if (q == NULL)
+      a = _mm512_div_pd(_mm512_loadu_pd(c+j),_mm512_loadu_pd(w+j));
+    else {
+      a = _mm512_div_pd(KGET8(c,q+j),KGET8(w,q+j));
+    }
+    a = _mm512_div_pd(a,vv);
+    s = _mm512_add_pd(s,_mm512_mul_pd(a,a));
+  }
+
+  t = _mm512_reduce_add_pd(s);
+  _mm256_zeroupper();
+
+  return (t+KWSSQ(n-j,(q == NULL) ? c+j : c,(q == NULL) ? w+j : w,
+                  (q == NULL) ? NULL : q+j,v));
+}
+
+#endif
+
+
+
+/****************************************************************************/
+/* Esta rotina escolhe os nucleos vetoriais de kern : level < 0 escolhe o   */
+/* maior nivel suportado pela CPU (e pelo sistema), level >= 0 limita o     */
+/* nivel a GSDAE_SIMDNONE, GSDAE_SIMDSSE2, GSDAE_SIMDAVX2 ou GSDAE_SIMD512. */
+/* A escolha vale para todos os contextos do processo : kern e global e    */
+/* nao e protegida, de modo que SETSIMD deve ser chamada antes de alocar os */
+/* contextos que usarao o nivel (antes de ALLOCCTX*, GSDAEBATCH e           */
+/* GSDAEENSEMBLE) e nunca enquanto uma integracao estiver em curso. Entre   */
+/* integracoes o nivel pode ser trocado (exsimd). Retorna o nivel           */
+/* escolhido.                                                               */
+/****************************************************************************/
+
+int
+SETSIMD (
+int  level
+)
+{
+  int      best; /* maior nivel suportado */
+  kernels  k;    /* nucleos escolhidos    */
+
+  best = GSDAE_SIMDNONE;
+#ifdef GSDAE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    best = GSDAE_SIMDSSE2;
+  if (__builtin_cpu_supports("avx2"))
+    best = GSDAE_SIMDAVX2;
+  if (__builtin_cpu_supports("avx512f"))
+    best = GSDAE_SIMD512;
+#endif
+  if ((level < 0) || (level > best))
+    level = best;
+
+  /* a tabela e montada e copiada para kern de uma vez, com */
+  /* o nivel junto dos ponteiros                            */
+  k.level = level;
+  k.rot   = KROT;
+  k.dot   = KDOT;
+  k.acc   = KACC;
+  k.pred  = KPRED;
+  k.wmax  = KWMAX;
+  k.wssq  = KWSSQ;
+#ifdef GSDAE_X86
+  if (level == GSDAE_SIMDSSE2) {
+    k.rot   = KROTSSE2;
+    k.dot   = KDOTSSE2;
+    k.acc   = KACCSSE2;
+    k.pred  = KPREDSSE2;
+    k.wmax  = KWMAXSSE2;
+    k.wssq  = KWSSQSSE2;
+  } else if (level == GSDAE_SIMDAVX2) {
+    k.rot   = KROTAVX2;
+    k.dot   = KDOTAVX2;
+    k.acc   = KACCAVX2;
+    k.pred  = KPREDAVX2;
+    k.wmax  = KWMAXAVX2;
+    k.wssq  = KWSSQAVX2;
+  } else if (level == GSDAE_SIMD512) {
+    k.rot   = KROT512;
+    k.dot   = KDOT512;
+    k.acc   = KACC512;
+    k.pred  = KPRED512;
+    k.wmax  = KWMAX512;
+    k.wssq  = KWSSQ512;
+  }
+#endif
+  kern = k;
+
+  return (level);
+}
+
+
+
+/****************************************************************************/
+/* Estas rotinas escolhem os nucleos vetoriais na primeira alocacao de um   */
+/* contexto : KERNINIT chama KERNFIRST uma unica vez no processo            */
+/* (pthread_once), de modo que threads que alocam contextos ao mesmo tempo  */
+/* (GSDAEBATCH) nao escrevem kern juntas. Um nivel ja escolhido por SETSIMD */
+/* e mantido.                                                               */
+/****************************************************************************/
+
+void
+KERNFIRST ( void )
+{
+  if (kern.level < 0)
+    SETSIMD(-1);
+}
+
+void
+KERNINIT ( void )
+{
+  pthread_once(&kernonce,KERNFIRST);
+}
+
+
+
+/****************************************************************************/
+/* Esta rotina aplica a matriz de rotacao de Givens nas matrizes A e Q para */
+/* a decomposicao A = QR.                                                   */
+/****************************************************************************/
+
+void 
+GIVENS ( 
+int   m,
+int   n,
+int   i,
+int   k,
+mreal A,
+mreal Q,
+real  s1,
+real  s2
+)
+{
+  real  s;   /* variavel auxiliar para armazenar dados    */
+
+  if (fabs(s2)+fabs(s1) > 0.0) {
+    if (fabs(s2) >= fabs(s1))
+      s  = sqrt(1.0+(s1/s2)*(s1/s2))*fabs(s2);
+    else
+      s  = sqrt(1.0+(s2/s1)*(s2/s1))*fabs(s1);
+    s1 = s1/s; s2 = s2/s; 
+    /* aplicando a matriz de rotacao em A */
+    KERNROT(n,A[i]+1,A[k]+1,NULL,s1,s2);
+    /* aplicando a matriz de rotacao em Q */
+    KERNROT(m,Q[i]+1,Q[k]+1,NULL,s1,s2);
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina retorna a decomposicao QR de uma matriz A (n+1)x(n) usando */
+/* o metodo de Givens. A matriz R volta em A e em Q volta a matriz Q^t da */
+/* decomposicao A = QR. Esta rotina tambem calcula uma estimativa para a  */
+/* condicao da matriz A.                                                  */
+/**************************************************************************/
+
+void 
+QR (
+int    m,
+int    n,
+mreal  A,
+mreal  Q,
+int    pivot,
+real  *cond
+)
+{
+  int   i,j; /* variaveis auxiliares para controle de lacos       */
+
+  /* inicializando Q com a identidade */
+  for (i = 1; i <= m; i++) {
+    for (j = 1; j <= m; j++) Q[i][j] = 0.0;
+    Q[i][i] = 1.0;
+  } 
+
+  /* decomposicao QR por Givens */
   for (i = 1; i <= m-1; i++) {
     /* escolha do pivo */
     if (pivot)
@@ -4890,589 +8115,5896 @@ real  *cond
     }
   }
 
-  /* calculo de uma estimativa para a condicao da matriz A */
-  if (n == 1) {
-   *cond = fabs(1.0/A[1][1]) ;
-  } else {
-    for (i = 2, (*cond) = 0.0; i <= n; i++)
-      for (j = 1; j <= i-1; j++) *cond = MAX2(*cond,fabs(A[j][i]/A[i][i]));
+  /* calculo de uma estimativa para a condicao da matriz A */
+  if (n == 1) {
+   *cond = fabs(1.0/A[1][1]) ;
+  } else {
+    for (i = 2, (*cond) = 0.0; i <= n; i++)
+      for (j = 1; j <= i-1; j++) *cond = MAX2(*cond,fabs(A[j][i]/A[i][i]));
+  }
+
+  return;
+}
+
+
+
+/**********************************************************************/
+/* Esta rotina calcula um passo do metodo de Newton modificado para   */
+/* sistemas indeterminados do tipo F(x) = 0, que e dado por           */
+/*                  x_{k+1} = x_k - A^+ F(x_k)                        */
+/* onde A^+ e a inversa de Moore-Penrouse de A = DF(x_0).             */
+/*                                                                    */
+/* Tendo a decomposicao A^t = QR, entao :                             */
+/*                      A^+ = Q^t / R^(-t) \                          */
+/*                                \  0^t   /                          */
+/**********************************************************************/
+
+void 
+NEWTON (
+int    n,
+mreal  Q,
+mreal  A,
+vreal  u,
+vreal  delta,
+real   ac
+)
+{
+  int   i;   /* variavel auxiliar para controle de lacos  */
+
+  /* calculo de u = Q^t y */
+  for (i = 1; i <= n; i++) 
+    u[i] = ac*KERNDOT(n,Q[i]+1,delta+1);
+  
+  /* calculo de A b = y, onde y <- b */
+  for (i = n; i >= 1; i--) 
+    u[i] = (u[i]-KERNDOT(n-i,A[i]+i+1,u+i+1))/A[i][i];
+
+  return;
+}
+
+
+/**************************************************************************/
+/* Esta rotina avalia a jacobiana DH do passo de Newton no ponto predito  */
+/* e calcula a sua decomposicao QR (QRH), retornando em cond a estimativa */
+/* da condicao. Se ls->schur = 1, o o > 0 e a jacobiana e exata (nDH = 1) */
+/* as linhas da cadeia de derivadas sao eliminadas (SETDHSCHUR) e apenas  */
+/* o sistema reduzido de dimensao n+1 e decomposto. Com a jacobiana       */
+/* esparsa (ls->sp != NULL) e n >= sp->nmin o sistema reduzido e montado  */
+/* no padrao de DFy (SETDHSPARSE) e decomposto pela LU esparsa, que       */
+/* reaproveita os pivos da fatoracao anterior sempre que possivel.        */
+/* Com a jacobiana aproximada (nDH = 0) e o padrao de DFy informado       */
+/* (ls->cpr != NULL), DFy e aproximada por grupos de colunas (SETDFCOLOR) */
+/* e DH e montada como no caso exato. No corretor de Newton-Krylov        */
+/* (ls->kr != NULL) DH nao e montada (KRYLOVSETUP).                       */
+/**************************************************************************/
+
+void 
+FACTORDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+real    h,
+real    cj,
+real    tolerancia,
+real    pcx,
+real    pdcx,
+real    wtx,
+mreal   pcy,
+mreal   pdcy,
+mreal   wty,
+vint    p,
+vint    q,
+vreal   delta,
+vreal   deltax,
+vreal   deltah,
+vreal   deltahx,
+vreal   DFx,
+mmreal  DFy,
+int     nDH,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+mreal   DH,
+mreal   Q,
+solver *ls,
+real   *cond
+)
+{
+  sparse *sp; /* jacobiana esparsa */
+
+  sp = ls->sp;
+
+  if (ls->kr != NULL) {
+
+    /* corretor de Newton-Krylov : apenas o ponto de linearizacao */
+    KRYLOVSETUP(n,o,r,h,cj,pcx,pdcx,pcy,pdcy,p,q,deltax,F,data,ls);
+    *cond    = 1.0;
+    ls->core = 3;
+    ls->jok  = 0;
+
+  } else if ((sp != NULL) && (o > 0) && (n >= sp->nmin)) {
+
+    /* sistema reduzido esparso */
+    sp->DFS(o,n,pcx,pcy,DFx,sp->val,sp->data);
+    SETDHSPARSE(n,o,r,cj,h,pcy,pdcx,pdcy,q,DFx,ls);
+    if ((!sp->numeric) || (SPARSEREFACT(sp,cond) != 0)) 
+      SPARSELU(sp,cond);
+    ls->core = 2;
+    ls->jok  = 1;
+
+  } else if ((ls->schur) && (o > 0) && ((nDH == 1) || (ls->cpr != NULL))) {
+
+    /* sistema reduzido */
+    if (nDH == 1) 
+      DF(o,n,pcx,pcy,DFx,DFy,data); 
+    else 
+      SETDFCOLOR(n,o,h,tolerancia,pcx,pdcx,wtx,pcy,pdcy,wty,p,deltah,
+                 deltahx,deltax,DFx,DFy,F,data,ls);
+    SETDHSCHUR(n,o,r,cj,h,pcy,pdcx,pdcy,p,q,DFx,DFy,DH,ls);
+    FACTORH(n+1,DH,Q,ls,cond);
+    ls->core = 1;
+    ls->jok  = 1;
+
+  } else {
+
+    /* sistema completo */
+    ls->jok = 1;
+    if ((nDH == 0) && (ls->cpr == NULL)) {
+      /* DH e aproximada diretamente : DFx e DFy nao sao guardadas */
+      SETDHAPPROX(n,o,r,dim,h,cj,tolerancia,pcx,pdcx,wtx,
+                  pcy,pdcy,wty,p,q,delta,deltax,deltah,deltahx,DH,F,data,ls); 
+      ls->jok = 0;
+    } else if (nDH == 0) {
+      SETDFCOLOR(n,o,h,tolerancia,pcx,pdcx,wtx,pcy,pdcy,wty,p,deltah,
+                 deltahx,deltax,DFx,DFy,F,data,ls);
+      SETDH(n,o,r,cj,h,pcx,pcy,pdcx,pdcy,p,q,DFx,DFy,NULL,data,DH); 
+    } else {
+      SETDH(n,o,r,cj,h,pcx,pcy,pdcx,pdcy,p,q,DFx,DFy,DF,data,DH); 
+    }
+    FACTORH(dim,DH,Q,ls,cond);
+    ls->core = 0;
+
+  }
+
+  /* nova fatoracao : as atualizacoes de Broyden sao descartadas */
+  ls->bdim  = dim;
+  ls->nbroy = 0;
+  ls->ncj   = 0;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina refatora DH para um novo cj (e o novo ponto predito nas    */
+/* linhas da cadeia e de normalizacao) sem avaliar DF : os blocos de F    */
+/* sao os de DFx e DFy (ou sp->val) guardados na ultima chamada de        */
+/* FACTORDH. O resolvedor e o mesmo dessa fatoracao. Retorna -1 se a      */
+/* jacobiana nao esta disponivel (ls->jok = 0) ou se ja foram feitas      */
+/* GSDAE_NCJ refatoracoes desde a avaliacao, e 0 caso contrario.          */
+/**************************************************************************/
+
+int 
+REFACTORDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+real    h,
+real    cj,
+real    pcx,
+real    pdcx,
+mreal   pcy,
+mreal   pdcy,
+vint    p,
+vint    q,
+vreal   DFx,
+mmreal  DFy,
+void   *data,
+mreal   DH,
+mreal   Q,
+solver *ls,
+real   *cond
+)
+{
+  sparse *sp; /* jacobiana esparsa */
+
+  if ((!ls->jok) || (ls->ncj >= GSDAE_NCJ) || (ls->bdim != dim)) 
+    return (-1);
+
+  sp = ls->sp;
+
+  if (ls->core == 2) {
+    SETDHSPARSE(n,o,r,cj,h,pcy,pdcx,pdcy,q,DFx,ls);
+    if (SPARSEREFACT(sp,cond) != 0) 
+      SPARSELU(sp,cond);
+  } else if (ls->core == 1) {
+    SETDHSCHUR(n,o,r,cj,h,pcy,pdcx,pdcy,p,q,DFx,DFy,DH,ls);
+    FACTORH(n+1,DH,Q,ls,cond);
+  } else {
+    SETDH(n,o,r,cj,h,pcx,pcy,pdcx,pdcy,p,q,DFx,DFy,NULL,data,DH); 
+    FACTORH(dim,DH,Q,ls,cond);
+  }
+
+  ls->nbroy = 0;
+  (ls->ncj)++;
+
+  return (0);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula u = ac DH^(-1) delta com a decomposicao obtida em  */
+/* FACTORDH.                                                              */
+/**************************************************************************/
+
+void 
+SOLVEDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  if (ls->core == 3) 
+    KRYLOVSOLVE(dim,ls,u,delta,ac);
+  else if (ls->core == 2) 
+    SPARSESOLVE(n,o,r,dim,p,q,ls,u,delta,ac);
+  else if (ls->core) 
+    SCHURSOLVE(n,o,r,dim,p,q,DFy,Q,DH,ls,u,delta,ac);
+  else 
+    SOLVEH(dim,Q,DH,ls,u,delta,ac);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Atualizacoes de Broyden da fatoracao de DH (ls->broyden = 1).          */
+/*                                                                        */
+/* Entre duas fatoracoes a inversa aproximada de DH e mantida na forma    */
+/* produto                                                                */
+/*                                                                        */
+/*   M = (I + d[m] s[m]^t) ... (I + d[1] s[1]^t) ac DH^(-1)               */
+/*                                                                        */
+/* onde DH^(-1) e aplicada por SOLVEDH com a decomposicao de FACTORDH.    */
+/* BROYDENAPPLY aplica os fatores (I + d s^t) a u = ac DH^(-1) delta.     */
+/* BROYDENUPDATE acrescenta um fator a partir do passo s = -u da iteracao */
+/* anterior do corretor e da diferenca y = H(c+s) - H(c) entre os         */
+/* residuos, ja avaliados em masterstep, de forma que M y = s (metodo de  */
+/* Broyden "bom" : d = (s - M y)/(s^t M y)). A decomposicao de DH nao e   */
+/* alterada, o que permite utilizar os tres resolvedores (QR completa,    */
+/* complemento de Schur e LU esparsa). Sao armazenados no maximo          */
+/* GSDAE_NBROY fatores; BS[j] = s[j] e BD[j] = d[j].                      */
+/**************************************************************************/
+
+void 
+BROYDENAPPLY (
+solver *ls,
+int     dim,
+vreal   u
+)
+{
+  int  i,j;
+  real t;
+
+  for (j = 1; j <= ls->nbroy; j++) {
+    t = 0.0;
+    for (i = 1; i <= dim; i++)
+      t += ls->BS[j][i]*u[i];
+    for (i = 1; i <= dim; i++)
+      u[i] += t*ls->BD[j][i];
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina acrescenta uma atualizacao de Broyden. Na entrada u e o    */
+/* passo da iteracao anterior (c <- c - u), ls->bh o residuo antes do     */
+/* passo e deltah o residuo depois do passo. ls->bh e utilizado como area */
+/* de trabalho.                                                           */
+/**************************************************************************/
+
+void 
+BROYDENUPDATE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   deltah,
+real    ac
+)
+{
+  int   i,m;
+  real  sz,ss,zz;
+  vreal z;
+  vreal d;
+  vreal s;
+
+  if (ls->nbroy >= GSDAE_NBROY) 
+    return;
+
+  m = ls->nbroy+1;
+  d = ls->BD[m];
+  s = ls->BS[m];
+
+  /* y = H(c+s) - H(c) */
+  z = ls->bh;
+  for (i = 1; i <= dim; i++)
+    z[i] = deltah[i]-z[i];
+
+  /* M y com as atualizacoes anteriores */
+  SOLVEDH(n,o,r,dim,p,q,DFy,Q,DH,ls,d,z,ac);
+  BROYDENAPPLY(ls,dim,d);
+
+  /* s^t M y */
+  sz = ss = zz = 0.0;
+  for (i = 1; i <= dim; i++) {
+    s[i] = -u[i];
+    sz  += s[i]*d[i];
+    ss  += s[i]*s[i];
+    zz  += d[i]*d[i];
+  }
+
+  /* atualizacao descartada se s e M y forem quase ortogonais */
+  if (fabs(sz) <= 1.0e-8*sqrt(ss*zz))
+    return;
+
+  for (i = 1; i <= dim; i++)
+    d[i] = (s[i]-d[i])/sz;
+  ls->nbroy = m;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina monta o complemento de Schur da jacobiana de SETDH.        */
+/*                                                                        */
+/* As linhas n+1..o*n+r de DH (cadeia de derivadas) tem a forma           */
+/*                                                                        */
+/*   h*dpx w[b-1][j] - cjaux w[b][j] + cjaux py[o-b][q[j]] x = delta      */
+/*                                                                        */
+/* onde w[b] (b = 0..o-1) sao as variaveis y[o-1-b] e w[-1][j] = y[o][j]  */
+/* (j = 1..r). Assim cada w[b][j] e escrito em funcao de uma variavel     */
+/* livre f[j] (y[o][q[j]] se j <= r e y[o-1][q[j]] se j > r) e de x :     */
+/*                                                                        */
+/*   w[b][j] = P[b][j] f[j] + X[b][j] x + K[b][j]                         */
+/*                                                                        */
+/* onde K depende apenas de delta. Substituindo nas n linhas de F e na    */
+/* linha de normalizacao resulta o sistema reduzido de dimensao n+1 nas   */
+/* variaveis (f,x), que volta em DH[1..n+1][1..n+1]. P, X, cjaux, rho e a */
+/* linha de normalizacao sao armazenados em ls para SCHURSOLVE; as linhas */
+/* de F sao lidas de DFy, que nao e alterada ate a proxima fatoracao.     */
+/**************************************************************************/
+
+void 
+SETDHSCHUR (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    p,
+vint    q,
+vreal   DFx,
+mmreal  DFy,
+mreal   DH,
+solver *ls
+)
+{
+  int   b,e,j;      /* variaveis auxiliares para controle de lacos */
+  int   dim;        /* dimensao de DH                              */
+  real  a,fp,fx;    /* variaveis auxiliares                        */
+  vreal row;        /* linha de DFy                                */
+
+  dim = o*n+r+1;
+
+  /* coeficientes da cadeia e linha de normalizacao */
+  SETCHAIN(n,o,r,cj,h,py,dpx,dpy,q,ls);
+
+  /* linhas de F : termos em y[o] e em x */
+  for (e = 1; e <= n; e++) {
+    for (j = 1; j <= n; j++) 
+      DH[e][j] = (j <= r) ? DFy[o][q[j]][p[e]] : 0.0;
+    DH[e][n+1] = DFx[p[e]];
+  }
+
+  /* linhas de F : termos em w[b] */
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) {
+      row = DFy[o-1-b][q[j]];
+      fp  = ls->P[b][j];
+      fx  = ls->X[b][j];
+      for (e = 1; e <= n; e++) {
+        a           = row[p[e]];
+        DH[e][j]   += a*fp;
+        DH[e][n+1] += a*fx;
+      }
+    }
+
+  /* linha de normalizacao */
+  for (j = 1; j <= n; j++) 
+    DH[n+1][j] = (j <= r) ? ls->nrm[j] : 0.0;
+  DH[n+1][n+1] = ls->nrm[dim];
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) {
+      a             = ls->nrm[b*n+r+j];
+      DH[n+1][j]   += a*ls->P[b][j];
+      DH[n+1][n+1] += a*ls->X[b][j];
+    }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula os coeficientes P e X da cadeia de derivadas e a   */
+/* linha de normalizacao de DH (veja SETDHSCHUR), armazenados em ls.      */
+/**************************************************************************/
+
+void 
+SETCHAIN (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    q,
+solver *ls
+)
+{
+  int   b,j;        /* variaveis auxiliares para controle de lacos */
+  int   dim;        /* dimensao de DH                              */
+  real  cjaux,rho;  /* coeficientes da cadeia                      */
+
+  dim   = o*n+r+1;
+  cjaux = cj*h;
+  rho   = h*dpx/cjaux;
+
+  ls->cjaux = cjaux;
+  ls->rho   = rho;
+
+  /* coeficientes da cadeia */
+  for (j = 1; j <= n; j++) {
+    if (j <= r) {
+      ls->P[0][j] = rho;
+      ls->X[0][j] = py[o][q[j]];
+    } else {
+      ls->P[0][j] = 1.0;
+      ls->X[0][j] = 0.0;
+    }
+    for (b = 1; b <= o-1; b++) {
+      ls->P[b][j] = rho*ls->P[b-1][j];
+      ls->X[b][j] = rho*ls->X[b-1][j]+py[o-b][q[j]];
+    }
+  }
+
+  /* linha de normalizacao de DH (como em SETDH) */
+  for (j = 1; j <= r; j++) 
+    ls->nrm[j] = 2.0*cjaux*dpy[o][q[j]];
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) 
+      ls->nrm[b*n+r+j] = 2.0*cjaux*dpy[o-1-b][q[j]];
+  ls->nrm[dim] = 2.0*cjaux*dpx;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula u = ac DH^(-1) delta com o sistema reduzido de     */
+/* SETDHSCHUR : calcula K a partir das linhas da cadeia de delta, resolve */
+/* o sistema reduzido com NEWTONH e recupera w[b] pela cadeia.            */
+/**************************************************************************/
+
+void 
+SCHURSOLVE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  int   b,e,j;    /* variaveis auxiliares para controle de lacos */
+  real  k,a;      /* variaveis auxiliares                        */
+  real  x;        /* correcao em x                               */
+  vreal g,v,row;  /* termo independente, solucao e linha de DFy  */
+
+  g = ls->W[1];
+  v = ls->W[2];
+
+  /* K[b][j] armazenado na posicao de w[b][j] em u */
+  for (j = 1; j <= n; j++) {
+    k = (j <= r) ? -delta[n+j]/ls->cjaux : 0.0;
+    u[r+j] = k;
+    for (b = 1; b <= o-1; b++) {
+      k = ls->rho*k-delta[b*n+r+j]/ls->cjaux;
+      u[b*n+r+j] = k;
+    }
+  }
+
+  /* termo independente do sistema reduzido */
+  for (e = 1; e <= n; e++) 
+    g[e] = delta[e];
+  g[n+1] = delta[dim];
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) {
+      k = u[b*n+r+j];
+      if (k != 0.0) {
+        row = DFy[o-1-b][q[j]];
+        for (e = 1; e <= n; e++) 
+          g[e] -= row[p[e]]*k;
+        g[n+1] -= ls->nrm[b*n+r+j]*k;
+      }
+    }
+
+  /* resolvendo o sistema reduzido */
+  SOLVEH(n+1,Q,DH,ls,v,g,1.0);
+
+  /* recuperando as variaveis eliminadas */
+  x = v[n+1];
+  for (j = 1; j <= n; j++) {
+    if (j <= r) 
+      u[j] = ac*v[j];
+    for (b = 0; b <= o-1; b++) {
+      a = ls->P[b][j]*v[j]+ls->X[b][j]*x+u[b*n+r+j];
+      u[b*n+r+j] = ac*a;
+    }
+  }
+  u[dim] = ac*x;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula o refletor de Householder H = I - tau v v^t que    */
+/* anula A[k+1..m][k]. O valor beta = (HA)[k][k] volta em A[k][k] e o     */
+/* vetor v (com v[k] = 1 implicito) volta em A[k+1..m][k]. Retorna tau.   */
+/**************************************************************************/
+
+real 
+HOUSEHOLDER (
+int    m,
+int    k,
+mreal  A
+)
+{
+  int   i;                /* variavel auxiliar para controle de lacos */
+  real  alpha,beta,tau;   /* dados do refletor                        */
+  real  scale,xnorm,aux;  /* variaveis auxiliares                     */
+
+  /* norma de A[k+1..m][k] com escala para evitar overflow; */
+  /* a escala inclui alpha, pois A[k+1..m][k] pode ser um    */
+  /* residuo de arredondamento muito menor que alpha, e      */
+  /* (alpha/scale)^2 daria overflow                          */
+  for (i = k+1, scale = 0.0; i <= m; i++) 
+    scale = MAX2(scale,fabs(A[i][k]));
+  if (scale == 0.0) 
+    return (0.0);
+  alpha = A[k][k];
+  scale = MAX2(scale,fabs(alpha));
+  for (i = k+1, xnorm = 0.0; i <= m; i++) {
+    aux    = A[i][k]/scale;
+    xnorm += aux*aux;
+  }
+
+  aux   = alpha/scale;
+  beta  = -FSIGN(alpha)*scale*sqrt(aux*aux+xnorm);
+  tau   = (beta-alpha)/beta;
+
+  /* normalizando v de modo que v[k] = 1 */
+  aux = 1.0/(alpha-beta);
+  for (i = k+1; i <= m; i++) 
+    A[i][k] *= aux;
+  A[k][k] = beta;
+
+  return (tau);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina retorna a decomposicao QR de uma matriz A (m)x(n), m >= n, */
+/* pelo metodo de Householder em blocos de ls->nb colunas (forma WY       */
+/* compacta). A matriz R volta no triangulo superior de A e os vetores    */
+/* de Householder abaixo da diagonal. Para cada bloco de colunas k0..k1   */
+/* a matriz triangular superior T do bloco volta em T[k0..k1][k0..k1],    */
+/* de modo que H_k0 ... H_k1 = I - V T V^t; em particular T[k][k] = tau   */
+/* do refletor k. Q nao e formada; NEWTONH aplica Q^t implicitamente.     */
+/*                                                                        */
+/* O pivoteamento e o mesmo de QR : antes de cada refletor a linha com o  */
+/* maior elemento na coluna k e trocada com a linha k (troca de ponteiros */
+/* de linhas inteiras, inclusive dos vetores ja armazenados), e a troca   */
+/* fica em ls->piv[k]. A estimativa para a condicao e a mesma de QR.      */
+/**************************************************************************/
+
+void 
+QRH (
+int     m,
+int     n,
+mreal   A,
+mreal   T,
+solver *ls,
+int     pivot,
+real   *cond
+)
+{
+  int    i,j,k,l;  /* variaveis auxiliares para controle de lacos */
+  int    k0,k1;    /* colunas do bloco                            */
+  int    kmax;     /* numero de refletores                        */
+  int    imax;     /* linha do pivo                               */
+  real   max;      /* valor do pivo                               */
+  real   tau,aux;  /* variaveis auxiliares                        */
+  vreal  Ai,w,z;   /* linhas de A e de trabalho                   */
+  mreal  W;        /* area de trabalho                            */
+
+  W    = ls->W;
+  kmax = MIN2(m-1,n);
+
+  for (k0 = 1; k0 <= kmax; k0 += ls->nb) {
+
+    k1 = MIN2(k0+ls->nb-1,kmax);
+
+    /* decomposicao do bloco de colunas k0..k1 */
+    for (k = k0; k <= k1; k++) {
+
+      /* escolha do pivo */
+      ls->piv[k] = k;
+      if (pivot) {
+        max  = fabs(A[k][k]);
+        imax = k;
+        for (i = k+1; i <= m; i++) 
+          if (fabs(A[i][k]) > max) {
+            imax = i;
+            max  = fabs(A[i][k]);
+          }
+        if (imax != k) {
+          Ai      = A[k];
+          A[k]    = A[imax];
+          A[imax] = Ai;
+        }
+        ls->piv[k] = imax;
+      }
+
+      /* refletor que anula A[k+1..m][k] */
+      tau     = HOUSEHOLDER(m,k,A);
+      T[k][k] = tau;
+
+      /* aplicando o refletor nas demais colunas do bloco */
+      if ((tau != 0.0) && (k < k1)) {
+        w = W[1];
+        for (j = k+1; j <= k1; j++) 
+          w[j] = A[k][j];
+        for (i = k+1; i <= m; i++) {
+          Ai  = A[i];
+          aux = Ai[k];
+          for (j = k+1; j <= k1; j++) 
+            w[j] += aux*Ai[j];
+        }
+        for (j = k+1; j <= k1; j++) {
+          w[j]    *= tau;
+          A[k][j] -= w[j];
+        }
+        for (i = k+1; i <= m; i++) {
+          Ai  = A[i];
+          aux = Ai[k];
+          for (j = k+1; j <= k1; j++) 
+            Ai[j] -= aux*w[j];
+        }
+      }
+
+    }
+
+    /* sem colunas restantes nao ha necessidade de T */
+    if (k1 == n) 
+      break;
+
+    /* calculo de T : T[k0..l-1][l] = -tau_l T V^t v_l */
+    z = W[1];
+    for (l = k0+1; l <= k1; l++) {
+      for (k = k0; k <= l-1; k++) 
+        z[k] = A[l][k];
+      for (i = l+1; i <= m; i++) {
+        Ai  = A[i];
+        aux = Ai[l];
+        for (k = k0; k <= l-1; k++) 
+          z[k] += Ai[k]*aux;
+      }
+      for (k = k0; k <= l-1; k++) {
+        for (j = k, aux = 0.0; j <= l-1; j++) 
+          aux += T[k][j]*z[j];
+        T[k][l] = -T[l][l]*aux;
+      }
+    }
+
+    /* atualizando as colunas k1+1..n : C <- (I - V T^t V^t) C */
+    if ((ls->qt != NULL) && (m >= ls->qt->nmin)) 
+      QRTHRUN(ls->qt,GSDAE_THQRH,m,n,k0,k1,k1+1,n,A,T,NULL,NULL);
+    else 
+      QRHUPDATE(m,A,T,W,k0,k1,k1+1,n);
+
+  }
+
+  /* calculo de uma estimativa para a condicao da matriz A */
+  if (n == 1) {
+   *cond = fabs(1.0/A[1][1]) ;
+  } else {
+    for (i = 2, (*cond) = 0.0; i <= n; i++)
+      for (j = 1; j <= i-1; j++) *cond = MAX2(*cond,fabs(A[j][i]/A[i][i]));
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina aplica o bloco de refletores k0..k1 de QRH nas colunas     */
+/* ja..jb de A : C <- (I - V T^t V^t) C, com W (k1-k0+1 linhas) como area */
+/* de trabalho. Cada coluna e atualizada de forma independente.           */
+/**************************************************************************/
+
+void 
+QRHUPDATE (
+int     m,
+mreal   A,
+mreal   T,
+mreal   W,
+int     k0,
+int     k1,
+int     ja,
+int     jb
+)
+{
+  int    i,j,k,l;  /* variaveis auxiliares para controle de lacos */
+  real   aux;      /* variavel auxiliar                           */
+  vreal  Ai,w,z;   /* linhas de A e de trabalho                   */
+
+  /* W = V^t C */
+  for (l = k0; l <= k1; l++) {
+    w = W[l-k0+1];
+    for (j = ja; j <= jb; j++) 
+      w[j] = 0.0;
+  }
+  for (i = k0; i <= m; i++) {
+    Ai = A[i];
+    for (l = k0; l <= MIN2(i,k1); l++) {
+      aux = (i == l) ? 1.0 : Ai[l];
+      if (aux != 0.0) {
+        w = W[l-k0+1];
+        for (j = ja; j <= jb; j++) 
+          w[j] += aux*Ai[j];
+      }
+    }
+  }
+
+  /* W = T^t W */
+  for (l = k1; l >= k0; l--) {
+    w   = W[l-k0+1];
+    aux = T[l][l];
+    for (j = ja; j <= jb; j++) 
+      w[j] *= aux;
+    for (k = k0; k <= l-1; k++) {
+      aux = T[k][l];
+      if (aux != 0.0) {
+        z = W[k-k0+1];
+        for (j = ja; j <= jb; j++) 
+          w[j] += aux*z[j];
+      }
+    }
+  }
+
+  /* C = C - V W */
+  for (i = k0; i <= m; i++) {
+    Ai = A[i];
+    for (l = k0; l <= MIN2(i,k1); l++) {
+      aux = (i == l) ? 1.0 : Ai[l];
+      if (aux != 0.0) {
+        w = W[l-k0+1];
+        for (j = ja; j <= jb; j++) 
+          Ai[j] -= aux*w[j];
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+/**********************************************************************/
+/* Esta rotina e equivalente a NEWTON para a decomposicao de QRH :    */
+/* calcula u = ac Q^t delta aplicando as trocas de linhas ls->piv e   */
+/* os refletores armazenados abaixo da diagonal de A (com tau na      */
+/* diagonal de T) e resolve R u = u.                                  */
+/**********************************************************************/
+
+void 
+NEWTONH (
+int     n,
+mreal   T,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  int   i,k; /* variaveis auxiliares para controle de lacos */
+  real  s;   /* variavel auxiliar                           */
+
+  for (i = 1; i <= n; i++) 
+    u[i] = ac*delta[i];
+
+  /* aplicando as trocas de linhas */
+  for (k = 1; k <= n-1; k++) 
+    if (ls->piv[k] != k) {
+      s             = u[k];
+      u[k]          = u[ls->piv[k]];
+      u[ls->piv[k]] = s;
+    }
+
+  /* aplicando os refletores : u = H_k u (k = 1..n-1) */
+  for (k = 1; k <= n-1; k++) {
+    if (T[k][k] == 0.0) 
+      continue;
+    for (i = k+1, s = u[k]; i <= n; i++) 
+      s += A[i][k]*u[i];
+    s    *= T[k][k];
+    u[k] -= s;
+    for (i = k+1; i <= n; i++) 
+      u[i] -= A[i][k]*s;
+  }
+  
+  /* calculo de R u = u */
+  for (i = n; i >= 1; i--) {
+    for (k = i+1; k <= n; k++) u[i] -= A[i][k]*u[k];
+    u[i] /= A[i][i];
+  } 
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina retorna a decomposicao LU com pivoteamento parcial de uma  */
+/* matriz A (n)x(n), em blocos de ls->nb colunas (forma a direita) : L    */
+/* (diagonal unitaria) abaixo da diagonal de A e U no triangulo superior. */
+/* As trocas de linhas sao feitas por ponteiros, como em QRH, e ficam em  */
+/* ls->piv. A estimativa da condicao usa U como QRH usa R. Retorna -1 se  */
+/* um pivo e nulo e 0 caso contrario.                                     */
+/**************************************************************************/
+
+int 
+LUH (
+int     n,
+mreal   A,
+solver *ls,
+real   *cond
+)
+{
+  int    i,j,k;    /* variaveis auxiliares para controle de lacos */
+  int    k0,k1;    /* colunas do bloco                            */
+  int    imax;     /* linha do pivo                               */
+  real   max;      /* valor do pivo                               */
+  real   aux;      /* variavel auxiliar                           */
+  vreal  Ai;       /* linha de A                                  */
+
+  for (k0 = 1; k0 <= n; k0 += ls->nb) {
+
+    k1 = MIN2(k0+ls->nb-1,n);
+
+    /* decomposicao do bloco de colunas k0..k1 */
+    for (k = k0; k <= k1; k++) {
+
+      /* escolha do pivo */
+      max  = fabs(A[k][k]);
+      imax = k;
+      for (i = k+1; i <= n; i++) 
+        if (fabs(A[i][k]) > max) {
+          imax = i;
+          max  = fabs(A[i][k]);
+        }
+      if (max == 0.0) 
+        return (-1);
+      if (imax != k) {
+        Ai      = A[k];
+        A[k]    = A[imax];
+        A[imax] = Ai;
+      }
+      ls->piv[k] = imax;
+
+      /* eliminacao nas demais colunas do bloco */
+      for (i = k+1; i <= n; i++) {
+        Ai     = A[i];
+        Ai[k] /= A[k][k];
+        aux    = Ai[k];
+        for (j = k+1; j <= k1; j++) 
+          Ai[j] -= aux*A[k][j];
+      }
+    }
+
+    /* linhas k0..k1 de U e bloco restante A22 */
+    if ((ls->qt != NULL) && (n >= ls->qt->nmin)) 
+      QRTHRUN(ls->qt,GSDAE_THLUH,n,n,k0,k1,k1+1,n,A,NULL,NULL,NULL);
+    else 
+      LUHUPDATE(n,A,k0,k1,k1+1,n);
+
+  }
+
+  /* calculo de uma estimativa para a condicao da matriz A */
+  if (n == 1) {
+   *cond = fabs(1.0/A[1][1]) ;
+  } else {
+    for (i = 2, (*cond) = 0.0; i <= n; i++)
+      for (j = 1; j <= i-1; j++) *cond = MAX2(*cond,fabs(A[j][i]/A[i][i]));
+  }
+
+  return (0);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina completa o passo k0..k1 de LUH nas colunas ja..jb : as     */
+/* linhas k0..k1 de U (U12 = L11^(-1) A12) e o bloco restante             */
+/* (A22 = A22 - L21 U12). Cada coluna e atualizada de forma independente. */
+/**************************************************************************/
+
+void 
+LUHUPDATE (
+int     n,
+mreal   A,
+int     k0,
+int     k1,
+int     ja,
+int     jb
+)
+{
+  int    i,j,k,l;  /* variaveis auxiliares para controle de lacos */
+  real   aux;      /* variavel auxiliar                           */
+  vreal  Ai,Al;    /* linhas de A                                 */
+
+  /* linhas k0..k1 de U : U12 = L11^(-1) A12 */
+  for (k = k0; k <= k1; k++) {
+    Al = A[k];
+    for (i = k+1; i <= k1; i++) {
+      Ai  = A[i];
+      aux = Ai[k];
+      for (j = ja; j <= jb; j++) 
+        Ai[j] -= aux*Al[j];
+    }
+  }
+
+  /* atualizando o bloco restante : A22 = A22 - L21 U12 */
+  for (i = k1+1; i <= n; i++) {
+    Ai = A[i];
+    for (l = k0; l <= k1; l++) {
+      aux = Ai[l];
+      if (aux != 0.0) {
+        Al = A[l];
+        for (j = ja; j <= jb; j++) 
+          Ai[j] -= aux*Al[j];
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+/**********************************************************************/
+/* Esta rotina e equivalente a NEWTONH para a decomposicao de LUH :   */
+/* calcula u = ac P delta, resolve L u = u e U u = u.                 */
+/**********************************************************************/
+
+void 
+NEWTONLU (
+int     n,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  int   i,k; /* variaveis auxiliares para controle de lacos */
+  real  s;   /* variavel auxiliar                           */
+
+  for (i = 1; i <= n; i++) 
+    u[i] = ac*delta[i];
+
+  /* aplicando as trocas de linhas */
+  for (k = 1; k <= n-1; k++) 
+    if (ls->piv[k] != k) {
+      s             = u[k];
+      u[k]          = u[ls->piv[k]];
+      u[ls->piv[k]] = s;
+    }
+
+  /* calculo de L u = u */
+  for (i = 2; i <= n; i++) 
+    for (k = 1; k < i; k++) u[i] -= A[i][k]*u[k];
+
+  /* calculo de U u = u */
+  for (i = n; i >= 1; i--) {
+    for (k = i+1; k <= n; k++) u[i] -= A[i][k]*u[k];
+    u[i] /= A[i][i];
+  } 
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina decompoe a matriz quadrada A (n)x(n) de FACTORDH. Com      */
+/* ls->adapt = 1 e usada a LU (LUH) enquanto a condicao da fatoracao      */
+/* anterior, ls->lcond, e menor que GSDAE_LUFRAC ls->cdmax; se a LU tem   */
+/* um pivo nulo ou a sua condicao ja nao satisfaz esse limite, A e        */
+/* restaurada de T e decomposta por QR (QRH). ls->lcond = 0 (mudanca de   */
+/* posto ou de ordem em settau) tambem impoe a QR. Como a LU so e mantida */
+/* longe de cdmax, o teste cond > cdmax de masterstep e o mesmo da QR.    */
+/**************************************************************************/
+
+void 
+FACTORH (
+int     n,
+mreal   A,
+mreal   T,
+solver *ls,
+real   *cond
+)
+{
+  int    i,j; /* variaveis auxiliares      */
+  int    lu;  /* fatoracao anterior e a LU */
+  real   lim; /* condicao maxima da LU     */
+  vreal  Ai;  /* variavel auxiliar         */
+
+  lu     = ls->lu;
+  ls->lu = 0;
+  lim    = GSDAE_LUFRAC*ls->cdmax;
+
+  if ((ls->adapt) && (ls->lcond > 0.0) && (ls->lcond < lim)) {
+
+    /* copia de A em T, que a LU nao utiliza */
+    for (i = 1; i <= n; i++) 
+      for (j = 1; j <= n; j++) 
+        T[i][j] = A[i][j];
+
+    if ((LUH(n,A,ls,cond) == 0) && (*cond < lim)) {
+      ls->lu = 1;
+    } else {
+      /* A volta a ser a copia (troca de linhas entre A e T) */
+      for (i = 1; i <= n; i++) {
+        Ai   = A[i];
+        A[i] = T[i];
+        T[i] = Ai;
+      }
+    }
+
+  }
+
+  if (!ls->lu) 
+    QRH(n,n,A,T,ls,1,cond);
+  else 
+    (ls->nlu)++;
+
+  if (ls->lu != lu) 
+    (ls->nsw)++;
+  ls->lcond = *cond;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula u = ac A^(-1) delta com a decomposicao de FACTORH. */
+/**************************************************************************/
+
+void 
+SOLVEH (
+int     n,
+mreal   T,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  if (ls->lu) 
+    NEWTONLU(n,A,ls,u,delta,ac);
+  else 
+    NEWTONH(n,T,A,ls,u,delta,ac);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/*                                                                        */
+/*                       Jacobiana esparsa                                */
+/*                                                                        */
+/*  Com ALLOCCTXSPARSE o usuario informa o padrao da jacobiana por linhas */
+/*  (equacoes) : as variaveis da equacao i sao ja[ia[i]..ia[i+1]-1], e a  */
+/*  rotina DFS preenche val[k][l] = d F_i / d y[k][ja[l]] (k = 0..o) no   */
+/*  padrao. O sistema reduzido do complemento de Schur (SETDHSCHUR) e     */
+/*  montado por colunas nas coordenadas do usuario (linha i : equacao i,  */
+/*  coluna j : variavel j, linha e coluna n+1 : normalizacao e x) e       */
+/*  decomposto por uma LU esparsa com pivoteamento parcial por colunas    */
+/*  (Gilbert-Peierls), na ordem de grau minimo de M + M^t calculada uma   */
+/*  unica vez (SPARSEORDER). A primeira fatoracao escolhe os pivos e o    */
+/*  padrao de L e U (SPARSELU); as seguintes apenas recalculam os valores */
+/*  com os mesmos pivos (SPARSEREFACT) e voltam a SPARSELU somente se um  */
+/*  pivo se tornar pequeno.                                               */
+/*                                                                        */
+/**************************************************************************/
+
+
+
+/**************************************************************************/
+/* Esta rotina monta o sistema reduzido de SETDHSCHUR em sp->cx a partir  */
+/* de sp->val e DFx.                                                      */
+/**************************************************************************/
+
+void 
+SETDHSPARSE (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    q,
+vreal   DFx,
+solver *ls
+)
+{
+  int     b,i,j,k,l;  /* variaveis auxiliares para controle de lacos */
+  int     dim;        /* dimensao de DH                              */
+  int     cx1;        /* inicio da coluna de x em M                  */
+  real    a,ax,v;     /* variaveis auxiliares                        */
+  vreal   cx;         /* valores de M                                */
+  sparse *sp;         /* jacobiana esparsa                           */
+
+  sp  = ls->sp;
+  cx  = sp->cx;
+  cx1 = sp->cp[n+1];
+  dim = o*n+r+1;
+
+  /* coeficientes da cadeia e linha de normalizacao */
+  SETCHAIN(n,o,r,cj,h,py,dpx,dpy,q,ls);
+
+  /* inversa da permutacao das variaveis */
+  for (j = 1; j <= n; j++) 
+    sp->qinv[q[j]] = j;
+
+  for (l = 1; l < sp->cp[n+2]; l++) 
+    cx[l] = 0.0;
+
+  /* linhas de F : termos em f e em x */
+  for (i = 1; i <= n; i++) {
+    ax = DFx[i];
+    for (l = sp->ia[i]; l < sp->ia[i+1]; l++) {
+      j = sp->qinv[sp->ja[l]];
+      a = (j <= r) ? sp->val[o][l] : 0.0;
+      for (b = 0; b <= o-1; b++) {
+        v   = sp->val[o-1-b][l];
+        a  += v*ls->P[b][j];
+        ax += v*ls->X[b][j];
+      }
+      cx[sp->map[l]] += a;
+    }
+    cx[cx1+i-1] = ax;
+  }
+
+  /* linha de normalizacao : ultimo elemento de cada coluna */
+  for (k = 1; k <= n; k++) {
+    j = sp->qinv[k];
+    a = (j <= r) ? ls->nrm[j] : 0.0;
+    for (b = 0; b <= o-1; b++) 
+      a += ls->nrm[b*n+r+j]*ls->P[b][j];
+    cx[sp->cp[k+1]-1] = a;
+  }
+  a = ls->nrm[dim];
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) 
+      a += ls->nrm[b*n+r+j]*ls->X[b][j];
+  cx[cx1+n] = a;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina e equivalente a SCHURSOLVE para o sistema reduzido de      */
+/* SETDHSPARSE decomposto por SPARSELU ou SPARSEREFACT.                   */
+/**************************************************************************/
+
+void 
+SPARSESOLVE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  int     b,e,i,j,l;  /* variaveis auxiliares para controle de lacos */
+  real    k,a;        /* variaveis auxiliares                        */
+  real    x;          /* correcao em x                               */
+  vreal   g,v;        /* termo independente e solucao                */
+  sparse *sp;         /* jacobiana esparsa                           */
+
+  sp = ls->sp;
+  g  = ls->W[1];
+  v  = ls->W[2];
+
+  /* K[b][j] armazenado na posicao de w[b][j] em u */
+  for (j = 1; j <= n; j++) {
+    k = (j <= r) ? -delta[n+j]/ls->cjaux : 0.0;
+    u[r+j] = k;
+    for (b = 1; b <= o-1; b++) {
+      k = ls->rho*k-delta[b*n+r+j]/ls->cjaux;
+      u[b*n+r+j] = k;
+    }
+  }
+
+  /* termo independente nas coordenadas do usuario */
+  for (e = 1; e <= n; e++) 
+    g[p[e]] = delta[e];
+  g[n+1] = delta[dim];
+  for (i = 1; i <= n; i++) 
+    for (l = sp->ia[i]; l < sp->ia[i+1]; l++) {
+      j = sp->qinv[sp->ja[l]];
+      for (b = 0; b <= o-1; b++) 
+        g[i] -= sp->val[o-1-b][l]*u[b*n+r+j];
+    }
+  for (b = 0; b <= o-1; b++) 
+    for (j = 1; j <= n; j++) 
+      g[n+1] -= ls->nrm[b*n+r+j]*u[b*n+r+j];
+
+  /* resolvendo o sistema reduzido */
+  SPARSELUSOLVE(sp,g,v);
+
+  /* recuperando as variaveis eliminadas */
+  x = v[n+1];
+  for (j = 1; j <= n; j++) {
+    if (j <= r) 
+      u[j] = ac*v[q[j]];
+    for (b = 0; b <= o-1; b++) {
+      a = ls->P[b][j]*v[q[j]]+ls->X[b][j]*x+u[b*n+r+j];
+      u[b*n+r+j] = ac*a;
+    }
+  }
+  u[dim] = ac*x;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina aloca a estrutura sparse para o padrao (ia,ja) de uma EAD  */
+/* de dimensao n e ordem o, monta o padrao do sistema reduzido M e faz a  */
+/* analise simbolica (SPARSEORDER). Retorna NULL se o padrao e invalido   */
+/* ou se nao ha memoria disponivel.                                       */
+/**************************************************************************/
+
+sparse *
+SPARSEALLOC (
+int   n,
+int   o,
+int   nnz,
+vint  ia,
+vint  ja
+)
+{
+  sparse *sp;     /* estrutura alocada                           */
+  int     i,j,l;  /* variaveis auxiliares para controle de lacos */
+  int     m;      /* dimensao do sistema reduzido                */
+  int     mnz;    /* elementos de M                              */
+  vint    w;      /* vetor de trabalho                           */
+
+  /* verificando o padrao */
+  if ((ia == NULL) || (ja == NULL) || (nnz < 0) || 
+      (ia[1] != 1) || (ia[n+1] != nnz+1)) 
+    return (NULL);
+  for (i = 1; i <= n; i++) 
+    if (ia[i+1] < ia[i]) 
+      return (NULL);
+  for (l = 1; l <= nnz; l++) 
+    if ((ja[l] < 1) || (ja[l] > n)) 
+      return (NULL);
+
+  sp = (sparse *) calloc(1,sizeof(sparse));
+  if (sp == NULL) {
+    printf("SPARSEALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  m          = n+1;
+  sp->nmin   = GSDAE_SPMIN;
+  sp->nnz    = nnz;
+  sp->o      = o;
+  sp->m      = m;
+  sp->ia     = (vint)  ALLOCVINT(n+1);
+  sp->ja     = (vint)  ALLOCVINT(nnz);
+  sp->val    = (mreal) ALLOCMREAL(o,nnz);
+  sp->map    = (vint)  ALLOCVINT(nnz);
+  sp->qinv   = (vint)  ALLOCVINT(n);
+  sp->cp     = (vint)  ALLOCVINT(m+1);
+  sp->perm   = (vint)  ALLOCVINT(m);
+  sp->lp     = (vint)  ALLOCVINT(m+1);
+  sp->up     = (vint)  ALLOCVINT(m+1);
+  sp->pinv   = (vint)  ALLOCVINT(m);
+  sp->x      = (vreal) ALLOCVREAL(m);
+  sp->xi     = (vint)  ALLOCVINT(m+1);
+  sp->stack  = (vint)  ALLOCVINT(m);
+  sp->pstack = (vint)  ALLOCVINT(m);
+  sp->mark   = (vint)  ALLOCVINT(m);
+  w          = (vint)  ALLOCVINT(m);
+
+  if ((sp->ia   == NULL) || (sp->ja    == NULL) || (sp->val    == NULL) ||
+      (sp->map  == NULL) || (sp->qinv  == NULL) || (sp->cp     == NULL) ||
+      (sp->perm == NULL) || (sp->lp    == NULL) || (sp->up     == NULL) ||
+      (sp->pinv == NULL) || (sp->x     == NULL) || (sp->xi     == NULL) ||
+      (sp->stack== NULL) || (sp->pstack== NULL) || (sp->mark   == NULL) ||
+      (w        == NULL)) {
+    printf("SPARSEALLOC : nao alocado\n");
+    FREEVINT(m,w);
+    SPARSEFREE(sp);
+    return (NULL);
+  }
+
+  for (i = 1; i <= n+1; i++) 
+    sp->ia[i] = ia[i];
+  for (l = 1; l <= nnz; l++) 
+    sp->ja[l] = ja[l];
+
+  /* contando os elementos distintos de cada coluna de M; */
+  /* cada coluna j <= n tem ainda a linha n+1 e a coluna  */
+  /* n+1 (x) e densa                                      */
+  for (i = 1; i <= n; i++) 
+    for (l = ia[i]; l < ia[i+1]; l++) 
+      if (sp->mark[ja[l]] != i) {
+        sp->mark[ja[l]] = i;
+        w[ja[l]]++;
+      }
+  sp->cp[1] = 1;
+  for (j = 1; j <= n; j++) 
+    sp->cp[j+1] = sp->cp[j]+w[j]+1;
+  sp->cp[m+1] = sp->cp[m]+m;
+  mnz = sp->cp[m+1]-1;
+
+  sp->ri = (vint)  ALLOCVINT(mnz);
+  sp->cx = (vreal) ALLOCVREAL(mnz);
+
+  /* espaco inicial para os fatores (aumentado em SPARSELU) */
+  sp->lmax = 2*mnz+m;
+  sp->umax = 2*mnz+m;
+  sp->li   = (vint)  ALLOCVINT(sp->lmax);
+  sp->lx   = (vreal) ALLOCVREAL(sp->lmax);
+  sp->ui   = (vint)  ALLOCVINT(sp->umax);
+  sp->ux   = (vreal) ALLOCVREAL(sp->umax);
+
+  if ((sp->ri == NULL) || (sp->cx == NULL) || (sp->li == NULL) ||
+      (sp->lx == NULL) || (sp->ui == NULL) || (sp->ux == NULL)) {
+    printf("SPARSEALLOC : nao alocado\n");
+    FREEVINT(m,w);
+    SPARSEFREE(sp);
+    return (NULL);
+  }
+
+  /* preenchendo as linhas de M e a posicao de cada elemento */
+  /* do padrao do usuario                                    */
+  for (j = 1; j <= n; j++) {
+    w[j]        = sp->cp[j];
+    sp->mark[j] = 0;
+  }
+  for (i = 1; i <= n; i++) 
+    for (l = ia[i]; l < ia[i+1]; l++) {
+      j = ja[l];
+      if (sp->mark[j] != i) {
+        sp->mark[j]   = i;
+        sp->ri[w[j]]  = i;
+        sp->map[l]    = w[j];
+        w[j]++;
+      } else {
+        /* elemento repetido na linha i */
+        sp->map[l]    = w[j]-1;
+      }
+    }
+  for (j = 1; j <= n; j++) 
+    sp->ri[sp->cp[j+1]-1] = m;
+  for (i = 1; i <= m; i++) 
+    sp->ri[sp->cp[m]+i-1] = i;
+
+  for (j = 1; j <= m; j++) 
+    sp->mark[j] = 0;
+  FREEVINT(m,w);
+
+  /* analise simbolica */
+  if (SPARSEORDER(n,sp) != 0) {
+    printf("SPARSEALLOC : nao alocado\n");
+    SPARSEFREE(sp);
+    return (NULL);
+  }
+
+  return (sp);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina libera a estrutura sparse                                  */
+/**************************************************************************/
+
+void 
+SPARSEFREE (
+sparse *sp
+)
+{
+  if (sp == NULL) 
+    return;
+
+  FREEVINT(sp->m,sp->ia);
+  FREEVINT(sp->nnz,sp->ja);
+  FREEMREAL(sp->o,sp->nnz,sp->val);
+  FREEVINT(sp->nnz,sp->map);
+  FREEVINT(sp->m,sp->qinv);
+  FREEVINT(sp->m+1,sp->cp);
+  FREEVINT(sp->m,sp->ri);
+  FREEVREAL(sp->m,sp->cx);
+  FREEVINT(sp->m,sp->perm);
+  FREEVINT(sp->m+1,sp->lp);
+  FREEVINT(sp->lmax,sp->li);
+  FREEVREAL(sp->lmax,sp->lx);
+  FREEVINT(sp->m+1,sp->up);
+  FREEVINT(sp->umax,sp->ui);
+  FREEVREAL(sp->umax,sp->ux);
+  FREEVINT(sp->m,sp->pinv);
+  FREEVREAL(sp->m,sp->x);
+  FREEVINT(sp->m+1,sp->xi);
+  FREEVINT(sp->m,sp->stack);
+  FREEVINT(sp->m,sp->pstack);
+  FREEVINT(sp->m,sp->mark);
+
+  free(sp);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula a ordem de eliminacao das colunas de M pelo grau   */
+/* minimo do grafo de M + M^t sem a linha e a coluna n+1, que sao densas  */
+/* e ficam por ultimo. A eliminacao e feita no proprio grafo : ao         */
+/* eliminar v os seus vizinhos formam um clique. Os vertices sao mantidos */
+/* em listas duplamente encadeadas por grau. Retorna -1 se nao ha memoria */
+/* disponivel.                                                            */
+/**************************************************************************/
+
+int 
+SPARSEORDER (
+int     n,
+sparse *sp
+)
+{
+  int   i,j,k,l,t;      /* variaveis auxiliares para controle de lacos */
+  int   v,u,w,d;        /* vertices e grau                             */
+  int   mindeg;         /* grau minimo atual                           */
+  int   nv;             /* numero de vizinhos de v                     */
+  int   stamp;          /* marca atual                                 */
+  int   fail;           /* falha na alocacao                           */
+  mint  adj;            /* listas de adjacencia                        */
+  vint  len,cap;        /* tamanho e capacidade das listas             */
+  vint  head,next,prev; /* listas de vertices por grau                 */
+  vint  deg,elim,nb;    /* grau, vertices eliminados e vizinhos de v   */
+  vint  mark,aux;       /* marcas                                      */
+
+  adj  = (mint) calloc(n+1,sizeof(vint));
+  len  = (vint) ALLOCVINT(n);
+  cap  = (vint) ALLOCVINT(n);
+  head = (vint) ALLOCVINT(n);
+  next = (vint) ALLOCVINT(n);
+  prev = (vint) ALLOCVINT(n);
+  deg  = (vint) ALLOCVINT(n);
+  elim = (vint) ALLOCVINT(n);
+  nb   = (vint) ALLOCVINT(n);
+  mark = sp->mark;
+
+  fail = ((adj  == NULL) || (len  == NULL) || (cap  == NULL) || 
+          (head == NULL) || (next == NULL) || (prev == NULL) ||
+          (deg  == NULL) || (elim == NULL) || (nb   == NULL));
+
+  /* listas de adjacencia de M + M^t (com repeticoes) */
+  if (!fail) {
+    for (i = 1; i <= n; i++) 
+      for (l = sp->ia[i]; l < sp->ia[i+1]; l++) 
+        if ((j = sp->ja[l]) != i) {
+          cap[i]++;
+          cap[j]++;
+        }
+    for (v = 1; (v <= n) && !fail; v++) {
+      adj[v] = (vint) malloc((cap[v]+1)*sizeof(int));
+      fail   = (adj[v] == NULL);
+    }
+  }
+
+  if (!fail) {
+
+    for (i = 1; i <= n; i++) 
+      for (l = sp->ia[i]; l < sp->ia[i+1]; l++) 
+        if ((j = sp->ja[l]) != i) {
+          adj[i][len[i]++] = j;
+          adj[j][len[j]++] = i;
+        }
+
+    /* removendo as repeticoes */
+    stamp = 0;
+    for (v = 1; v <= n; v++) {
+      mark[v] = ++stamp;
+      for (t = 0, l = 0; t < len[v]; t++) {
+        w = adj[v][t];
+        if (mark[w] != stamp) {
+          mark[w]    = stamp;
+          adj[v][l++] = w;
+        }
+      }
+      len[v] = l;
+    }
+
+    /* listas por grau */
+    for (v = 1; v <= n; v++) {
+      d       = len[v];
+      deg[v]  = d;
+      prev[v] = 0;
+      next[v] = head[d];
+      if (head[d]) 
+        prev[head[d]] = v;
+      head[d] = v;
+    }
+
+    /* eliminacao */
+    mindeg = 0;
+    for (k = 1; (k <= n) && !fail; k++) {
+
+      while (head[mindeg] == 0) 
+        mindeg++;
+
+      /* retirando o vertice de grau minimo */
+      v       = head[mindeg];
+      head[mindeg] = next[v];
+      if (next[v]) 
+        prev[next[v]] = 0;
+      elim[v]      = 1;
+      sp->perm[k]  = v;
+
+      /* vizinhos de v ainda nao eliminados */
+      for (t = 0, nv = 0; t < len[v]; t++) 
+        if (!elim[adj[v][t]]) 
+          nb[nv++] = adj[v][t];
+
+      /* os vizinhos de v formam um clique */
+      for (i = 0; (i < nv) && !fail; i++) {
+
+        u = nb[i];
+
+        /* retirando u da lista do seu grau */
+        if (prev[u]) 
+          next[prev[u]] = next[u];
+        else 
+          head[deg[u]] = next[u];
+        if (next[u]) 
+          prev[next[u]] = prev[u];
+
+        if (len[u]+nv > cap[u]) {
+          cap[u] = 2*(len[u]+nv);
+          aux    = (vint) realloc(adj[u],(cap[u]+1)*sizeof(int));
+          if (aux == NULL) {
+            fail = 1;
+            break;
+          }
+          adj[u] = aux;
+        }
+
+        mark[u] = ++stamp;
+        for (t = 0, l = 0; t < len[u]; t++) {
+          w = adj[u][t];
+          if ((!elim[w]) && (mark[w] != stamp)) {
+            mark[w]     = stamp;
+            adj[u][l++] = w;
+          }
+        }
+        for (t = 0; t < nv; t++) {
+          w = nb[t];
+          if (mark[w] != stamp) {
+            mark[w]     = stamp;
+            adj[u][l++] = w;
+          }
+        }
+        len[u] = l;
+
+        /* inserindo u na lista do novo grau */
+        deg[u]  = l;
+        prev[u] = 0;
+        next[u] = head[l];
+        if (head[l]) 
+          prev[head[l]] = u;
+        head[l] = u;
+        if (l < mindeg) 
+          mindeg = l;
+
+      }
+
+      free(adj[v]);
+      adj[v] = NULL;
+
+    }
+
+    /* a coluna de x e a ultima */
+    sp->perm[n+1] = n+1;
+
+  }
+
+  /* liberando a memoria */
+  if (adj != NULL) {
+    for (v = 1; v <= n; v++) 
+      free(adj[v]);
+    free(adj);
+  }
+  FREEVINT(n,len);
+  FREEVINT(n,cap);
+  FREEVINT(n,head);
+  FREEVINT(n,next);
+  FREEVINT(n,prev);
+  FREEVINT(n,deg);
+  FREEVINT(n,elim);
+  FREEVINT(n,nb);
+
+  for (v = 1; v <= sp->m; v++) 
+    mark[v] = 0;
+  sp->stamp = 0;
+
+  return (fail ? -1 : 0);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula, por busca em profundidade no grafo das colunas ja */
+/* calculadas de L, as linhas nao nulas de L^(-1) M(:,col). As linhas     */
+/* voltam em sp->xi[top..m], em ordem topologica, e a rotina retorna top. */
+/**************************************************************************/
+
+int 
+SPARSEREACH (
+sparse *sp,
+int     col
+)
+{
+  int  i,j,l,p;   /* variaveis auxiliares               */
+  int  J;         /* coluna de L da linha j             */
+  int  top;       /* inicio da pilha de saida           */
+  int  head;      /* topo da pilha da busca             */
+  int  done;      /* todos os vizinhos ja visitados     */
+
+  /* reiniciando as marcas */
+  if (sp->stamp > (1 << 30)) {
+    for (i = 1; i <= sp->m; i++) 
+      sp->mark[i] = 0;
+    sp->stamp = 0;
+  }
+  sp->stamp++;
+
+  top = sp->m+1;
+  for (p = sp->cp[col]; p < sp->cp[col+1]; p++) {
+
+    if (sp->mark[sp->ri[p]] == sp->stamp) 
+      continue;
+
+    /* busca em profundidade a partir de ri[p] */
+    head = 1;
+    sp->stack[1] = sp->ri[p];
+    while (head > 0) {
+      j = sp->stack[head];
+      J = sp->pinv[j];
+      if (sp->mark[j] != sp->stamp) {
+        sp->mark[j] = sp->stamp;
+        sp->pstack[head] = (J == 0) ? 0 : sp->lp[J]+1;
+      }
+      done = 1;
+      if (J != 0) {
+        for (l = sp->pstack[head]; l < sp->lp[J+1]; l++) {
+          i = sp->li[l];
+          if (sp->mark[i] != sp->stamp) {
+            sp->pstack[head]   = l;
+            sp->stack[++head]  = i;
+            done = 0;
+            break;
+          }
+        }
+      }
+      if (done) {
+        head--;
+        sp->xi[--top] = j;
+      }
+    }
+
+  }
+
+  return (top);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula a decomposicao LU de M com pivoteamento parcial,   */
+/* M(pinv,perm) = L U, escolhendo o elemento da diagonal como pivo sempre */
+/* que ele nao for menor que GSDAE_SPTOL vezes o maior da coluna. Retorna */
+/* em cond uma estimativa da condicao (como em QRH) e -1 se M e singular. */
+/**************************************************************************/
+
+int 
+SPARSELU (
+sparse *sp,
+real   *cond
+)
+{
+  int    i,j,k,l,p; /* variaveis auxiliares para controle de lacos */
+  int    m;         /* dimensao de M                               */
+  int    J;         /* coluna de L da linha j                      */
+  int    col;       /* coluna de M eliminada no passo k            */
+  int    top;       /* inicio do padrao de x                       */
+  int    ipiv;      /* linha do pivo                               */
+  int    lnz,unz;   /* elementos de L e de U                       */
+  int    nmax;      /* nova dimensao de L ou U                     */
+  real   amax,a;    /* variaveis auxiliares                        */
+  real   pivot;     /* pivo                                        */
+  vint   iaux;      /* vetores realocados                          */
+  vreal  raux;
+  vreal  x;         /* coluna k de L^(-1) M                        */
+
+  m = sp->m;
+  x = sp->x;
+
+  sp->numeric = 0;
+  sp->nlu++;
+  *cond = 0.0;
+
+  for (i = 1; i <= m; i++) {
+    sp->pinv[i] = 0;
+    x[i]        = 0.0;
+  }
+
+  lnz = unz = 1;
+  for (k = 1; k <= m; k++) {
+
+    sp->lp[k] = lnz;
+    sp->up[k] = unz;
+
+    /* garantindo espaco para a coluna k de L e de U */
+    if (lnz+m > sp->lmax) {
+      nmax = 2*sp->lmax+m;
+      iaux = (vint)  realloc(sp->li,(nmax+1)*sizeof(int));
+      if (iaux != NULL) 
+        sp->li = iaux;
+      raux = (vreal) realloc(sp->lx,(nmax+1)*sizeof(real));
+      if (raux != NULL) 
+        sp->lx = raux;
+      if ((iaux == NULL) || (raux == NULL)) {
+        printf("SPARSELU : nao alocado\n");
+        *cond = HUGE_VAL;
+        return (-1);
+      }
+      sp->lmax = nmax;
+    }
+    if (unz+m > sp->umax) {
+      nmax = 2*sp->umax+m;
+      iaux = (vint)  realloc(sp->ui,(nmax+1)*sizeof(int));
+      if (iaux != NULL) 
+        sp->ui = iaux;
+      raux = (vreal) realloc(sp->ux,(nmax+1)*sizeof(real));
+      if (raux != NULL) 
+        sp->ux = raux;
+      if ((iaux == NULL) || (raux == NULL)) {
+        printf("SPARSELU : nao alocado\n");
+        *cond = HUGE_VAL;
+        return (-1);
+      }
+      sp->umax = nmax;
+    }
+
+    /* x = L^(-1) M(:,col) */
+    col = sp->perm[k];
+    top = SPARSEREACH(sp,col);
+    for (p = sp->cp[col]; p < sp->cp[col+1]; p++) 
+      x[sp->ri[p]] = sp->cx[p];
+    for (p = top; p <= m; p++) {
+      j = sp->xi[p];
+      if ((J = sp->pinv[j]) == 0) 
+        continue;
+      a = x[j];
+      for (l = sp->lp[J]+1; l < sp->lp[J+1]; l++) 
+        x[sp->li[l]] -= sp->lx[l]*a;
+    }
+
+    /* coluna k de U e escolha do pivo */
+    ipiv = 0;
+    amax = -1.0;
+    for (p = top; p <= m; p++) {
+      i = sp->xi[p];
+      if (sp->pinv[i] == 0) {
+        if (fabs(x[i]) > amax) {
+          amax = fabs(x[i]);
+          ipiv = i;
+        }
+      } else {
+        sp->ui[unz]   = sp->pinv[i];
+        sp->ux[unz++] = x[i];
+      }
+    }
+
+    /* matriz singular */
+    if ((ipiv == 0) || (amax <= 0.0)) {
+      for (p = top; p <= m; p++) 
+        x[sp->xi[p]] = 0.0;
+      *cond = HUGE_VAL;
+      return (-1);
+    }
+
+    if ((sp->pinv[col] == 0) && (fabs(x[col]) >= GSDAE_SPTOL*amax)) 
+      ipiv = col;
+
+    pivot         = x[ipiv];
+    sp->ui[unz]   = k;
+    sp->ux[unz++] = pivot;
+    sp->pinv[ipiv] = k;
+
+    /* coluna k de L (linhas ainda na numeracao de M) */
+    sp->li[lnz]   = ipiv;
+    sp->lx[lnz++] = 1.0;
+    for (p = top; p <= m; p++) {
+      i = sp->xi[p];
+      if (sp->pinv[i] == 0) {
+        sp->li[lnz]   = i;
+        sp->lx[lnz++] = x[i]/pivot;
+      }
+      x[i] = 0.0;
+    }
+
+    /* estimativa da condicao */
+    for (p = sp->up[k]; p < unz-1; p++) 
+      *cond = MAX2(*cond,fabs(sp->ux[p]/pivot));
+
+  }
+
+  sp->lp[m+1] = lnz;
+  sp->up[m+1] = unz;
+
+  /* linhas de L na numeracao dos pivos */
+  for (p = 1; p < lnz; p++) 
+    sp->li[p] = sp->pinv[sp->li[p]];
+
+  sp->numeric = 1;
+
+  return (0);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina recalcula os valores de L e U para um novo M com o mesmo   */
+/* padrao, mantendo os pivos e o padrao da ultima chamada de SPARSELU.    */
+/* Retorna -1 (e sp->numeric = 0) se algum pivo for menor que GSDAE_SPREF */
+/* vezes o maior elemento da sua coluna de L.                             */
+/**************************************************************************/
+
+int 
+SPARSEREFACT (
+sparse *sp,
+real   *cond
+)
+{
+  int    j,k,l,p;   /* variaveis auxiliares para controle de lacos */
+  int    m;         /* dimensao de M                               */
+  int    col;       /* coluna de M eliminada no passo k            */
+  real   a,amax;    /* variaveis auxiliares                        */
+  real   pivot;     /* pivo                                        */
+  vreal  x;         /* coluna k de L^(-1) M, na numeracao dos pivos */
+
+  m = sp->m;
+  x = sp->x;
+
+  *cond = 0.0;
+
+  for (k = 1; k <= m; k++) {
+
+    /* zerando as posicoes das colunas k de L e U */
+    for (p = sp->up[k]; p < sp->up[k+1]; p++) 
+      x[sp->ui[p]] = 0.0;
+    for (l = sp->lp[k]; l < sp->lp[k+1]; l++) 
+      x[sp->li[l]] = 0.0;
+
+    /* M(:,col) na numeracao dos pivos */
+    col = sp->perm[k];
+    for (p = sp->cp[col]; p < sp->cp[col+1]; p++) 
+      x[sp->pinv[sp->ri[p]]] = sp->cx[p];
+
+    /* coluna k de U, na ordem topologica da fatoracao */
+    for (p = sp->up[k]; p < sp->up[k+1]-1; p++) {
+      j = sp->ui[p];
+      a = x[j];
+      sp->ux[p] = a;
+      for (l = sp->lp[j]+1; l < sp->lp[j+1]; l++) 
+        x[sp->li[l]] -= sp->lx[l]*a;
+    }
+
+    /* verificando o pivo */
+    pivot = x[k];
+    for (l = sp->lp[k]+1, amax = 0.0; l < sp->lp[k+1]; l++) 
+      amax = MAX2(amax,fabs(x[sp->li[l]]));
+    if ((pivot == 0.0) || (fabs(pivot) < GSDAE_SPREF*amax)) {
+      sp->numeric = 0;
+      return (-1);
+    }
+
+    /* coluna k de L */
+    sp->ux[sp->up[k+1]-1] = pivot;
+    for (l = sp->lp[k]+1; l < sp->lp[k+1]; l++) 
+      sp->lx[l] = x[sp->li[l]]/pivot;
+
+    /* estimativa da condicao */
+    for (p = sp->up[k]; p < sp->up[k+1]-1; p++) 
+      *cond = MAX2(*cond,fabs(sp->ux[p]/pivot));
+
+  }
+
+  sp->nrelu++;
+
+  return (0);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina resolve M z = b com a decomposicao de SPARSELU ou          */
+/* SPARSEREFACT.                                                          */
+/**************************************************************************/
+
+void 
+SPARSELUSOLVE (
+sparse *sp,
+vreal   b,
+vreal   z
+)
+{
+  int    i,j,k,l,p; /* variaveis auxiliares para controle de lacos */
+  int    m;         /* dimensao de M                               */
+  real   a;         /* variavel auxiliar                           */
+  vreal  w;         /* solucao na numeracao dos pivos              */
+
+  m = sp->m;
+  w = sp->x;
+
+  for (i = 1; i <= m; i++) 
+    w[sp->pinv[i]] = b[i];
+
+  /* L w = w */
+  for (j = 1; j <= m; j++) 
+    if ((a = w[j]) != 0.0) 
+      for (l = sp->lp[j]+1; l < sp->lp[j+1]; l++) 
+        w[sp->li[l]] -= sp->lx[l]*a;
+
+  /* U w = w */
+  for (j = m; j >= 1; j--) {
+    w[j] /= sp->ux[sp->up[j+1]-1];
+    a     = w[j];
+    for (p = sp->up[j]; p < sp->up[j+1]-1; p++) 
+      w[sp->ui[p]] -= sp->ux[p]*a;
+  }
+
+  for (k = 1; k <= m; k++) {
+    z[sp->perm[k]] = w[k];
+    w[k]           = 0.0;
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina verifica, pela LU esparsa de M = diag(DFy[o],1), se DFy[o] */
+/* e regular, isto e, se todos os pivos tem modulo maior que o limite de  */
+/* QR2. Retorna 1 se DFy[o] e regular e 0 caso contrario. Utiliza os      */
+/* valores de sp->val da ultima chamada de DFS.                           */
+/**************************************************************************/
+
+int 
+SPARSEREGULAR (
+int     n,
+int     o,
+sparse *sp
+)
+{
+  int   i,k,l;  /* variaveis auxiliares para controle de lacos */
+  real  cond;   /* estimativa da condicao                      */
+
+  for (l = 1; l < sp->cp[n+2]; l++) 
+    sp->cx[l] = 0.0;
+  for (i = 1; i <= n; i++) 
+    for (l = sp->ia[i]; l < sp->ia[i+1]; l++) 
+      sp->cx[sp->map[l]] += sp->val[o][l];
+  sp->cx[sp->cp[n+2]-1] = 1.0;
+
+  if (SPARSELU(sp,&cond) != 0) 
+    return (0);
+
+  for (k = 1; k <= n; k++) 
+    if (fabs(sp->ux[sp->up[k+1]-1]) < 1.0e-15) 
+      return (0);
+
+  return (1);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula pela LU esparsa o vetor tangente z (n+1) que a QR  */
+/* de Givens de B (SETB) retorna em Q[n+1] : z e o vetor unitario do      */
+/* nucleo de B^t com det(B,z) > 0. Com B^t = (b,A), onde b e a coluna de  */
+/* x, o vetor (1,v) com A v = -b pertence ao nucleo, e                    */
+/*                                                                        */
+/*   det(B,(1,v)) = (-1)^n det(A) (1+v^t v)                               */
+/*                                                                        */
+/* O sistema A v = -b e resolvido em M = ((A,b),(0,1)) nas coordenadas do */
+/* usuario, em que det(A) = sinal(p) sinal(q) det(M). Retorna em cond a   */
+/* estimativa da condicao da LU (HUGE_VAL se M e singular).               */
+/**************************************************************************/
+
+void 
+SPARSETAU (
+int     n,
+int     o,
+int     r,
+mreal   y,
+vint    p,
+vint    q,
+vreal   DFx,
+sparse *sp,
+vreal   z,
+real   *cond
+)
+{
+  int   i,j,k,l;  /* variaveis auxiliares para controle de lacos */
+  int   jv;       /* variavel do elemento l do padrao            */
+  int   sign;     /* sinal de det(B,z)                           */
+  real  a,norm;   /* variaveis auxiliares                        */
+
+  for (j = 1; j <= n; j++) 
+    sp->qinv[q[j]] = j;
+
+  /* colunas das variaveis : DFy[o] (j <= r) ou DFy[o-1] (j > r) */
+  /* coluna de x : DFx + DFy[0] y[1] + .. + DFy[o-1] y[o]        */
+  for (l = 1; l < sp->cp[n+2]; l++) 
+    sp->cx[l] = 0.0;
+  for (i = 1; i <= n; i++) {
+    a = DFx[i];
+    for (l = sp->ia[i]; l < sp->ia[i+1]; l++) {
+      jv = sp->ja[l];
+      j  = sp->qinv[jv];
+      if (j <= r) 
+        sp->cx[sp->map[l]] += sp->val[o][l];
+      else 
+        sp->cx[sp->map[l]] += sp->val[o-1][l];
+      for (k = 0; k <= o-2; k++) 
+        a += sp->val[k][l]*y[k+1][jv];
+      if ((o > 0) && (j <= r)) 
+        a += sp->val[o-1][l]*y[o][jv];
+    }
+    sp->cx[sp->cp[n+1]+i-1] = a;
+  }
+  sp->cx[sp->cp[n+2]-1] = 1.0;
+
+  if (SPARSELU(sp,cond) != 0) 
+    return;
+
+  /* resolvendo M w = e_(n+1) em z */
+  for (i = 1; i <= n; i++) 
+    z[i] = 0.0;
+  z[n+1] = 1.0;
+  SPARSELUSOLVE(sp,z,z);
+
+  /* sinal de det(B,(1,v)) */
+  sign = (n % 2 == 0) ? 1 : -1;
+  sign *= PERMSIGN(n,p,sp->xi)*PERMSIGN(n,q,sp->xi);
+  sign *= PERMSIGN(n+1,sp->pinv,sp->xi)*PERMSIGN(n+1,sp->perm,sp->xi);
+  for (k = 1; k <= n+1; k++) 
+    if (sp->ux[sp->up[k+1]-1] < 0.0) 
+      sign = -sign;
+
+  /* z = sign (1,v) / |(1,v)| nas coordenadas de B */
+  for (j = 1, norm = 1.0; j <= n; j++) {
+    sp->x[j+1] = z[q[j]];
+    norm      += z[q[j]]*z[q[j]];
+  }
+  norm = sign/sqrt(norm);
+  z[1] = norm;
+  for (j = 2; j <= n+1; j++) {
+    z[j]     = norm*sp->x[j];
+    sp->x[j] = 0.0;
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina retorna o sinal (1 ou -1) da permutacao p de 1..n. O vetor */
+/* w (n) e utilizado como area de trabalho.                               */
+/**************************************************************************/
+
+int 
+PERMSIGN (
+int   n,
+vint  p,
+vint  w
+)
+{
+  int  i,j;   /* variaveis auxiliares */
+  int  sign;  /* sinal da permutacao  */
+
+  for (i = 1; i <= n; i++) 
+    w[i] = 0;
+
+  sign = 1;
+  for (i = 1; i <= n; i++) 
+    if (!w[i]) {
+      /* um ciclo de comprimento l tem sinal (-1)^(l-1) */
+      for (j = p[i], w[i] = 1; j != i; j = p[j]) {
+        w[j] = 1;
+        sign = -sign;
+      }
+    }
+
+  return (sign);
+}
+
+
+
+/**************************************************************************/
+/*                                                                        */
+/*                     Corretor de Newton-Krylov                          */
+/*                                                                        */
+/* Com ALLOCCTXKRYLOV o sistema do passo de Newton DH u = delta e         */
+/* resolvido pelo GMRES com reinicio, sem montar DH. FACTORDH apenas      */
+/* guarda o ponto de linearizacao (KRYLOVSETUP), seguindo a mesma regra   */
+/* de reavaliacao da fatoracao (aDH, cjold), e SOLVEDH chama KRYLOVSOLVE. */
+/* Os produtos DH v sao formados por KRYLOVOP : as linhas da cadeia de    */
+/* derivadas e a linha de normalizacao sao lineares e calculadas          */
+/* diretamente, e as linhas de F usam a rotina JV do usuario ou uma       */
+/* diferenca finita de F (KRYLOVJVF). A tolerancia relativa do GMRES      */
+/* (termo forcante) segue a taxa de convergencia ro estimada em           */
+/* masterstep e o limite do seu teste de aceitacao. Assim a memoria e     */
+/* O(n) : DH, Q e DFy nao sao alocadas.                                   */
+/*                                                                        */
+/**************************************************************************/
+
+krylov *
+KRYLOVALLOC (
+int  n,
+int  o,
+int  m
+)
+{
+  krylov *kr;  /* estrutura alocada             */
+  int     dim; /* dimensao do sistema aumentado */
+
+  kr = (krylov *) calloc(1,sizeof(krylov));
+  if (kr == NULL) {
+    printf("KRYLOVALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  dim        = (o+1)*n+1;
+  kr->m      = m;
+  kr->maxit  = GSDAE_KRIT;
+  kr->nalloc = n;
+  kr->oalloc = o;
+  kr->V      = (mreal) ALLOCMREAL(m+1,dim);
+  kr->Hs     = (mreal) ALLOCMREAL(m+1,m);
+  kr->cs     = (vreal) ALLOCVREAL(m+1);
+  kr->sn     = (vreal) ALLOCVREAL(m+1);
+  kr->g      = (vreal) ALLOCVREAL(m+1);
+  kr->z      = (vreal) ALLOCVREAL(n+1);
+  kr->t      = (vreal) ALLOCVREAL(n);
+  kr->y0     = (mreal) ALLOCMREAL(o,n);
+  kr->dpy0   = (mreal) ALLOCMREAL(o,n);
+  kr->f0     = (vreal) ALLOCVREAL(n);
+  kr->vy     = (mreal) ALLOCMREAL(o,n);
+  kr->yb     = (mreal) ALLOCMREAL(o,n);
+  kr->fb     = (vreal) ALLOCVREAL(n);
+  kr->fv     = (vreal) ALLOCVREAL(n);
+  kr->w      = (vreal) ALLOCVREAL(dim);
+  kr->pt     = (vreal) ALLOCVREAL(n);
+  kr->xc     = (vreal) ALLOCVREAL(dim);
+
+  if ((kr->V    == NULL) || (kr->Hs  == NULL) || (kr->cs == NULL) ||
+      (kr->sn   == NULL) || (kr->g   == NULL) || (kr->z  == NULL) ||
+      (kr->t    == NULL) || (kr->y0  == NULL) || (kr->dpy0 == NULL) ||
+      (kr->f0   == NULL) || (kr->vy  == NULL) || (kr->yb == NULL) ||
+      (kr->fb   == NULL) || (kr->fv  == NULL) || (kr->w  == NULL) ||
+      (kr->pt   == NULL) || (kr->xc  == NULL)) {
+    printf("KRYLOVALLOC : nao alocado\n");
+    KRYLOVFREE(kr);
+    return (NULL);
+  }
+
+  return (kr);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina libera a estrutura krylov                                  */
+/**************************************************************************/
+
+void 
+KRYLOVFREE (
+krylov *kr
+)
+{
+  int n,o,dim; /* dimensoes alocadas */
+
+  if (kr == NULL) 
+    return;
+
+  n   = kr->nalloc;
+  o   = kr->oalloc;
+  dim = (o+1)*n+1;
+
+  FREEMREAL(kr->m+1,dim,kr->V);
+  FREEMREAL(kr->m+1,kr->m,kr->Hs);
+  FREEVREAL(kr->m+1,kr->cs);
+  FREEVREAL(kr->m+1,kr->sn);
+  FREEVREAL(kr->m+1,kr->g);
+  FREEVREAL(n+1,kr->z);
+  FREEVREAL(n,kr->t);
+  FREEMREAL(o,n,kr->y0);
+  FREEMREAL(o,n,kr->dpy0);
+  FREEVREAL(n,kr->f0);
+  FREEMREAL(o,n,kr->vy);
+  FREEMREAL(o,n,kr->yb);
+  FREEVREAL(n,kr->fb);
+  FREEVREAL(n,kr->fv);
+  FREEVREAL(dim,kr->w);
+  FREEVREAL(n,kr->pt);
+  FREEVREAL(dim,kr->xc);
+  PCFREE(kr->pcb);
+
+  free(kr);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina guarda em kr o ponto de linearizacao (x0,y0) com F(x0,y0)  */
+/* em f0. Usada por KRYLOVSETUP e KRYLOVTAU.                              */
+/**************************************************************************/
+
+void 
+KRYLOVPOINT (
+krylov *kr,
+int     n,
+int     o,
+real    x,
+mreal   y,
+vreal   f,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+)
+{
+  int  i,j;  /* variaveis auxiliares */
+  real c;    /* max(1,|(x,y)|)       */
+
+  kr->n    = n;
+  kr->o    = o;
+  kr->x0   = x;
+  kr->F    = F;
+  kr->data = data;
+
+  c = MAX2(1.0,fabs(x));
+  for (i = 0; i <= o; i++) 
+    for (j = 1; j <= n; j++) {
+      kr->y0[i][j] = y[i][j];
+      c = MAX2(c,fabs(y[i][j]));
+    }
+  kr->cnrm = c;
+
+  for (j = 1; j <= n; j++) 
+    kr->f0[j] = f[j];
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula jv = DFx vx + DFy[0] vy[0] + .. + DFy[o] vy[o] no  */
+/* ponto de linearizacao, com a rotina JV do usuario ou por diferenca     */
+/* finita de F com incremento relativo sqrt(1.0e-15).                     */
+/**************************************************************************/
+
+void 
+KRYLOVJVF (
+krylov *kr,
+real    vx,
+mreal   vy,
+vreal   jv
+)
+{
+  int  i,j;    /* variaveis auxiliares   */
+  int  n,o;    /* dimensao e ordem       */
+  real vmax;   /* norma maxima da direcao */
+  real del;    /* incremento             */
+
+  n = kr->n;
+  o = kr->o;
+
+  if (kr->JV != NULL) {
+    kr->JV(o,n,kr->x0,kr->y0,vx,vy,jv,kr->data);
+    return;
+  }
+
+  vmax = fabs(vx);
+  for (i = 0; i <= o; i++) 
+    for (j = 1; j <= n; j++) 
+      vmax = MAX2(vmax,fabs(vy[i][j]));
+
+  if (vmax == 0.0) {
+    for (j = 1; j <= n; j++) 
+      jv[j] = 0.0;
+    return;
+  }
+
+  del = sqrt(1.0e-15)*kr->cnrm/vmax;
+  for (i = 0; i <= o; i++) 
+    for (j = 1; j <= n; j++) 
+      kr->yb[i][j] = kr->y0[i][j]+del*vy[i][j];
+
+  kr->F(o,n,kr->x0+del*vx,kr->yb,kr->fb,kr->data);
+  (kr->nfe)++;
+
+  for (j = 1; j <= n; j++) 
+    jv[j] = (kr->fb[j]-kr->f0[j])/del;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula w = A v para os operadores do GMRES :              */
+/*                                                                        */
+/*   GSDAE_KRDH  : A = DH no ponto de linearizacao, com as mesmas         */
+/*                 variaveis e linhas de SETDH (dim = o*n+r+1)            */
+/*   GSDAE_KRTAU : A = DFy[o] (dimensao n), sistema do vetor tangente     */
+/**************************************************************************/
+
+void 
+KRYLOVOP (
+krylov *kr,
+int     kind,
+vreal   v,
+vreal   w
+)
+{
+  int    i,j,k;  /* variaveis auxiliares  */
+  int    n,o,r;  /* dimensao, ordem, posto */
+  real   vx;     /* direcao em x          */
+  real   a;      /* variavel auxiliar     */
+  mreal  vy;     /* direcao em y          */
+  vint   p,q;    /* permutacoes           */
+
+  n  = kr->n;
+  o  = kr->o;
+  r  = kr->r;
+  p  = kr->p;
+  q  = kr->q;
+  vy = kr->vy;
+
+  if (kind == GSDAE_KRTAU) {
+
+    for (i = 0; i < o; i++) 
+      for (j = 1; j <= n; j++) 
+        vy[i][j] = 0.0;
+    for (j = 1; j <= n; j++) 
+      vy[o][j] = v[j];
+    KRYLOVJVF(kr,0.0,vy,w);
+
+    return;
+  }
+
+  /* variaveis de DH (veja SETDH) */
+  vx = v[o*n+r+1];
+  for (j = 1; j <= r; j++) 
+    vy[o][q[j]] = v[j];
+  for (j = r+1; j <= n; j++) 
+    vy[o][q[j]] = 0.0;
+  for (i = o-1; i >= 0; i--) 
+    for (j = 1; j <= n; j++) 
+      vy[i][q[j]] = v[(o-i-1)*n+r+j];
+
+  /* linhas de F */
+  KRYLOVJVF(kr,vx,vy,kr->fv);
+  for (i = 1; i <= n; i++) 
+    w[i] = kr->fv[p[i]];
+
+  /* linhas da cadeia : h dpx v[k] - cj h v[k-1] + cj h y[k] vx */
+  if (o > 0) 
+    for (i = 1; i <= r; i++) 
+      w[n+i] = kr->h*kr->dpx0*vy[o][q[i]]-kr->cjaux*vy[o-1][q[i]]+
+               kr->cjaux*kr->y0[o][q[i]]*vx;
+  for (k = o-1; k >= 1; k--) 
+    for (i = 1; i <= n; i++) 
+      w[(o-k)*n+r+i] = kr->h*kr->dpx0*vy[k][q[i]]-kr->cjaux*vy[k-1][q[i]]+
+                       kr->cjaux*kr->y0[k][q[i]]*vx;
+
+  /* linha de normalizacao */
+  a = kr->dpx0*vx;
+  for (i = 1; i <= r; i++) 
+    a += kr->dpy0[o][q[i]]*vy[o][q[i]];
+  for (k = o-1; k >= 0; k--) 
+    for (i = 1; i <= n; i++) 
+      a += kr->dpy0[k][q[i]]*vy[k][q[i]];
+  w[o*n+r+1] = 2.0*kr->cjaux*a;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* GMRES com reinicio a cada kr->m iteracoes para A x = b, onde A e o     */
+/* operador kind de KRYLOVOP. A iteracao termina quando |b - A x| <=      */
+/* eta |b|. Retorna 0 se convergiu e 1 caso contrario (x e a melhor       */
+/* aproximacao obtida). Para A = DH o precondicionador (KRYLOVPC), se     */
+/* houver, e aplicado a direita, de modo que o residuo testado e o de     */
+/* A x = b.                                                               */
+/**************************************************************************/
+
+int 
+KRYLOVGMRES (
+krylov *kr,
+int     kind,
+int     dim,
+vreal   b,
+vreal   x,
+real    eta
+)
+{
+  int   i,j,l;   /* variaveis auxiliares         */
+  int   it;      /* iteracoes realizadas         */
+  int   m;       /* ultima coluna do subespaco   */
+  int   stop;    /* 1 : subespaco invariante     */
+  int   pc;      /* 1 : precondicionar           */
+  real  beta;    /* |b|                          */
+  real  res;     /* norma do residuo             */
+  real  t,a;     /* variaveis auxiliares         */
+  mreal V;       /* base ortonormal              */
+  mreal Hs;      /* Hessenberg                   */
+  vreal cs,sn,g; /* rotacoes e residuo projetado */
+
+  V  = kr->V;
+  Hs = kr->Hs;
+  cs = kr->cs;
+  sn = kr->sn;
+  g  = kr->g;
+
+  pc = (kind == GSDAE_KRDH) && (kr->pcsolve != NULL) && kr->pcok;
+
+  for (i = 1; i <= dim; i++) 
+    x[i] = 0.0;
+
+  beta = 0.0;
+  for (i = 1; i <= dim; i++) 
+    beta += b[i]*b[i];
+  beta = sqrt(beta);
+  if (beta == 0.0) 
+    return (0);
+
+  it = 0;
+  while (1) {
+
+    /* residuo inicial do ciclo */
+    if (it == 0) 
+      for (i = 1; i <= dim; i++) 
+        V[1][i] = b[i];
+    else {
+      KRYLOVOP(kr,kind,x,V[1]);
+      for (i = 1; i <= dim; i++) 
+        V[1][i] = b[i]-V[1][i];
+    }
+    res = 0.0;
+    for (i = 1; i <= dim; i++) 
+      res += V[1][i]*V[1][i];
+    res = sqrt(res);
+    if (res <= eta*beta) 
+      return (0);
+    if (it >= kr->maxit) 
+      return (1);
+    for (i = 1; i <= dim; i++) 
+      V[1][i] /= res;
+    g[1] = res;
+
+    /* processo de Arnoldi com Gram-Schmidt modificado */
+    m    = 0;
+    stop = 0;
+    while ((m < kr->m) && (it < kr->maxit) && (res > eta*beta) && !stop) {
+
+      m++;
+      it++;
+      (kr->nli)++;
+
+      if (pc) {
+        KRYLOVPC(kr,V[m],kr->w);
+        KRYLOVOP(kr,kind,kr->w,V[m+1]);
+      } else 
+        KRYLOVOP(kr,kind,V[m],V[m+1]);
+      for (l = 1; l <= m; l++) {
+        t = 0.0;
+        for (i = 1; i <= dim; i++) 
+          t += V[m+1][i]*V[l][i];
+        Hs[l][m] = t;
+        for (i = 1; i <= dim; i++) 
+          V[m+1][i] -= t*V[l][i];
+      }
+      t = 0.0;
+      for (i = 1; i <= dim; i++) 
+        t += V[m+1][i]*V[m+1][i];
+      t = sqrt(t);
+      Hs[m+1][m] = t;
+      if (t > 0.0) 
+        for (i = 1; i <= dim; i++) 
+          V[m+1][i] /= t;
+      else 
+        stop = 1;
+
+      /* rotacoes de Givens anteriores e nova rotacao */
+      for (l = 1; l < m; l++) {
+        a          =  cs[l]*Hs[l][m]+sn[l]*Hs[l+1][m];
+        Hs[l+1][m] = -sn[l]*Hs[l][m]+cs[l]*Hs[l+1][m];
+        Hs[l][m]   =  a;
+      }
+      a = sqrt(Hs[m][m]*Hs[m][m]+Hs[m+1][m]*Hs[m+1][m]);
+      if (a == 0.0) {
+        cs[m] = 1.0;
+        sn[m] = 0.0;
+      } else {
+        cs[m] = Hs[m][m]/a;
+        sn[m] = Hs[m+1][m]/a;
+      }
+      Hs[m][m]   = a;
+      Hs[m+1][m] = 0.0;
+      g[m+1]     = -sn[m]*g[m];
+      g[m]       =  cs[m]*g[m];
+      res        = fabs(g[m+1]);
+
+    }
+
+    /* x <- x + V y, com Hs y = g (triangular superior) */
+    for (l = m; l >= 1; l--) {
+      t = g[l];
+      for (j = l+1; j <= m; j++) 
+        t -= Hs[l][j]*g[j];
+      g[l] = (Hs[l][l] != 0.0) ? t/Hs[l][l] : 0.0;
+    }
+    if (pc) {
+      /* x <- x + M^(-1) V y (V[m+1] como area de trabalho) */
+      for (i = 1; i <= dim; i++) 
+        kr->w[i] = 0.0;
+      for (l = 1; l <= m; l++) 
+        for (i = 1; i <= dim; i++) 
+          kr->w[i] += g[l]*V[l][i];
+      KRYLOVPC(kr,kr->w,V[m+1]);
+      for (i = 1; i <= dim; i++) 
+        x[i] += V[m+1][i];
+    } else 
+      for (l = 1; l <= m; l++) 
+        for (i = 1; i <= dim; i++) 
+          x[i] += g[l]*V[l][i];
+
+    if (res <= eta*beta) 
+      return (0);
+    if (stop) 
+      return (1);
+
+  }
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina substitui a montagem e a fatoracao de DH no corretor de    */
+/* Newton-Krylov : o ponto predito (pcx,pcy), a sua derivada (pdcx,pdcy), */
+/* F no ponto (deltax), cj e h sao guardados em ls->kr para os produtos   */
+/* DH v de KRYLOVOP.                                                      */
+/**************************************************************************/
+
+void 
+KRYLOVSETUP (
+int     n,
+int     o,
+int     r,
+real    h,
+real    cj,
+real    pcx,
+real    pdcx,
+mreal   pcy,
+mreal   pdcy,
+vint    p,
+vint    q,
+vreal   deltax,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
+)
+{
+  int     i,j; /* variaveis auxiliares */
+  krylov *kr;  /* corretor de Krylov   */
+
+  kr = ls->kr;
+
+  KRYLOVPOINT(kr,n,o,pcx,pcy,deltax,F,data);
+  kr->r     = r;
+  kr->p     = p;
+  kr->q     = q;
+  kr->h     = h;
+  kr->cjaux = cj*h;
+  kr->dpx0  = pdcx;
+  for (i = 0; i <= o; i++) 
+    for (j = 1; j <= n; j++) 
+      kr->dpy0[i][j] = pdcy[i][j];
+
+  /* a derivada passa a orientar o vetor tangente (KRYLOVTAU) */
+  kr->ref = 1;
+  kr->ro  = 0.0;
+  kr->dn  = 0.0;
+
+  /* precondicionador no novo ponto */
+  kr->pcok = 0;
+  if (kr->pcsetup != NULL) {
+    kr->st.n   = n;
+    kr->st.o   = o;
+    kr->st.x   = kr->x0;
+    kr->st.y   = kr->y0;
+    kr->st.f   = kr->f0;
+    kr->st.cj  = cj;
+    kr->st.h   = h;
+    kr->st.rho = pdcx/cj;
+    kr->st.kr  = kr;
+    kr->pcok   = (kr->pcsetup(cj,h,&(kr->st),kr->pcdata) == 0);
+    (kr->npc)++;
+    if (kr->pcok) 
+      KRYLOVPCX(kr);
+  }
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula u = ac DH^(-1) delta pelo GMRES. O termo forcante  */
+/* segue o teste de masterstep : com erro relativo eta na correcao, a     */
+/* taxa estimada ro aumenta de cerca de eta e a norma peso da correcao,   */
+/* dn, de eta dn. Por isso eta = GSDAE_EPLI min(ro, 0.33/dn), limitado a  */
+/* [ETAMIN,ETAMAX]; ro = 0 (fora de masterstep) usa ETAMIN.               */
+/**************************************************************************/
+
+void 
+KRYLOVSOLVE (
+int     dim,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+)
+{
+  int     i;   /* variavel auxiliar   */
+  real    eta; /* termo forcante      */
+  krylov *kr;  /* corretor de Krylov  */
+
+  kr = ls->kr;
+
+  eta = GSDAE_EPLI*kr->ro;
+  if (kr->dn > 0.0) 
+    eta = MIN2(eta,GSDAE_EPLI*0.33/kr->dn);
+  eta = MAX2(GSDAE_ETAMIN,MIN2(GSDAE_ETAMAX,eta));
+
+  KRYLOVGMRES(kr,GSDAE_KRDH,dim,delta,u,eta);
+  for (i = 1; i <= dim; i++) 
+    u[i] *= ac;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula o vetor tangente de settau sem montar B quando     */
+/* DFy[o] e regular (r = n) : B^t (1,v) = 0 equivale a                    */
+/*                                                                        */
+/*   DFy[o] v = -(DFx + DFy[0] y[1] + .. + DFy[o-1] y[o]),                */
+/*                                                                        */
+/* resolvido pelo GMRES com produtos de KRYLOVJVF. Retorna em kr->z o     */
+/* vetor (1,v)/|(1,v)| nas coordenadas de B (como Q[n+1] em settau),      */
+/* orientado no sentido da derivada anterior (*kr->rx,kr->ry) quando ela  */
+/* existe e com x crescente no ponto inicial. cond = HUGE_VAL indica que  */
+/* o GMRES nao convergiu (DFy[o] singular).                               */
+/**************************************************************************/
+
+void 
+KRYLOVTAU (
+int     n,
+int     o,
+real    x,
+mreal   y,
+vint    q,
+vreal   delta,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+krylov *kr,
+real   *cond
+)
+{
+  int  i,j;   /* variaveis auxiliares */
+  real norm;  /* norma de (1,v)       */
+  real a;     /* produto escalar      */
+
+  KRYLOVPOINT(kr,n,o,x,y,delta,F,data);
+
+  /* lado direito : -DF (1,y[1],..,y[o],0) */
+  for (i = 0; i < o; i++) 
+    for (j = 1; j <= n; j++) 
+      kr->vy[i][j] = y[i+1][j];
+  for (j = 1; j <= n; j++) 
+    kr->vy[o][j] = 0.0;
+  KRYLOVJVF(kr,1.0,kr->vy,kr->fv);
+  for (j = 1; j <= n; j++) 
+    kr->fv[j] = -kr->fv[j];
+
+  if (KRYLOVGMRES(kr,GSDAE_KRTAU,n,kr->fv,kr->t,GSDAE_KRTOL) != 0) {
+    *cond = HUGE_VAL;
+    return;
+  }
+  *cond = 1.0;
+
+  /* orientacao */
+  a = 1.0;
+  if (kr->ref) {
+    a = *(kr->rx);
+    for (j = 1; j <= n; j++) 
+      a += kr->t[j]*kr->ry[o][j];
+    for (i = 0; i < o; i++) 
+      for (j = 1; j <= n; j++) 
+        a += y[i+1][j]*kr->ry[i][j];
+  }
+
+  norm = 1.0;
+  for (j = 1; j <= n; j++) 
+    norm += kr->t[j]*kr->t[j];
+  norm = FSIGN(a)/sqrt(norm);
+
+  kr->z[1] = norm;
+  for (i = 1; i <= n; i++) 
+    kr->z[i+1] = norm*kr->t[q[i]];
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina resolve M z = v nas variaveis y, onde M e a parte          */
+/* triangular inferior por blocos de DH sem a coluna de x, com o bloco    */
+/* das linhas de F nas variaveis y[o] substituido por G :                 */
+/*                                                                        */
+/*   z[y[o]]   = P^(-1) v[F]           (rotina solve, P aproxima G)       */
+/*   z[y[k-1]] = (h dpx z[y[k]] - v[cadeia k])/(cj h),  k = o..1          */
+/*                                                                        */
+/* isto e, a eliminacao da cadeia de SETDHSCHUR. z[dim] nao e alterado.   */
+/* Retorna dpy . z[y], o termo em y da linha de normalizacao.             */
+/**************************************************************************/
+
+real 
+KRYLOVPCB (
+krylov *kr,
+vreal   v,
+vreal   z
+)
+{
+  int  i,k;    /* variaveis auxiliares   */
+  int  n,o,r;  /* dimensao, ordem, posto */
+  real a;      /* dpy . z[y]             */
+  vint p,q;    /* permutacoes            */
+
+  n = kr->n;
+  o = kr->o;
+  r = kr->r;
+  p = kr->p;
+  q = kr->q;
+
+  /* variaveis y[o] : P^(-1) nas coordenadas do usuario */
+  for (i = 1; i <= n; i++) 
+    kr->pt[p[i]] = v[i];
+  kr->pcsolve(n,kr->pt,kr->pcdata);
+  for (i = 1; i <= r; i++) 
+    z[i] = kr->pt[q[i]];
+
+  /* variaveis y[o-1] (linhas n+1..n+r) */
+  if (o > 0) 
+    for (i = 1; i <= r; i++) 
+      z[r+i] = (kr->h*kr->dpx0*z[i]-v[n+i])/kr->cjaux;
+
+  /* variaveis y[k-1] (k = o-1..1) */
+  for (k = o-1; k >= 1; k--) 
+    for (i = 1; i <= n; i++) 
+      z[(o-k)*n+r+i] = (kr->h*kr->dpx0*z[(o-k-1)*n+r+i]-
+                        v[(o-k)*n+r+i])/kr->cjaux;
+
+  a = 0.0;
+  for (i = 1; i <= r; i++) 
+    a += kr->dpy0[o][q[i]]*z[i];
+  for (k = o-1; k >= 0; k--) 
+    for (i = 1; i <= n; i++) 
+      a += kr->dpy0[k][q[i]]*z[(o-k-1)*n+r+i];
+
+  return (a);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina prepara o acoplamento com x do precondicionador, apos o    */
+/* setup do usuario : xc = M^(-1) c, onde c e a coluna de x em DH (DFx    */
+/* nas linhas de F e cj h y[k] nas linhas da cadeia), e o pivo            */
+/* xden = dpx - dpy . xc da linha de normalizacao.                        */
+/**************************************************************************/
+
+void 
+KRYLOVPCX (
+krylov *kr
+)
+{
+  int  i,j,k;  /* variaveis auxiliares   */
+  int  n,o,r;  /* dimensao, ordem, posto */
+  real a;      /* escala de xden         */
+  vint p,q;    /* permutacoes            */
+
+  n = kr->n;
+  o = kr->o;
+  r = kr->r;
+  p = kr->p;
+  q = kr->q;
+
+  for (k = 0; k <= o; k++) 
+    for (j = 1; j <= n; j++) 
+      kr->vy[k][j] = 0.0;
+  KRYLOVJVF(kr,1.0,kr->vy,kr->fv);
+  for (i = 1; i <= n; i++) 
+    kr->w[i] = kr->fv[p[i]];
+  if (o > 0) 
+    for (i = 1; i <= r; i++) 
+      kr->w[n+i] = kr->cjaux*kr->y0[o][q[i]];
+  for (k = o-1; k >= 1; k--) 
+    for (i = 1; i <= n; i++) 
+      kr->w[(o-k)*n+r+i] = kr->cjaux*kr->y0[k][q[i]];
+
+  kr->xden = kr->dpx0-KRYLOVPCB(kr,kr->w,kr->xc);
+
+  /* sem pivo : x fica fora do precondicionador */
+  a = fabs(kr->dpx0);
+  for (k = 0; k <= o; k++) 
+    for (j = 1; j <= n; j++) 
+      a += fabs(kr->dpy0[k][j]);
+  if (fabs(kr->xden) <= 1.0e-8*a) 
+    kr->xden = 0.0;
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina aplica o precondicionador a direita z = M^(-1) v no        */
+/* sistema DH z = v : M e M da rotina KRYLOVPCB acrescida da coluna de x  */
+/* e da linha de normalizacao, resolvida por bordejamento,                */
+/*                                                                        */
+/*   z[x] = (v[norm]/(2 cj h) - dpy . M^(-1) v)/xden                      */
+/*   z[y] = M^(-1) v - z[x] xc                                            */
+/*                                                                        */
+/**************************************************************************/
+
+void 
+KRYLOVPC (
+krylov *kr,
+vreal   v,
+vreal   z
+)
+{
+  int  i;    /* variavel auxiliar */
+  int  dim;  /* dimensao de DH    */
+  real a;    /* dpy . M^(-1) v    */
+
+  dim = kr->o*kr->n+kr->r+1;
+
+  a = KRYLOVPCB(kr,v,z);
+  if (kr->xden == 0.0) {
+    z[dim] = 0.0;
+    return;
+  }
+
+  z[dim] = (v[dim]/(2.0*kr->cjaux)-a)/kr->xden;
+  for (i = 1; i < dim; i++) 
+    z[i] -= z[dim]*kr->xc[i];
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina calcula w = G v, G = DFy[o] + rho DFy[o-1] + .. +          */
+/* rho^o DFy[0], no ponto de linearizacao de st, com um produto de        */
+/* KRYLOVJVF. Pode ser usada pela rotina setup de um precondicionador     */
+/* do usuario para obter G por colunas.                                   */
+/**************************************************************************/
+
+void 
+PCGV (
+pcstate *st,
+vreal    v,
+vreal    w
+)
+{
+  int     j,k; /* variaveis auxiliares */
+  real    c;   /* rho^(o-k)            */
+  krylov *kr;  /* corretor de Krylov   */
+
+  kr = st->kr;
+  c  = 1.0;
+  for (k = st->o; k >= 0; k--) {
+    for (j = 1; j <= st->n; j++) 
+      kr->vy[k][j] = c*v[j];
+    c *= st->rho;
+  }
+  KRYLOVJVF(kr,0.0,kr->vy,w);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina aloca um precondicionador interno para G de dimensao n :   */
+/*                                                                        */
+/*   GSDAE_PCBJ  : blocos diagonais de tamanho bs, obtidos com 2 bs       */
+/*                 produtos (sondagem), exatos se a semilargura de banda  */
+/*                 de G nao excede bs, e decompostos por LU               */
+/*   GSDAE_PCILU : ILU(0) no padrao cpr (SETPATTERN) acrescido da         */
+/*                 diagonal, com G obtida por grupos de colunas (ncolor   */
+/*                 produtos)                                              */
+/*                                                                        */
+/* Retorna NULL se os dados sao invalidos ou se nao ha memoria.           */
+/**************************************************************************/
+
+pcbuiltin *
+PCALLOC (
+int       n,
+int       kind,
+int       bs,
+coloring *cpr
+)
+{
+  pcbuiltin *pcb;   /* estrutura alocada        */
+  int        i,j,l; /* variaveis auxiliares     */
+  int        diag;  /* 1 : (j,j) esta no padrao */
+  int        fail;  /* 1 : nao alocado          */
+
+  if ((kind == GSDAE_PCBJ) && ((bs < 1) || (bs > n))) 
+    return (NULL);
+  if ((kind == GSDAE_PCILU) && ((cpr == NULL) || (cpr->n < n))) 
+    return (NULL);
+  if ((kind != GSDAE_PCBJ) && (kind != GSDAE_PCILU)) 
+    return (NULL);
+
+  pcb = (pcbuiltin *) calloc(1,sizeof(pcbuiltin));
+  if (pcb == NULL) {
+    printf("PCALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  pcb->kind = kind;
+  pcb->n    = n;
+  pcb->e    = (vreal) ALLOCVREAL(n);
+  pcb->w    = (vreal) ALLOCVREAL(n);
+
+  if (kind == GSDAE_PCBJ) {
+
+    pcb->bs  = bs;
+    pcb->B   = (mreal) ALLOCMREAL(n,bs);
+    pcb->piv = (vint)  ALLOCVINT(n);
+    fail = (pcb->e == NULL) || (pcb->w == NULL) || (pcb->B == NULL) || 
+           (pcb->piv == NULL);
+    if (fail) {
+      printf("PCALLOC : nao alocado\n");
+      PCFREE(pcb);
+      return (NULL);
+    }
+    return (pcb);
+
+  }
+
+  /* ILU(0) : padrao por linhas com a diagonal, a partir do */
+  /* padrao por colunas de cpr                              */
+  pcb->nnz    = cpr->nnz;
+  pcb->ncolor = cpr->ncolor;
+  pcb->cp     = (vint)  ALLOCVINT(n+1);
+  pcb->ri     = (vint)  ALLOCVINT(cpr->nnz);
+  pcb->map    = (vint)  ALLOCVINT(cpr->nnz);
+  pcb->gp     = (vint)  ALLOCVINT(cpr->ncolor+1);
+  pcb->gv     = (vint)  ALLOCVINT(n);
+  pcb->ia     = (vint)  ALLOCVINT(n+1);
+  pcb->dg     = (vint)  ALLOCVINT(n);
+  pcb->iw     = (vint)  ALLOCVINT(n);
+  fail = (pcb->e  == NULL) || (pcb->w  == NULL) || (pcb->cp == NULL) || 
+         (pcb->ri == NULL) || (pcb->map== NULL) || (pcb->gp == NULL) ||
+         (pcb->gv == NULL) || (pcb->ia == NULL) || (pcb->dg == NULL) ||
+         (pcb->iw == NULL);
+  if (fail) {
+    printf("PCALLOC : nao alocado\n");
+    PCFREE(pcb);
+    return (NULL);
+  }
+
+  for (j = 1; j <= n+1; j++) 
+    pcb->cp[j] = cpr->cp[j];
+  for (l = 1; l <= cpr->nnz; l++) 
+    pcb->ri[l] = cpr->ri[l];
+  for (l = 1; l <= cpr->ncolor+1; l++) 
+    pcb->gp[l] = cpr->gp[l];
+  for (j = 1; j <= n; j++) 
+    pcb->gv[j] = cpr->gv[j];
+
+  /* contando os elementos de cada linha (iw) */
+  for (i = 1; i <= n; i++) 
+    pcb->iw[i] = 0;
+  for (j = 1; j <= n; j++) {
+    diag = 0;
+    for (l = pcb->cp[j]; l < pcb->cp[j+1]; l++) {
+      pcb->iw[pcb->ri[l]]++;
+      if (pcb->ri[l] == j) 
+        diag = 1;
+    }
+    if (!diag) {
+      pcb->iw[j]++;
+      pcb->nnz++;
+    }
+  }
+  pcb->ia[1] = 1;
+  for (i = 1; i <= n; i++) 
+    pcb->ia[i+1] = pcb->ia[i]+pcb->iw[i];
+
+  pcb->ja = (vint)  ALLOCVINT(pcb->nnz);
+  pcb->a  = (vreal) ALLOCVREAL(pcb->nnz);
+  if ((pcb->ja == NULL) || (pcb->a == NULL)) {
+    printf("PCALLOC : nao alocado\n");
+    PCFREE(pcb);
+    return (NULL);
+  }
+
+  /* as colunas sao percorridas em ordem crescente, de modo */
+  /* que cada linha fica ordenada                           */
+  for (i = 1; i <= n; i++) 
+    pcb->iw[i] = pcb->ia[i];
+  for (j = 1; j <= n; j++) {
+    diag = 0;
+    for (l = pcb->cp[j]; l < pcb->cp[j+1]; l++) {
+      i = pcb->ri[l];
+      if ((i > j) && !diag) {
+        pcb->dg[j]           = pcb->iw[j];
+        pcb->ja[pcb->iw[j]++] = j;
+        diag = 1;
+      }
+      if (i == j) {
+        pcb->dg[j] = pcb->iw[j];
+        diag = 1;
+      }
+      pcb->map[l]          = pcb->iw[i];
+      pcb->ja[pcb->iw[i]++] = j;
+    }
+    if (!diag) {
+      pcb->dg[j]            = pcb->iw[j];
+      pcb->ja[pcb->iw[j]++] = j;
+    }
+  }
+
+  /* iw marca as colunas da linha corrente na ILU(0) */
+  for (i = 1; i <= n; i++) 
+    pcb->iw[i] = 0;
+
+  return (pcb);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina libera um precondicionador interno                         */
+/**************************************************************************/
+
+void 
+PCFREE (
+pcbuiltin *pcb
+)
+{
+  int n; /* dimensao */
+
+  if (pcb == NULL) 
+    return;
+
+  n = pcb->n;
+
+  FREEVREAL(n,pcb->e);
+  FREEVREAL(n,pcb->w);
+  FREEMREAL(n,pcb->bs,pcb->B);
+  FREEVINT(n,pcb->piv);
+  FREEVINT(n+1,pcb->cp);
+  FREEVINT(pcb->nnz,pcb->ri);
+  FREEVINT(pcb->nnz,pcb->map);
+  FREEVINT(pcb->ncolor+1,pcb->gp);
+  FREEVINT(n,pcb->gv);
+  FREEVINT(n+1,pcb->ia);
+  FREEVINT(n,pcb->dg);
+  FREEVINT(n,pcb->iw);
+  FREEVINT(pcb->nnz,pcb->ja);
+  FREEVREAL(pcb->nnz,pcb->a);
+
+  free(pcb);
+
+  return;
+}
+
+
+
+/**************************************************************************/
+/* Rotina setup dos precondicionadores internos : obtem G no ponto de st  */
+/* com PCGV e calcula a LU dos blocos (GSDAE_PCBJ) ou a ILU(0)            */
+/* (GSDAE_PCILU). Retorna -1 se um pivo e nulo.                           */
+/**************************************************************************/
+
+int 
+PCSETUP (
+real     cj,
+real     h,
+pcstate *st,
+void    *pdata
+)
+{
+  pcbuiltin *pcb;       /* precondicionador interno    */
+  int        n,bs;      /* dimensao e tamanho do bloco */
+  int        i,j,k,l,c; /* variaveis auxiliares        */
+  int        b0,m;      /* inicio e tamanho do bloco   */
+  int        ncol;      /* numero de sondagens         */
+  real       t;         /* variavel auxiliar           */
+  mreal      B;         /* blocos                      */
+
+  pcb = (pcbuiltin *) pdata;
+  n   = pcb->n;
+
+  if (pcb->kind == GSDAE_PCBJ) {
+
+    bs   = pcb->bs;
+    B    = pcb->B;
+    ncol = MIN2(2*bs,n);
+
+    /* sondagem : as colunas j = c, c+ncol, .. sao somadas */
+    for (c = 1; c <= ncol; c++) {
+      for (j = 1; j <= n; j++) 
+        pcb->e[j] = (((j-1) % ncol) == c-1) ? 1.0 : 0.0;
+      PCGV(st,pcb->e,pcb->w);
+      for (j = c; j <= n; j += ncol) {
+        b0 = ((j-1)/bs)*bs;
+        m  = MIN2(bs,n-b0);
+        for (i = b0+1; i <= b0+m; i++) 
+          B[i][j-b0] = pcb->w[i];
+      }
+    }
+
+    /* LU de cada bloco com pivoteamento parcial */
+    for (b0 = 0; b0 < n; b0 += bs) {
+      m = MIN2(bs,n-b0);
+      for (k = 1; k <= m; k++) {
+        l = k;
+        for (i = k+1; i <= m; i++) 
+          if (fabs(B[b0+i][k]) > fabs(B[b0+l][k])) 
+            l = i;
+        pcb->piv[b0+k] = l;
+        if (B[b0+l][k] == 0.0) 
+          return (-1);
+        if (l != k) 
+          for (j = 1; j <= m; j++) {
+            t            = B[b0+k][j];
+            B[b0+k][j]   = B[b0+l][j];
+            B[b0+l][j]   = t;
+          }
+        for (i = k+1; i <= m; i++) {
+          B[b0+i][k] /= B[b0+k][k];
+          for (j = k+1; j <= m; j++) 
+            B[b0+i][j] -= B[b0+i][k]*B[b0+k][j];
+        }
+      }
+    }
+
+    return (0);
+  }
+
+  /* G no padrao, por grupos de colunas estruturalmente ortogonais */
+  for (l = 1; l <= pcb->nnz; l++) 
+    pcb->a[l] = 0.0;
+  for (j = 1; j <= n; j++) 
+    pcb->e[j] = 0.0;
+  for (c = 1; c <= pcb->ncolor; c++) {
+    for (l = pcb->gp[c]; l < pcb->gp[c+1]; l++) 
+      pcb->e[pcb->gv[l]] = 1.0;
+    PCGV(st,pcb->e,pcb->w);
+    for (l = pcb->gp[c]; l < pcb->gp[c+1]; l++) {
+      j          = pcb->gv[l];
+      pcb->e[j]  = 0.0;
+      for (k = pcb->cp[j]; k < pcb->cp[j+1]; k++) 
+        pcb->a[pcb->map[k]] = pcb->w[pcb->ri[k]];
+    }
+  }
+
+  /* ILU(0) por linhas (IKJ) */
+  for (i = 1; i <= n; i++) {
+    for (l = pcb->ia[i]; l < pcb->ia[i+1]; l++) 
+      pcb->iw[pcb->ja[l]] = l;
+    for (l = pcb->ia[i]; l < pcb->dg[i]; l++) {
+      k          = pcb->ja[l];
+      pcb->a[l] /= pcb->a[pcb->dg[k]];
+      for (m = pcb->dg[k]+1; m < pcb->ia[k+1]; m++) 
+        if (pcb->iw[pcb->ja[m]] != 0) 
+          pcb->a[pcb->iw[pcb->ja[m]]] -= pcb->a[l]*pcb->a[m];
+    }
+    for (l = pcb->ia[i]; l < pcb->ia[i+1]; l++) 
+      pcb->iw[pcb->ja[l]] = 0;
+    if (pcb->a[pcb->dg[i]] == 0.0) 
+      return (-1);
+  }
+
+  return (0);
+}
+
+
+
+/**************************************************************************/
+/* Rotina solve dos precondicionadores internos : rhs <- P^(-1) rhs       */
+/**************************************************************************/
+
+void 
+PCSOLVE (
+int    n,
+vreal  rhs,
+void  *pdata
+)
+{
+  pcbuiltin *pcb;     /* precondicionador interno  */
+  int        i,k,l;   /* variaveis auxiliares      */
+  int        b0,m,bs; /* bloco                     */
+  real       t;       /* variavel auxiliar         */
+  mreal      B;       /* blocos                    */
+
+  pcb = (pcbuiltin *) pdata;
+
+  if (pcb->kind == GSDAE_PCBJ) {
+
+    bs = pcb->bs;
+    B  = pcb->B;
+    for (b0 = 0; b0 < n; b0 += bs) {
+      m = MIN2(bs,n-b0);
+      for (k = 1; k <= m; k++) {
+        l = pcb->piv[b0+k];
+        if (l != k) {
+          t            = rhs[b0+k];
+          rhs[b0+k]    = rhs[b0+l];
+          rhs[b0+l]    = t;
+        }
+        for (i = k+1; i <= m; i++) 
+          rhs[b0+i] -= B[b0+i][k]*rhs[b0+k];
+      }
+      for (k = m; k >= 1; k--) {
+        for (i = k+1; i <= m; i++) 
+          rhs[b0+k] -= B[b0+k][i]*rhs[b0+i];
+        rhs[b0+k] /= B[b0+k][k];
+      }
+    }
+
+    return;
+  }
+
+  /* L y = rhs (diagonal unitaria) e U x = y */
+  for (i = 1; i <= n; i++) 
+    for (l = pcb->ia[i]; l < pcb->dg[i]; l++) 
+      rhs[i] -= pcb->a[l]*rhs[pcb->ja[l]];
+  for (i = n; i >= 1; i--) {
+    for (l = pcb->dg[i]+1; l < pcb->ia[i+1]; l++) 
+      rhs[i] -= pcb->a[l]*rhs[pcb->ja[l]];
+    rhs[i] /= pcb->a[pcb->dg[i]];
+  }
+
+  return;
+}
+
+
+
+real    
+PIVOT2 (
+int   n,
+int   k,
+mreal A,
+vint  p,
+vint  q
+) 
+{
+  int  i,j,imax,jmax;
+  real max;
+
+  max  = fabs(A[p[k]][q[k]]);
+  imax = jmax = k;
+
+  for (i = k; i <= n; i++) 
+    for (j = k; j <= n; j++) 
+      if (fabs(A[p[i]][q[j]]) > max) {
+        imax = i;
+        jmax = j;
+        max  = fabs(A[p[i]][q[j]]);
+      }
+
+  if (imax != k) {
+    i       = p[k];
+    p[k]    = p[imax];
+    p[imax] = i;
+  }
+
+  if (jmax != k) {
+    j       = q[k];
+    q[k]    = q[jmax];
+    q[jmax] = j;
+  }
+
+  return (max);
+}
+
+
+void 
+GIVENS2 ( 
+int   n,
+int   i,
+int   k,
+mreal A,
+mreal Q,
+vint  p,
+vint  q,
+real  s1,
+real  s2
+)
+{
+  real  s;   /* variavel auxiliar para armazenar dados    */
+
+  if (fabs(s2)+fabs(s1) > 0.0) {
+    if (fabs(s2) >= fabs(s1))
+      s  = sqrt(1.0+(s1/s2)*(s1/s2))*fabs(s2);
+    else
+      s  = sqrt(1.0+(s2/s1)*(s2/s1))*fabs(s1);
+    s1 = s1/s; s2 = s2/s; 
+    /* aplicando a matriz de rotacao em A e Q : as linhas sao */
+    /* completas e podem ser percorridas sem a permutacao q   */
+    KERNROT(n,A[p[i]]+1,A[p[k]]+1,NULL,s1,s2);
+    KERNROT(n,Q[p[i]]+1,Q[p[k]]+1,NULL,s1,s2);
+  }
+
+  return;
+}
+
+
+int 
+QR2 (
+int    n,
+mreal  A,
+mreal  Q,
+vint   p,
+vint   q
+)
+{
+  return (QR2TH(n,A,Q,p,q,NULL));
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina e QR2 com as threads de ls->qt (ls = NULL : sequencial).   */
+/* Para n >= qt->nmin as rotacoes de cada passo i sao calculadas na       */
+/* coluna q[i] e depois aplicadas as demais colunas de A e de Q em        */
+/* ladrilhos (QR2UPDATE); as operacoes de cada coluna sao as mesmas de    */
+/* GIVENS2, de modo que o pivoteamento e o posto retornado nao mudam.     */
+/**************************************************************************/
+
+int 
+QR2TH (
+int     n,
+mreal   A,
+mreal   Q,
+vint    p,
+vint    q,
+solver *ls
+)
+{
+  int    i,k;   /* variaveis auxiliares                 */
+  real   s,t;   /* variaveis auxiliares                 */
+  real   s1,s2; /* rotacao                              */
+  vreal  Ai,Ak; /* linhas p[i] e p[k] de A              */
+  qrthr *qt;    /* threads (NULL : sequencial)          */
+
+  qt = NULL;
+  if ((ls != NULL) && (ls->qt != NULL) && (n >= ls->qt->nmin) && 
+      (n <= ls->qt->dim)) 
+    qt = ls->qt;
+
+  for (i = 1; i <= n; i++) {
+    for (k = 1; k <= n; k++) Q[i][k] = 0.0;
+    p[i]    = i;
+    q[i]    = i;
+    Q[i][i] = 1.0;
+  } 
+
+  for (i = 1; i < n; i++) {
+    if (PIVOT2(n,i,A,p,q) < 1.0e-15) 
+      return (i-1);
+
+    if (qt == NULL) {
+      for (k = i+1; k <= n; k++) 
+        GIVENS2(n,i,k,A,Q,p,q,A[p[i]][q[i]],A[p[k]][q[i]]);
+      continue;
+    }
+
+    /* rotacoes na coluna q[i] (como em GIVENS2) */
+    Ai = A[p[i]];
+    for (k = i+1; k <= n; k++) {
+      Ak     = A[p[k]];
+      s1     = Ai[q[i]];
+      s2     = Ak[q[i]];
+      qt->rk[k] = (fabs(s2)+fabs(s1) > 0.0);
+      if (!qt->rk[k]) 
+        continue;
+      if (fabs(s2) >= fabs(s1))
+        s  = sqrt(1.0+(s1/s2)*(s1/s2))*fabs(s2);
+      else
+        s  = sqrt(1.0+(s2/s1)*(s2/s1))*fabs(s1);
+      s1 = s1/s; s2 = s2/s; 
+      qt->rc[k] = s1;
+      qt->rs[k] = s2;
+      s        =  s1*Ai[q[i]]+s2*Ak[q[i]];
+      t        = -s2*Ai[q[i]]+s1*Ak[q[i]];
+      Ai[q[i]] =  s; 
+      Ak[q[i]] =  t;
+    }
+
+    /* demais colunas de A e colunas de Q */
+    QRTHRUN(qt,GSDAE_THQR2,n,n,i,i,1,n,A,Q,p,q);
+  }
+
+  if (fabs(A[p[n]][q[n]]) < 1.0e-15) 
+    return (n-1);
+
+  return (n);
+}
+
+
+
+/**************************************************************************/
+/* Esta rotina aplica as rotacoes (rc,rs) do passo i de QR2TH, k = i+1..n */
+/* com rk[k] = 1, nas colunas ja..jb de A (exceto q[i]) e de Q. Como as   */
+/* rotacoes atingem linhas inteiras, os ladrilhos sao de colunas fisicas. */
+/**************************************************************************/
+
+void 
+QR2UPDATE (
+int    n,
+int    i,
+mreal  A,
+mreal  Q,
+vint   p,
+vint   q,
+vreal  rc,
+vreal  rs,
+vint   rk,
+int    ja,
+int    jb
+)
+{
+  int    k;     /* variavel auxiliar     */
+  int    c;     /* coluna q[i]           */
+  real   s1,s2; /* rotacao               */
+  vreal  Ai,Ak; /* linhas p[i] e p[k]    */
+
+  c = q[i];
+  for (k = i+1; k <= n; k++) {
+    if (!rk[k]) 
+      continue;
+    s1 = rc[k];
+    s2 = rs[k];
+    Ai = A[p[i]];
+    Ak = A[p[k]];
+    /* colunas ja..jb exceto c */
+    if ((c < ja) || (c > jb)) 
+      KERNROT(jb-ja+1,Ai+ja,Ak+ja,NULL,s1,s2);
+    else {
+      KERNROT(c-ja,Ai+ja,Ak+ja,NULL,s1,s2);
+      KERNROT(jb-c,Ai+c+1,Ak+c+1,NULL,s1,s2);
+    }
+    KERNROT(jb-ja+1,Q[p[i]]+ja,Q[p[k]]+ja,NULL,s1,s2);
+  }
+
+  return;
+}
+
+
+void 
+SOLVESYSTEM (
+int    n,
+mreal  A,
+mreal  Q,
+vint   p,
+vint   q,
+vreal  x,
+vreal  y
+)
+{
+  int   i,j; 
+  real  s;   
+
+  for (j = 1; j <= n; j++) x[j] = y[j];
+
+  /* produto por linhas inteiras de Q : acesso sequencial */
+  for (i = 1; i <= n; i++) 
+    y[p[i]] = KERNDOT(n,Q[p[i]]+1,x+1);
+  
+  for (i = n; i >= 1; i--) {
+    for (j = i+1, s = 0.0; j <= n; j++) s += A[p[i]][q[j]]*x[q[j]];
+    x[q[i]] = (y[p[i]]-s)/A[p[i]][q[i]];
+  } 
+  
+  return;
+}
+
+
+void 
+ALLOCPAR (
+int  n,
+int  o,
+mreal *y,
+mreal *atoly,
+mreal *rtoly,
+vreal *ftol,
+vint  *infoinput,
+vint  *infooutput,
+void (*F)(int,int,real,mreal,vreal),
+void (*DF)(int,int,real,mreal,vreal,mmreal)
+)
+{
+  *y     = (mreal) ALLOCMREAL(o,n);
+  if (*y == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  *atoly = (mreal) ALLOCMREAL(o,n);
+  if (*atoly == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  *rtoly = (mreal) ALLOCMREAL(o,n);
+  if (*rtoly == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  *ftol = (vreal) ALLOCVREAL(n);
+  if (*ftol == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  *infoinput  = (vint)  ALLOCVINT(2*n+10);
+  if (*infoinput == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  *infooutput  = (vint)  ALLOCVINT(2*n+10);
+  if (*infooutput == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  /* alocando o contexto global, cujas rotinas F e DF */
+  /* repassam a chamada para as rotinas do usuario    */
+  par = ALLOCCTX(n,o,FPAR,DFPAR,NULL);
+  if (par == NULL) {
+    printf("ALLOCPAR : nao alocado\n");
+    exit(1);
+    return;
+  }
+
+  /* definindo as funcoes do usuario */
+  par->data = (void *) par;
+  par->F0   = F;
+  par->DF0  = DF;
+
+  return;
+}
+
+
+
+
+void 
+FREEPAR ( 
+int    n,
+int    o,
+mreal *y,
+mreal *atoly,
+mreal *rtoly,
+vreal *ftol,
+vint  *infoinput,
+vint  *infooutput
+)
+{
+  extern parameter *par;
+
+  *y           = (mreal) FREEMREAL(o,n,*y);
+  *atoly       = (mreal) FREEMREAL(o,n,*atoly);
+  *rtoly       = (mreal) FREEMREAL(o,n,*rtoly);
+  *ftol        = (vreal) FREEVREAL(n,*ftol);
+  *infoinput   = (vint)  FREEVINT(2*n+10,*infoinput);
+  *infooutput  = (vint)  FREEVINT(2*n+10,*infooutput);
+
+  /* desaloca o contexto global */
+  FREECTX(par);
+  par = NULL;
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/* rotinas que repassam as chamadas de F e DF do contexto */
+/* global par para as rotinas do usuario sem o parametro  */
+/* data (ver ALLOCPAR)                                    */
+/* ****************************************************** */
+
+void 
+FPAR (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  ((parameter *) data)->F0(o,n,x,y,delta);
+
+  return;
+}
+
+
+void 
+DFPAR (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  ((parameter *) data)->DF0(o,n,x,y,DFx,DFy);
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto para a integracao de uma */
+/* EAD de dimensao n e ordem o. As rotinas F e DF sao     */
+/* chamadas com o parametro data definido pelo usuario.   */
+/* Os vetores e matrizes do contexto sao alocados em um   */
+/* unico bloco alinhado (GSDAE_ARENA).                    */
+/* Retorna NULL caso nao haja memoria disponivel.         */
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTX (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void  *data
+)
+{
+  return (ALLOCCTXMODE(n,o,F,DF,data,GSDAE_ARENA));
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto como ALLOCCTX, com o     */
+/* modo de alocacao dos vetores e matrizes :              */
+/*                                                        */
+/*   GSDAE_MALLOC : cada vetor e cada linha das matrizes  */
+/*                  sao alocados separadamente (malloc)   */
+/*   GSDAE_ARENA  : todos os vetores e matrizes sao       */
+/*                  retirados de um unico bloco, com cada */
+/*                  linha alinhada em GSDAE_ALIGN bytes   */
+/*   GSDAE_HUGE   : como GSDAE_ARENA, mas o bloco e       */
+/*                  alocado em paginas grandes quando o   */
+/*                  sistema permitir                      */
+/*                                                        */
+/* Em todos os modos as matrizes mantem os ponteiros para */
+/* as linhas, de modo que o acesso DH[i][j] nao se altera.*/
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTXMODE (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void  *data,
+int    mode
+)
+{
+  return (ALLOCCTXSP(n,o,F,DF,data,mode,NULL));
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto como ALLOCCTXMODE com a  */
+/* jacobiana esparsa sp (NULL : densa). Com sp != NULL o  */
+/* contexto passa a ser o responsavel por liberar sp, e   */
+/* DH e Q sao alocadas apenas com dimensao n+1, pois o    */
+/* passo de Newton usa sempre o sistema reduzido.         */
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTXSP (
+int     n,
+int     o,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+int     mode,
+sparse *sp
+)
+{
+  return (ALLOCCTXLS(n,o,F,DF,data,mode,sp,NULL));
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto como ALLOCCTXSP com o    */
+/* corretor de Newton-Krylov kr (NULL : fatoracao de DH). */
+/* Com kr != NULL o contexto passa a ser o responsavel    */
+/* por liberar kr, e DH, Q e DFy nao sao alocadas.        */
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTXLS (
+int     n,
+int     o,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+int     mode,
+sparse *sp,
+krylov *kr
+)
+{
+  gsdae_ctx *ctx; /* contexto alocado */
+
+  /* verificando a dimensao e a ordem */
+  if ((n <= 0) || (o < 0)) {
+    SPARSEFREE(sp);
+    KRYLOVFREE(kr);
+    return (NULL);
+  }
+
+  /* escolhendo os nucleos vetoriais na primeira alocacao */
+  KERNINIT();
+
+  ctx = (gsdae_ctx *) calloc(1,sizeof(gsdae_ctx));
+  if (ctx == NULL) {
+    printf("ALLOCCTX : nao alocado\n");
+    SPARSEFREE(sp);
+    KRYLOVFREE(kr);
+    return (NULL);
+  }
+
+  /* jacobiana esparsa */
+  ctx->ls.sp = sp;
+
+  /* corretor de Newton-Krylov */
+  ctx->ls.kr = kr;
+
+  /* armazenando as dimensoes alocadas */
+  ctx->nalloc = n;
+  ctx->oalloc = o;
+
+  /* inicializando a ordem e a dimensao com 0 */
+  ctx->n = 0;
+  ctx->o = 0;
+
+  /* definindo as funcoes e os dados do usuario */
+  ctx->F    = F;
+  ctx->DF   = DF;
+  ctx->data = data;
+  ctx->F0   = NULL;
+  ctx->DF0  = NULL;
+
+  /* inicializando os controladores de erro */
+  ctx->error  = 0;
+  ctx->nerror = 0;
+
+  /* alocando os vetores e as matrizes */
+  ctx->mode = mode;
+  if (mode == GSDAE_MALLOC) 
+    CTXARRAYS(ctx,n,o,NULL);
+  else {
+    /* calculando o tamanho do bloco */
+    CTXARRAYS(ctx,n,o,&(ctx->mem));
+    /* alocando o bloco e distribuindo os dados */
+    if (ARENAALLOC(&(ctx->mem),(mode == GSDAE_HUGE)) == 0) 
+      CTXARRAYS(ctx,n,o,&(ctx->mem));
+  }
+
+  /* verificando se todos os dados foram alocados */
+  if ((ctx->p     == NULL) || (ctx->q       == NULL) ||
+      (ctx->paux  == NULL) || (ctx->qaux    == NULL) ||
+      (ctx->DFx   == NULL) || (ctx->u       == NULL) ||
+      (ctx->delta == NULL) || (ctx->deltax  == NULL) ||
+      (ctx->deltah== NULL) || (ctx->deltahx == NULL) ||
+      (ctx->psi   == NULL) || (ctx->alfa    == NULL) ||
+      (ctx->beta  == NULL) || (ctx->gama    == NULL) ||
+      (ctx->sigma == NULL) || (ctx->phix    == NULL) ||
+      (ctx->ftol  == NULL) || (ctx->y       == NULL) ||
+      (ctx->tauy  == NULL) || (ctx->DH      == NULL) ||
+      (ctx->cy    == NULL) || (ctx->cyx     == NULL) ||
+      (ctx->pcy   == NULL) || (ctx->pdcy    == NULL) ||
+      (ctx->dy    == NULL) || (ctx->ccy     == NULL) ||
+      (ctx->yx    == NULL) || (ctx->Q       == NULL) ||
+      (ctx->atoly == NULL) || (ctx->rtoly   == NULL) ||
+      (ctx->wty   == NULL) || (ctx->Ey      == NULL) ||
+      (ctx->DFy   == NULL) || (ctx->phiy    == NULL) ||
+      (ctx->ls.piv== NULL) || (ctx->ls.W    == NULL) ||
+      (ctx->ls.P  == NULL) || (ctx->ls.X    == NULL) ||
+      (ctx->ls.nrm== NULL) || (ctx->ls.BS   == NULL) ||
+      (ctx->ls.BD == NULL) || (ctx->ls.bh   == NULL)) {
+
+    printf("ALLOCCTX : nao alocado\n");
+    FREECTX(ctx);
+    return (NULL);
+
+  }
+
+  return (ctx);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto para uma EAD de dimensao */
+/* n e ordem o com a jacobiana esparsa. O padrao de DFy   */
+/* (uniao dos padroes de DFy[0],..,DFy[o]) e informado    */
+/* por linhas : as variaveis que aparecem na equacao i    */
+/* sao ja[l], l = ia[i]..ia[i+1]-1 (ia[1] = 1 e           */
+/* ia[n+1] = nnz+1). A rotina DFS substitui DF :          */
+/*                                                        */
+/*   DFS(o,n,x,y,DFx,val,data)                            */
+/*                                                        */
+/* onde val[k][l] = d F_i / d y[k][ja[l]] (k = 0..o).     */
+/* Retorna NULL se o padrao e invalido ou se nao ha       */
+/* memoria disponivel.                                    */
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTXSPARSE (
+int    n,
+int    o,
+int    nnz,
+vint   ia,
+vint   ja,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DFS)(int,int,real,mreal,vreal,mreal,void *),
+void  *data
+)
+{
+  gsdae_ctx *ctx; /* contexto alocado */
+  sparse    *sp;  /* jacobiana esparsa */
+
+  if ((n <= 0) || (o < 0) || (F == NULL) || (DFS == NULL)) 
+    return (NULL);
+
+  sp = SPARSEALLOC(n,o,nnz,ia,ja);
+  if (sp == NULL) 
+    return (NULL);
+
+  /* rotinas e dados do usuario */
+  sp->F    = F;
+  sp->DFS  = DFS;
+  sp->data = data;
+
+  /* as rotinas F e DF do contexto repassam a chamada */
+  /* para as rotinas do usuario                       */
+  ctx = ALLOCCTXSP(n,o,SPARSEF,SPARSEDF,NULL,GSDAE_ARENA,sp);
+  if (ctx == NULL) 
+    return (NULL);
+  ctx->data = (void *) ctx;
+
+  return (ctx);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina aloca um contexto para EADs grandes com o  */
+/* corretor de Newton-Krylov : o sistema do passo de      */
+/* Newton e resolvido pelo GMRES sem montar DH, e a       */
+/* memoria e O(n). Os produtos da jacobiana por um vetor  */
+/* sao dados pela rotina                                  */
+/*                                                        */
+/*   JV(o,n,x,y,vx,vy,jv,data)                            */
+/*                                                        */
+/* com jv = DFx vx + DFy[0] vy[0] + .. + DFy[o] vy[o], ou */
+/* por diferencas finitas de F se JV = NULL. DFy[o] deve  */
+/* ser regular (infoinput[4] = 0 ou n) e as opcoes        */
+/* infoinput[2] e infoinput[5] nao sao utilizadas.        */
+/* Retorna NULL se nao ha memoria disponivel.             */
+/* ****************************************************** */
+
+gsdae_ctx *
+ALLOCCTXKRYLOV (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*JV)(int,int,real,mreal,real,mreal,vreal,void *),
+void  *data
+)
+{
+  gsdae_ctx *ctx; /* contexto alocado   */
+  krylov    *kr;  /* corretor de Krylov */
+
+  if ((n <= 0) || (o < 0) || (F == NULL)) 
+    return (NULL);
+
+  kr = KRYLOVALLOC(n,o,GSDAE_KRM);
+  if (kr == NULL) 
+    return (NULL);
+  kr->JV = JV;
+
+  ctx = ALLOCCTXLS(n,o,F,NULL,data,GSDAE_ARENA,NULL,kr);
+  if (ctx == NULL) 
+    return (NULL);
+
+  /* a derivada no ultimo passo orienta o vetor tangente */
+  kr->rx = &(ctx->pdcx);
+  kr->ry = ctx->pdcy;
+
+  return (ctx);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina informa um precondicionador a direita para */
+/* o corretor de Newton-Krylov (ALLOCCTXKRYLOV). As       */
+/* rotinas do usuario sao                                 */
+/*                                                        */
+/*   setup(cj,h,st,pdata)                                 */
+/*   solve(n,rhs,pdata)                                   */
+/*                                                        */
+/* setup e chamada sempre que a jacobiana seria           */
+/* reavaliada (mesma regra de aDH e cjold) e deve         */
+/* preparar P ~ G = DFy[o] + rho DFy[o-1] + .. +          */
+/* rho^o DFy[0], rho = st->rho, no ponto (st->x,st->y);   */
+/* PCGV(st,v,w) calcula w = G v. Se setup retorna um      */
+/* valor nao nulo o passo segue sem precondicionador.     */
+/* solve substitui rhs (1..n, ordem do usuario) por       */
+/* P^(-1) rhs. Com setup = NULL ou solve = NULL o         */
+/* precondicionador e retirado. Retorna 0, ou -1 se o     */
+/* contexto nao usa o corretor de Newton-Krylov.          */
+/* ****************************************************** */
+
+int 
+SETPRECOND (
+gsdae_ctx *ctx,
+int      (*setup)(real,real,pcstate *,void *),
+void     (*solve)(int,vreal,void *),
+void      *pdata
+)
+{
+  krylov *kr; /* corretor de Krylov */
+
+  if ((ctx == NULL) || (ctx->ls.kr == NULL)) 
+    return (-1);
+
+  kr = ctx->ls.kr;
+  if (pdata != (void *) kr->pcb) {
+    PCFREE(kr->pcb);
+    kr->pcb = NULL;
+  }
+
+  if ((setup == NULL) || (solve == NULL)) {
+    kr->pcsetup = NULL;
+    kr->pcsolve = NULL;
+    kr->pcdata  = NULL;
+  }
+  else {
+    kr->pcsetup = setup;
+    kr->pcsolve = solve;
+    kr->pcdata  = pdata;
+  }
+  kr->pcok = 0;
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina escolhe um precondicionador interno para o */
+/* corretor de Newton-Krylov :                            */
+/*                                                        */
+/*   GSDAE_PCNONE : sem precondicionador                  */
+/*   GSDAE_PCBJ   : bloco-Jacobi com blocos bs x bs de G  */
+/*   GSDAE_PCILU  : ILU(0) de G no padrao de SETPATTERN   */
+/*                  ou DETECTPATTERN (chamada antes)      */
+/*                                                        */
+/* G e obtida por produtos JV (ou diferencas de F) em     */
+/* grupos de colunas. Retorna 0, ou -1 se os dados sao    */
+/* invalidos ou se nao ha memoria disponivel.             */
+/* ****************************************************** */
+
+int 
+SETPRECONDKIND (
+gsdae_ctx *ctx,
+int        kind,
+int        bs
+)
+{
+  pcbuiltin *pcb; /* precondicionador interno */
+
+  if ((ctx == NULL) || (ctx->ls.kr == NULL)) 
+    return (-1);
+
+  if (kind == GSDAE_PCNONE) 
+    return (SETPRECOND(ctx,NULL,NULL,NULL));
+
+  pcb = PCALLOC(ctx->nalloc,kind,bs,ctx->ls.cpr);
+  if (pcb == NULL) 
+    return (-1);
+
+  SETPRECOND(ctx,PCSETUP,PCSOLVE,(void *) pcb);
+  ctx->ls.kr->pcb = pcb;
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina informa o padrao de DFy (uniao sobre as    */
+/* ordens, no mesmo formato de ALLOCCTXSPARSE) para as    */
+/* jacobianas aproximadas (infoinput[2] = 0) : as colunas */
+/* sao coloridas uma unica vez e cada aproximacao de DF   */
+/* passa a custar (o+1)*ncolor+1 avaliacoes de F. Um      */
+/* padrao anterior e substituido. Retorna 0, ou -1 se o   */
+/* padrao e invalido ou se nao ha memoria disponivel.     */
+/* ****************************************************** */
+
+int 
+SETPATTERN (
+gsdae_ctx *ctx,
+int        nnz,
+vint       ia,
+vint       ja
+)
+{
+  coloring *cpr; /* coloracao das colunas */
+
+  if (ctx == NULL) 
+    return (-1);
+
+  cpr = COLORALLOC(ctx->nalloc,ctx->oalloc,nnz,ia,ja);
+  if (cpr == NULL) 
+    return (-1);
+
+  COLORFREE(ctx->ls.cpr);
+  ctx->ls.cpr = cpr;
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina declara que F pode ser chamada ao mesmo    */
+/* tempo por varias threads (com o mesmo data) : as       */
+/* colunas das jacobianas aproximadas (SETDHAPPROX,       */
+/* DFAPPROX, DFCOLOR e, portanto, rankneighbourhood) sao  */
+/* divididas entre nthreads threads, cada uma com copias  */
+/* privadas do ponto e dos residuos. Com nthreads <= 1 o  */
+/* modo sequencial e restaurado. Retorna 0, ou -1 se nao  */
+/* ha memoria disponivel (o contexto fica sequencial).    */
+/* ****************************************************** */
+
+int 
+SETTHREADS (
+gsdae_ctx *ctx,
+int        nthreads
+)
+{
+  if (ctx == NULL) 
+    return (-1);
+
+  FDFREE(ctx->ls.fd);
+  ctx->ls.fd = NULL;
+
+  if (nthreads <= 1) 
+    return (0);
+
+  ctx->ls.fd = FDALLOC(ctx->nalloc,ctx->oalloc,nthreads);
+  if (ctx->ls.fd == NULL) 
+    return (-1);
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina informa a rotina                           */
+/*                                                        */
+/*   Fb(o,n,m,xs,ys,fs,data)                              */
+/*                                                        */
+/* que avalia F nos m pontos (xs[l],ys[l]), l = 1..m, em  */
+/* uma chamada : fs[l][i] = F(o,n,xs[l],ys[l])[i], com    */
+/* ys[l][k][i] como y em F. As colunas das jacobianas     */
+/* aproximadas (SETDHAPPROX, DFAPPROX, DFCOLOR e,         */
+/* portanto, rankneighbourhood) passam a ser avaliadas em */
+/* lotes de ate mmax pontos (mmax <= 0 : GSDAE_FBMAX),    */
+/* e Fb pode vetorizar ou dividir entre threads os pontos */
+/* de um lote. Fb tem prioridade sobre SETTHREADS e F     */
+/* continua sendo usada nos demais pontos. Com Fb = NULL  */
+/* as avaliacoes voltam a ser individuais. Retorna 0, ou  */
+/* -1 se nao ha memoria disponivel.                       */
+/* ****************************************************** */
+
+int 
+SETFBATCH (
+gsdae_ctx *ctx,
+void     (*Fb)(int,int,int,vreal,mmreal,mreal,void *),
+int        mmax
+)
+{
+  if (ctx == NULL) 
+    return (-1);
+
+  FBFREE(ctx->ls.fb);
+  ctx->ls.fb = NULL;
+
+  if (Fb == NULL) 
+    return (0);
+
+  if (mmax <= 0) 
+    mmax = GSDAE_FBMAX;
+  mmax = MIN2(mmax,(ctx->oalloc+1)*ctx->nalloc+1);
+
+  ctx->ls.fb = FBALLOC(ctx->nalloc,ctx->oalloc,mmax,Fb);
+  if (ctx->ls.fb == NULL) 
+    return (-1);
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina divide as fatoracoes densas de dimensao    */
+/* maior ou igual a nmin (nmin <= 0 : GSDAE_QRMIN) entre  */
+/* nthreads threads : as atualizacoes das colunas a       */
+/* direita de cada bloco de QRH e LUH (DH em masterstep)  */
+/* e as rotacoes de QR2 (B em settau e rankneighbourhood) */
+/* sao aplicadas em ladrilhos de GSDAE_QRTILE colunas. O  */
+/* pivoteamento, a estimativa da condicao e o resultado   */
+/* sao os mesmos do modo sequencial. Com nthreads <= 1 o  */
+/* modo sequencial e restaurado. Retorna 0, ou -1 se nao  */
+/* ha memoria disponivel (o contexto fica sequencial).    */
+/* ****************************************************** */
+
+int 
+SETQRTHREADS (
+gsdae_ctx *ctx,
+int        nthreads,
+int        nmin
+)
+{
+  if (ctx == NULL) 
+    return (-1);
+
+  QRTHFREE(ctx->ls.qt);
+  ctx->ls.qt = NULL;
+
+  if (nthreads <= 1) 
+    return (0);
+
+  ctx->ls.qt = QRTHALLOC((ctx->oalloc+1)*ctx->nalloc+1,ctx->ls.nb,
+                         nthreads,nmin);
+  if (ctx->ls.qt == NULL) 
+    return (-1);
+
+  return (0);
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina detecta o padrao de DF no ponto (x,y) com  */
+/* PATTERNDETECT, guarda-o no contexto (ctx->pat) e o     */
+/* informa a SETPATTERN. Se file != NULL o padrao e lido  */
+/* desse arquivo quando ele existe e corresponde a EAD;   */
+/* caso contrario e detectado e gravado nele. Retorna 0,  */
+/* ou -1 se o padrao nao pode ser obtido.                 */
+/* ****************************************************** */
+
+int 
+DETECTPATTERN (
+gsdae_ctx *ctx,
+real       x,
+mreal      y,
+char      *file
+)
+{
+  pattern *pt; /* padrao detectado ou lido */
+
+  if ((ctx == NULL) || (y == NULL)) 
+    return (-1);
+
+  pt = NULL;
+  if (file != NULL) 
+    pt = PATTERNREAD(file,ctx->nalloc,ctx->oalloc);
+
+  if (pt == NULL) {
+    pt = PATTERNDETECT(ctx->nalloc,ctx->oalloc,x,y,ctx->F,ctx->data);
+    if (pt == NULL) 
+      return (-1);
+    /* uma falha na gravacao apenas impede o reaproveitamento */
+    if (file != NULL) 
+      PATTERNWRITE(file,pt);
+  }
+
+  PATTERNFREE(ctx->pat);
+  ctx->pat = pt;
+
+  return (SETPATTERN(ctx,pt->nnz,pt->ia,pt->ja));
+}
+
+
+
+/* ****************************************************** */
+/* rotinas F e DF de um contexto com jacobiana esparsa :  */
+/* SPARSEDF espalha o padrao em DFy para as rotinas que   */
+/* usam a jacobiana densa (settau e rankneighbourhood)    */
+/* ****************************************************** */
+
+void 
+SPARSEF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+)
+{
+  sparse *sp; /* jacobiana esparsa */
+
+  sp = ((gsdae_ctx *) data)->ls.sp;
+  sp->F(o,n,x,y,delta,sp->data);
+
+  return;
+}
+
+
+void 
+SPARSEDF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+)
+{
+  int     i,j,k,l; /* variaveis auxiliares para controle de lacos */
+  sparse *sp;      /* jacobiana esparsa                           */
+
+  sp = ((gsdae_ctx *) data)->ls.sp;
+  sp->DFS(o,n,x,y,DFx,sp->val,sp->data);
+
+  for (k = 0; k <= o; k++) 
+    for (j = 1; j <= n; j++) 
+      for (i = 1; i <= n; i++) 
+        DFy[k][j][i] = 0.0;
+
+  for (i = 1; i <= n; i++) 
+    for (l = sp->ia[i]; l < sp->ia[i+1]; l++) 
+      for (k = 0; k <= o; k++) 
+        DFy[k][sp->ja[l]][i] += sp->val[k][l];
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina define os vetores e matrizes do contexto.  */
+/* Se ar = NULL os dados sao alocados com malloc. Caso    */
+/* contrario sao retirados da arena ar; se a arena ainda  */
+/* nao foi alocada (ar->base = NULL) apenas o tamanho     */
+/* necessario e acumulado em ar->used.                    */
+/* ****************************************************** */
+
+void 
+CTXARRAYS (
+gsdae_ctx *ctx,
+int        n,
+int        o,
+arena     *ar
+)
+{
+  int dim;  /* dimensao do sistema aumentado   */
+  int ddim; /* dimensao de DH e Q              */
+  int fdim; /* dimensao de DFy                 */
+  int nb;   /* linhas da area de trabalho W    */
+
+  dim  = (o+1)*n+1;
+  ddim = (ctx->ls.sp != NULL) ? n+1 : dim;
+  fdim = n;
+  nb   = GSDAE_NB;
+
+  /* o corretor de Newton-Krylov nao monta DH nem DFy */
+  if (ctx->ls.kr != NULL) {
+    ddim = 1;
+    fdim = 1;
+    nb   = 1;
+  }
+
+  if (ar == NULL) {
+
+    /* aloca vetores inteiros */
+    ctx->p       = (vint)   ALLOCVINT(n);
+    ctx->q       = (vint)   ALLOCVINT(n);
+    ctx->paux    = (vint)   ALLOCVINT(n);
+    ctx->qaux    = (vint)   ALLOCVINT(n);
+
+    /* aloca vetores reais */
+    ctx->DFx     = (vreal)  ALLOCVREAL(n);
+    ctx->u       = (vreal)  ALLOCVREAL(dim);
+    ctx->delta   = (vreal)  ALLOCVREAL(n+1);
+    ctx->deltax  = (vreal)  ALLOCVREAL(n+1);
+    ctx->deltah  = (vreal)  ALLOCVREAL(dim);
+    ctx->deltahx = (vreal)  ALLOCVREAL(dim);
+    ctx->psi     = (vreal)  ALLOCVREAL(8);
+    ctx->alfa    = (vreal)  ALLOCVREAL(8);
+    ctx->beta    = (vreal)  ALLOCVREAL(8);
+    ctx->gama    = (vreal)  ALLOCVREAL(8);
+    ctx->sigma   = (vreal)  ALLOCVREAL(8);
+    ctx->phix    = (vreal)  ALLOCVREAL(8);
+    ctx->ftol    = (vreal)  ALLOCVREAL(n);
+
+    /* aloca matrizes bidimensionais */
+    ctx->y       = (mreal)  ALLOCMREAL(o,n);
+    ctx->tauy    = (mreal)  ALLOCMREAL(o,n);
+    ctx->DH      = (mreal)  ALLOCMREAL(ddim,ddim);
+    ctx->cy      = (mreal)  ALLOCMREAL(o,n);
+    ctx->cyx     = (mreal)  ALLOCMREAL(o,n);
+    ctx->pcy     = (mreal)  ALLOCMREAL(o,n);
+    ctx->pdcy    = (mreal)  ALLOCMREAL(o,n);
+    ctx->dy      = (mreal)  ALLOCMREAL(o,n);
+    ctx->ccy     = (mreal)  ALLOCMREAL(o,n);
+    ctx->yx      = (mreal)  ALLOCMREAL(o,n);
+    ctx->Q       = (mreal)  ALLOCMREAL(ddim,ddim);
+    ctx->atoly   = (mreal)  ALLOCMREAL(o,n);
+    ctx->rtoly   = (mreal)  ALLOCMREAL(o,n);
+    ctx->wty     = (mreal)  ALLOCMREAL(o,n);
+    ctx->Ey      = (mreal)  ALLOCMREAL(o,n);
+
+    /* aloca matrizes tridimensionais */
+    ctx->DFy     = (mmreal) ALLOCMMREAL(o,fdim,fdim);
+    ctx->phiy    = (mmreal) ALLOCPHI(8,o,n);
+
+    /* resolvedor linear */
+    ctx->ls.nb   = GSDAE_NB;
+    ctx->ls.piv  = (vint)   ALLOCVINT(dim);
+    ctx->ls.W    = (mreal)  ALLOCMREAL(nb,dim);
+    ctx->ls.P    = (mreal)  ALLOCMREAL(o,n);
+    ctx->ls.X    = (mreal)  ALLOCMREAL(o,n);
+    ctx->ls.nrm  = (vreal)  ALLOCVREAL(dim);
+    ctx->ls.BS   = (mreal)  ALLOCMREAL(GSDAE_NBROY,dim);
+    ctx->ls.BD   = (mreal)  ALLOCMREAL(GSDAE_NBROY,dim);
+    ctx->ls.bh   = (vreal)  ALLOCVREAL(dim);
+
+    return;
+
+  }
+
+  /* reiniciando a arena */
+  ar->used = 0;
+
+  /* as matrizes mais utilizadas (QR, GIVENS, predictor e */
+  /* update) ficam no inicio do bloco                     */
+  ctx->DH      = (mreal)  ARENAMREAL(ar,ddim,ddim);
+  ctx->Q       = (mreal)  ARENAMREAL(ar,ddim,ddim);
+  ctx->DFy     = (mmreal) ARENAMMREAL(ar,o,fdim,fdim);
+  ctx->phiy    = (mmreal) ARENAPHI(ar,8,o,n);
+
+  /* vetores reais */
+  ctx->u       = (vreal)  ARENAVREAL(ar,dim);
+  ctx->deltah  = (vreal)  ARENAVREAL(ar,dim);
+  ctx->deltahx = (vreal)  ARENAVREAL(ar,dim);
+  ctx->DFx     = (vreal)  ARENAVREAL(ar,n);
+  ctx->delta   = (vreal)  ARENAVREAL(ar,n+1);
+  ctx->deltax  = (vreal)  ARENAVREAL(ar,n+1);
+  ctx->ftol    = (vreal)  ARENAVREAL(ar,n);
+  ctx->psi     = (vreal)  ARENAVREAL(ar,8);
+  ctx->alfa    = (vreal)  ARENAVREAL(ar,8);
+  ctx->beta    = (vreal)  ARENAVREAL(ar,8);
+  ctx->gama    = (vreal)  ARENAVREAL(ar,8);
+  ctx->sigma   = (vreal)  ARENAVREAL(ar,8);
+  ctx->phix    = (vreal)  ARENAVREAL(ar,8);
+
+  /* matrizes bidimensionais */
+  ctx->y       = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->tauy    = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->cy      = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->cyx     = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->pcy     = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->pdcy    = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->dy      = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->ccy     = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->yx      = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->atoly   = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->rtoly   = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->wty     = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->Ey      = (mreal)  ARENAMREAL(ar,o,n);
+
+  /* vetores inteiros */
+  ctx->p       = (vint)   ARENAVINT(ar,n);
+  ctx->q       = (vint)   ARENAVINT(ar,n);
+  ctx->paux    = (vint)   ARENAVINT(ar,n);
+  ctx->qaux    = (vint)   ARENAVINT(ar,n);
+
+  /* resolvedor linear */
+  ctx->ls.nb   = GSDAE_NB;
+  ctx->ls.piv  = (vint)   ARENAVINT(ar,dim);
+  ctx->ls.W    = (mreal)  ARENAMREAL(ar,nb,dim);
+  ctx->ls.P    = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->ls.X    = (mreal)  ARENAMREAL(ar,o,n);
+  ctx->ls.nrm  = (vreal)  ARENAVREAL(ar,dim);
+  ctx->ls.BS   = (mreal)  ARENAMREAL(ar,GSDAE_NBROY,dim);
+  ctx->ls.BD   = (mreal)  ARENAMREAL(ar,GSDAE_NBROY,dim);
+  ctx->ls.bh   = (vreal)  ARENAVREAL(ar,dim);
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/* Esta rotina libera um contexto alocado por ALLOCCTX    */
+/* ou ALLOCCTXMODE                                        */
+/* ****************************************************** */
+
+void 
+FREECTX ( 
+gsdae_ctx *ctx
+)
+{
+  int n, o; /* dimensoes alocadas */
+  int ddim; /* dimensao de DH e Q */
+  int fdim; /* dimensao de DFy    */
+  int nb;   /* linhas de W        */
+
+  if (ctx == NULL) 
+    return;
+
+  n = ctx->nalloc;
+  o = ctx->oalloc;
+
+  /* dimensoes de DH, Q, DFy e W (veja CTXARRAYS) */
+  ddim = (ctx->ls.sp != NULL) ? n+1 : (o+1)*n+1;
+  fdim = n;
+  nb   = GSDAE_NB;
+  if (ctx->ls.kr != NULL) {
+    ddim = 1;
+    fdim = 1;
+    nb   = 1;
+  }
+
+  /* corretor de Newton-Krylov */
+  KRYLOVFREE(ctx->ls.kr);
+  ctx->ls.kr = NULL;
+
+  /* jacobiana esparsa */
+  SPARSEFREE(ctx->ls.sp);
+  ctx->ls.sp = NULL;
+
+  /* coloracao de DFy */
+  COLORFREE(ctx->ls.cpr);
+  ctx->ls.cpr = NULL;
+
+  /* padrao detectado */
+  PATTERNFREE(ctx->pat);
+  ctx->pat = NULL;
+
+  /* threads das jacobianas aproximadas */
+  FDFREE(ctx->ls.fd);
+  ctx->ls.fd = NULL;
+
+  /* threads das fatoracoes densas */
+  QRTHFREE(ctx->ls.qt);
+  ctx->ls.qt = NULL;
+
+  /* lotes de F (SETFBATCH) */
+  FBFREE(ctx->ls.fb);
+  ctx->ls.fb = NULL;
+
+  /* os dados retirados da arena sao liberados de uma vez */
+  if (ctx->mode != GSDAE_MALLOC) {
+    ARENAFREE(&(ctx->mem));
+    free(ctx);
+    return;
+  }
+
+  /* desaloca vetores inteiros */
+  ctx->p       = (vint)  FREEVINT(n,ctx->p);
+  ctx->q       = (vint)  FREEVINT(n,ctx->q);
+  ctx->paux    = (vint)  FREEVINT(n,ctx->paux);
+  ctx->qaux    = (vint)  FREEVINT(n,ctx->qaux);
+
+  /* desaloca vetores reais */
+  ctx->DFx     = (vreal) FREEVREAL(n,ctx->DFx);
+  ctx->u       = (vreal) FREEVREAL((o+1)*n+1,ctx->u);
+  ctx->delta   = (vreal) FREEVREAL(n+1,ctx->delta);
+  ctx->deltax  = (vreal) FREEVREAL(n+1,ctx->deltax);
+  ctx->deltah  = (vreal) FREEVREAL((o+1)*n+1,ctx->deltah);
+  ctx->deltahx = (vreal) FREEVREAL((o+1)*n+1,ctx->deltahx);
+  ctx->psi     = (vreal) FREEVREAL(8,ctx->psi);
+  ctx->alfa    = (vreal) FREEVREAL(8,ctx->alfa);
+  ctx->beta    = (vreal) FREEVREAL(8,ctx->beta);
+  ctx->gama    = (vreal) FREEVREAL(8,ctx->gama);
+  ctx->sigma   = (vreal) FREEVREAL(8,ctx->sigma);
+  ctx->phix    = (vreal) FREEVREAL(8,ctx->phix);
+  ctx->ftol    = (vreal) FREEVREAL(n,ctx->ftol);
+   
+  /* desaloca matrizes bidimensionais */
+  ctx->y       = (mreal) FREEMREAL(o,n,ctx->y);
+  ctx->tauy    = (mreal) FREEMREAL(o,n,ctx->tauy); 
+  ctx->DH      = (mreal) FREEMREAL(ddim,ddim,ctx->DH);
+  ctx->cy      = (mreal) FREEMREAL(o,n,ctx->cy);
+  ctx->cyx     = (mreal) FREEMREAL(o,n,ctx->cyx);
+  ctx->pcy     = (mreal) FREEMREAL(o,n,ctx->pcy);
+  ctx->pdcy    = (mreal) FREEMREAL(o,n,ctx->pdcy);
+  ctx->dy      = (mreal) FREEMREAL(o,n,ctx->dy);
+  ctx->ccy     = (mreal) FREEMREAL(o,n,ctx->ccy);
+  ctx->yx      = (mreal) FREEMREAL(o,n,ctx->yx);
+  ctx->Q       = (mreal) FREEMREAL(ddim,ddim,ctx->Q);
+  ctx->atoly   = (mreal) FREEMREAL(o,n,ctx->atoly);
+  ctx->rtoly   = (mreal) FREEMREAL(o,n,ctx->rtoly);
+  ctx->wty     = (mreal) FREEMREAL(o,n,ctx->wty);
+  ctx->Ey      = (mreal) FREEMREAL(o,n,ctx->Ey);
+  
+  /* desaloca matrizes tridimensionais */
+  ctx->DFy     = (mmreal) FREEMMREAL(o,fdim,fdim,ctx->DFy);
+  ctx->phiy    = (mmreal) FREEPHI(8,ctx->phiy);
+
+  /* desaloca o resolvedor linear */
+  ctx->ls.piv  = (vint)  FREEVINT((o+1)*n+1,ctx->ls.piv);
+  ctx->ls.W    = (mreal) FREEMREAL(nb,(o+1)*n+1,ctx->ls.W);
+  ctx->ls.P    = (mreal) FREEMREAL(o,n,ctx->ls.P);
+  ctx->ls.X    = (mreal) FREEMREAL(o,n,ctx->ls.X);
+  ctx->ls.nrm  = (vreal) FREEVREAL((o+1)*n+1,ctx->ls.nrm);
+  ctx->ls.BS   = (mreal) FREEMREAL(GSDAE_NBROY,(o+1)*n+1,ctx->ls.BS);
+  ctx->ls.BD   = (mreal) FREEMREAL(GSDAE_NBROY,(o+1)*n+1,ctx->ls.BD);
+  ctx->ls.bh   = (vreal) FREEVREAL((o+1)*n+1,ctx->ls.bh);
+  
+  free(ctx);
+
+  return;
+}
+
+
+/* ****************************************************** */
+/*                                                        */
+/*                 Pool de threads                        */
+/*                                                        */
+/*  O pool executa uma mesma tarefa task(id,arg) em       */
+/*  nthreads threads, onde id = 0..nthreads-1. A thread   */
+/*  que chama POOLRUN executa a tarefa com id = 0 e as    */
+/*  demais threads sao criadas uma unica vez em POOLALLOC */
+/*  e ficam bloqueadas ate a proxima chamada de POOLRUN.  */
+/*  POOLRUN retorna somente apos todas as threads         */
+/*  terminarem a tarefa.                                  */
+/*                                                        */
+/* ****************************************************** */
+
+pool *
+POOLALLOC (
+int nthreads
+)
+{
+  pool *pl;  /* pool alocado          */
+  int   i;   /* variavel auxiliar     */
+
+  pl = (pool *) calloc(1,sizeof(pool));
+  if (pl == NULL) {
+    printf("POOLALLOC : nao alocado\n");
+    return (NULL);
+  }
+
+  /* a thread que chama POOLRUN e a thread 0 */
+  pl->nthreads = MAX2(nthreads,1);
+  pl->nstarted = 0;
+
+  pthread_mutex_init(&(pl->lock),NULL);
+  pthread_cond_init(&(pl->start),NULL);
+  pthread_cond_init(&(pl->finish),NULL);
+
+  if (pl->nthreads == 1) 
+    return (pl);
+
+  pl->thread = (pthread_t *) malloc(pl->nthreads*sizeof(pthread_t));
+  if (pl->thread == NULL) {
+    printf("POOLALLOC : nao alocado\n");
+    pl->nthreads = 1;
+    return (pl);
+  }
+
+  /* criando as threads auxiliares */
+  for (i = 1; i < pl->nthreads; i++) 
+    if (pthread_create(&(pl->thread[i]),NULL,POOLWORKER,(void *) pl) != 0) 
+      break;
+
+  /* utilizando somente as threads criadas */
+  pthread_mutex_lock(&(pl->lock));
+  pl->nthreads = i;
+  pthread_mutex_unlock(&(pl->lock));
+
+  return (pl);
+}
+
+
+
+void *
+POOLWORKER (
+void *arg
+)
+{
+  pool  *pl;          /* pool da thread              */
+  int    id;          /* identificador da thread     */
+  int    generation;  /* ultima tarefa executada     */
+  void (*task)(int,void *);
+  void  *targ;
+
+  pl = (pool *) arg;
+
+  pthread_mutex_lock(&(pl->lock));
+  id         = ++(pl->nstarted);
+
+  /* toda thread parte da geracao inicial do pool, de modo */
+  /* que uma tarefa disparada antes da thread iniciar nao  */
+  /* seja perdida                                          */
+  generation = 0;
+
+  while (1) {
+
+    /* esperando por uma nova tarefa */
+    while ((pl->generation == generation) && !(pl->stop)) 
+      pthread_cond_wait(&(pl->start),&(pl->lock));
+
+    if (pl->stop) 
+      break;
+
+    generation = pl->generation;
+    task       = pl->task;
+    targ       = pl->arg;
+
+    /* as threads alem de nthreads nao participam */
+    if (id >= pl->nthreads) 
+      continue;
+
+    pthread_mutex_unlock(&(pl->lock));
+
+    /* executando a tarefa */
+    task(id,targ);
+
+    pthread_mutex_lock(&(pl->lock));
+
+    /* avisando o termino da tarefa */
+    if (--(pl->running) == 0) 
+      pthread_cond_signal(&(pl->finish));
+
+  }
+
+  pthread_mutex_unlock(&(pl->lock));
+
+  return (NULL);
+}
+
+
+
+void 
+POOLRUN (
+pool  *pl,
+void (*task)(int,void *),
+void  *arg
+)
+{
+  /* sem threads auxiliares a tarefa e executada diretamente */
+  if ((pl == NULL) || (pl->nthreads == 1)) {
+    task(0,arg);
+    return;
+  }
+
+  /* disparando a tarefa nas threads auxiliares */
+  pthread_mutex_lock(&(pl->lock));
+  pl->task    = task;
+  pl->arg     = arg;
+  pl->running = pl->nthreads-1;
+  pl->generation++;
+  pthread_cond_broadcast(&(pl->start));
+  pthread_mutex_unlock(&(pl->lock));
+
+  /* a thread que chama executa a parte 0 */
+  task(0,arg);
+
+  /* esperando o termino das threads auxiliares */
+  pthread_mutex_lock(&(pl->lock));
+  while (pl->running > 0) 
+    pthread_cond_wait(&(pl->finish),&(pl->lock));
+  pthread_mutex_unlock(&(pl->lock));
+
+  return;
+}
+
+
+
+void 
+POOLFREE (
+pool *pl
+)
+{
+  int i, nthreads; /* variaveis auxiliares */
+
+  if (pl == NULL) 
+    return;
+
+  /* parando as threads auxiliares */
+  pthread_mutex_lock(&(pl->lock));
+  nthreads = pl->nthreads;
+  pl->stop = 1;
+  pthread_cond_broadcast(&(pl->start));
+  pthread_mutex_unlock(&(pl->lock));
+
+  for (i = 1; i < nthreads; i++) 
+    pthread_join(pl->thread[i],NULL);
+
+  pthread_mutex_destroy(&(pl->lock));
+  pthread_cond_destroy(&(pl->start));
+  pthread_cond_destroy(&(pl->finish));
+
+  free(pl->thread);
+  free(pl);
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/*                                                        */
+/*                 Rotina GSDAEBATCH                      */
+/*                                                        */
+/*  Esta rotina integra m instancias independentes de uma */
+/*  mesma EAD de dimensao n e ordem o, definida pelas     */
+/*  rotinas F e DF, utilizando nthreads threads. Cada     */
+/*  instancia inst[i] (i = 0..m-1) contem o ponto inicial */
+/*  (s,x,y), o ponto final send, os passos, as            */
+/*  tolerancias, o vetor info (equivalente a infoinput de */
+/*  GSDAE, infoinput[1] e ignorado) e os dados do usuario */
+/*  data repassados para F e DF.                          */
+/*                                                        */
+/*  Cada instancia e integrada ate send com chamadas      */
+/*  sucessivas de GSDAECTX enquanto o valor retornado for */
+/*  positivo (singularidades e mudancas de posto ou       */
+/*  ordem). Na saida (s,x,y) contem o ultimo ponto, status*/
+/*  o ultimo valor retornado por GSDAECTX e os demais     */
+/*  campos os contadores de STATISTICSCTX, o posto e a    */
+/*  ordem final.                                          */
+/*                                                        */
+/*  Cada thread possui o seu proprio contexto, reutilizado*/
+/*  em todas as instancias que ela integra. As instancias */
+/*  sao distribuidas em faixas contiguas entre as threads;*/
+/*  cada thread retira blocos do inicio da sua faixa, com */
+/*  tamanho proporcional ao inverso do custo medio (numero*/
+/*  de avaliacoes de F e da jacobiana) das instancias ja  */
+/*  integradas por ela, e quando a sua faixa termina rouba*/
+/*  a metade final da maior faixa restante. Como cada     */
+/*  instancia e integrada do inicio ao fim em um contexto */
+/*  reinicializado, o resultado nao depende do numero de  */
+/*  threads.                                              */
+/*                                                        */
+/*  O valor retornado e o numero de instancias com status */
+/*  negativo.                                             */
+/*                                                        */
+/* ****************************************************** */
+
+int 
+GSDAEBATCH (
+int         n,
+int         o,
+int         m,
+gsdae_inst *inst,
+void      (*F)(int,int,real,mreal,vreal,void *),
+void      (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+int         nthreads
+)
+{
+  batch  bt;       /* dados compartilhados pelas threads */
+  pool  *pl;       /* pool de threads                    */
+  int    i, nerr;  /* variaveis auxiliares               */
+
+  if ((m <= 0) || (inst == NULL)) 
+    return (0);
+
+  /* nao ha necessidade de mais threads que instancias */
+  nthreads = MAX2(1,MIN2(nthreads,m));
+
+  bt.n        = n;
+  bt.o        = o;
+  bt.m        = m;
+  bt.inst     = inst;
+  bt.F        = F;
+  bt.DF       = DF;
+
+  bt.range = (batchrange *) calloc(nthreads,sizeof(batchrange));
+  if (bt.range == NULL) {
+    printf("GSDAEBATCH : nao alocado\n");
+    for (i = 0; i < m; i++) 
+      inst[i].status = -1;
+    return (m);
+  }
+
+  /* os nucleos vetoriais sao escolhidos antes das threads */
+  KERNINIT();
+
+  pl = POOLALLOC(nthreads);
+  nthreads = (pl == NULL) ? 1 : pl->nthreads;
+  bt.nthreads = nthreads;
+
+  /* dividindo as instancias em faixas contiguas */
+  for (i = 0; i < nthreads; i++) {
+    bt.range[i].lo   = (int) (((long) i*m)/nthreads);
+    bt.range[i].hi   = (int) (((long) (i+1)*m)/nthreads);
+    pthread_mutex_init(&(bt.range[i].lock),NULL);
+  }
+
+  /* integrando as instancias */
+  POOLRUN(pl,BATCHTASK,(void *) &bt);
+
+  POOLFREE(pl);
+  for (i = 0; i < nthreads; i++) 
+    pthread_mutex_destroy(&(bt.range[i].lock));
+  free(bt.range);
+
+  /* contando as instancias com erro */
+  for (i = 0, nerr = 0; i < m; i++) 
+    if (inst[i].status < 0) 
+      nerr++;
+
+  return (nerr);
+}
+
+
+
+/* ****************************************************** */
+/* Tarefa executada por cada thread em GSDAEBATCH         */
+/* ****************************************************** */
+
+void 
+BATCHTASK (
+int   id,
+void *arg
+)
+{
+  batch      *bt;         /* dados compartilhados        */
+  batchrange *own;        /* faixa da thread             */
+  gsdae_ctx  *ctx;        /* contexto da thread          */
+  vint        ii, io;     /* infoinput e infooutput      */
+  int         lo, hi;     /* bloco retirado da faixa     */
+  int         i, v, vmax; /* variaveis auxiliares        */
+  int         chunk;      /* tamanho do bloco            */
+  int         left, lmax; /* instancias restantes        */
+  double      cost;       /* custo das instancias        */
+  int         ndone;      /* instancias integradas       */
+  real        target;     /* custo desejado de um bloco  */
+
+  bt  = (batch *) arg;
+  own = &(bt->range[id]);
+
+  /* custo desejado para cada bloco em avaliacoes de F */
+  target = 2.0e4;
+  cost   = 0.0;
+  ndone  = 0;
+
+  /* alocando o contexto e os vetores de informacao na */
+  /* propria thread                                    */
+  ctx = ALLOCCTX(bt->n,bt->o,bt->F,bt->DF,NULL);
+  ii  = ALLOCVINT(2*bt->n+10);
+  io  = ALLOCVINT(2*bt->n+10);
+
+  while (1) {
+
+    /* retirando um bloco do inicio da propria faixa */
+    pthread_mutex_lock(&(own->lock));
+    left = own->hi-own->lo;
+    if (left > 0) {
+      if (ndone == 0) 
+        chunk = 1;
+      else 
+        chunk = (int) MAX2(1.0,target*ndone/MAX2(cost,1.0));
+      chunk   = MIN2(chunk,MAX2(1,left/2));
+      lo      = own->lo;
+      hi      = lo+chunk;
+      own->lo = hi;
+    }
+    pthread_mutex_unlock(&(own->lock));
+
+    if (left <= 0) {
+
+      /* a faixa terminou : roubando a metade final da */
+      /* maior faixa restante                          */
+      lo = hi = 0;
+      do {
+        vmax = -1;
+        lmax = 0;
+        for (i = 1; i < bt->nthreads; i++) {
+          v = (id+i) % bt->nthreads;
+          pthread_mutex_lock(&(bt->range[v].lock));
+          left = bt->range[v].hi-bt->range[v].lo;
+          pthread_mutex_unlock(&(bt->range[v].lock));
+          if (left > lmax) {
+            lmax = left;
+            vmax = v;
+          }
+        }
+        if (vmax < 0) 
+          break;
+        pthread_mutex_lock(&(bt->range[vmax].lock));
+        left = bt->range[vmax].hi-bt->range[vmax].lo;
+        if (left > 0) {
+          hi = bt->range[vmax].hi;
+          lo = hi-(left+1)/2;
+          bt->range[vmax].hi = lo;
+        }
+        pthread_mutex_unlock(&(bt->range[vmax].lock));
+      } while (lo == hi);
+
+      /* nao ha mais instancias */
+      if (lo == hi) 
+        break;
+
+      /* o bloco roubado passa a ser a propria faixa */
+      pthread_mutex_lock(&(own->lock));
+      own->lo = lo;
+      own->hi = hi;
+      pthread_mutex_unlock(&(own->lock));
+      continue;
+
+    }
+
+    /* integrando o bloco */
+    for (i = lo; i < hi; i++) {
+      BATCHONE(ctx,bt->n,bt->o,&(bt->inst[i]),ii,io);
+      cost += bt->inst[i].nfunc+bt->inst[i].njac;
+      ndone++;
+    }
+
+  }
+
+  FREECTX(ctx);
+  FREEVINT(2*bt->n+10,ii);
+  FREEVINT(2*bt->n+10,io);
+
+  return;
+}
+
+
+
+/* ****************************************************** */
+/* Integracao de uma instancia de GSDAEBATCH no contexto  */
+/* ctx utilizando ii e io como infoinput e infooutput     */
+/* ****************************************************** */
+
+void 
+BATCHONE (
+gsdae_ctx  *ctx,
+int         n,
+int         o,
+gsdae_inst *in,
+vint        ii,
+vint        io
+)
+{
+  int  i;       /* variavel auxiliar                   */
+  int  cont;    /* numero de chamadas de GSDAECTX      */
+  int  maxcont; /* numero maximo de chamadas           */
+  real len;     /* comprimento de arco                 */
+
+  /* contexto nao alocado */
+  if ((ctx == NULL) || (ii == NULL) || (io == NULL)) {
+    in->status = -1;
+    return;
+  }
+
+  /* copiando as informacoes de entrada da instancia */
+  for (i = 0; i <= 2*n+10; i++) {
+    ii[i] = (in->info != NULL) ? in->info[i] : 0;
+    io[i] = 0;
   }
 
+  /* definindo a primeira chamada */
+  ii[1] = 0;
+
+  /* definindo os dados do usuario da instancia */
+  ctx->data = in->data;
+
+  /* integrando ate send ou ate ocorrer um erro */
+  maxcont = 1000;
+  cont    = 0;
+  do {
+    in->status = GSDAECTX(ctx,n,o,in->h,in->hmin,in->hmax,in->cdmax,
+                          &(in->s),in->send,&(in->x),in->y,
+                          in->atolx,in->atoly,in->rtolx,in->rtoly,
+                          in->ftol,ii,io);
+    cont++;
+  } while ((in->status > 0) && (cont < maxcont));
+
+  /* copiando os contadores */
+  STATISTICSCTX(ctx,&len,&(in->nstep),&(in->nreject),&(in->nsuc),
+                &(in->nfunc),&(in->njac),&(in->nqr),&(in->nstart),
+                &(in->nfnew));
+  in->rank  = ctx->rank;
+  in->order = ctx->o;
+
   return;
 }
 
 
 
-/**********************************************************************/
-/* Esta rotina calcula um passo do metodo de Newton modificado para   */
-/* sistemas indeterminados do tipo F(x) = 0, que e dado por           */
-/*                  x_{k+1} = x_k - A^+ F(x_k)                        */
-/* onde A^+ e a inversa de Moore-Penrouse de A = DF(x_0).             */
-/*                                                                    */
-/* Tendo a decomposicao A^t = QR, entao :                             */
-/*                      A^+ = Q^t / R^(-t) \                          */
-/*                                \  0^t   /                          */
-/**********************************************************************/
+/* ****************************************************** */
+/*                                                        */
+/*                 Rotina GSDAEENSEMBLE                   */
+/*                                                        */
+/*  Esta rotina integra m instancias pequenas de uma      */
+/*  mesma EAD de dimensao n e ordem o em grupos de w      */
+/*  instancias avancadas juntas (em passo travado). As    */
+/*  variaveis de um grupo sao intercaladas : a variavel i */
+/*  da instancia l (l = 1..w) ocupa a posicao (i-1)*w+l,  */
+/*  e o grupo e integrado como uma unica EAD de dimensao  */
+/*  w*n cuja jacobiana e bloco-diagonal. A rotina F do    */
+/*  usuario avalia todas as instancias do grupo em uma    */
+/*  chamada :                                             */
+/*                                                        */
+/*    F(o,n,w,x,y,delta,data)                             */
+/*                                                        */
+/*  com y[k][(i-1)*w+l] e delta[(i-1)*w+l] (as instancias */
+/*  sao contiguas para cada variavel, o que permite       */
+/*  vetorizar F) e data[l] = inst[l].data. A jacobiana e  */
+/*  dada por                                              */
+/*                                                        */
+/*    DF(o,n,w,x,y,DFx,DFy,data)                          */
+/*                                                        */
+/*  com DFy[k][j][(i-1)*w+l] = d F_i / d y[k][j] e        */
+/*  DFx[(i-1)*w+l] = d F_i / d x na instancia l, ou por   */
+/*  diferencas finitas se DF = NULL : cada avaliacao de F */
+/*  perturba a variavel j de todas as instancias, e DF    */
+/*  custa (o+1)*n+2 chamadas de F para o grupo inteiro.   */
+/*                                                        */
+/*  O contexto do grupo e o de ALLOCCTXSPARSE, de modo    */
+/*  que para w*n >= GSDAE_SPMIN o sistema de Newton e     */
+/*  resolvido pela LU esparsa, cujo preenchimento fica    */
+/*  nos blocos das instancias; abaixo disso a fatoracao   */
+/*  densa de todo o grupo e usada. Com w <= 0 e usado o   */
+/*  menor multiplo da largura dos nucleos vetoriais       */
+/*  (SETSIMD) com w*n >= GSDAE_SPMIN.                     */
+/*                                                        */
+/*  O passo, a ordem e a aceitacao sao comuns ao grupo :  */
+/*  a norma do erro e tomada sobre todas as instancias    */
+/*  com as tolerancias atol e rtol divididas por sqrt(w), */
+/*  o que garante que o erro de cada instancia satisfaz   */
+/*  as suas proprias tolerancias. Como x e comum, as      */
+/*  instancias de um grupo tem o mesmo x inicial e o      */
+/*  mesmo ponto final xend (o xend de CSDAECTX; send nao  */
+/*  e usado); um grupo termina antes de w instancias      */
+/*  quando x ou xend mudam. s, h, hmin, hmax, cdmax e     */
+/*  info[5..8] sao os da primeira instancia do grupo.     */
+/*                                                        */
+/*  Na saida cada instancia recebe (s,x,y), o status e os */
+/*  contadores do grupo; s e o comprimento de arco do     */
+/*  grupo e rank e n se o grupo tem posto completo e o    */
+/*  posto do grupo caso contrario.                        */
+/*                                                        */
+/*  O valor retornado e o numero de instancias com status */
+/*  negativo.                                             */
+/*                                                        */
+/* ****************************************************** */
 
-void 
-NEWTON (
-int    n,
-mreal  Q,
-mreal  A,
-vreal  u,
-vreal  delta,
-real   ac
+int 
+GSDAEENSEMBLE (
+int         n,
+int         o,
+int         m,
+gsdae_inst *inst,
+void      (*F)(int,int,int,real,mreal,vreal,void **),
+void      (*DF)(int,int,int,real,mreal,vreal,mmreal,void **),
+int         w
 )
 {
-  int   i,j; /* variaveis auxiliares para controle de lacos         */
-  real  s;   /* variavel auxiliar para calculo da norma de A^+ F(u) */
+  ensemble   ens;      /* dados do grupo                    */
+  gsdae_ctx *ctx;      /* contexto do grupo                 */
+  int        i, l;     /* variaveis auxiliares              */
+  int        lo, wg;   /* primeira instancia e tamanho      */
+  int        wctx;     /* numero de instancias de ctx       */
+  int        lw;       /* largura dos nucleos vetoriais     */
+  int        nerr;     /* instancias com erro               */
+
+  if ((m <= 0) || (inst == NULL)) 
+    return (0);
 
-  /* calculo de u = Q^t y */
-  for (i = 1; i <= n; i++) {
-    for (j = 1, s = 0.0; j <= n; j++) s += Q[i][j]*delta[j];
-    u[i] = ac*s;
+  /* padrao : multiplo da largura dos nucleos vetoriais com */
+  /* w*n >= GSDAE_SPMIN, para que o grupo use a LU esparsa   */
+  if (w <= 0) {
+    KERNINIT();
+    lw = (kern.level == GSDAE_SIMD512) ? 8 : 
+         (kern.level == GSDAE_SIMDAVX2) ? 4 : 2;
+    w  = lw*((GSDAE_SPMIN+lw*n-1)/(lw*n));
   }
-  
-  /* calculo de A b = y, onde y <- b */
-  for (i = n; i >= 1; i--) {
-    for (j = i+1; j <= n; j++) u[i] -= A[i][j]*u[j];
-    u[i] /= A[i][i];
-  } 
 
-  return;
-}
+  ens.n     = n;
+  ens.o     = o;
+  ens.F     = F;
+  ens.DF    = DF;
+  ens.data  = (void **) calloc(w+1,sizeof(void *));
+  ens.DFy   = NULL;
+  ens.delta = NULL;
+  ens.daux  = NULL;
+  ens.dy    = NULL;
+  ens.w     = 0;
+  ctx       = NULL;
+  wctx      = 0;
+  if (ens.data == NULL) {
+    printf("GSDAEENSEMBLE : nao alocado\n");
+    for (i = 0; i < m; i++) 
+      inst[i].status = -1;
+    return (m);
+  }
 
+  for (lo = 0; lo < m; lo += wg) {
 
-real    
-PIVOT2 (
-int   n,
-int   k,
-mreal A,
-vint  p,
-vint  q
-) 
-{
-  int  i,j,imax,jmax;
-  real max;
+    /* formando o grupo : ate w instancias com x e xend iguais */
+    for (wg = 1; (wg < w) && (lo+wg < m) && 
+                 (inst[lo+wg].x == inst[lo].x) && 
+                 (inst[lo+wg].xend == inst[lo].xend); wg++)
+      ;
 
-  max  = fabs(A[p[k]][q[k]]);
-  imax = jmax = k;
+    /* o contexto e refeito apenas quando o tamanho muda */
+    if (wg != wctx) {
+      ENSEMBLEFREE(&ens,ctx);
+      ens.w = wg;
+      ctx   = ENSEMBLECTX(&ens);
+      wctx  = (ctx == NULL) ? 0 : wg;
+    }
 
-  for (i = k; i <= n; i++) 
-    for (j = k; j <= n; j++) 
-      if (fabs(A[p[i]][q[j]]) > max) {
-        imax = i;
-        jmax = j;
-        max  = fabs(A[p[i]][q[j]]);
-      }
+    for (l = 1; l <= wg; l++) 
+      ens.data[l] = inst[lo+l-1].data;
+    ENSEMBLEONE(ctx,&ens,inst+lo);
 
-  if (imax != k) {
-    i       = p[k];
-    p[k]    = p[imax];
-    p[imax] = i;
   }
 
-  if (jmax != k) {
-    j       = q[k];
-    q[k]    = q[jmax];
-    q[jmax] = j;
-  }
+  ENSEMBLEFREE(&ens,ctx);
+  free(ens.data);
 
-  return (max);
+  /* contando as instancias com erro */
+  for (i = 0, nerr = 0; i < m; i++) 
+    if (inst[i].status < 0) 
+      nerr++;
+
+  return (nerr);
 }
 
 
-void 
-GIVENS2 ( 
-int   n,
-int   i,
-int   k,
-mreal A,
-mreal Q,
-vint  p,
-vint  q,
-real  s1,
-real  s2
+
+/* ****************************************************** */
+/* Contexto de um grupo de GSDAEENSEMBLE com ens->w       */
+/* instancias : padrao bloco-diagonal intercalado (cada   */
+/* equacao (i,l) usa as variaveis (j,l), j = 1..n) e      */
+/* areas de trabalho de ENSEMBLEDF. Retorna NULL se nao   */
+/* ha memoria disponivel.                                 */
+/* ****************************************************** */
+
+gsdae_ctx *
+ENSEMBLECTX (
+ensemble *ens
 )
 {
-  int   j;   /* variavel auxiliar para controle de lacos  */
-  real  s,t; /* variaveis auxiliares para armazenar dados */
+  gsdae_ctx *ctx;     /* contexto do grupo          */
+  vint       ia, ja;  /* padrao de DFy do grupo     */
+  int        nw, nnz; /* dimensao e elementos       */
+  int        i, j, l; /* variaveis auxiliares       */
+  int        r, t;    /* linha e elemento           */
+
+  nw  = ens->w*ens->n;
+  nnz = nw*ens->n;
+  ia  = ALLOCVINT(nw+1);
+  ja  = ALLOCVINT(nnz);
+  if ((ia == NULL) || (ja == NULL)) {
+    printf("ENSEMBLECTX : nao alocado\n");
+    FREEVINT(nw+1,ia);
+    FREEVINT(nnz,ja);
+    return (NULL);
+  }
 
-  if (fabs(s2)+fabs(s1) > 0.0) {
-    if (fabs(s2) >= fabs(s1))
-      s  = sqrt(1.0+(s1/s2)*(s1/s2))*fabs(s2);
-    else
-      s  = sqrt(1.0+(s2/s1)*(s2/s1))*fabs(s1);
-    s1 = s1/s; s2 = s2/s; 
-    /* aplicando a matriz de rotacao em A e Q */
-    for (j = 1; j <= n; j++) {
-      s             =  s1*A[p[i]][q[j]]+s2*A[p[k]][q[j]];
-      t             = -s2*A[p[i]][q[j]]+s1*A[p[k]][q[j]];
-      A[p[i]][q[j]] =  s; 
-      A[p[k]][q[j]] =  t;
-      s             =  s1*Q[p[i]][q[j]]+s2*Q[p[k]][q[j]];
-      t             = -s2*Q[p[i]][q[j]]+s1*Q[p[k]][q[j]];
-      Q[p[i]][q[j]] =  s;
-      Q[p[k]][q[j]] =  t;
+  /* linha r = (i-1)*w+l : variaveis (j-1)*w+l */
+  for (i = 1, t = 1; i <= ens->n; i++) 
+    for (l = 1; l <= ens->w; l++) {
+      r     = (i-1)*ens->w+l;
+      ia[r] = t;
+      for (j = 1; j <= ens->n; j++) 
+        ja[t++] = (j-1)*ens->w+l;
     }
+  ia[nw+1] = t;
+
+  ctx = ALLOCCTXSPARSE(nw,ens->o,nnz,ia,ja,ENSEMBLEF,ENSEMBLEDF,
+                       (void *) ens);
+  FREEVINT(nw+1,ia);
+  FREEVINT(nnz,ja);
+
+  ens->DFy   = ALLOCMMREAL(ens->o,ens->n,nw);
+  ens->delta = ALLOCVREAL(nw);
+  ens->daux  = ALLOCVREAL(nw);
+  ens->dy    = ALLOCVREAL(ens->w);
+  if ((ctx == NULL) || (ens->DFy == NULL) || (ens->delta == NULL) || 
+      (ens->daux == NULL) || (ens->dy == NULL)) {
+    printf("ENSEMBLECTX : nao alocado\n");
+    ENSEMBLEFREE(ens,ctx);
+    return (NULL);
   }
 
-  return;
+  return (ctx);
 }
 
 
-int 
-QR2 (
-int    n,
-mreal  A,
-mreal  Q,
-vint   p,
-vint   q
+
+/* ****************************************************** */
+/* Libera o contexto e as areas de trabalho de um grupo   */
+/* ****************************************************** */
+
+void 
+ENSEMBLEFREE (
+ensemble  *ens,
+gsdae_ctx *ctx
 )
 {
-  int   i,k; 
+  int nw; /* dimensao do grupo */
+
+  nw = ens->w*ens->n;
+  if (ctx != NULL) 
+    FREECTX(ctx);
+  if (ens->DFy != NULL) 
+    FREEMMREAL(ens->o,ens->n,nw,ens->DFy);
+  if (ens->delta != NULL) 
+    FREEVREAL(nw,ens->delta);
+  if (ens->daux != NULL) 
+    FREEVREAL(nw,ens->daux);
+  if (ens->dy != NULL) 
+    FREEVREAL(ens->w,ens->dy);
+  ens->DFy   = NULL;
+  ens->delta = NULL;
+  ens->daux  = NULL;
+  ens->dy    = NULL;
 
-  for (i = 1; i <= n; i++) {
-    for (k = 1; k <= n; k++) Q[i][k] = 0.0;
-    p[i]    = i;
-    q[i]    = i;
-    Q[i][i] = 1.0;
-  } 
+  return;
+}
 
-  for (i = 1; i < n; i++) {
-    if (PIVOT2(n,i,A,p,q) < 1.0e-15) 
-      return (i-1);
-    for (k = i+1; k <= n; k++) 
-      GIVENS2(n,i,k,A,Q,p,q,A[p[i]][q[i]],A[p[k]][q[i]]);
+
+
+/* ****************************************************** */
+/* Integracao de um grupo de GSDAEENSEMBLE (in[0..w-1])   */
+/* no contexto ctx                                        */
+/* ****************************************************** */
+
+void 
+ENSEMBLEONE (
+gsdae_ctx  *ctx,
+ensemble   *ens,
+gsdae_inst *in
+)
+{
+  int   i, j, k, l;  /* variaveis auxiliares              */
+  int   n, o, w, nw; /* dimensoes                         */
+  int   cont;        /* numero de chamadas de CSDAECTX    */
+  int   maxcont;     /* numero maximo de chamadas         */
+  int   status;      /* valor retornado por CSDAECTX      */
+  vint  ii, io;      /* infoinput e infooutput do grupo   */
+  mreal y;           /* estado do grupo                   */
+  mreal atoly, rtoly;/* tolerancias do grupo              */
+  vreal ftol;        /* tolerancia de F do grupo          */
+  vint  info;        /* informacoes de uma instancia      */
+  int   def, ndef;   /* instancias com tolerancias padrao */
+  real  atolx, rtolx;/* tolerancias de x                  */
+  real  a, rl, sc;   /* tolerancias e escala 1/sqrt(w)    */
+  real  s, x, len;   /* ponto do grupo                    */
+
+  n  = ens->n;
+  o  = ens->o;
+  w  = ens->w;
+  nw = w*n;
+
+  ii    = ALLOCVINT(2*nw+10);
+  io    = ALLOCVINT(2*nw+10);
+  y     = ALLOCMREAL(o,nw);
+  atoly = ALLOCMREAL(o,nw);
+  rtoly = ALLOCMREAL(o,nw);
+  ftol  = ALLOCVREAL(nw);
+
+  /* contexto ou vetores nao alocados */
+  if ((ctx == NULL) || (ii == NULL) || (io == NULL) || (y == NULL) || 
+      (atoly == NULL) || (rtoly == NULL) || (ftol == NULL)) {
+    for (l = 0; l < w; l++) 
+      in[l].status = -1;
+    FREEVINT(2*nw+10,ii);
+    FREEVINT(2*nw+10,io);
+    FREEMREAL(o,nw,y);
+    FREEMREAL(o,nw,atoly);
+    FREEMREAL(o,nw,rtoly);
+    FREEVREAL(nw,ftol);
+    return;
   }
 
-  if (fabs(A[p[n]][q[n]]) < 1.0e-15) 
-    return (n-1);
+  /* tolerancias de cada instancia, como em GSDAE, e estado  */
+  /* intercalado; atol e rtol sao divididas por sqrt(w). Se   */
+  /* todas usam os valores padrao o grupo tambem os usa; caso */
+  /* contrario rtol = atol nas instancias com valores padrao, */
+  /* ja que CSDAECTX exige atol <= rtol                       */
+  sc    = 1.0/sqrt((real) w);
+  atolx = rtolx = -1.0;
+  ndef  = 0;
+  for (l = 1; l <= w; l++) {
+    info = in[l-1].info;
+    def  = ((info == NULL) || (info[3] == 0));
+    ndef += def;
+    for (i = 1; i <= n; i++) {
+      j = (i-1)*w+l;
+      for (k = 0; k <= o; k++) {
+        y[k][j] = in[l-1].y[k][i];
+        if (def) {
+          a  = 1.0e-15;
+          rl = 1.0e-15;
+        } else if (info[3] == 1) {
+          a  = in[l-1].atolx;
+          rl = in[l-1].rtolx;
+        } else {
+          a  = in[l-1].atoly[k][i];
+          rl = in[l-1].rtoly[k][i];
+        }
+        atoly[k][j] = sc*fabs(a);
+        rtoly[k][j] = sc*fabs(rl);
+      }
+      ftol[j] = (def) ? 1.0e-12 : 
+                (info[3] == 1) ? fabs(in[l-1].ftol[1]) : fabs(in[l-1].ftol[i]);
+    }
+    a  = (def) ? 1.0e-15 : fabs(in[l-1].atolx);
+    rl = (def) ? 1.0e-15 : fabs(in[l-1].rtolx);
+    atolx = ((atolx < 0.0) || (a  < atolx)) ? a  : atolx;
+    rtolx = ((rtolx < 0.0) || (rl < rtolx)) ? rl : rtolx;
+  }
+  atolx *= sc;
+  rtolx *= sc;
+
+  /* informacoes de entrada : primeira chamada, tolerancias */
+  /* do grupo e opcoes 5..8 da primeira instancia           */
+  for (i = 0; i <= 2*nw+10; i++) 
+    ii[i] = io[i] = 0;
+  info = in[0].info;
+  for (i = 5; (info != NULL) && (i <= 8); i++) 
+    ii[i] = info[i];
+  ii[1] = 0;
+  ii[2] = 1;
+  ii[3] = (ndef == w) ? 0 : 2;
+
+  /* integrando ate xend ou ate ocorrer um erro */
+  s       = in[0].s;
+  x       = in[0].x;
+  maxcont = 1000;
+  cont    = 0;
+  do {
+    status = CSDAECTX(ctx,nw,o,in[0].h,in[0].hmin,in[0].hmax,in[0].cdmax,
+                      &s,&x,in[0].xend,y,atolx,atoly,rtolx,rtoly,ftol,
+                      ii,io);
+    cont++;
+  } while ((status > 0) && (cont < maxcont));
+
+  /* devolvendo o ponto e os contadores a cada instancia */
+  for (l = 1; l <= w; l++) {
+    for (k = 0; k <= o; k++) 
+      for (i = 1; i <= n; i++) 
+        in[l-1].y[k][i] = y[k][(i-1)*w+l];
+    in[l-1].x      = x;
+    in[l-1].status = status;
+    STATISTICSCTX(ctx,&len,&(in[l-1].nstep),&(in[l-1].nreject),
+                  &(in[l-1].nsuc),&(in[l-1].nfunc),&(in[l-1].njac),
+                  &(in[l-1].nqr),&(in[l-1].nstart),&(in[l-1].nfnew));
+    in[l-1].s     = s;
+    in[l-1].rank  = (ctx->rank == nw) ? n : ctx->rank;
+    in[l-1].order = ctx->o;
+  }
 
-  return (n);
+  FREEVINT(2*nw+10,ii);
+  FREEVINT(2*nw+10,io);
+  FREEMREAL(o,nw,y);
+  FREEMREAL(o,nw,atoly);
+  FREEMREAL(o,nw,rtoly);
+  FREEVREAL(nw,ftol);
+
+  return;
 }
 
 
+
+/* ****************************************************** */
+/* rotinas F e DF do contexto de um grupo : repassam a    */
+/* chamada para as rotinas do usuario. ENSEMBLEDF copia   */
+/* DFy intercalada para o padrao do contexto (a equacao   */
+/* r = (i-1)*w+l ocupa val[k][(r-1)*n+1..r*n]) ou a       */
+/* aproxima por diferencas finitas, perturbando a mesma   */
+/* variavel de todas as instancias em cada chamada de F   */
+/* ****************************************************** */
+
 void 
-SOLVESYSTEM (
+ENSEMBLEF (
+int    o,
 int    n,
-mreal  A,
-mreal  Q,
-vint   p,
-vint   q,
-vreal  x,
-vreal  y
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
 )
 {
-  int   i,j; 
-  real  s;   
+  ensemble *ens; /* dados do grupo */
 
-  for (j = 1; j <= n; j++) x[j] = y[j];
+  ens = (ensemble *) data;
+  ens->F(o,ens->n,ens->w,x,y,delta,ens->data);
 
-  for (i = 1; i <= n; i++) 
-    for (j = 1, y[p[i]] = 0.0; j <= n; j++) 
-      y[p[i]] += Q[p[i]][q[j]]*x[q[j]];
-  
-  for (i = n; i >= 1; i--) {
-    for (j = i+1, s = 0.0; j <= n; j++) s += A[p[i]][q[j]]*x[q[j]];
-    x[q[i]] = (y[p[i]]-s)/A[p[i]][q[i]];
-  } 
-  
   return;
 }
 
 
 void 
-ALLOCPAR (
-int  n,
-int  o,
-mreal *y,
-mreal *atoly,
-mreal *rtoly,
-vreal *ftol,
-vint  *infoinput,
-vint  *infooutput,
-void (*F)(int,int,real,mreal,vreal),
-void (*DF)(int,int,real,mreal,vreal,mmreal)
+ENSEMBLEDF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mreal  val,
+void  *data
 )
 {
-  *y     = (mreal) ALLOCMREAL(o,n);
-  if (*y == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
+  ensemble *ens;      /* dados do grupo              */
+  int       i,j,k,l;  /* variaveis auxiliares        */
+  int       r,w,ne;   /* equacao, instancias e n     */
+  real      del;      /* incremento                  */
+  real      save;     /* valor anterior              */
+  real      uround;   /* menor constante considerada */
+  vreal     d, da;    /* F e F perturbada            */
+
+  ens = (ensemble *) data;
+  w   = ens->w;
+  ne  = ens->n;
+
+  /* jacobiana do usuario */
+  if (ens->DF != NULL) {
+    ens->DF(o,ne,w,x,y,DFx,ens->DFy,ens->data);
+    for (k = 0; k <= o; k++) 
+      for (r = 1; r <= n; r++) 
+        for (j = 1; j <= ne; j++) 
+          val[k][(r-1)*ne+j] = ens->DFy[k][j][r];
     return;
   }
 
-  *atoly = (mreal) ALLOCMREAL(o,n);
-  if (*atoly == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* diferencas finitas : derivada com relacao a x */
+  d      = ens->delta;
+  da     = ens->daux;
+  uround = sqrt(1.0e-15);
+  ens->F(o,ne,w,x,y,d,ens->data);
+  del = uround*MAX2(fabs(x),1.0);
+  del = (x+del)-x;
+  ens->F(o,ne,w,x+del,y,da,ens->data);
+  for (r = 1; r <= n; r++) 
+    DFx[r] = (da[r]-d[r])/del;
+
+  /* variavel j de ordem k em todas as instancias */
+  for (k = 0; k <= o; k++) 
+    for (j = 1; j <= ne; j++) {
+      for (l = 1; l <= w; l++) {
+        i          = (j-1)*w+l;
+        save       = y[k][i];
+        del        = uround*MAX2(fabs(save),1.0);
+        y[k][i]    = save+del;
+        ens->dy[l] = y[k][i]-save;
+      }
+      ens->F(o,ne,w,x,y,da,ens->data);
+      for (l = 1; l <= w; l++) {
+        y[k][(j-1)*w+l] -= ens->dy[l];
+        for (i = 1; i <= ne; i++) {
+          r = (i-1)*w+l;
+          val[k][(r-1)*ne+j] = (da[r]-d[r])/ens->dy[l];
+        }
+      }
+    }
 
-  *rtoly = (mreal) ALLOCMREAL(o,n);
-  if (*rtoly == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  return;
+}
 
-  *ftol = (vreal) ALLOCVREAL(n);
-  if (*ftol == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  *infoinput  = (vint)  ALLOCVINT(2*n+10);
-  if (*infoinput == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  *infooutput  = (vint)  ALLOCVINT(2*n+10);
-  if (*infooutput == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+/************************************************************/
+/* Funcoes para alocacao em arena                           */
+/************************************************************/
+/* Os vetores e matrizes de um contexto podem ser retirados */
+/* de um unico bloco de memoria (arena). Cada vetor e cada  */
+/* linha de matriz comeca em um endereco multiplo de        */
+/* GSDAE_ALIGN bytes. As matrizes mantem o vetor de         */
+/* ponteiros para as linhas, que tambem fica na arena.      */
+/* Enquanto ar->base = NULL as funcoes apenas acumulam o    */
+/* tamanho necessario em ar->used e retornam NULL.          */
+/************************************************************/
 
-  par = (parameter *) malloc(sizeof(parameter));
-  if (par == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+void *
+ARENAGET (
+arena  *ar,
+size_t  size
+)
+{
+  size_t pos; /* posicao alinhada do bloco */
 
-  /* inicializando a ordem e a dimensao com 0 */
-  par->n = 0;
-  par->o = 0;
+  pos      = (ar->used+GSDAE_ALIGN-1) & ~((size_t) GSDAE_ALIGN-1);
+  ar->used = pos+size;
 
-  /* definindo as funcoes */
-  par->F  = F;
-  par->DF = DF;
+  /* contando o tamanho necessario */
+  if (ar->base == NULL) 
+    return (NULL);
 
-  /* aloca vetores inteiros */
-  par->p = (vint) ALLOCVINT(n);
-  if ( par->p == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
+  /* arena menor que o necessario */
+  if (ar->used > ar->size) {
+    printf("ARENA : nao alocado\n");
+    return (NULL);
   }
 
-  par->q = (vint) ALLOCVINT(n);
-  if ( par->q == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  return ((void *) (ar->base+pos));
+}
+
+
+
+vint 
+ARENAVINT (
+arena *ar,
+int    n
+)
+{
+  return ((vint) ARENAGET(ar,(n+1)*sizeof(int)));
+}
+
 
-  par->paux = (vint) ALLOCVINT(n);
-  if ( par->paux == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->qaux = (vint) ALLOCVINT(n);
-  if ( par->qaux == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+vreal 
+ARENAVREAL (
+arena *ar,
+int    n
+)
+{
+  return ((vreal) ARENAGET(ar,(n+1)*sizeof(real)));
+}
 
 
-  /* aloca vetores reais */
-  par->DFx = (vreal) ALLOCVREAL(n);
-  if ( par->DFx == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->u  = (vreal) ALLOCVREAL((o+1)*n+1);
-  if ( par->u == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+mreal 
+ARENAMREAL (
+arena *ar,
+int    m,
+int    n
+)
+{
+  mreal v;  /* ponteiro para a matriz */
+  int   i;  /* variavel auxiliar      */
 
-  par->delta = (vreal) ALLOCVREAL(n+1);
-  if ( par->delta == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* alocando os ponteiros para as linhas */
+  v = (mreal) ARENAGET(ar,(m+1)*sizeof(vreal));
 
-  par->deltax = (vreal) ALLOCVREAL(n+1);
-  if ( par->deltax == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
-  
-  par->deltah = (vreal) ALLOCVREAL((o+1)*n+1);
-  if ( par->delta == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
-  
-  par->deltahx = (vreal) ALLOCVREAL((o+1)*n+1);
-  if ( par->delta == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* alocando as linhas, cada uma alinhada */
+  for (i = 0; i <= m; i++) 
+    if (v != NULL) 
+      v[i] = ARENAVREAL(ar,n);
+    else 
+      ARENAVREAL(ar,n);
 
-  par->psi = (vreal) ALLOCVREAL(8);
-  if ( par->psi == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  return (v);
+}
 
-  par->alfa = (vreal) ALLOCVREAL(8);
-  if ( par->alfa == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->beta = (vreal) ALLOCVREAL(8);
-  if ( par->beta == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->gama = (vreal) ALLOCVREAL(8);
-  if ( par->gama == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+mmreal 
+ARENAMMREAL (
+arena *ar,
+int    m,
+int    n,
+int    k
+)
+{
+  mmreal v;  /* ponteiro para a matriz */
+  int    i;  /* variavel auxiliar      */
 
-  par->sigma = (vreal) ALLOCVREAL(8);
-  if ( par->sigma == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* alocando os ponteiros para a primeira dimensao */
+  v = (mmreal) ARENAGET(ar,(m+1)*sizeof(mreal));
 
-  par->phix = (vreal) ALLOCVREAL(8);
-  if ( par->phix == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
- 
-  par->ftol = (vreal) ALLOCVREAL(n);
-  if ( par->ftol == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
- 
-  /* aloca matrizes bidimensionais */
- 
-  par->y = (mreal) ALLOCMREAL(o,n);
-  if ( par->y == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* alocando as matrizes v[i] */
+  for (i = 0; i <= m; i++) 
+    if (v != NULL) 
+      v[i] = ARENAMREAL(ar,n,k);
+    else 
+      ARENAMREAL(ar,n,k);
 
-  par->tauy = (mreal) ALLOCMREAL(o,n);
-  if ( par->tauy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  return (v);
+}
 
-  par->DH = (mreal) ALLOCMREAL((o+1)*n+1,(o+1)*n+1);
-  if ( par->DH == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->cy = (mreal) ALLOCMREAL(o,n);
-  if ( par->cy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+/* historico das diferencas divididas em um bloco (veja ALLOCPHI) */
+mmreal 
+ARENAPHI (
+arena *ar,
+int    m,
+int    o,
+int    n
+)
+{
+  mmreal v;    /* ponteiro para a matriz    */
+  vreal  base; /* bloco das linhas          */
+  int    ld;   /* distancia entre as linhas */
+  int    pad;  /* reais por GSDAE_ALIGN     */
+  int    i,l;  /* variaveis auxiliares      */
+
+  pad = GSDAE_ALIGN/sizeof(real);
+  ld  = ((pad+(o+1)*n+pad-1)/pad)*pad;
+
+  /* alocando os ponteiros */
+  v = (mmreal) ARENAGET(ar,(m+1)*sizeof(mreal));
+  for (l = 0; l <= m; l++) 
+    if (v != NULL) 
+      v[l] = (mreal) ARENAGET(ar,(o+1)*sizeof(vreal));
+    else 
+      ARENAGET(ar,(o+1)*sizeof(vreal));
 
-  par->cyx = (mreal) ALLOCMREAL(o,n);
-  if ( par->cyx == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* alocando o bloco */
+  base = (vreal) ARENAGET(ar,(m+1)*ld*sizeof(real));
+  if ((v == NULL) || (base == NULL)) 
+    return (NULL);
 
-  par->pcy = (mreal) ALLOCMREAL(o,n);
-  if ( par->pcy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  for (l = 0; l <= m; l++) 
+    for (i = 0; i <= o; i++) 
+      v[l][i] = base+l*ld+pad-1+i*n;
 
-  par->pdcy = (mreal) ALLOCMREAL(o,n);
-  if ( par->pdcy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  return (v);
+}
 
-  par->dy = (mreal) ALLOCMREAL(o,n);
-  if (par->dy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->ccy = (mreal) ALLOCMREAL(o,n);
-  if ( par->ccy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
 
-  par->yx = (mreal) ALLOCMREAL(o,n);
-  if ( par->yx == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+/************************************************************/
+/* Aloca o bloco da arena com o tamanho acumulado em        */
+/* ar->used. Se huge = 1 tenta utilizar paginas grandes,    */
+/* primeiro explicitamente (MAP_HUGETLB) e depois por meio  */
+/* de paginas grandes transparentes (MADV_HUGEPAGE). O      */
+/* bloco e inicializado com zero. Retorna 0 se o bloco foi  */
+/* alocado e -1 caso contrario.                             */
+/************************************************************/
 
-  par->Q = (mreal) ALLOCMREAL((o+1)*n+1,(o+1)*n+1);
-  if ( par->Q == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+int 
+ARENAALLOC (
+arena *ar,
+int    huge
+)
+{
+  size_t size;  /* tamanho do bloco          */
+  size_t page;  /* tamanho da pagina grande  */
+  void  *base;  /* bloco alocado             */
+
+  size       = ar->used;
+  ar->base   = NULL;
+  ar->mapped = 0;
+
+  if (huge) {
+
+    /* arredondando para o tamanho da pagina grande */
+    page = 2*1024*1024;
+    size = (size+page-1) & ~(page-1);
+
+#ifdef MAP_HUGETLB
+    base = mmap(NULL,size,PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,-1,0);
+    if (base != MAP_FAILED) {
+      ar->base   = (char *) base;
+      ar->size   = size;
+      ar->mapped = 1;
+      return (0);
+    }
+#endif
 
-  par->atoly = (mreal) ALLOCMREAL(o,n);
-  if ( par->atoly == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
   }
 
-  par->rtoly = (mreal) ALLOCMREAL(o,n);
-  if ( par->rtoly == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
+  if (posix_memalign(&base,(huge) ? 2*1024*1024 : GSDAE_ALIGN,size) != 0) {
+    printf("ARENA : nao alocado\n");
+    return (-1);
   }
 
-  par->wty = (mreal) ALLOCMREAL(o,n);
-  if ( par->wty == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+#ifdef MADV_HUGEPAGE
+  if (huge) 
+    madvise(base,size,MADV_HUGEPAGE);
+#endif
 
-  par->Ey = (mreal) ALLOCMREAL(o,n);
-  if ( par->Ey == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
-   
-  /* aloca matrizes tridimensionais */
-   
-  par->DFy  = (mmreal) ALLOCMMREAL(o,n,n);
-  if ( par->DFy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  /* inicializando o bloco com zero */
+  memset(base,0,size);
 
-  par->phiy = (mmreal) ALLOCMMREAL(8,o,n);
-  if ( par->phiy == NULL) {
-    printf("ALLOCPAR : nao alocado\n");
-    exit(1);
-    return;
-  }
+  ar->base = (char *) base;
+  ar->size = size;
 
-  return;
+  return (0);
 }
 
 
 
+/************************************************************/
+/* Libera o bloco da arena                                  */
+/************************************************************/
 
 void 
-FREEPAR ( 
-int    n,
-int    o,
-mreal *y,
-mreal *atoly,
-mreal *rtoly,
-vreal *ftol,
-vint  *infoinput,
-vint  *infooutput
+ARENAFREE (
+arena *ar
 )
 {
-  extern parameter *par;
-
-  *y           = (mreal) FREEMREAL(o,n,*y);
-  *atoly       = (mreal) FREEMREAL(o,n,*atoly);
-  *rtoly       = (mreal) FREEMREAL(o,n,*rtoly);
-  *ftol        = (vreal) FREEVREAL(n,*ftol);
-  *infoinput   = (vint)  FREEVINT(2*n+10,*infoinput);
-  *infooutput  = (vint)  FREEVINT(2*n+10,*infooutput);
+  if (ar->base == NULL) 
+    return;
 
-  /* desaloca vetores inteiros */
-  par->p       = (vint)  FREEVINT(n,par->p);
-  par->q       = (vint)  FREEVINT(n,par->q);
-  par->paux    = (vint)  FREEVINT(n,par->paux);
-  par->qaux    = (vint)  FREEVINT(n,par->qaux);
+  if (ar->mapped) 
+    munmap(ar->base,ar->size);
+  else 
+    free(ar->base);
 
-  /* desaloca vetores reais */
-  par->DFx     = (vreal) FREEVREAL(n,par->DFx);
-  par->u       = (vreal) FREEVREAL((o+1)*n+1,par->u);
-  par->delta   = (vreal) FREEVREAL(n+1,par->delta);
-  par->deltax  = (vreal) FREEVREAL(n+1,par->deltax);
-  par->deltah  = (vreal) FREEVREAL((o+1)*n+1,par->delta);
-  par->deltahx = (vreal) FREEVREAL((o+1)*n+1,par->deltax);
-  par->psi     = (vreal) FREEVREAL(8,par->psi);
-  par->alfa    = (vreal) FREEVREAL(8,par->alfa);
-  par->beta    = (vreal) FREEVREAL(8,par->beta);
-  par->gama    = (vreal) FREEVREAL(8,par->gama);
-  par->sigma   = (vreal) FREEVREAL(8,par->sigma);
-  par->phix    = (vreal) FREEVREAL(8,par->phix);
-  par->ftol    = (vreal) FREEVREAL(n,par->ftol);
-   
-  /* desaloca matrizes bidimensionais */
-  par->y       = (mreal) FREEMREAL(o,n,par->y);
-  par->tauy    = (mreal) FREEMREAL(o,n,par->tauy); 
-  par->DH      = (mreal) FREEMREAL((o+1)*n+1,(o+1)*n+1,par->DH);
-  par->cy      = (mreal) FREEMREAL(o,n,par->cy);
-  par->cyx     = (mreal) FREEMREAL(o,n,par->cyx);
-  par->pcy     = (mreal) FREEMREAL(o,n,par->pcy);
-  par->pdcy    = (mreal) FREEMREAL(o,n,par->pdcy);
-  par->dy      = (mreal) FREEMREAL(o,n,par->dy);
-  par->ccy     = (mreal) FREEMREAL(o-1,n,par->ccy);
-  par->yx      = (mreal) FREEMREAL(o,n,par->yx);
-  par->Q       = (mreal) FREEMREAL((o+1)*n+1,(o+1)*n+1,par->Q);
-  par->atoly   = (mreal) FREEMREAL(o,n,par->atoly);
-  par->rtoly   = (mreal) FREEMREAL(o,n,par->rtoly);
-  par->wty     = (mreal) FREEMREAL(o,n,par->wty);
-  par->Ey      = (mreal) FREEMREAL(o,n,par->Ey);
-  
-  /* desaloca matrizes tridimensionais */
-  par->DFy     = (mmreal) FREEMMREAL(o,n,n,par->DFy);
-  par->phiy    = (mmreal) FREEMMREAL(8,o,n,par->phiy);
-  
-  free(par);
+  ar->base = NULL;
+  ar->size = 0;
+  ar->used = 0;
 
   return;
 }
 
 
+
 /************************************************************/
 /* Funcao para alocacao de vetor de inteiros                */
 /************************************************************/
@@ -5629,6 +14161,10 @@ mint v
 {
   int      i;  /* variavel auxiliar */
 
+  /* verificando se a matriz foi alocada */
+  if (v == NULL) 
+    return (NULL);
+
   /* liberando as linhas da matriz */
   for (i = 0; i <= m ; i++) free(v[i]);
 
@@ -5701,6 +14237,10 @@ mmint v
 {
   int      i,j;  /* variaveis auxiliares */
 
+  /* verificando se a matriz foi alocada */
+  if (v == NULL) 
+    return (NULL);
+
   /* liberando a terceira dimensao da matriz */
   for (i = 0; i <= m; i++) 
     for (j = 0; j <= n; j++) free(v[i][j]);
@@ -5871,6 +14411,10 @@ mreal v
 {
   int      i;  /* variavel auxiliar */
 
+  /* verificando se a matriz foi alocada */
+  if (v == NULL) 
+    return (NULL);
+
   /* liberando as linhas da matriz */
   for (i = 0; i <= m; i++) free(v[i]);
 
@@ -5943,6 +14487,10 @@ mmreal v
 {
   int      i,j;  /* variaveis auxiliares */
 
+  /* verificando se a matriz foi alocada */
+  if (v == NULL) 
+    return (NULL);
+
   /* liberando a terceira dimensao da matriz */
   for (i = 0; i <= m; i++) 
     for (j = 0; j <= n; j++) free(v[i][j]);
@@ -5956,3 +14504,84 @@ mmreal v
   /* retornando o ponteiro */
   return (NULL);
 }
+
+
+/**********************************************************/
+/* Esta rotina aloca o historico das diferencas divididas */
+/* v[0..m][0..o][1..n] em um unico bloco alinhado : a     */
+/* linha l do bloco guarda o estado y[0..o][1..n] em      */
+/* sequencia (v[l][i] = v[l][0]+i*n), com v[l][0][1] em   */
+/* um endereco multiplo de GSDAE_ALIGN bytes.             */
+/**********************************************************/
+
+mmreal  
+ALLOCPHI ( 
+int m,
+int o,
+int n
+)
+{
+  mmreal v;      /* ponteiro para a matriz    */
+  void  *base;   /* bloco das linhas          */
+  int    ld;     /* distancia entre as linhas */
+  int    pad;    /* reais por GSDAE_ALIGN     */
+  int    i,l;    /* variaveis auxiliares      */
+
+  pad = GSDAE_ALIGN/sizeof(real);
+  ld  = ((pad+(o+1)*n+pad-1)/pad)*pad;
+
+  /* alocando os ponteiros */
+  v = (mmreal) malloc((m+1)*sizeof(mreal));
+  if (v == NULL) {
+    printf("VECTORS : nao alocado\n");
+    return (NULL);
+  }
+  for (l = 0; l <= m; l++) {
+    v[l] = (mreal) malloc((o+1)*sizeof(vreal));
+    if (v[l] == NULL) {
+      printf("VECTORS : nao alocado\n");
+      return (NULL);
+    }
+  }
+
+  /* alocando o bloco */
+  if (posix_memalign(&base,GSDAE_ALIGN,(m+1)*ld*sizeof(real)) != 0) {
+    printf("VECTORS : nao alocado\n");
+    return (NULL);
+  }
+  memset(base,0,(m+1)*ld*sizeof(real));
+
+  for (l = 0; l <= m; l++) 
+    for (i = 0; i <= o; i++) 
+      v[l][i] = (vreal) base+l*ld+pad-1+i*n;
+
+  /* retornando o ponteiro */
+  return (v);
+}
+
+
+/*************************************************/
+/* Esta rotina libera o historico de ALLOCPHI    */
+/*************************************************/
+
+mmreal 
+FREEPHI (
+int    m,
+mmreal v
+)
+{
+  int  l;   /* variavel auxiliar */
+  int  pad; /* reais por GSDAE_ALIGN */
+
+  /* verificando se a matriz foi alocada */
+  if (v == NULL) 
+    return (NULL);
+
+  pad = GSDAE_ALIGN/sizeof(real);
+  free(v[0][0]-(pad-1));
+  for (l = 0; l <= m; l++) free(v[l]);
+  free(v);
+
+  /* retornando o ponteiro */
+  return (NULL);
+}
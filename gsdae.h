@@ -28,19 +28,32 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
 
 /* ****************************************************** */
 /*   incluindo os tipos de dados e macro-funcoes          */
 /* ****************************************************** */
 #include "types.h"
 
+/* intrinsecos dos nucleos vetoriais (SSE2/AVX2/AVX-512) */
+#ifdef GSDAE_X86
+#include <immintrin.h>
+#endif
+
 
 /* ****************************************************** */
 /*   declarando a variavel global que armazena todos os   */
-/*   dados para a execucao da rotina GSDAE e definindo-a  */
-/*   como nao alocada                                     */
+/*   dados para a execucao da rotina GSDAE (definida em   */
+/*   gsdae.c como nao alocada)                            */
 /* ****************************************************** */
-parameter *par = NULL;
+extern parameter *par;
+
+/* nucleos vetoriais escolhidos por SETSIMD (chamar antes de      */
+/* alocar os contextos e nunca durante uma integracao)            */
+extern kernels kern;
+extern pthread_once_t kernonce;
 
 
 /* ****************************************************** */
@@ -108,6 +121,335 @@ int   status,
 char *mens
 );
 
+int 
+GSDAECTX (
+gsdae_ctx *par,
+int    n,           
+int    o,           
+real   h,           
+real   hmin,        
+real   hmax,        
+real   cdmax,       
+real  *s,           
+real   send,        
+real  *x,           
+mreal  y,           
+real   atolx,       
+mreal  atoly,       
+real   rtolx,       
+mreal  rtoly,       
+vreal  ftol,        
+vint   infoinput,   
+vint   infooutput   
+);
+
+int 
+CSDAECTX (
+gsdae_ctx *par,
+int    n,           
+int    o,           
+real   h,          
+real   hmin,        
+real   hmax,        
+real   cdmax,       
+real  *s,           
+real  *x,           
+real   xend,        
+mreal  y,           
+real   atolx,       
+mreal  atoly,       
+real   rtolx,       
+mreal  rtoly,       
+vreal  ftol,        
+vint   infoinput,   
+vint   infooutput   
+);
+
+void 
+STATISTICSCTX (
+gsdae_ctx *par,
+real *s,
+int  *npas,
+int  *nreject,
+int  *nsuc,
+int  *nfunc,
+int  *njac,
+int  *nqr,
+int  *nstart,
+int  *nfnew
+);
+
+void 
+STATISTICSLU (
+int *nlu,
+int *nsw
+);
+
+void 
+STATISTICSLUCTX (
+gsdae_ctx *par,
+int       *nlu,
+int       *nsw
+);
+
+gsdae_ctx *
+ALLOCCTX (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void  *data
+);
+
+gsdae_ctx *
+ALLOCCTXMODE (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void  *data,
+int    mode
+);
+
+gsdae_ctx *
+ALLOCCTXSP (
+int     n,
+int     o,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+int     mode,
+sparse *sp
+);
+
+gsdae_ctx *
+ALLOCCTXLS (
+int     n,
+int     o,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+int     mode,
+sparse *sp,
+krylov *kr
+);
+
+gsdae_ctx *
+ALLOCCTXKRYLOV (
+int    n,
+int    o,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*JV)(int,int,real,mreal,real,mreal,vreal,void *),
+void  *data
+);
+
+int 
+SETPRECOND (
+gsdae_ctx *ctx,
+int      (*setup)(real,real,pcstate *,void *),
+void     (*solve)(int,vreal,void *),
+void      *pdata
+);
+
+int 
+SETPRECONDKIND (
+gsdae_ctx *ctx,
+int        kind,
+int        bs
+);
+
+gsdae_ctx *
+ALLOCCTXSPARSE (
+int    n,
+int    o,
+int    nnz,
+vint   ia,
+vint   ja,
+void (*F)(int,int,real,mreal,vreal,void *),
+void (*DFS)(int,int,real,mreal,vreal,mreal,void *),
+void  *data
+);
+
+int 
+SETPATTERN (
+gsdae_ctx *ctx,
+int        nnz,
+vint       ia,
+vint       ja
+);
+
+int 
+SETTHREADS (
+gsdae_ctx *ctx,
+int        nthreads
+);
+
+int 
+SETFBATCH (
+gsdae_ctx *ctx,
+void     (*Fb)(int,int,int,vreal,mmreal,mreal,void *),
+int        mmax
+);
+
+int 
+SETQRTHREADS (
+gsdae_ctx *ctx,
+int        nthreads,
+int        nmin
+);
+
+int 
+SETSIMD (
+int  level
+);
+
+void
+KERNFIRST ( void );
+
+void
+KERNINIT ( void );
+
+int 
+DETECTPATTERN (
+gsdae_ctx *ctx,
+real       x,
+mreal      y,
+char      *file
+);
+
+void 
+SPARSEF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+);
+
+void 
+SPARSEDF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+);
+
+void 
+CTXARRAYS (
+gsdae_ctx *ctx,
+int        n,
+int        o,
+arena     *ar
+);
+
+void 
+FREECTX ( 
+gsdae_ctx *ctx
+);
+
+int 
+GSDAEBATCH (
+int         n,
+int         o,
+int         m,
+gsdae_inst *inst,
+void      (*F)(int,int,real,mreal,vreal,void *),
+void      (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+int         nthreads
+);
+
+void 
+BATCHTASK (
+int   id,
+void *arg
+);
+
+void 
+BATCHONE (
+gsdae_ctx  *ctx,
+int         n,
+int         o,
+gsdae_inst *in,
+vint        ii,
+vint        io
+);
+
+int 
+GSDAEENSEMBLE (
+int         n,
+int         o,
+int         m,
+gsdae_inst *inst,
+void      (*F)(int,int,int,real,mreal,vreal,void **),
+void      (*DF)(int,int,int,real,mreal,vreal,mmreal,void **),
+int         w
+);
+
+gsdae_ctx *
+ENSEMBLECTX (
+ensemble *ens
+);
+
+void 
+ENSEMBLEFREE (
+ensemble  *ens,
+gsdae_ctx *ctx
+);
+
+void 
+ENSEMBLEONE (
+gsdae_ctx  *ctx,
+ensemble   *ens,
+gsdae_inst *in
+);
+
+void 
+ENSEMBLEF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+);
+
+void 
+ENSEMBLEDF (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mreal  val,
+void  *data
+);
+
+pool *
+POOLALLOC (
+int nthreads
+);
+
+void *
+POOLWORKER (
+void *arg
+);
+
+void 
+POOLRUN (
+pool  *pl,
+void (*task)(int,void *),
+void  *arg
+);
+
+void 
+POOLFREE (
+pool *pl
+);
+
 void 
 weightvector (
 int    n,
@@ -136,6 +478,19 @@ real   wtx,
 mreal  wty
 );
 
+real 
+weightnormvmax (
+int    n, 
+int    o,
+int    r, 
+real   cx, 
+mreal  cy,
+vint   q,
+real   wtx, 
+mreal  wty,
+real   vmax
+);
+
 void 
 SETH (
 int   n,          
@@ -150,7 +505,23 @@ vint  p,
 vint  q,
 vreal delta, 
 vreal deltah,
-void  (*F)(int,int,real,mreal,vreal)
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  *data
+);
+
+void 
+SETHW (
+int   n,          
+int   o,
+int   r,
+real  h,
+real  dpx,
+mreal dpy,
+mreal y,       
+vint  p,
+vint  q,
+vreal delta, 
+vreal deltah
 );
 
 void 
@@ -168,7 +539,8 @@ vint    p,
 vint    q,
 vreal   DFx,
 mmreal  DFy,
-void    (*DF)(int,int,real,mreal,vreal,mmreal),
+void    (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
 mreal   DH 
 );
 
@@ -194,7 +566,27 @@ vreal   deltaaux,
 vreal   deltah,
 vreal   deltahaux,
 mreal   DH,
-void   (*F)(int,int,real,mreal,vreal) 
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
+);
+
+void 
+predictlast (
+int     n, 
+int     o, 
+int     r, 
+int     k, 
+int     ns,
+vreal   beta, 
+vreal   gama, 
+vreal   phix,
+mmreal  phiy,
+real   *pcx,
+mreal   pcy,
+real   *pdcx,
+mreal   pdcy,
+vint    q
 );
 
 void 
@@ -203,6 +595,8 @@ int     n,
 int     o, 
 int     r, 
 int     k, 
+int     ns,
+vreal   beta, 
 vreal   gama, 
 vreal   phix,
 mmreal  phiy,
@@ -214,6 +608,37 @@ vint    q,
 vreal   u
 );
 
+real 
+PREDICTSTEP (
+int     n, 
+int     o, 
+int     r, 
+int     k, 
+int     ns,
+vreal   beta, 
+vreal   gama, 
+vreal   phix,
+mmreal  phiy,
+real   *cx,
+mreal   cy,
+real   *cxx,
+mreal   cyx,
+real   *pcx,
+mreal   pcy,
+real   *pdcx,
+mreal   pdcy,
+real   *Ex,
+mreal   Ey,
+vint    q,
+vreal   u,
+real    atolx,
+real    rtolx,
+mreal   atoly,
+mreal   rtoly,
+real   *wtx,
+mreal   wty
+);
+
 void  
 coefficient ( 
 int     n,
@@ -232,13 +657,22 @@ real   *cjold,
 real   *factor,
 int    *aDH,
 real   *ck,
-vreal   phix,
-mmreal  phiy,
 int    *ns,
 real   *hold,
 int    *kold 
 );
 
+void 
+phirestore (
+int    n,
+int    o,
+int    l0,
+int    l1,
+vreal  beta,
+vreal  phix,
+mmreal phiy
+);
+
 void 
 update (
 int    n,
@@ -316,8 +750,9 @@ int    *ifase,
 int    *ns,
 real   *hold,
 int    *kold,
-void   (*F)(int,int,real,mreal,vreal),
-void   (*DF)(int,int,real,mreal,vreal,mmreal),
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
 real   *sold,
 real   *taux,
 mreal   tauy,
@@ -325,7 +760,8 @@ int    *naF,
 int    *naDH,
 int    *ndQR,
 vreal  deltah,
-vreal  deltahx
+vreal  deltahx,
+solver *ls
 );
 
 int 
@@ -495,8 +931,10 @@ int     nDH,
 int    *naF,
 int    *naDH,
 int    *nQR,
-void    (*F)(int,int,real,mreal,vreal),
-void    (*DF)(int,int,real,mreal,vreal,mmreal)
+void    (*F)(int,int,real,mreal,vreal,void *),
+void    (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+solver *ls
 );
 
 int 
@@ -519,8 +957,10 @@ vint    q,
 int     nDH,
 int    *naDH,
 int    *nQR,
-void   (*F)(int,int,real,mreal,vreal),
-void   (*DF)(int,int,real,mreal,vreal,mmreal)
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+solver *ls
 );
 
 void 
@@ -534,27 +974,219 @@ vreal   delta,
 vreal   deltaaux,
 vreal   DFx,
 mmreal  DFy,
-void    (*F)(int,int,real,mreal,vreal) 
+void    (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
 );
 
 void 
-firststep (
+DFCOLOR (
 int     n,
 int     o,
-int     r,
-real    cx,
-mreal   cy,
-vreal   phix,
-mmreal  phiy,
-vint    p,
-vint    q,
-real    taux,
-mreal   tauy,
-real   *cj,
-real   *cjold,
-real   *factor,
-real   *hold,
-real    h,
+real    x,
+real    delx,
+mreal   y,
+vreal   delta,
+vreal   deltaaux,
+vreal   DFx,
+mmreal  DFy,
+void    (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
+);
+
+void 
+SETDFCOLOR (
+int     n,
+int     o,
+real    h,
+real    uround,
+real    x,
+real    dx,
+real    wtx,
+mreal   y,
+mreal   dy,
+mreal   wty,
+vint    p,
+vreal   deltah,
+vreal   delta,
+vreal   deltaaux,
+vreal   DFx,
+mmreal  DFy,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
+);
+
+coloring *
+COLORALLOC (
+int   n,
+int   o,
+int   nnz,
+vint  ia,
+vint  ja
+);
+
+void 
+COLORFREE (
+coloring *cpr
+);
+
+real 
+PATTERNRAND (
+unsigned long *seed
+);
+
+pattern *
+PATTERNALLOC (
+int   n,
+int   o,
+int   nnz
+);
+
+void 
+PATTERNFREE (
+pattern *pt
+);
+
+pattern *
+PATTERNDETECT (
+int     n,
+int     o,
+real    x,
+mreal   y,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+);
+
+int 
+PATTERNWRITE (
+char    *file,
+pattern *pt
+);
+
+pattern *
+PATTERNREAD (
+char *file,
+int   n,
+int   o
+);
+
+int 
+PATTERNDH (
+pattern *pt,
+int      r,
+vint     p,
+vint     q,
+vint     ia,
+vint     ja
+);
+
+fdjac *
+FDALLOC (
+int   n,
+int   o,
+int   nthreads
+);
+
+void 
+FDFREE (
+fdjac *fd
+);
+
+qrthr *
+QRTHALLOC (
+int   dim,
+int   nb,
+int   nthreads,
+int   nmin
+);
+
+void 
+QRTHFREE (
+qrthr *qt
+);
+
+void 
+QRTHTASK (
+int   id,
+void *arg
+);
+
+void 
+QRTHRUN (
+qrthr *qt,
+int    kind,
+int    m,
+int    n,
+int    k0,
+int    k1,
+int    j0,
+int    j1,
+mreal  A,
+mreal  T,
+vint   p,
+vint   q
+);
+
+void 
+FDSETUP (
+fdjac  *fd,
+int     kind,
+int     ncol,
+int     n,
+int     o,
+int     r,
+int     dim,
+real    x,
+mreal   y,
+vreal   base,
+void   (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+);
+
+void 
+FDTASK (
+int   id,
+void *arg
+);
+
+fbatch *
+FBALLOC (
+int   n,
+int   o,
+int   mmax,
+void (*Fb)(int,int,int,vreal,mmreal,mreal,void *)
+);
+
+void 
+FBFREE (
+fbatch *fb
+);
+
+void 
+FBRUN (
+fbatch *fb
+);
+
+void 
+firststep (
+int     n,
+int     o,
+int     r,
+real    cx,
+mreal   cy,
+vreal   phix,
+mmreal  phiy,
+vint    p,
+vint    q,
+real    taux,
+mreal   tauy,
+real   *cj,
+real   *cjold,
+real   *factor,
+real   *hold,
+real    h,
 int    *k,
 int    *kold,
 int    *ns,
@@ -564,62 +1196,807 @@ real   *pdcx
 );
 
 int 
-functionnorm (
+functionnorm (
+int   n,
+vreal x,
+vreal tol
+);
+
+real 
+POWER (
+real x,
+int  y
+);
+
+real 
+ROOT ( 
+real x,
+int  y
+);
+
+void    
+PIVOT (
+int   n,
+int   k,
+mreal A,
+mreal Q
+); 
+
+void
+KROT (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+);
+
+real
+KDOT (
+int    n,
+vreal  x,
+vreal  y
+);
+
+void
+KACC (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+);
+
+void
+KPRED (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+);
+
+real
+KWMAX (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+);
+
+real
+KWSSQ (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+);
+
+#ifdef GSDAE_X86
+
+void
+KROTSSE2 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+);
+
+real
+KDOTSSE2 (
+int    n,
+vreal  x,
+vreal  y
+);
+
+void
+KACCSSE2 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+);
+
+void
+KPREDSSE2 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+);
+
+real
+KWMAXSSE2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+);
+
+real
+KWSSQSSE2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+);
+
+__m256d
+KGET4 (
+vreal  x,
+vint   q
+);
+
+void
+KPUT4 (
+vreal    x,
+vint     q,
+__m256d  v
+);
+
+void
+KROTAVX2 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+);
+
+real
+KDOTAVX2 (
+int    n,
+vreal  x,
+vreal  y
+);
+
+void
+KACCAVX2 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+);
+
+void
+KPREDAVX2 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+);
+
+real
+KWMAXAVX2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+);
+
+real
+KWSSQAVX2 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+);
+
+__m512d
+KGET8 (
+vreal  x,
+vint   q
+);
+
+void
+KPUT8 (
+vreal    x,
+vint     q,
+__m512d  v
+);
+
+void
+KROT512 (
+int    n,
+vreal  x,
+vreal  y,
+vint   q,
+real   c,
+real   s
+);
+
+real
+KDOT512 (
+int    n,
+vreal  x,
+vreal  y
+);
+
+void
+KACC512 (
+int    n,
+real   a,
+vreal  x,
+vreal  y,
+vreal  z,
+vint   q
+);
+
+void
+KPRED512 (
+int    n,
+int    m,
+int    ns,
+vreal  b,
+vreal  a,
+vreal  x,
+int    ld,
+vreal  y,
+vreal  z
+);
+
+real
+KWMAX512 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   vmax
+);
+
+real
+KWSSQ512 (
+int    n,
+vreal  c,
+vreal  w,
+vint   q,
+real   v
+);
+
+#endif
+
+void 
+GIVENS ( 
+int   m,
+int   n,
+int   i,
+int   k,
+mreal A,
+mreal Q,
+real  s1,
+real  s2
+);
+
+void 
+QR (
+int    m,
+int    n,
+mreal  A,
+mreal  Q,
+int    pivot,
+real  *cond
+);
+
+void 
+NEWTON (
+int    n,
+mreal  Q,
+mreal  A,
+vreal  u,
+vreal  delta,
+real  ac
+);
+
+void 
+FACTORDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+real    h,
+real    cj,
+real    tolerancia,
+real    pcx,
+real    pdcx,
+real    wtx,
+mreal   pcy,
+mreal   pdcy,
+mreal   wty,
+vint    p,
+vint    q,
+vreal   delta,
+vreal   deltax,
+vreal   deltah,
+vreal   deltahx,
+vreal   DFx,
+mmreal  DFy,
+int     nDH,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void  (*DF)(int,int,real,mreal,vreal,mmreal,void *),
+void   *data,
+mreal   DH,
+mreal   Q,
+solver *ls,
+real   *cond
+);
+
+int 
+REFACTORDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+real    h,
+real    cj,
+real    pcx,
+real    pdcx,
+mreal   pcy,
+mreal   pdcy,
+vint    p,
+vint    q,
+vreal   DFx,
+mmreal  DFy,
+void   *data,
+mreal   DH,
+mreal   Q,
+solver *ls,
+real   *cond
+);
+
+void 
+SOLVEDH (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+void 
+BROYDENAPPLY (
+solver *ls,
+int     dim,
+vreal   u
+);
+
+void 
+BROYDENUPDATE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   deltah,
+real    ac
+);
+
+void 
+SETDHSCHUR (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    p,
+vint    q,
+vreal   DFx,
+mmreal  DFy,
+mreal   DH,
+solver *ls
+);
+
+void 
+SCHURSOLVE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+mmreal  DFy,
+mreal   Q,
+mreal   DH,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+real 
+HOUSEHOLDER (
+int    m,
+int    k,
+mreal  A
+);
+
+void 
+QRH (
+int     m,
+int     n,
+mreal   A,
+mreal   T,
+solver *ls,
+int     pivot,
+real   *cond
+);
+
+void 
+QRHUPDATE (
+int     m,
+mreal   A,
+mreal   T,
+mreal   W,
+int     k0,
+int     k1,
+int     ja,
+int     jb
+);
+
+void 
+NEWTONH (
+int     n,
+mreal   T,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+int 
+LUH (
+int     n,
+mreal   A,
+solver *ls,
+real   *cond
+);
+
+void 
+LUHUPDATE (
+int     n,
+mreal   A,
+int     k0,
+int     k1,
+int     ja,
+int     jb
+);
+
+void 
+NEWTONLU (
+int     n,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+void 
+FACTORH (
+int     n,
+mreal   A,
+mreal   T,
+solver *ls,
+real   *cond
+);
+
+void 
+SOLVEH (
+int     n,
+mreal   T,
+mreal   A,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+void 
+SETCHAIN (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    q,
+solver *ls
+);
+
+void 
+SETDHSPARSE (
+int     n,
+int     o,
+int     r,
+real    cj,
+real    h,
+mreal   py,
+real    dpx,
+mreal   dpy,
+vint    q,
+vreal   DFx,
+solver *ls
+);
+
+void 
+SPARSESOLVE (
+int     n,
+int     o,
+int     r,
+int     dim,
+vint    p,
+vint    q,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+sparse *
+SPARSEALLOC (
+int   n,
+int   o,
+int   nnz,
+vint  ia,
+vint  ja
+);
+
+void 
+SPARSEFREE (
+sparse *sp
+);
+
+int 
+SPARSEORDER (
+int     n,
+sparse *sp
+);
+
+int 
+SPARSEREACH (
+sparse *sp,
+int     col
+);
+
+int 
+SPARSELU (
+sparse *sp,
+real   *cond
+);
+
+int 
+SPARSEREFACT (
+sparse *sp,
+real   *cond
+);
+
+void 
+SPARSELUSOLVE (
+sparse *sp,
+vreal   b,
+vreal   z
+);
+
+int 
+SPARSEREGULAR (
+int     n,
+int     o,
+sparse *sp
+);
+
+void 
+SPARSETAU (
+int     n,
+int     o,
+int     r,
+mreal   y,
+vint    p,
+vint    q,
+vreal   DFx,
+sparse *sp,
+vreal   z,
+real   *cond
+);
+
+int 
+PERMSIGN (
 int   n,
-vreal x,
-vreal tol
+vint  p,
+vint  w
 );
 
-real 
-POWER (
-real x,
-int  y
+krylov *
+KRYLOVALLOC (
+int  n,
+int  o,
+int  m
+);
+
+void 
+KRYLOVFREE (
+krylov *kr
+);
+
+void 
+KRYLOVPOINT (
+krylov *kr,
+int     n,
+int     o,
+real    x,
+mreal   y,
+vreal   f,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data
+);
+
+void 
+KRYLOVJVF (
+krylov *kr,
+real    vx,
+mreal   vy,
+vreal   jv
+);
+
+void 
+KRYLOVOP (
+krylov *kr,
+int     kind,
+vreal   v,
+vreal   w
+);
+
+int 
+KRYLOVGMRES (
+krylov *kr,
+int     kind,
+int     dim,
+vreal   b,
+vreal   x,
+real    eta
+);
+
+void 
+KRYLOVSETUP (
+int     n,
+int     o,
+int     r,
+real    h,
+real    cj,
+real    pcx,
+real    pdcx,
+mreal   pcy,
+mreal   pdcy,
+vint    p,
+vint    q,
+vreal   deltax,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+solver *ls
+);
+
+void 
+KRYLOVSOLVE (
+int     dim,
+solver *ls,
+vreal   u,
+vreal   delta,
+real    ac
+);
+
+void 
+KRYLOVTAU (
+int     n,
+int     o,
+real    x,
+mreal   y,
+vint    q,
+vreal   delta,
+void  (*F)(int,int,real,mreal,vreal,void *),
+void   *data,
+krylov *kr,
+real   *cond
 );
 
 real 
-ROOT ( 
-real x,
-int  y
+KRYLOVPCB (
+krylov *kr,
+vreal   v,
+vreal   z
 );
 
-void    
-PIVOT (
-int   n,
-int   k,
-mreal A,
-mreal Q
-); 
+void 
+KRYLOVPCX (
+krylov *kr
+);
 
 void 
-GIVENS ( 
-int   m,
-int   n,
-int   i,
-int   k,
-mreal A,
-mreal Q,
-real  s1,
-real  s2
+KRYLOVPC (
+krylov *kr,
+vreal   v,
+vreal   z
 );
 
 void 
-QR (
-int    m,
-int    n,
-mreal  A,
-mreal  Q,
-int    pivot,
-real  *cond
+PCGV (
+pcstate *st,
+vreal    v,
+vreal    w
+);
+
+pcbuiltin *
+PCALLOC (
+int       n,
+int       kind,
+int       bs,
+coloring *cpr
 );
 
 void 
-NEWTON (
+PCFREE (
+pcbuiltin *pcb
+);
+
+int 
+PCSETUP (
+real     cj,
+real     h,
+pcstate *st,
+void    *pdata
+);
+
+void 
+PCSOLVE (
 int    n,
-mreal  Q,
-mreal  A,
-vreal  u,
-vreal  delta,
-real  ac
+vreal  rhs,
+void  *pdata
 );
 
 real    
@@ -653,6 +2030,31 @@ vint   p,
 vint   q
 );
 
+int 
+QR2TH (
+int     n,
+mreal   A,
+mreal   Q,
+vint    p,
+vint    q,
+solver *ls
+);
+
+void 
+QR2UPDATE (
+int    n,
+int    i,
+mreal  A,
+mreal  Q,
+vint   p,
+vint   q,
+vreal  rc,
+vreal  rs,
+vint   rk,
+int    ja,
+int    jb
+);
+
 void 
 SOLVESYSTEM (
 int    n,
@@ -690,6 +2092,79 @@ vint  *infoinput,
 vint  *infooutput
 );
 
+void 
+FPAR (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  delta,
+void  *data
+);
+
+void 
+DFPAR (
+int    o,
+int    n,
+real   x,
+mreal  y,
+vreal  DFx,
+mmreal DFy,
+void  *data
+);
+
+void *
+ARENAGET (
+arena  *ar,
+size_t  size
+);
+
+vint 
+ARENAVINT (
+arena *ar,
+int    n
+);
+
+vreal 
+ARENAVREAL (
+arena *ar,
+int    n
+);
+
+mreal 
+ARENAMREAL (
+arena *ar,
+int    m,
+int    n
+);
+
+mmreal 
+ARENAMMREAL (
+arena *ar,
+int    m,
+int    n,
+int    k
+);
+
+mmreal 
+ARENAPHI (
+arena *ar,
+int    m,
+int    o,
+int    n
+);
+
+int 
+ARENAALLOC (
+arena *ar,
+int    huge
+);
+
+void 
+ARENAFREE (
+arena *ar
+);
+
 vint   
 ALLOCVINT (
 int n
@@ -781,3 +2256,16 @@ int    n,
 int    k,
 mmreal v
 );
+
+mmreal  
+ALLOCPHI ( 
+int m,
+int o,
+int n
+);
+
+mmreal 
+FREEPHI (
+int    m,
+mmreal v
+);
@@ -0,0 +1,610 @@
+/* ****************************************************** */
+/*                                                        */
+/*                    CODIGO GSDAE                        */
+/*                  ARQUIVO gsdae.hpp                     */
+/*                                                        */
+/*  Interface C++ (somente cabecalho) para os contextos   */
+/*  do GSDAE : F e DF podem ser funcoes lambda ou objetos */
+/*  funcao, e a classe gsdae::solver e dona do contexto e */
+/*  dos vetores de entrada e saida (ALLOCCTX e FREECTX).  */
+/*                                                        */
+/* ****************************************************** */
+/*                                                        */
+/*  Uso :                                                 */
+/*                                                        */
+/*    auto F = [w](int o, int n, real x, mreal y,         */
+/*                 vreal delta) { ... };                  */
+/*    gsdae::solver<decltype(F)> sv(n,o,F);               */
+/*    sv.y(0,1) = 1.0;                                    */
+/*    sv.tolerances(1.0e-9,1.0e-7,1.0e-6);                */
+/*    while (sv.advance(send) > 0) ;                      */
+/*                                                        */
+/*  F(o,n,x,y,delta) e DF(o,n,x,y,DFx,DFy) tem os mesmos  */
+/*  argumentos das rotinas da interface C (sem data), com */
+/*  os indices a partir de 1. Sem DF (gsdae::nojac) as    */
+/*  jacobianas sao aproximadas por diferencas finitas.    */
+/*                                                        */
+/*  A chamada de F pela interface C e indireta e nao pode */
+/*  ser expandida no local. Por isso a classe informa     */
+/*  tambem a versao em lotes de F (SETFBATCH) : as        */
+/*  colunas das jacobianas aproximadas sao avaliadas em   */
+/*  um laco sobre os pontos do lote em que F e expandida  */
+/*  pelo compilador e pode ser vetorizada. Como a versao  */
+/*  em lotes tem prioridade sobre SETTHREADS, as colunas  */
+/*  sao divididas entre k threads por threads(k), que a   */
+/*  retira com k > 1 e a restaura com k <= 1.             */
+/*                                                        */
+/*  Com gsdae::autojac<N> no lugar de DF as jacobianas    */
+/*  sao exatas, obtidas por derivacao automatica (modo    */
+/*  direto, N direcoes por avaliacao) de F. F deve ser    */
+/*  generica nos tipos de x, y e delta :                  */
+/*                                                        */
+/*    auto F = [](int o, int n, auto x, auto y,           */
+/*                auto delta) { ... };                    */
+/*    gsdae::solver<decltype(F),gsdae::autojac<>>         */
+/*      sv(n,o,F);                                        */
+/*                                                        */
+/*  Com um padrao informado por SETPATTERN(sv.ctx(),...)  */
+/*  cada direcao agrupa as variaveis de uma cor.          */
+/*                                                        */
+/*  advance e advancex chamam GSDAECTX e CSDAECTX com o   */
+/*  estado guardado na classe e retornam o mesmo codigo;  */
+/*  info() da acesso a infoinput para as demais opcoes.   */
+/*  O contexto e liberado no destrutor; a classe pode ser */
+/*  movida, mas nao copiada.                              */
+/*                                                        */
+/* ****************************************************** */
+
+#ifndef GSDAE_HPP
+#define GSDAE_HPP
+
+extern "C" {
+#include "gsdae.h"
+}
+
+#include <cmath>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace gsdae {
+
+/* ****************************************************** */
+/* DF ausente : jacobianas por diferencas finitas         */
+/* ****************************************************** */
+
+struct nojac {
+};
+
+/* ****************************************************** */
+/* numeros duais com N direcoes : v + d[0] e_1 + ... +    */
+/* d[N-1] e_N, com e_l e_m = 0 (modo direto da derivacao  */
+/* automatica)                                            */
+/* ****************************************************** */
+
+template <int N>
+struct dual {
+  real v;      /* valor                 */
+  real d[N];   /* derivadas direcionais */
+
+  dual (real v0 = 0.0) : v(v0) { for (int l = 0; l < N; l++) d[l] = 0.0; }
+
+  dual &operator+= (const dual &b) { return (*this = *this+b); }
+  dual &operator-= (const dual &b) { return (*this = *this-b); }
+  dual &operator*= (const dual &b) { return (*this = *this*b); }
+  dual &operator/= (const dual &b) { return (*this = *this/b); }
+  dual &operator+= (real b) { v += b; return (*this); }
+  dual &operator-= (real b) { v -= b; return (*this); }
+  dual &operator*= (real b) { return (*this = *this*b); }
+  dual &operator/= (real b) { return (*this = *this/b); }
+};
+
+/* regra da cadeia : g(a) com g(a.v) = gv e g'(a.v) = dg */
+template <int N>
+inline dual<N>
+chain (const dual<N> &a, real gv, real dg)
+{
+  dual<N> r(gv);
+  for (int l = 0; l < N; l++) r.d[l] = dg*a.d[l];
+  return (r);
+}
+
+template <int N>
+inline dual<N>
+operator- (const dual<N> &a)
+{
+  return (chain(a,-a.v,-1.0));
+}
+
+template <int N>
+inline dual<N>
+operator+ (const dual<N> &a, const dual<N> &b)
+{
+  dual<N> r(a.v+b.v);
+  for (int l = 0; l < N; l++) r.d[l] = a.d[l]+b.d[l];
+  return (r);
+}
+
+template <int N>
+inline dual<N>
+operator- (const dual<N> &a, const dual<N> &b)
+{
+  dual<N> r(a.v-b.v);
+  for (int l = 0; l < N; l++) r.d[l] = a.d[l]-b.d[l];
+  return (r);
+}
+
+template <int N>
+inline dual<N>
+operator* (const dual<N> &a, const dual<N> &b)
+{
+  dual<N> r(a.v*b.v);
+  for (int l = 0; l < N; l++) r.d[l] = a.d[l]*b.v+a.v*b.d[l];
+  return (r);
+}
+
+template <int N>
+inline dual<N>
+operator/ (const dual<N> &a, const dual<N> &b)
+{
+  real    q = a.v/b.v;
+  dual<N> r(q);
+  for (int l = 0; l < N; l++) r.d[l] = (a.d[l]-q*b.d[l])/b.v;
+  return (r);
+}
+
+template <int N>
+inline dual<N> operator+ (const dual<N> &a, real b) { return (chain(a,a.v+b,1.0)); }
+template <int N>
+inline dual<N> operator+ (real a, const dual<N> &b) { return (chain(b,a+b.v,1.0)); }
+template <int N>
+inline dual<N> operator- (const dual<N> &a, real b) { return (chain(a,a.v-b,1.0)); }
+template <int N>
+inline dual<N> operator- (real a, const dual<N> &b) { return (chain(b,a-b.v,-1.0)); }
+template <int N>
+inline dual<N> operator* (const dual<N> &a, real b) { return (chain(a,a.v*b,b)); }
+template <int N>
+inline dual<N> operator* (real a, const dual<N> &b) { return (chain(b,a*b.v,a)); }
+template <int N>
+inline dual<N> operator/ (const dual<N> &a, real b) { return (chain(a,a.v/b,1.0/b)); }
+template <int N>
+inline dual<N> operator/ (real a, const dual<N> &b) { return (chain(b,a/b.v,-a/(b.v*b.v))); }
+
+/* comparacoes pelo valor */
+#define GSDAE_DUALCMP(op)                                                     \
+template <int N>                                                              \
+inline bool operator op (const dual<N> &a, const dual<N> &b) { return (a.v op b.v); } \
+template <int N>                                                              \
+inline bool operator op (const dual<N> &a, real b) { return (a.v op b); }    \
+template <int N>                                                              \
+inline bool operator op (real a, const dual<N> &b) { return (a op b.v); }
+
+GSDAE_DUALCMP(<)
+GSDAE_DUALCMP(>)
+GSDAE_DUALCMP(<=)
+GSDAE_DUALCMP(>=)
+GSDAE_DUALCMP(==)
+GSDAE_DUALCMP(!=)
+
+#undef GSDAE_DUALCMP
+
+/* funcoes elementares (encontradas por ADL em F generica) */
+template <int N>
+inline dual<N> sqrt (const dual<N> &a)
+{ real s = std::sqrt(a.v); return (chain(a,s,0.5/s)); }
+template <int N>
+inline dual<N> exp (const dual<N> &a)
+{ real e = std::exp(a.v); return (chain(a,e,e)); }
+template <int N>
+inline dual<N> log (const dual<N> &a)
+{ return (chain(a,std::log(a.v),1.0/a.v)); }
+template <int N>
+inline dual<N> sin (const dual<N> &a)
+{ return (chain(a,std::sin(a.v),std::cos(a.v))); }
+template <int N>
+inline dual<N> cos (const dual<N> &a)
+{ return (chain(a,std::cos(a.v),-std::sin(a.v))); }
+template <int N>
+inline dual<N> tan (const dual<N> &a)
+{ real t = std::tan(a.v); return (chain(a,t,1.0+t*t)); }
+template <int N>
+inline dual<N> atan (const dual<N> &a)
+{ return (chain(a,std::atan(a.v),1.0/(1.0+a.v*a.v))); }
+template <int N>
+inline dual<N> sinh (const dual<N> &a)
+{ return (chain(a,std::sinh(a.v),std::cosh(a.v))); }
+template <int N>
+inline dual<N> cosh (const dual<N> &a)
+{ return (chain(a,std::cosh(a.v),std::sinh(a.v))); }
+template <int N>
+inline dual<N> tanh (const dual<N> &a)
+{ real t = std::tanh(a.v); return (chain(a,t,1.0-t*t)); }
+template <int N>
+inline dual<N> fabs (const dual<N> &a)
+{ return (chain(a,std::fabs(a.v),(a.v < 0.0) ? -1.0 : 1.0)); }
+template <int N>
+inline dual<N> pow (const dual<N> &a, real b)
+{ return (chain(a,std::pow(a.v,b),b*std::pow(a.v,b-1.0))); }
+template <int N>
+inline dual<N> pow (const dual<N> &a, const dual<N> &b)
+{ return (exp(b*log(a))); }
+
+/* ****************************************************** */
+/* DF por derivacao automatica de uma F generica : F e    */
+/* avaliada com numeros duais de N direcoes, e cada       */
+/* avaliacao fornece N colunas de DFx e DFy. Com o padrao */
+/* de SETPATTERN cada direcao e uma cor (todas as         */
+/* variaveis da cor), e DF custa ((o+1)*ncolor+1)/N       */
+/* avaliacoes em vez de ((o+1)*n+1)/N.                    */
+/* ****************************************************** */
+
+template <int N = 8>
+class autojac {
+
+public:
+
+  template <class Fun>
+  void
+  operator() (Fun &f, coloring *cpr, int o, int n, real x, mreal y,
+              vreal DFx, mmreal DFy)
+  {
+    int ncol;   /* direcoes por ordem k             */
+    int ndir;   /* direcoes : x e (o+1)*ncol de y   */
+    int d0, m;  /* primeira direcao e direcoes do passo */
+
+    alloc(o,n);
+    ncol = (cpr != NULL) ? cpr->ncolor : n;
+    ndir = (o+1)*ncol+1;
+
+    /* valores do ponto (derivadas nulas) */
+    for (int k = 0; k <= o; k++)
+      for (int i = 1; i <= n; i++)
+        yp_[k][i] = dual<N>(y[k][i]);
+
+    /* elementos fora do padrao */
+    if (cpr != NULL)
+      for (int k = 0; k <= o; k++)
+        for (int j = 1; j <= n; j++)
+          for (int i = 1; i <= n; i++)
+            DFy[k][j][i] = 0.0;
+
+    for (d0 = 0; d0 < ndir; d0 += N) {
+      m = (ndir-d0 < N) ? ndir-d0 : N;
+      dual<N> xd(x);
+      for (int l = 0; l < m; l++)
+        seed(cpr,ncol,d0+l,l,1.0,xd);
+      f(o,n,xd,yp_.data(),dl_.data());
+      for (int l = 0; l < m; l++) {
+        seed(cpr,ncol,d0+l,l,0.0,xd);
+        store(cpr,ncol,n,d0+l,l,DFx,DFy);
+      }
+    }
+  }
+
+private:
+
+  std::vector<dual<N>>   yd_;   /* y(s) com (o+1) x (n+1) posicoes */
+  std::vector<dual<N> *> yp_;   /* linhas de yd_ (indices de 1)    */
+  std::vector<dual<N>>   dl_;   /* delta (indices de 1)            */
+
+  void
+  alloc (int o, int n)
+  {
+    if ((yp_.size() == (size_t) (o+1)) && (dl_.size() == (size_t) (n+1)))
+      return;
+    yd_.assign((o+1)*(n+1),dual<N>());
+    yp_.resize(o+1);
+    dl_.assign(n+1,dual<N>());
+    for (int k = 0; k <= o; k++)
+      yp_[k] = &yd_[k*(n+1)];
+  }
+
+  /* direcao dir (0 : x; 1+k*ncol+c-1 : cor ou variavel c de y[k]) */
+  /* na componente l das derivadas                                 */
+  void
+  seed (coloring *cpr, int ncol, int dir, int l, real e, dual<N> &xd)
+  {
+    int k, c;
+
+    if (dir == 0) {
+      xd.d[l] = e;
+      return;
+    }
+    k = (dir-1)/ncol;
+    c = (dir-1)%ncol+1;
+    if (cpr == NULL)
+      yp_[k][c].d[l] = e;
+    else
+      for (int g = cpr->gp[c]; g < cpr->gp[c+1]; g++)
+        yp_[k][cpr->gv[g]].d[l] = e;
+  }
+
+  /* colunas da direcao dir : DFx ou DFy[k][j] (j na cor c) */
+  void
+  store (coloring *cpr, int ncol, int n, int dir, int l, vreal DFx,
+         mmreal DFy)
+  {
+    int k, c, j;
+
+    if (dir == 0) {
+      for (int i = 1; i <= n; i++)
+        DFx[i] = dl_[i].d[l];
+      return;
+    }
+    k = (dir-1)/ncol;
+    c = (dir-1)%ncol+1;
+    if (cpr == NULL) {
+      for (int i = 1; i <= n; i++)
+        DFy[k][c][i] = dl_[i].d[l];
+      return;
+    }
+    /* cada equacao depende de no maximo uma variavel da cor */
+    for (int g = cpr->gp[c]; g < cpr->gp[c+1]; g++) {
+      j = cpr->gv[g];
+      for (int q = cpr->cp[j]; q < cpr->cp[j+1]; q++)
+        DFy[k][j][cpr->ri[q]] = dl_[cpr->ri[q]].d[l];
+    }
+  }
+
+};
+
+/* avaliacao de DF : rotina do usuario ou derivacao automatica */
+template <class Jac, class Fun>
+inline void
+evaljac (Jac &df, Fun &, coloring *, int o, int n, real x, mreal y,
+         vreal DFx, mmreal DFy)
+{
+  df(o,n,x,y,DFx,DFy);
+}
+
+template <int N, class Fun>
+inline void
+evaljac (autojac<N> &df, Fun &f, coloring *cpr, int o, int n, real x,
+         mreal y, vreal DFx, mmreal DFy)
+{
+  df(f,cpr,o,n,x,y,DFx,DFy);
+}
+
+/* ****************************************************** */
+/* dados repassados para as rotinas F e DF do contexto    */
+/* ****************************************************** */
+
+template <class Fun, class Jac>
+struct callbacks {
+  Fun        f;
+  Jac        df;
+  gsdae_ctx *ctx;   /* padrao de DFy (SETPATTERN) para autojac */
+
+  callbacks (Fun f0, Jac df0)
+    : f(std::move(f0)), df(std::move(df0)), ctx(NULL) {}
+
+  static void
+  F (int o, int n, real x, mreal y, vreal delta, void *data)
+  {
+    static_cast<callbacks *>(data)->f(o,n,x,y,delta);
+  }
+
+  /* F nos m pontos de um lote (SETFBATCH) : f e expandida no laco */
+  static void
+  FB (int o, int n, int m, vreal xs, mmreal ys, mreal fs, void *data)
+  {
+    Fun &f = static_cast<callbacks *>(data)->f;
+    for (int l = 1; l <= m; l++)
+      f(o,n,xs[l],ys[l],fs[l]);
+  }
+
+  static void
+  DF (int o, int n, real x, mreal y, vreal DFx, mmreal DFy, void *data)
+  {
+    callbacks *cb = static_cast<callbacks *>(data);
+    evaljac(cb->df,cb->f,(cb->ctx != NULL) ? cb->ctx->ls.cpr : NULL,
+            o,n,x,y,DFx,DFy);
+  }
+};
+
+/* rotina DF do contexto (NULL sem DF) */
+typedef void (*dfroutine)(int,int,real,mreal,vreal,mmreal,void *);
+
+template <class Fun, class Jac>
+struct jacobian {
+  static dfroutine get () { return (callbacks<Fun,Jac>::DF); }
+};
+
+template <class Fun>
+struct jacobian<Fun,nojac> {
+  static dfroutine get () { return (NULL); }
+};
+
+/* ****************************************************** */
+/* integrador de uma EAD de dimensao n e ordem o          */
+/* ****************************************************** */
+
+template <class Fun, class Jac = nojac>
+class solver {
+
+public:
+
+  /* mmax : pontos por chamada da versao em lotes de F   */
+  /* (<= 0 : GSDAE_FBMAX)                                 */
+  solver (int n, int o, Fun f, Jac df = Jac(), int mmax = 0)
+    : n_(n), o_(o), mmax_(mmax),
+      cb_(new callbacks<Fun,Jac>(std::move(f),std::move(df)))
+  {
+    ctx_   = ALLOCCTX(n,o,callbacks<Fun,Jac>::F,jacobian<Fun,Jac>::get(),
+                      cb_.get());
+    y_     = ALLOCMREAL(o,n);
+    atoly_ = ALLOCMREAL(o,n);
+    rtoly_ = ALLOCMREAL(o,n);
+    ftol_  = ALLOCVREAL(n);
+    ii_    = ALLOCVINT(2*n+10);
+    io_    = ALLOCVINT(2*n+10);
+    if ((ctx_ == NULL) || (y_ == NULL) || (atoly_ == NULL) ||
+        (rtoly_ == NULL) || (ftol_ == NULL) || (ii_ == NULL) ||
+        (io_ == NULL) ||
+        (SETFBATCH(ctx_,callbacks<Fun,Jac>::FB,mmax) != 0)) {
+      release();
+      throw std::bad_alloc();
+    }
+    cb_->ctx = ctx_;
+
+    /* valores iniciais; infoinput[2] = 1 se ha DF */
+    s_     = 0.0;
+    x_     = 0.0;
+    h_     = 1.0e-6;
+    hmin_  = 1.0e-16;
+    hmax_  = 0.0;
+    cdmax_ = 1.0e50;
+    atolx_ = 0.0;
+    rtolx_ = 0.0;
+    ii_[2] = (jacobian<Fun,Jac>::get() != NULL);
+  }
+
+  ~solver ()
+  {
+    release();
+  }
+
+  solver (const solver &) = delete;
+  solver &operator= (const solver &) = delete;
+
+  solver (solver &&sv) noexcept
+  {
+    take(sv);
+  }
+
+  solver &operator= (solver &&sv) noexcept
+  {
+    if (this != &sv) {
+      release();
+      take(sv);
+    }
+    return (*this);
+  }
+
+  /* ponto c(s) = (x(s),y(s)) */
+  real  &s () { return (s_); }
+  real  &x () { return (x_); }
+  real  &y (int k, int i) { return (y_[k][i]); }
+  mreal  y () { return (y_); }
+
+  /* passos inicial, minimo e maximo e condicao maxima */
+  real  &h () { return (h_); }
+  real  &hmin () { return (hmin_); }
+  real  &hmax () { return (hmax_); }
+  real  &cdmax () { return (cdmax_); }
+
+  /* tolerancias iguais para todas as variaveis (infoinput[3] = 1) */
+  void
+  tolerances (real atol, real rtol, real ftol)
+  {
+    atolx_    = atol;
+    rtolx_    = rtol;
+    ftol_[1]  = ftol;
+    ii_[3]    = 1;
+  }
+
+  /* tolerancias de cada variavel (infoinput[3] = 2) */
+  real  &atolx () { return (atolx_); }
+  real  &rtolx () { return (rtolx_); }
+  mreal  atoly () { return (atoly_); }
+  mreal  rtoly () { return (rtoly_); }
+  vreal  ftol () { return (ftol_); }
+
+  /* infoinput e infooutput de GSDAECTX e CSDAECTX */
+  vint   info () { return (ii_); }
+  vint   infooutput () { return (io_); }
+
+  /* contexto (para SETPATTERN, STATISTICSCTX, ...; SETTHREADS */
+  /* nao tem efeito com a versao em lotes de F : use threads)  */
+  gsdae_ctx *ctx () { return (ctx_); }
+
+  /* colunas das jacobianas aproximadas divididas entre k     */
+  /* threads (SETTHREADS) com F ponto a ponto; k <= 1 volta   */
+  /* aos lotes                                                */
+  int
+  threads (int k)
+  {
+    if (SETTHREADS(ctx_,k) != 0)
+      return (-1);
+    return (SETFBATCH(ctx_,(k > 1) ? NULL : callbacks<Fun,Jac>::FB,mmax_));
+  }
+
+  /* integracao ate s = send (GSDAECTX) */
+  int
+  advance (real send)
+  {
+    return (GSDAECTX(ctx_,n_,o_,h_,hmin_,hmax_,cdmax_,&s_,send,&x_,y_,
+                     atolx_,atoly_,rtolx_,rtoly_,ftol_,ii_,io_));
+  }
+
+  /* integracao ate x = xend (CSDAECTX) */
+  int
+  advancex (real xend)
+  {
+    return (CSDAECTX(ctx_,n_,o_,h_,hmin_,hmax_,cdmax_,&s_,&x_,xend,y_,
+                     atolx_,atoly_,rtolx_,rtoly_,ftol_,ii_,io_));
+  }
+
+private:
+
+  int        n_, o_, mmax_;
+  std::unique_ptr<callbacks<Fun,Jac>> cb_;
+  gsdae_ctx *ctx_   = NULL;
+  mreal      y_     = NULL;
+  mreal      atoly_ = NULL;
+  mreal      rtoly_ = NULL;
+  vreal      ftol_  = NULL;
+  vint       ii_    = NULL;
+  vint       io_    = NULL;
+  real       s_, x_, h_, hmin_, hmax_, cdmax_, atolx_, rtolx_;
+
+  void
+  release ()
+  {
+    if (ctx_   != NULL) FREECTX(ctx_);
+    if (y_     != NULL) FREEMREAL(o_,n_,y_);
+    if (atoly_ != NULL) FREEMREAL(o_,n_,atoly_);
+    if (rtoly_ != NULL) FREEMREAL(o_,n_,rtoly_);
+    if (ftol_  != NULL) FREEVREAL(n_,ftol_);
+    if (ii_    != NULL) FREEVINT(2*n_+10,ii_);
+    if (io_    != NULL) FREEVINT(2*n_+10,io_);
+    ctx_ = NULL;
+    y_   = atoly_ = rtoly_ = NULL;
+    ftol_ = NULL;
+    ii_  = io_ = NULL;
+  }
+
+  void
+  take (solver &sv)
+  {
+    n_      = sv.n_;
+    o_      = sv.o_;
+    mmax_   = sv.mmax_;
+    cb_     = std::move(sv.cb_);
+    ctx_    = sv.ctx_;
+    y_      = sv.y_;
+    atoly_  = sv.atoly_;
+    rtoly_  = sv.rtoly_;
+    ftol_   = sv.ftol_;
+    ii_     = sv.ii_;
+    io_     = sv.io_;
+    s_      = sv.s_;
+    x_      = sv.x_;
+    h_      = sv.h_;
+    hmin_   = sv.hmin_;
+    hmax_   = sv.hmax_;
+    cdmax_  = sv.cdmax_;
+    atolx_  = sv.atolx_;
+    rtolx_  = sv.rtolx_;
+    sv.ctx_ = NULL;
+    sv.y_   = sv.atoly_ = sv.rtoly_ = NULL;
+    sv.ftol_ = NULL;
+    sv.ii_  = sv.io_ = NULL;
+  }
+
+};
+
+}
+
+#endif
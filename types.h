@@ -59,8 +59,374 @@ typedef real  ***mmreal;
 /* os dados utilizados em GSDAE                          */
 /* ***************************************************** */
 
+/* ***************************************************** */
+/* definindo a estrutura arena que armazena um bloco     */
+/* contiguo de memoria do qual sao retirados os vetores  */
+/* e matrizes de um contexto                             */
+/* ***************************************************** */
+
+/* modos de alocacao de um contexto */
+#define GSDAE_MALLOC 0   /* um malloc por linha          */
+#define GSDAE_ARENA  1   /* um unico bloco alinhado      */
+#define GSDAE_HUGE   2   /* bloco unico em paginas       */
+                         /* grandes (quando disponiveis) */
+
+/* alinhamento dos blocos da arena (linha de cache) */
+#define GSDAE_ALIGN  64
+
+/* colunas por bloco nas passagens fundidas sobre o historico */
+/* phiy e o estado (update e PREDICTSTEP) : o bloco das k+2   */
+/* linhas de phi e dos vetores do passo cabe na cache L1      */
+#define GSDAE_PHIBLK 256
+
+typedef struct arena  arena; 
+
+struct arena {
+  char   *base;   /* inicio do bloco (NULL : contagem) */
+  size_t  size;   /* tamanho do bloco                  */
+  size_t  used;   /* bytes utilizados                  */
+  int     mapped; /* bloco alocado com mmap            */
+};
+
+/* ***************************************************** */
+/* definindo a estrutura solver que armazena o estado do */
+/* resolvedor linear do passo de Newton (masterstep)     */
+/* ***************************************************** */
+
+/* tamanho do bloco da decomposicao QR de Householder */
+#define GSDAE_NB     32
+
+/* numero maximo de atualizacoes de Broyden entre duas */
+/* fatoracoes de DH                                    */
+#define GSDAE_NBROY  8
+
+/* com infoinput[7] = 1 DH e decomposta por LU enquanto a */
+/* condicao da ultima fatoracao nao excede GSDAE_LUFRAC   */
+/* cdmax (caso contrario volta-se a QR)                   */
+#define GSDAE_LUFRAC  1.0e-3
+
+/* com infoinput[8] = 1, numero maximo de refatoracoes de */
+/* DH para um novo cj com a jacobiana guardada antes de   */
+/* uma nova avaliacao de DF                               */
+#define GSDAE_NCJ  2
+
+/* ***************************************************** */
+/* definindo a estrutura sparse que armazena a jacobiana */
+/* esparsa (ALLOCCTXSPARSE) e a decomposicao LU esparsa  */
+/* do sistema reduzido do passo de Newton                */
+/* ***************************************************** */
+
+/* dimensao minima para o uso da LU esparsa */
+#define GSDAE_SPMIN  64
+
+/* limiar do pivoteamento parcial da LU esparsa */
+#define GSDAE_SPTOL  0.1
+
+/* pivo minimo (relativo) aceito na refatoracao */
+#define GSDAE_SPREF  1.0e-3
+
+typedef struct sparse  sparse;
+
+struct sparse {
+  int    nmin;  /* dimensao minima para a LU esparsa     */
+  /* padrao da jacobiana por linhas (equacoes)           */
+  int    nnz;   /* numero de elementos do padrao         */
+  int    o;     /* ordem alocada de val                  */
+  vint   ia;    /* inicio das linhas (1..n+1)            */
+  vint   ja;    /* variavel de cada elemento (1..nnz)    */
+  mreal  val;   /* DFy[k] no padrao (k = 0..o)           */
+  /* rotinas e dados do usuario                          */
+  void (*F)(int,int,real,mreal,vreal,void *);
+  void (*DFS)(int,int,real,mreal,vreal,mreal,void *);
+  void  *data;
+  /* sistema reduzido M (dimensao m = n+1) por colunas   */
+  int    m;
+  vint   cp;    /* inicio das colunas (1..m+1)           */
+  vint   ri;    /* linha de cada elemento                */
+  vreal  cx;    /* valor de cada elemento                */
+  vint   map;   /* posicao em M de cada elemento de ja   */
+  vint   qinv;  /* inversa da permutacao q               */
+  /* ordenacao de grau minimo (analise simbolica)        */
+  vint   perm;  /* coluna de M eliminada no passo k      */
+  /* fatores L (diagonal unitaria) e U                   */
+  int    lmax;  /* elementos alocados de L               */
+  vint   lp;
+  vint   li;
+  vreal  lx;
+  int    umax;  /* elementos alocados de U               */
+  vint   up;
+  vint   ui;
+  vreal  ux;
+  vint   pinv;  /* passo em que cada linha e pivo        */
+  int    numeric; /* 1 : padrao de L e U valido          */
+  /* areas de trabalho                                   */
+  vreal  x;
+  vint   xi;
+  vint   stack;
+  vint   pstack;
+  vint   mark;
+  int    stamp;
+  /* contadores                                          */
+  int    nlu;   /* fatoracoes com pivoteamento           */
+  int    nrelu; /* refatoracoes numericas                */
+};
+
+/* ***************************************************** */
+/* definindo a estrutura coloring que armazena o padrao  */
+/* de DFy e a coloracao das suas colunas (Curtis, Powell */
+/* e Reid) usada nas jacobianas aproximadas              */
+/* ***************************************************** */
+
+typedef struct coloring  coloring;
+
+struct coloring {
+  int    n;     /* dimensao da EAD                       */
+  int    o;     /* ordem alocada de del                  */
+  int    nnz;   /* elementos distintos do padrao         */
+  /* padrao de DFy por colunas (variaveis)               */
+  vint   cp;    /* inicio das colunas (1..n+1)           */
+  vint   ri;    /* equacao de cada elemento              */
+  /* grupos de colunas estruturalmente ortogonais        */
+  int    ncolor; /* numero de cores                      */
+  vint   color; /* cor de cada variavel                  */
+  vint   gp;    /* inicio de cada cor (1..ncolor+1)      */
+  vint   gv;    /* variaveis ordenadas por cor           */
+  /* areas de trabalho                                   */
+  mreal  del;   /* incrementos de y (0..o x n)           */
+  vreal  save;  /* valores originais de y[k]             */
+};
+
+/* ***************************************************** */
+/* definindo a estrutura pattern que armazena o padrao   */
+/* de DFy e DFx detectado por perturbacoes de F          */
+/* (PATTERNDETECT)                                       */
+/* ***************************************************** */
+
+/* numero de pontos base aleatorios da deteccao */
+#define GSDAE_NPROBE 2
+
+/* maior ordem representada na mascara de ordens */
+#define GSDAE_PMAXO  30
+
+typedef struct pattern  pattern;
+
+struct pattern {
+  int    n;     /* dimensao da EAD                       */
+  int    o;     /* ordem da EAD                          */
+  int    nnz;   /* elementos do padrao (uniao)           */
+  vint   ia;    /* inicio das linhas (1..n+1)            */
+  vint   ja;    /* variavel de cada elemento             */
+  vint   ord;   /* bit k : elemento presente em DFy[k]   */
+  vint   dx;    /* 1 : a equacao depende de x            */
+};
+
+/* ***************************************************** */
+/* definindo a estrutura krylov que armazena o estado do */
+/* corretor de Newton-Krylov (ALLOCCTXKRYLOV) : GMRES    */
+/* com reinicio e produtos jacobiana-vetor sem matriz    */
+/* ***************************************************** */
+
+/* dimensao do subespaco de Krylov (reinicio do GMRES) */
+#define GSDAE_KRM    30
+
+/* numero maximo de iteracoes do GMRES por sistema */
+#define GSDAE_KRIT   300
+
+/* termo forcante (tolerancia relativa) : o erro da correcao */
+/* fica abaixo de GSDAE_EPLI vezes a taxa estimada de         */
+/* masterstep e o limite 0.33 do seu teste de aceitacao. O    */
+/* residuo do GMRES nao tem pesos nem precondicionamento, por */
+/* isso GSDAE_EPLI e menor que o 0.05 usual (DASPK)           */
+#define GSDAE_EPLI   1.0e-3
+#define GSDAE_ETAMAX 1.0e-3
+#define GSDAE_ETAMIN 1.0e-10
+
+/* tolerancia relativa do sistema do vetor tangente */
+#define GSDAE_KRTOL  1.0e-10
+
+/* operadores de KRYLOVOP */
+#define GSDAE_KRDH   0    /* DH no ponto de linearizacao  */
+#define GSDAE_KRTAU  1    /* DFy[o] (vetor tangente)      */
+
+/* precondicionadores internos (SETPRECONDKIND) */
+#define GSDAE_PCNONE 0    /* sem precondicionador         */
+#define GSDAE_PCBJ   1    /* bloco-Jacobi de G            */
+#define GSDAE_PCILU  2    /* ILU(0) de G no padrao de DFy */
+
+typedef struct krylov  krylov;
+
+/* estado passado a rotina setup do precondicionador : o  */
+/* bloco de DH nas variaveis y[o], apos eliminar a cadeia */
+/* de derivadas, e G = DFy[o] + rho DFy[o-1] + .. +       */
+/* rho^o DFy[0], cujos produtos sao dados por PCGV        */
+typedef struct pcstate  pcstate;
+
+struct pcstate {
+  int     n;
+  int     o;
+  real    x;     /* ponto de linearizacao                 */
+  mreal   y;
+  vreal   f;     /* F no ponto                            */
+  real    cj;
+  real    h;
+  real    rho;   /* dpx/cj                                */
+  krylov *kr;
+};
+
+/* precondicionador interno : blocos LU de G (GSDAE_PCBJ) */
+/* ou ILU(0) de G no padrao informado por SETPATTERN      */
+typedef struct pcbuiltin  pcbuiltin;
+
+struct pcbuiltin {
+  int    kind;
+  int    n;
+  /* bloco-Jacobi                                        */
+  int    bs;    /* tamanho dos blocos                    */
+  mreal  B;     /* linha i : G[i][bloco de i] (n x bs)   */
+  vint   piv;   /* pivos da LU de cada bloco             */
+  /* ILU(0) : G por linhas com a diagonal                */
+  int    nnz;
+  vint   ia;
+  vint   ja;
+  vint   dg;    /* posicao da diagonal de cada linha     */
+  vreal  a;
+  vint   map;   /* posicao em a de cada elemento da CSC  */
+  vint   cp;    /* padrao por colunas (de coloring)      */
+  vint   ri;
+  int    ncolor;
+  vint   gp;    /* variaveis de cada cor                 */
+  vint   gv;
+  /* areas de trabalho                                   */
+  vreal  e;
+  vreal  w;
+  vint   iw;
+};
+
+struct krylov {
+  int    m;     /* dimensao do subespaco                 */
+  int    maxit; /* iteracoes maximas por sistema         */
+  /* dimensoes alocadas                                  */
+  int    nalloc;
+  int    oalloc;
+  /* GMRES                                               */
+  mreal  V;     /* base ortonormal (m+1 x dim)           */
+  mreal  Hs;    /* Hessenberg ((m+1) x m)                */
+  vreal  cs;    /* rotacoes de Givens                    */
+  vreal  sn;
+  vreal  g;     /* residuo no subespaco                  */
+  vreal  z;     /* vetor tangente (n+1)                  */
+  vreal  t;     /* solucao do sistema do vetor tangente  */
+  /* ponto de linearizacao (FACTORDH ou settau)          */
+  int    n;
+  int    o;
+  int    r;
+  vint   p;
+  vint   q;
+  real   x0;
+  mreal  y0;
+  real   dpx0;
+  mreal  dpy0;
+  vreal  f0;    /* F no ponto                            */
+  real   cnrm;  /* max(1,|c|) no ponto                   */
+  real   h;
+  real   cjaux; /* cj*h                                  */
+  /* produtos jacobiana-vetor                            */
+  void (*F)(int,int,real,mreal,vreal,void *);
+  void (*JV)(int,int,real,mreal,real,mreal,vreal,void *);
+  void  *data;
+  mreal  vy;    /* direcao (o x n)                       */
+  mreal  yb;    /* ponto perturbado                      */
+  vreal  fb;    /* F no ponto perturbado                 */
+  vreal  fv;    /* DF na direcao                         */
+  /* termo forcante                                      */
+  real   ro;    /* taxa de convergencia de masterstep    */
+  real   dn;    /* norma peso esperada da correcao       */
+  /* orientacao do vetor tangente                        */
+  int    ref;   /* 1 : (*rx,ry) e a derivada anterior    */
+  real  *rx;
+  mreal  ry;
+  /* precondicionador a direita (SETPRECOND)             */
+  int  (*pcsetup)(real,real,pcstate *,void *);
+  void (*pcsolve)(int,vreal,void *);
+  void  *pcdata;
+  int    pcok;  /* 1 : setup no ponto atual sem falha    */
+  pcstate st;
+  pcbuiltin *pcb; /* interno (NULL : do usuario)         */
+  vreal  w;     /* (dim)                                 */
+  vreal  pt;    /* (n)                                   */
+  vreal  xc;    /* M^(-1) (coluna x de DH) (dim)         */
+  real   xden;  /* pivo da variavel x em M               */
+  /* contadores                                          */
+  int    nli;   /* iteracoes do GMRES                    */
+  int    nfe;   /* avaliacoes de F nos produtos          */
+  int    npc;   /* setups do precondicionador            */
+};
+
+/* threads das jacobianas aproximadas (SETTHREADS) */
+typedef struct fdjac  fdjac;
+
+/* lotes de F das jacobianas aproximadas (SETFBATCH) */
+typedef struct fbatch  fbatch;
+
+/* threads das fatoracoes densas (SETQRTHREADS) */
+typedef struct qrthr  qrthr;
+
+typedef struct solver  solver;
+
+struct solver {
+  int    nb;    /* tamanho do bloco da QR             */
+  vint   piv;   /* trocas de linhas da QR (pivoteamento) */
+  mreal  W;     /* area de trabalho (nb x dim)        */
+  /* complemento de Schur (infoinput[5] = 1) */
+  int    schur; /* 1 : eliminar as linhas da cadeia   */
+  int    core;  /* 1 : fatoracao atual e a reduzida   */
+                /* 2 : reduzida e esparsa (LU)        */
+                /* 3 : sem fatoracao (GMRES)          */
+  real   cjaux; /* cj*h da fatoracao                  */
+  real   rho;   /* h*dpx/cjaux da fatoracao           */
+  mreal  P;     /* coeficientes da cadeia (o x n)     */
+  mreal  X;     /* coeficientes de x na cadeia        */
+  vreal  nrm;   /* linha de normalizacao de DH        */
+  /* jacobiana esparsa (NULL : densa)  */
+  sparse *sp;
+  /* coloracao de DFy (NULL : uma avaliacao de F por coluna) */
+  coloring *cpr;
+  /* threads das jacobianas aproximadas (NULL : sequencial) */
+  fdjac *fd;
+  /* lotes de F das jacobianas aproximadas (NULL : F) */
+  fbatch *fb;
+  /* threads de QRH, LUH e QR2 (NULL : sequencial) */
+  qrthr *qt;
+  /* corretor de Newton-Krylov (NULL : fatoracao de DH) */
+  krylov *kr;
+  /* atualizacoes de Broyden (infoinput[6] = 1) */
+  int    broyden; /* 1 : manter a fatoracao e atualiza-la */
+  int    bdim;  /* dimensao da ultima fatoracao       */
+  int    nbroy; /* atualizacoes desde a fatoracao     */
+  mreal  BS;    /* passos s (GSDAE_NBROY x dim)       */
+  mreal  BD;    /* (s-B^-1 y)/(s^t B^-1 y)            */
+  vreal  bh;    /* H no ponto anterior                */
+  /* LU com retorno a QR (infoinput[7] = 1) */
+  int    adapt; /* 1 : LU longe de cdmax              */
+  int    lu;    /* 1 : fatoracao densa atual e a LU   */
+  real   lcond; /* condicao da ultima fatoracao densa */
+                /* (0 : desconhecida, usar QR)        */
+  real   cdmax; /* condicao maxima de masterstep      */
+  int    nlu;   /* decomposicoes LU                   */
+  int    nsw;   /* trocas entre LU e QR               */
+  /* refatoracao para um novo cj (infoinput[8] = 1) */
+  int    cjup;  /* 1 : reutilizar DFx e DFy guardadas */
+  int    jok;   /* 1 : DFx e DFy (ou sp->val) contem  */
+                /*     a jacobiana da fatoracao atual */
+  int    ncj;   /* refatoracoes desde a avaliacao     */
+};
+
 typedef struct parameter  parameter; 
 
+/* contexto do integrador : cada contexto armazena todos */
+/* os dados de uma integracao independente               */
+typedef struct parameter  gsdae_ctx; 
+
 struct parameter {
   /* variavel de comprimento de arco */
   real   s;
@@ -79,10 +445,18 @@ struct parameter {
   int    n;     
   /* ordem da EAD */
   int    o;
+  /* dimensao e ordem alocadas */
+  int    nalloc;
+  int    oalloc;
   /* rotina que define a EAD */
-  void   (*F)(int,int,real,mreal,vreal);
+  void   (*F)(int,int,real,mreal,vreal,void *);
   /* rotina que define a jacobiana */
-  void   (*DF)(int,int,real,mreal,vreal,mmreal);
+  void   (*DF)(int,int,real,mreal,vreal,mmreal,void *);
+  /* dados do usuario repassados para F e DF */
+  void   *data;
+  /* rotinas do usuario sem dados (ALLOCPAR) */
+  void   (*F0)(int,int,real,mreal,vreal);
+  void   (*DF0)(int,int,real,mreal,vreal,mmreal);
   /* ordem do metodo */
   int    k;
   /* posto de DFy[o] */
@@ -150,6 +524,16 @@ struct parameter {
   int    cfalhas;
   int    nflhs;      
   int    irank;
+  /* controladores de erro */
+  int    error;
+  int    nerror;
+  /* memoria do contexto (GSDAE_ARENA e GSDAE_HUGE) */
+  int    mode;
+  arena  mem;
+  /* resolvedor linear do passo de Newton */
+  solver ls;
+  /* padrao de DF detectado (DETECTPATTERN) */
+  pattern *pat;
   /* variaveis auxiliares */
   real   xend;
   real   x;
@@ -172,6 +556,282 @@ struct parameter {
   mreal  Ey;
 };
 
+/* ***************************************************** */
+/* definindo a estrutura pool que armazena um conjunto   */
+/* de threads que executam uma mesma tarefa              */
+/* ***************************************************** */
+
+typedef struct pool  pool; 
+
+struct pool {
+  /* numero de threads (incluindo a thread que chama) */
+  int              nthreads;
+  int              nstarted;
+  pthread_t       *thread;
+  /* sincronizacao das threads */
+  pthread_mutex_t  lock;
+  pthread_cond_t   start;
+  pthread_cond_t   finish;
+  /* tarefa executada pelas threads */
+  void           (*task)(int,void *);
+  void            *arg;
+  int              generation;
+  int              running;
+  int              stop;
+};
+
+/* ***************************************************** */
+/* definindo a estrutura gsdae_inst que armazena uma     */
+/* instancia integrada por GSDAEBATCH (ate s = send) ou  */
+/* por GSDAEENSEMBLE (ate x = xend)                      */
+/* ***************************************************** */
+
+typedef struct gsdae_inst  gsdae_inst; 
+
+struct gsdae_inst {
+  /* dados de entrada (como em GSDAE) */
+  real   h;
+  real   hmin;
+  real   hmax;
+  real   cdmax;
+  real   send;
+  real   xend;
+  real   atolx;
+  real   rtolx;
+  mreal  atoly;
+  mreal  rtoly;
+  vreal  ftol;
+  vint   info;
+  void  *data;
+  /* dados de entrada e saida */
+  real   s;
+  real   x;
+  mreal  y;
+  /* dados de saida */
+  int    status;
+  int    nstep;
+  int    nreject;
+  int    nsuc;
+  int    nfunc;
+  int    njac;
+  int    nqr;
+  int    nstart;
+  int    nfnew;
+  int    rank;
+  int    order;
+};
+
+/* ***************************************************** */
+/* definindo as estruturas internas de GSDAEBATCH        */
+/* ***************************************************** */
+
+typedef struct batchrange  batchrange; 
+
+struct batchrange {
+  /* faixa de instancias [lo,hi) de uma thread */
+  int              lo;
+  int              hi;
+  pthread_mutex_t  lock;
+};
+
+typedef struct batch  batch; 
+
+struct batch {
+  int          n;
+  int          o;
+  int          m;
+  int          nthreads;
+  gsdae_inst  *inst;
+  batchrange  *range;
+  void       (*F)(int,int,real,mreal,vreal,void *);
+  void       (*DF)(int,int,real,mreal,vreal,mmreal,void *);
+};
+
+/* ***************************************************** */
+/* definindo a estrutura ensemble de um grupo de         */
+/* GSDAEENSEMBLE (dados de ENSEMBLEF e ENSEMBLEDF)       */
+/* ***************************************************** */
+
+typedef struct ensemble  ensemble; 
+
+struct ensemble {
+  int      n;      /* dimensao de cada instancia          */
+  int      o;      /* ordem da EAD                        */
+  int      w;      /* numero de instancias do grupo       */
+  void   (*F)(int,int,int,real,mreal,vreal,void **);
+  void   (*DF)(int,int,int,real,mreal,vreal,mmreal,void **);
+  void   **data;   /* dados do usuario de cada instancia  */
+  mmreal   DFy;    /* DFy intercalada [0..o][1..n][1..w*n]*/
+  vreal    delta;  /* F no ponto (diferencas finitas)     */
+  vreal    daux;   /* F no ponto perturbado               */
+  vreal    dy;     /* incrementos de cada instancia       */
+};
+
+/* ***************************************************** */
+/* definindo a estrutura fdjac que divide as colunas das */
+/* jacobianas aproximadas entre threads (F segura)       */
+/* ***************************************************** */
+
+/* tarefas de FDTASK */
+#define GSDAE_FDDH    0    /* colunas de DH (SETDHAPPROX)  */
+#define GSDAE_FDDF    1    /* colunas de DF (DFAPPROX)     */
+#define GSDAE_FDCOLOR 2    /* cores de DF (DFCOLOR)        */
+
+struct fdjac {
+  int          nthreads;
+  pool        *pl;
+  /* dimensoes alocadas */
+  int          nalloc;
+  int          oalloc;
+  /* copias privadas de cada thread (0..nthreads-1) */
+  mreal       *y;
+  mreal       *dy;
+  vreal       *f;     /* F (n+1)               */
+  vreal       *fh;    /* H ((o+1)n+1)          */
+  /* tarefa atual */
+  int          kind;
+  int          ncol;  /* colunas ou cores      */
+  int          n;
+  int          o;
+  int          r;
+  int          dim;
+  real         x;
+  mreal        ys;    /* ponto (compartilhado) */
+  vreal        base;  /* F ou H no ponto       */
+  void       (*F)(int,int,real,mreal,vreal,void *);
+  void        *data;
+  real         uround;
+  real         h;
+  real         cj;
+  real         dx;
+  real         wtx;
+  mreal        dys;
+  mreal        wty;
+  vint         p;
+  vint         q;
+  mreal        DH;
+  real         delx;
+  vreal        DFx;
+  mmreal       DFy;
+  coloring    *cpr;
+};
+
+/* ***************************************************** */
+/* definindo a estrutura fbatch que avalia as colunas    */
+/* das jacobianas aproximadas em lotes de pontos com a   */
+/* rotina Fb do usuario (SETFBATCH)                      */
+/* ***************************************************** */
+
+/* numero padrao de pontos por chamada de Fb */
+#define GSDAE_FBMAX  64
+
+struct fbatch {
+  int          mmax;  /* pontos por chamada    */
+  void       (*Fb)(int,int,int,vreal,mmreal,mreal,void *);
+  /* dimensoes alocadas */
+  int          nalloc;
+  int          oalloc;
+  /* pontos do lote (1..mmax) */
+  vreal        xs;
+  mmreal       ys;
+  mreal        fs;    /* F (1..mmax x n)       */
+  vreal        del;   /* incrementos           */
+  mreal        dy;    /* y' (SETDHAPPROX)     */
+  vreal        fh;    /* H ((o+1)n+1)          */
+  /* tarefa atual (como em FDTASK) */
+  fdjac        task;
+};
+
+/* ***************************************************** */
+/* definindo a estrutura qrthr que divide as colunas das */
+/* atualizacoes de QRH, LUH e QR2 em ladrilhos executados */
+/* pelas threads de um pool (SETQRTHREADS)               */
+/* ***************************************************** */
+
+/* dimensao minima para usar as threads e largura dos */
+/* ladrilhos de colunas                                */
+#define GSDAE_QRMIN   256
+#define GSDAE_QRTILE  64
+
+/* tarefas de QRTHTASK */
+#define GSDAE_THQRH   0    /* C = (I - V T^t V^t) C (QRH)  */
+#define GSDAE_THLUH   1    /* U12 e A22 (LUH)              */
+#define GSDAE_THQR2   2    /* rotacoes de Givens (QR2)     */
+
+struct qrthr {
+  int              nthreads;
+  int              nmin;  /* dimensao minima               */
+  pool            *pl;
+  /* dimensoes alocadas */
+  int              nb;
+  int              dim;
+  /* area de trabalho de cada thread (nb x dim) */
+  mreal           *W;
+  /* rotacoes de QR2 : cosseno, seno e 1 se aplicada */
+  vreal            rc;
+  vreal            rs;
+  vint             rk;
+  /* distribuicao dos ladrilhos */
+  pthread_mutex_t  lock;
+  int              next;
+  int              ntile;
+  /* tarefa atual */
+  int              kind;
+  int              m;
+  int              n;
+  int              k0;
+  int              k1;
+  int              j0;    /* colunas j0..j1 em ladrilhos  */
+  int              j1;
+  mreal            A;
+  mreal            T;
+  vint             p;
+  vint             q;
+};
+
+
+/* ***************************************************** */
+/* definindo a estrutura kernels com os nucleos vetoriais */
+/* dos lacos internos, escolhidos pela CPUID (SETSIMD)    */
+/* ***************************************************** */
+
+/* x86 com gcc ou clang : versoes SSE2, AVX2 e AVX-512 */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GSDAE_X86
+/* conjunto de instrucoes de cada versao; AVX-512F inclui FMA e a */
+/* contracao de a*b+c mudaria o resultado de rot e acc            */
+#define GSDAE_TSSE2 __attribute__((target("sse2")))
+#define GSDAE_TAVX2 __attribute__((target("avx2")))
+#define GSDAE_T512  __attribute__((target("avx512f"),optimize("fp-contract=off")))
+#endif
+
+/* niveis dos nucleos */
+#define GSDAE_SIMDNONE 0    /* escalar                      */
+#define GSDAE_SIMDSSE2 1
+#define GSDAE_SIMDAVX2 2
+#define GSDAE_SIMD512  3    /* AVX-512F                     */
+
+typedef struct kernels  kernels;
+
+struct kernels {
+  int    level;  /* nivel escolhido (-1 : ainda nao escolhido) */
+  /* rotacao de Givens em x[0..n-1] e y[0..n-1] (ou x[q[j]]) */
+  void (*rot)(int,vreal,vreal,vint,real,real);
+  /* produto interno */
+  real (*dot)(int,vreal,vreal);
+  /* y += x e z += a x */
+  void (*acc)(int,real,vreal,vreal,vreal,vint);
+  /* y = soma de x_l e z = soma de a[l] x_l (predictor) */
+  void (*pred)(int,int,int,vreal,vreal,vreal,int,vreal,vreal);
+  /* max |c/w| e soma de ((c/w)/v)^2 (weightnorm) */
+  real (*wmax)(int,vreal,vreal,vint,real);
+  real (*wssq)(int,vreal,vreal,vint,real);
+};
+
+/* vetores com menos de GSDAE_KSHORT elementos usam os nucleos */
+/* escalares em vez dos de kern (KERNROT, ..., KERNWSSQ)       */
+#define GSDAE_KSHORT  8
+
 
 /* ******************************************************* */
 /* Definindo as macro-funcoes utilizadas em GSDAE          */